@@ -0,0 +1,39 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+
+// Shared helpers for the engine benchmarks
+//
+// Each benchmark is a standalone executable that prints its measurements. Timings are the best of
+// several runs, which filters out most of the noise from the rest of the system.
+
+namespace eloo::bench {
+    inline volatile double gSink = 0.0;
+
+    // Keeps the optimizer from discarding results that are otherwise unused
+    inline void keep(double value) {
+        gSink = gSink + value;
+    }
+
+    // Best time in milliseconds of 'runs' calls to 'fn'
+    template <typename Fn>
+    inline double best_ms(int runs, Fn&& fn) {
+        double best = 1e30;
+        for (int run = 0; run < runs; ++run) {
+            const auto start = std::chrono::steady_clock::now();
+            fn();
+            const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            best = ms < best ? ms : best;
+        }
+        return best;
+    }
+
+    inline double per_second(size_t items, double ms) {
+        return ms > 0.0 ? static_cast<double>(items) * 1000.0 / ms : 0.0;
+    }
+
+    inline void report(const char* name, size_t items, double ms) {
+        std::printf("%-40s %10.3f ms %14.0f /s\n", name, ms, per_second(items, ms));
+    }
+}
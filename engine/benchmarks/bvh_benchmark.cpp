@@ -0,0 +1,96 @@
+#include "benchmark.h"
+#include "scenes.h"
+
+#include "maths/math.h"
+#include "utility/bvh.h"
+
+using namespace eloo;
+
+// Binned SAH build time and closest/any hit rays per second on a heightfield, against testing
+// every triangle with raycast::test_tri. The grid size can be given on the command line, the
+// default being 1024 x 1024 cells, about 2.1M triangles
+
+namespace {
+    constexpr uint32_t DEFAULT_GRID = 1024;
+    constexpr size_t RAY_COUNT = 200000;
+    // Brute force is millions of times slower per ray, so it only gets a handful
+    constexpr size_t BRUTE_FORCE_RAYS = 16;
+    constexpr int BUILD_RUNS = 3;
+    constexpr int QUERY_RUNS = 3;
+}
+
+int main(int argc, char** argv) {
+    const uint32_t gridSize = bench::grid_size_arg(argc, argv, DEFAULT_GRID);
+    const bench::indexed_mesh terrain = bench::make_heightfield(gridSize);
+    const size_t triangles = terrain.triangle_count();
+    const eastl::vector<raycast::ray> rays = bench::make_terrain_rays(gridSize, RAY_COUNT);
+
+    // The triangles' bounds, to time the box tree on the same scene
+    eastl::vector<bvh::aabb> boxes(triangles);
+    for (size_t i = 0; i < triangles; ++i) {
+        const float3::values& a = terrain.vertices[terrain.indices[i * 3]];
+        const float3::values& b = terrain.vertices[terrain.indices[i * 3 + 1]];
+        const float3::values& c = terrain.vertices[terrain.indices[i * 3 + 2]];
+        boxes[i].min = { math::min(math::min(a.x(), b.x()), c.x()), math::min(math::min(a.y(), b.y()), c.y()), math::min(math::min(a.z(), b.z()), c.z()) };
+        boxes[i].max = { math::max(math::max(a.x(), b.x()), c.x()), math::max(math::max(a.y(), b.y()), c.y()), math::max(math::max(a.z(), b.z()), c.z()) };
+    }
+
+    std::printf("%zu triangles, %zu rays\n", triangles, RAY_COUNT);
+
+    bvh::mesh mesh;
+    double ms = bench::best_ms(BUILD_RUNS, [&] {
+        mesh.build(terrain.vertices, terrain.indices);
+    });
+    bench::report("mesh SAH build (triangles)", triangles, ms);
+
+    bvh::tree tree;
+    ms = bench::best_ms(BUILD_RUNS, [&] {
+        tree.build(boxes);
+    });
+    bench::report("tree SAH build (boxes)", triangles, ms);
+
+    ms = bench::best_ms(QUERY_RUNS, [&] {
+        size_t hits = 0;
+        for (const raycast::ray& query : rays) {
+            raycast::batch_hit closest;
+            hits += mesh.raycast(query, closest) ? 1 : 0;
+        }
+        bench::keep(static_cast<double>(hits));
+    });
+    bench::report("mesh closest hit (rays)", RAY_COUNT, ms);
+
+    ms = bench::best_ms(QUERY_RUNS, [&] {
+        size_t hits = 0;
+        for (const raycast::ray& query : rays) {
+            hits += mesh.occluded(query) ? 1 : 0;
+        }
+        bench::keep(static_cast<double>(hits));
+    });
+    bench::report("mesh any hit (rays)", RAY_COUNT, ms);
+
+    ms = bench::best_ms(QUERY_RUNS, [&] {
+        size_t hits = 0;
+        for (const raycast::ray& query : rays) {
+            raycast::batch_hit closest;
+            hits += tree.raycast(query, closest) ? 1 : 0;
+        }
+        bench::keep(static_cast<double>(hits));
+    });
+    bench::report("tree closest hit (rays)", RAY_COUNT, ms);
+
+    ms = bench::best_ms(1, [&] {
+        float nearest = FLT_MAX;
+        for (size_t r = 0; r < BRUTE_FORCE_RAYS; ++r) {
+            for (size_t i = 0; i < triangles; ++i) {
+                raycast::result hit;
+                const uint32_t* triangle = &terrain.indices[i * 3];
+                if (raycast::test_tri(rays[r], terrain.vertices[triangle[0]], terrain.vertices[triangle[1]], terrain.vertices[triangle[2]], hit)) {
+                    nearest = math::min(nearest, hit.distance);
+                }
+            }
+        }
+        bench::keep(nearest);
+    });
+    bench::report("test_tri every triangle (rays)", BRUTE_FORCE_RAYS, ms);
+    return 0;
+}
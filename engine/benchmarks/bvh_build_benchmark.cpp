@@ -0,0 +1,79 @@
+#include "benchmark.h"
+#include "scenes.h"
+
+#include "utility/bvh.h"
+#include "utility/parallel.h"
+
+using namespace eloo;
+
+// SAH and LBVH build times on one thread and across the worker pool, and the query speed each
+// method's tree gives. The single threaded builds run inside a parallel_for chunk, where nested
+// parallel_for calls run serially. Also checks the node arrays come out the same either way.
+// The speed-up depends on the machine's core count, which is printed with the results
+
+namespace {
+    constexpr uint32_t DEFAULT_GRID = 1024;
+    constexpr size_t RAY_COUNT = 200000;
+    constexpr int BUILD_RUNS = 3;
+
+    uint64_t hash_nodes(eastl::span<const bvh::node> nodes) {
+        uint64_t hash = 14695981039346656037ull;
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(nodes.data());
+        for (size_t i = 0; i < nodes.size_bytes(); ++i) {
+            hash = (hash ^ bytes[i]) * 1099511628211ull;
+        }
+        return hash;
+    }
+
+    template <typename BuildFn>
+    double serial_ms(BuildFn&& buildFn) {
+        return bench::best_ms(BUILD_RUNS, [&] {
+            parallel::parallel_for(1, 1, [&](size_t, size_t) { buildFn(); });
+        });
+    }
+}
+
+int main(int argc, char** argv) {
+    const uint32_t gridSize = bench::grid_size_arg(argc, argv, DEFAULT_GRID);
+    const bench::indexed_mesh terrain = bench::make_heightfield(gridSize);
+    const size_t triangles = terrain.triangle_count();
+    const eastl::vector<raycast::ray> rays = bench::make_terrain_rays(gridSize, RAY_COUNT);
+
+    std::printf("%zu triangles, %zu workers\n", triangles, parallel::worker_count());
+
+    bool identical = true;
+    for (const bvh::build_method method : { bvh::build_method::sah, bvh::build_method::lbvh }) {
+        const char* methodName = method == bvh::build_method::sah ? "SAH" : "LBVH";
+        bvh::build_settings settings;
+        settings.method = method;
+
+        bvh::mesh mesh;
+        const auto build = [&] { mesh.build(terrain.vertices, terrain.indices, settings); };
+        char name[64];
+
+        const double serial = serial_ms(build);
+        const uint64_t serialHash = hash_nodes(mesh.nodes());
+        std::snprintf(name, sizeof(name), "%s build, 1 thread", methodName);
+        bench::report(name, triangles, serial);
+
+        const double pooled = bench::best_ms(BUILD_RUNS, build);
+        identical = identical && hash_nodes(mesh.nodes()) == serialHash;
+        std::snprintf(name, sizeof(name), "%s build, %zu workers", methodName, parallel::worker_count());
+        bench::report(name, triangles, pooled);
+        std::printf("%-40s %10.2fx\n", "  speed-up", serial / pooled);
+
+        const double query = bench::best_ms(1, [&] {
+            size_t hits = 0;
+            for (const raycast::ray& ray : rays) {
+                raycast::batch_hit closest;
+                hits += mesh.raycast(ray, closest) ? 1 : 0;
+            }
+            bench::keep(static_cast<double>(hits));
+        });
+        std::snprintf(name, sizeof(name), "%s closest hit (rays)", methodName);
+        bench::report(name, RAY_COUNT, query);
+    }
+
+    std::printf("Node arrays %s between 1 thread and the pool\n", identical ? "match" : "DIFFER");
+    return identical ? 0 : 1;
+}
@@ -0,0 +1,67 @@
+#include "benchmark.h"
+#include "scenes.h"
+
+#include "utility/bvh.h"
+#include "utility/bvh_compressed.h"
+
+using namespace eloo;
+
+// Memory per triangle and rays per second for the full float mesh and the 4 and 8 wide
+// compressed meshes, built from the same heightfield. The grid size can be given on the
+// command line, the default being 1024 x 1024 cells, about 2.1M triangles
+
+namespace {
+    constexpr uint32_t DEFAULT_GRID = 1024;
+    constexpr size_t RAY_COUNT = 200000;
+    constexpr int QUERY_RUNS = 3;
+
+    template <typename Mesh>
+    void run(const char* label, const Mesh& mesh, size_t triangles, eastl::span<const raycast::ray> rays) {
+        char name[64];
+        std::printf("%-40s %10.1f bytes/triangle\n", label, static_cast<double>(mesh.memory_bytes()) / static_cast<double>(triangles));
+
+        double ms = bench::best_ms(QUERY_RUNS, [&] {
+            size_t hits = 0;
+            for (const raycast::ray& query : rays) {
+                raycast::batch_hit closest;
+                hits += mesh.raycast(query, closest) ? 1 : 0;
+            }
+            bench::keep(static_cast<double>(hits));
+        });
+        std::snprintf(name, sizeof(name), "  %s closest hit", label);
+        bench::report(name, rays.size(), ms);
+
+        ms = bench::best_ms(QUERY_RUNS, [&] {
+            size_t hits = 0;
+            for (const raycast::ray& query : rays) {
+                hits += mesh.occluded(query) ? 1 : 0;
+            }
+            bench::keep(static_cast<double>(hits));
+        });
+        std::snprintf(name, sizeof(name), "  %s any hit", label);
+        bench::report(name, rays.size(), ms);
+    }
+}
+
+int main(int argc, char** argv) {
+    const uint32_t gridSize = bench::grid_size_arg(argc, argv, DEFAULT_GRID);
+    const bench::indexed_mesh terrain = bench::make_heightfield(gridSize);
+    const size_t triangles = terrain.triangle_count();
+    const eastl::vector<raycast::ray> rays = bench::make_terrain_rays(gridSize, RAY_COUNT);
+
+    std::printf("%zu triangles, %zu rays\n", triangles, RAY_COUNT);
+
+    {
+        const bvh::mesh mesh(terrain.vertices, terrain.indices);
+        run("mesh", mesh, triangles, rays);
+    }
+    {
+        const bvh::compressed_mesh<4> mesh(terrain.vertices, terrain.indices);
+        run("compressed_mesh<4>", mesh, triangles, rays);
+    }
+    {
+        const bvh::compressed_mesh<8> mesh(terrain.vertices, terrain.indices);
+        run("compressed_mesh<8>", mesh, triangles, rays);
+    }
+    return 0;
+}
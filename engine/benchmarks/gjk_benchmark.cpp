@@ -0,0 +1,153 @@
+#include "benchmark.h"
+
+#include "maths/math.h"
+#include "maths/random.h"
+#include "utility/gjk.h"
+#include "utility/parallel.h"
+
+#include <EASTL/vector.h>
+
+using namespace eloo;
+
+// Pairs/sec for the overlap, closest point and penetration batches over a mix of spheres,
+// capsules, boxes, ellipsoids and hulls. Pairs are drawn from shapes whose centres are close,
+// as a broadphase would hand them over. Each batch runs cold, without caches, and warm, from
+// caches filled by the same pairs after the shapes moved a little, as between two frames
+
+namespace {
+    constexpr size_t SHAPE_COUNT = 2000;
+    constexpr size_t PAIR_COUNT = 200000;
+    constexpr size_t HULL_VERTICES = 32;
+    constexpr float SPREAD = 20.0f;
+    // Shapes whose centres are closer than this make candidate pairs
+    constexpr float NEAR_DISTANCE = 4.0f;
+    // How far every shape moves between the frame that fills the caches and the timed one
+    constexpr float STEP = 0.05f;
+    constexpr int RUNS = 5;
+
+    float3::values random_point(math::random::generator& rng, float extent) {
+        return { rng.range(-extent, extent), rng.range(-extent, extent), rng.range(-extent, extent) };
+    }
+
+    eastl::vector<float3::values> make_hull(math::random::generator& rng) {
+        eastl::vector<float3::values> vertices;
+        for (size_t i = 0; i < HULL_VERTICES; ++i) {
+            vertices.push_back(math::vector::normalize(random_point(rng, 1.0f)) * rng.range(0.5f, 2.0f));
+        }
+        return vertices;
+    }
+
+    gjk::shape make_shape(math::random::generator& rng, size_t index, const float3::values& centre, eastl::span<const float3::values> hull) {
+        switch (index % 5) {
+            case 0:  return gjk::shape::sphere(centre, rng.range(0.5f, 2.0f));
+            case 1:  return gjk::shape::capsule(centre, rng.range(0.0f, 2.0f), rng.range(0.3f, 1.0f));
+            case 2:  return gjk::shape::box(centre, centre + float3::values(rng.range(0.5f, 3.0f), rng.range(0.5f, 3.0f), rng.range(0.5f, 3.0f)));
+            case 3:  return gjk::shape::ellipsoid(centre, { rng.range(0.5f, 2.0f), rng.range(0.5f, 2.0f), rng.range(0.5f, 2.0f) });
+            default: return gjk::shape::hull(hull);
+        }
+    }
+
+    // Moves a shape by 'offset', rewriting hull vertices in place
+    void move_shape(gjk::shape& convex, eastl::vector<float3::values>& hull, const float3::values& offset) {
+        if (convex.type == gjk::shape_type::hull) {
+            for (float3::values& vertex : hull) {
+                vertex = vertex + offset;
+            }
+            return;
+        }
+        convex.origin = convex.origin + offset;
+        if (convex.type == gjk::shape_type::box) {
+            convex.extent = convex.extent + offset;
+        }
+    }
+}
+
+int main() {
+    math::random::generator rng;
+
+    // Hulls keep their own vertices so each one can move on its own
+    eastl::vector<eastl::vector<float3::values>> hulls(SHAPE_COUNT);
+    eastl::vector<float3::values> centres;
+    eastl::vector<gjk::shape> shapes;
+    for (size_t i = 0; i < SHAPE_COUNT; ++i) {
+        const float3::values centre = random_point(rng, SPREAD);
+        centres.push_back(centre);
+        if (i % 5 == 4) {
+            hulls[i] = make_hull(rng);
+            for (float3::values& vertex : hulls[i]) {
+                vertex = vertex + centre;
+            }
+        }
+        shapes.push_back(make_shape(rng, i, centre, hulls[i]));
+    }
+
+    eastl::vector<gjk::shape_pair> candidates;
+    for (uint32_t a = 0; a < SHAPE_COUNT; ++a) {
+        for (uint32_t b = a + 1; b < SHAPE_COUNT; ++b) {
+            if (math::vector::distance(centres[a], centres[b]) < NEAR_DISTANCE) {
+                candidates.push_back({ a, b });
+            }
+        }
+    }
+    eastl::vector<gjk::shape_pair> pairs(PAIR_COUNT);
+    for (gjk::shape_pair& pair : pairs) {
+        pair = candidates[rng.range(0, static_cast<int32_t>(candidates.size()) - 1)];
+    }
+
+    eastl::vector<uint8_t> overlapping(PAIR_COUNT);
+    eastl::vector<gjk::result> results(PAIR_COUNT);
+    eastl::vector<gjk::cache> overlapCaches(PAIR_COUNT), closestCaches(PAIR_COUNT), penetrationCaches(PAIR_COUNT);
+
+    // Fill the caches on the first frame, then move every shape for the timed one
+    gjk::overlap(shapes, pairs, overlapping, overlapCaches);
+    gjk::closest_points(shapes, pairs, results, closestCaches);
+    gjk::penetration(shapes, pairs, results, penetrationCaches);
+    for (size_t i = 0; i < SHAPE_COUNT; ++i) {
+        move_shape(shapes[i], hulls[i], random_point(rng, STEP));
+    }
+
+    size_t hits = 0;
+    for (const uint8_t hit : overlapping) {
+        hits += hit;
+    }
+    std::printf("%zu shapes, %zu pairs, %zu overlapping, best of %d runs, %zu workers\n", SHAPE_COUNT, PAIR_COUNT, hits, RUNS, parallel::worker_count());
+
+    // Warm runs start each pair from a copy of the first frame's cache, so every run does the
+    // same work
+    eastl::vector<gjk::cache> caches(PAIR_COUNT);
+    double ms = bench::best_ms(RUNS, [&] {
+        gjk::overlap(shapes, pairs, overlapping);
+    });
+    bench::report("overlap, cold (pairs)", PAIR_COUNT, ms);
+
+    ms = bench::best_ms(RUNS, [&] {
+        caches = overlapCaches;
+        gjk::overlap(shapes, pairs, overlapping, caches);
+    });
+    bench::report("overlap, warm (pairs)", PAIR_COUNT, ms);
+
+    ms = bench::best_ms(RUNS, [&] {
+        gjk::closest_points(shapes, pairs, results);
+    });
+    bench::report("closest points, cold (pairs)", PAIR_COUNT, ms);
+
+    ms = bench::best_ms(RUNS, [&] {
+        caches = closestCaches;
+        gjk::closest_points(shapes, pairs, results, caches);
+    });
+    bench::report("closest points, warm (pairs)", PAIR_COUNT, ms);
+
+    ms = bench::best_ms(RUNS, [&] {
+        gjk::penetration(shapes, pairs, results);
+    });
+    bench::report("penetration, cold (pairs)", PAIR_COUNT, ms);
+
+    ms = bench::best_ms(RUNS, [&] {
+        caches = penetrationCaches;
+        gjk::penetration(shapes, pairs, results, caches);
+    });
+    bench::report("penetration, warm (pairs)", PAIR_COUNT, ms);
+
+    bench::keep(results[PAIR_COUNT / 2].distance);
+    return 0;
+}
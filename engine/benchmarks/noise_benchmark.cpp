@@ -0,0 +1,74 @@
+#include "benchmark.h"
+
+#include "maths/noise.h"
+#include "utility/parallel.h"
+
+#include <EASTL/vector.h>
+
+using namespace eloo;
+using namespace eloo::math;
+
+// Samples/sec for each noise type one point at a time against the SoA batch, plus a fractal
+// grid. Batches and grids large enough to tile run across the worker pool
+
+namespace {
+    constexpr size_t COUNT = 1 << 20;
+    constexpr uint32_t GRID_SIZE = 1024;
+    constexpr int RUNS = 5;
+
+    const char* type_name(noise::type kind) {
+        switch (kind) {
+            case noise::type::value:   return "value";
+            case noise::type::perlin:  return "perlin";
+            case noise::type::simplex: return "simplex";
+            case noise::type::worley:  return "worley";
+        }
+        return "";
+    }
+}
+
+int main() {
+    random::generator rng;
+    eastl::vector<float> x(COUNT), y(COUNT), z(COUNT), out(COUNT);
+    rng.fill_range(x, -100.0f, 100.0f);
+    rng.fill_range(y, -100.0f, 100.0f);
+    rng.fill_range(z, -100.0f, 100.0f);
+
+    std::printf("%zu random 3D points, best of %d runs, %zu workers\n", COUNT, RUNS, parallel::worker_count());
+
+    char name[64];
+    for (const noise::type kind : { noise::type::value, noise::type::perlin, noise::type::simplex, noise::type::worley }) {
+        noise::settings config;
+        config.kind = kind;
+        const noise::generator gen(random::DEFAULT_SEED, config);
+
+        double ms = bench::best_ms(RUNS, [&] {
+            for (size_t i = 0; i < COUNT; ++i) {
+                out[i] = gen.sample(x[i], y[i], z[i]);
+            }
+            bench::keep(out[COUNT / 2]);
+        });
+        std::snprintf(name, sizeof(name), "%s 3D scalar", type_name(kind));
+        bench::report(name, COUNT, ms);
+
+        ms = bench::best_ms(RUNS, [&] {
+            gen.sample(x, y, z, out);
+            bench::keep(out[COUNT / 2]);
+        });
+        std::snprintf(name, sizeof(name), "%s 3D batch", type_name(kind));
+        bench::report(name, COUNT, ms);
+    }
+
+    noise::settings config;
+    config.mode = noise::fractal::fbm;
+    config.octaves = 5;
+    config.frequency = 0.01f;
+    const noise::generator fbm(random::DEFAULT_SEED, config);
+    eastl::vector<float> grid(GRID_SIZE * GRID_SIZE);
+    const double ms = bench::best_ms(RUNS, [&] {
+        fbm.sample_grid(float2::values(0.0f, 0.0f), float2::values(1.0f, 1.0f), GRID_SIZE, GRID_SIZE, grid);
+        bench::keep(grid[grid.size() / 2]);
+    });
+    bench::report("simplex fbm 5 octaves 2D grid", grid.size(), ms);
+    return 0;
+}
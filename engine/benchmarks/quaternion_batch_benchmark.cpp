@@ -0,0 +1,105 @@
+#include "benchmark.h"
+
+#include "maths/math.h"
+#include "maths/quaternion_batch.h"
+#include "maths/random.h"
+
+#include <EASTL/vector.h>
+
+using namespace eloo;
+
+// Scalar slerp and matrix conversion, one quaternion at a time, against the SoA and AoS batch
+// kernels over the same data
+
+namespace {
+    constexpr size_t COUNT = 1 << 16;
+    constexpr int RUNS = 20;
+
+    struct soa_stream {
+        eastl::vector<float> x, y, z, w;
+
+        explicit soa_stream(size_t count) : x(count), y(count), z(count), w(count) {}
+
+        math::quaternion::soa_span span() { return { x, y, z, w }; }
+        math::quaternion::soa_const_span const_span() const { return { x, y, z, w }; }
+    };
+
+    quaternion_v random_rotation(math::random::generator& rng) {
+        return math::quaternion::normalize(rng.gaussian(), rng.gaussian(), rng.gaussian(), rng.gaussian());
+    }
+
+    void scalar_to_matrix(const quaternion_v& q, matrix3x3_v& out) {
+        const float x = q.x(), y = q.y(), z = q.z(), w = q.w();
+        out = matrix3x3_v(
+            1.0f - 2.0f * (y * y + z * z), 2.0f * (x * y - z * w), 2.0f * (x * z + y * w),
+            2.0f * (x * y + z * w), 1.0f - 2.0f * (x * x + z * z), 2.0f * (y * z - x * w),
+            2.0f * (x * z - y * w), 2.0f * (y * z + x * w), 1.0f - 2.0f * (x * x + y * y));
+    }
+}
+
+int main() {
+    math::random::generator rng;
+
+    eastl::vector<quaternion_v> from, to, out(COUNT, eloo::quaternion::IDENTITY);
+    eastl::vector<float> t(COUNT);
+    soa_stream fromSoa(COUNT), toSoa(COUNT), outSoa(COUNT);
+    from.reserve(COUNT);
+    to.reserve(COUNT);
+    for (size_t i = 0; i < COUNT; ++i) {
+        from.push_back(random_rotation(rng));
+        to.push_back(random_rotation(rng));
+        t[i] = rng.uniform();
+        fromSoa.x[i] = from[i].x(); fromSoa.y[i] = from[i].y(); fromSoa.z[i] = from[i].z(); fromSoa.w[i] = from[i].w();
+        toSoa.x[i] = to[i].x(); toSoa.y[i] = to[i].y(); toSoa.z[i] = to[i].z(); toSoa.w[i] = to[i].w();
+    }
+
+    std::printf("%zu quaternions, best of %d runs\n", COUNT, RUNS);
+
+    double ms = bench::best_ms(RUNS, [&] {
+        for (size_t i = 0; i < COUNT; ++i) {
+            out[i] = math::interpolation::slerp(from[i], to[i], t[i], math::interpolation::blend_func::lerp);
+        }
+        bench::keep(out[COUNT / 2].w());
+    });
+    bench::report("slerp scalar", COUNT, ms);
+
+    ms = bench::best_ms(RUNS, [&] {
+        math::quaternion::slerp(from, to, t, out);
+        bench::keep(out[COUNT / 2].w());
+    });
+    bench::report("slerp batch AoS", COUNT, ms);
+
+    ms = bench::best_ms(RUNS, [&] {
+        math::quaternion::slerp(fromSoa.const_span(), toSoa.const_span(), t, outSoa.span());
+        bench::keep(outSoa.w[COUNT / 2]);
+    });
+    bench::report("slerp batch SoA", COUNT, ms);
+
+    ms = bench::best_ms(RUNS, [&] {
+        math::quaternion::nlerp(fromSoa.const_span(), toSoa.const_span(), t, outSoa.span());
+        bench::keep(outSoa.w[COUNT / 2]);
+    });
+    bench::report("nlerp batch SoA", COUNT, ms);
+
+    eastl::vector<matrix3x3_v> matrices(COUNT);
+    ms = bench::best_ms(RUNS, [&] {
+        for (size_t i = 0; i < COUNT; ++i) {
+            scalar_to_matrix(from[i], matrices[i]);
+        }
+        bench::keep(matrices[COUNT / 2][0]);
+    });
+    bench::report("to_matrix scalar", COUNT, ms);
+
+    ms = bench::best_ms(RUNS, [&] {
+        math::quaternion::to_matrix(from, matrices);
+        bench::keep(matrices[COUNT / 2][0]);
+    });
+    bench::report("to_matrix batch AoS", COUNT, ms);
+
+    ms = bench::best_ms(RUNS, [&] {
+        math::quaternion::to_matrix(fromSoa.const_span(), matrices);
+        bench::keep(matrices[COUNT / 2][0]);
+    });
+    bench::report("to_matrix batch SoA", COUNT, ms);
+    return 0;
+}
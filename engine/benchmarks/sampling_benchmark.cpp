@@ -0,0 +1,84 @@
+#include "benchmark.h"
+
+#include "maths/sampling.h"
+
+#include <EASTL/vector.h>
+
+using namespace eloo;
+using namespace eloo::math::random;
+
+// Samples/sec for each sampler drawn one at a time against its span overload
+
+namespace {
+    constexpr size_t COUNT = 1 << 18;
+    constexpr int RUNS = 10;
+}
+
+int main() {
+    generator gen;
+
+    std::printf("%zu samples, best of %d runs\n", COUNT, RUNS);
+
+    eastl::vector<float> values(COUNT);
+    double ms = bench::best_ms(RUNS, [&] {
+        for (float& value : values) {
+            value = normal(gen);
+        }
+        bench::keep(values[COUNT / 2]);
+    });
+    bench::report("normal scalar", COUNT, ms);
+
+    ms = bench::best_ms(RUNS, [&] {
+        fill_normal(gen, values);
+        bench::keep(values[COUNT / 2]);
+    });
+    bench::report("normal batch", COUNT, ms);
+
+    const float weights[] = { 1.0f, 0.5f, 3.0f, 6.0f, 0.25f, 2.0f, 0.0f, 4.0f };
+    const alias_table table(weights);
+    eastl::vector<uint32_t> picks(COUNT);
+    ms = bench::best_ms(RUNS, [&] {
+        for (uint32_t& pick : picks) {
+            pick = table.sample(gen);
+        }
+        bench::keep(picks[COUNT / 2]);
+    });
+    bench::report("alias scalar", COUNT, ms);
+
+    ms = bench::best_ms(RUNS, [&] {
+        table.sample(gen, picks);
+        bench::keep(picks[COUNT / 2]);
+    });
+    bench::report("alias batch", COUNT, ms);
+
+    eastl::vector<float3::values> points(COUNT, float3::ZERO);
+    ms = bench::best_ms(RUNS, [&] {
+        for (float3::values& point : points) {
+            point = in_sphere(gen);
+        }
+        bench::keep(points[COUNT / 2].x());
+    });
+    bench::report("in_sphere scalar", COUNT, ms);
+
+    ms = bench::best_ms(RUNS, [&] {
+        in_sphere(gen, points);
+        bench::keep(points[COUNT / 2].x());
+    });
+    bench::report("in_sphere batch", COUNT, ms);
+
+    const float3::values axis(0.0f, 1.0f, 0.0f);
+    ms = bench::best_ms(RUNS, [&] {
+        for (float3::values& point : points) {
+            point = in_cone(gen, axis, 0.3f);
+        }
+        bench::keep(points[COUNT / 2].x());
+    });
+    bench::report("in_cone scalar", COUNT, ms);
+
+    ms = bench::best_ms(RUNS, [&] {
+        in_cone(gen, axis, 0.3f, points);
+        bench::keep(points[COUNT / 2].x());
+    });
+    bench::report("in_cone batch", COUNT, ms);
+    return 0;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "maths/random.h"
+#include "utility/raycast.h"
+
+#include <EASTL/vector.h>
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+
+// Content shared by the acceleration structure benchmarks
+
+namespace eloo::bench {
+    struct indexed_mesh {
+        eastl::vector<float3::values> vertices;
+        eastl::vector<uint32_t> indices;
+
+        inline size_t triangle_count() const { return indices.size() / 3; }
+    };
+
+    // Grid size from the first command line argument, so large meshes can be tried without
+    // rebuilding
+    inline uint32_t grid_size_arg(int argc, char** argv, uint32_t fallback) {
+        const long size = argc > 1 ? std::strtol(argv[1], nullptr, 10) : 0;
+        return size > 0 ? static_cast<uint32_t>(size) : fallback;
+    }
+
+    // Rolling terrain over 'size' x 'size' unit cells on the XZ plane, two triangles per cell
+    inline indexed_mesh make_heightfield(uint32_t size) {
+        indexed_mesh terrain;
+        terrain.vertices.reserve((size + 1) * (size + 1));
+        terrain.indices.reserve(size * size * 6);
+        for (uint32_t z = 0; z <= size; ++z) {
+            for (uint32_t x = 0; x <= size; ++x) {
+                const float height = std::sin(static_cast<float>(x) * 0.05f) * std::cos(static_cast<float>(z) * 0.07f) * 20.0f;
+                terrain.vertices.push_back({ static_cast<float>(x), height, static_cast<float>(z) });
+            }
+        }
+        for (uint32_t z = 0; z < size; ++z) {
+            for (uint32_t x = 0; x < size; ++x) {
+                const uint32_t corner = z * (size + 1) + x;
+                const uint32_t triangles[6] = { corner, corner + size + 1, corner + 1, corner + 1, corner + size + 1, corner + size + 2 };
+                terrain.indices.insert(terrain.indices.end(), triangles, triangles + 6);
+            }
+        }
+        return terrain;
+    }
+
+    // The same terrain as a triangle soup
+    inline eastl::vector<float3::values> make_soup(const indexed_mesh& terrain) {
+        eastl::vector<float3::values> soup;
+        soup.reserve(terrain.indices.size());
+        for (const uint32_t index : terrain.indices) {
+            soup.push_back(terrain.vertices[index]);
+        }
+        return soup;
+    }
+
+    // Rays starting above the terrain, pointing down within about 30 degrees of vertical
+    inline eastl::vector<raycast::ray> make_terrain_rays(uint32_t size, size_t count, uint64_t seed = 1) {
+        math::random::generator rng(seed);
+        eastl::vector<raycast::ray> rays;
+        rays.reserve(count);
+        const float extent = static_cast<float>(size);
+        for (size_t i = 0; i < count; ++i) {
+            const float3::values origin(rng.range(0.0f, extent), 60.0f, rng.range(0.0f, extent));
+            const float3::values direction(rng.range(-0.5f, 0.5f), -1.0f, rng.range(-0.5f, 0.5f));
+            rays.push_back(raycast::ray(origin, direction));
+        }
+        return rays;
+    }
+}
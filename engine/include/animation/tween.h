@@ -0,0 +1,128 @@
+#pragma once
+
+#include "utility/defines.h"
+#include "utility/colour.h"
+#include "utility/observer.h"
+
+#include "maths/interpolation.h"
+
+#include "datatypes/float3.h"
+
+#include <EASTL/array.h>
+#include <EASTL/span.h>
+#include <EASTL/vector.h>
+
+// Batched tweening
+//
+// Tweens are stored in SoA columns inside groups. A group owns a single blend function (and its
+// options), so each update evaluates one homogeneous curve over every track in the group before
+// writing the results straight into the targets. Groups also carry their own time scale and pause
+// state, which means slowing down all UI tweens is a single write rather than one per tween.
+//
+// Completion is delivered once per update, as a span of every tween that finished that frame.
+
+namespace eloo::tween {
+    ELOO_DECLARE_ID_T;
+
+    using group_id_t = uint32_t;
+
+    enum flags : uint8_t {
+        none        = 0,
+        looping     = 1 << 0,   // Restarts from the beginning once complete. Never reports completion
+        ping_pong   = 1 << 1,   // Plays forwards then backwards. Never reports completion
+        paused      = 1 << 2    // Holds the current time until unpaused
+    };
+
+    class manager {
+    public:
+        using completed_observer_t = observer<eastl::span<const id_t>>;
+
+    public:
+        group_id_t create_group(math::interpolation::blend_func func, math::interpolation::blend_opt options = eastl::monostate{}, float timeScale = 1.0f);
+        void set_group_time_scale(group_id_t group, float timeScale);
+        void set_group_paused(group_id_t group, bool isPaused);
+        void clear_group(group_id_t group);
+
+        id_t create(group_id_t group, float* target, float from, float to, float duration, uint8_t trackFlags = flags::none);
+        id_t create(group_id_t group, float3::values* target, const float3::values& from, const float3::values& to, float duration, uint8_t trackFlags = flags::none);
+        id_t create(group_id_t group, colour_t* target, colour_t from, colour_t to, float duration, uint8_t trackFlags = flags::none);
+
+        // Stops the tween where it is, without reporting it as completed
+        bool try_release(id_t id);
+        bool is_valid(id_t id) const;
+
+        void set_paused(id_t id, bool isPaused);
+
+        // Advances every unpaused group and writes the results into the targets, then reports
+        // all tweens that completed during this update. Completed tweens are released before the
+        // broadcast, so their ids are no longer valid inside the callback.
+        void update(float deltaTime);
+
+        inline completed_observer_t& on_completed() { return mOnCompleted; }
+
+        size_t count() const;
+
+    private:
+        enum class track_kind : uint8_t {
+            scalar,
+            vector3,
+            colour,
+            invalid
+        };
+
+        // SoA storage for one kind of target. 'delta' holds (to - from) per channel
+        template <int ChannelCount, typename TargetT>
+        struct track_pool {
+            eastl::vector<float> elapsed;
+            eastl::vector<float> duration;
+            eastl::vector<uint8_t> trackFlags;
+            eastl::array<eastl::vector<float>, ChannelCount> from;
+            eastl::array<eastl::vector<float>, ChannelCount> delta;
+            eastl::vector<TargetT*> targets;
+            eastl::vector<size_t> ids;
+
+            inline size_t size() const { return ids.size(); }
+        };
+
+        struct group {
+            math::interpolation::blend_func func = math::interpolation::blend_func::lerp;
+            math::interpolation::blend_opt options;
+            float timeScale = 1.0f;
+            bool isPaused = false;
+
+            track_pool<1, float> scalars;
+            track_pool<3, float3::values> vectors;
+            track_pool<4, colour_t> colours;
+        };
+
+        struct location {
+            group_id_t group = 0;
+            track_kind kind = track_kind::invalid;
+            uint32_t index = 0;
+        };
+
+    private:
+        template <int ChannelCount, typename TargetT>
+        id_t push_track(group_id_t groupID, track_kind kind, track_pool<ChannelCount, TargetT>& pool, TargetT* target, const float* from, const float* to, float duration, uint8_t trackFlags);
+
+        template <int ChannelCount, typename TargetT>
+        void remove_track(track_pool<ChannelCount, TargetT>& pool, size_t index);
+
+        template <int ChannelCount, typename TargetT>
+        void advance_pool(const group& grp, track_pool<ChannelCount, TargetT>& pool, float deltaTime);
+
+        uint8_t& track_flags(const location& loc);
+
+    private:
+        eastl::vector<group> mGroups;
+        eastl::vector<location> mLocations;
+        eastl::vector<size_t> mUnusedIDs;
+
+        // Per-update scratch, reused to avoid allocating every frame
+        eastl::vector<float> mScratchT;
+        eastl::vector<float> mScratchWeights;
+        eastl::vector<id_t> mCompleted;
+
+        completed_observer_t mOnCompleted;
+    };
+}
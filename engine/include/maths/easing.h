@@ -0,0 +1,408 @@
+#pragma once
+
+#include "maths/math.h"
+
+#include <EASTL/span.h>
+
+// Compile-time resolved easing functions.
+//
+// interpolation::interpolate(from, to, t, blend_func, blend_opt) resolves the curve at runtime, which
+// is what data-driven systems need. When the curve is known statically, use the templated form
+// instead, which collapses down to the concrete easing function:
+//
+//     interpolation::interpolate<blend_func::cubic, ease_type::out>(from, to, t);
+//     interpolation::interpolate<blend_func::expo, ease_type::in>(from, to, t, 8.0f);      // power
+//     interpolation::interpolate<blend_func::step>(fromSpan, toSpan, t, outSpan, 4);        // steps
+
+namespace eloo::math::interpolation {
+    namespace ease {
+
+        /////////////////////////////////////////////////////////
+        // Sine
+
+        ELOO_FORCE_INLINE float sine_in(float t) {
+            return 1.0f - cos(t * f32::PI * 0.5f);
+        }
+
+        ELOO_FORCE_INLINE float sine_out(float t) {
+            return sin(t * f32::PI * 0.5f);
+        }
+
+        ELOO_FORCE_INLINE float sine_in_out(float t) {
+            return -(cos(t * f32::PI) - 1.0f) * 0.5f;
+        }
+
+
+        /////////////////////////////////////////////////////////
+        // Quad
+
+        ELOO_FORCE_INLINE constexpr float quad_in(float t) {
+            return t * t;
+        }
+
+        ELOO_FORCE_INLINE constexpr float quad_out(float t) {
+            const float omt = 1.0f - t;
+            return 1.0f - omt * omt;
+        }
+
+        ELOO_FORCE_INLINE constexpr float quad_in_out(float t) {
+            const float omt = 1.0f - t;
+            return t < 0.5f ? 2.0f * t * t : 1.0f - 2.0f * omt * omt;
+        }
+
+
+        /////////////////////////////////////////////////////////
+        // Cubic
+
+        ELOO_FORCE_INLINE constexpr float cubic_in(float t) {
+            return t * t * t;
+        }
+
+        ELOO_FORCE_INLINE constexpr float cubic_out(float t) {
+            const float omt = 1.0f - t;
+            return 1.0f - omt * omt * omt;
+        }
+
+        ELOO_FORCE_INLINE constexpr float cubic_in_out(float t) {
+            const float omt = 1.0f - t;
+            return t < 0.5f ? 4.0f * t * t * t : 1.0f - 4.0f * omt * omt * omt;
+        }
+
+
+        /////////////////////////////////////////////////////////
+        // Quart
+
+        ELOO_FORCE_INLINE constexpr float quart_in(float t) {
+            return t * t * t * t;
+        }
+
+        ELOO_FORCE_INLINE constexpr float quart_out(float t) {
+            const float omt = 1.0f - t;
+            return 1.0f - omt * omt * omt * omt;
+        }
+
+        ELOO_FORCE_INLINE constexpr float quart_in_out(float t) {
+            const float omt = 1.0f - t;
+            return t < 0.5f ? 8.0f * t * t * t * t : 1.0f - 8.0f * omt * omt * omt * omt;
+        }
+
+
+        /////////////////////////////////////////////////////////
+        // Quint
+
+        ELOO_FORCE_INLINE constexpr float quint_in(float t) {
+            return t * t * t * t * t;
+        }
+
+        ELOO_FORCE_INLINE constexpr float quint_out(float t) {
+            const float omt = 1.0f - t;
+            return 1.0f - omt * omt * omt * omt * omt;
+        }
+
+        ELOO_FORCE_INLINE constexpr float quint_in_out(float t) {
+            const float omt = 1.0f - t;
+            return t < 0.5f ? 16.0f * t * t * t * t * t : 1.0f - 16.0f * omt * omt * omt * omt * omt;
+        }
+
+
+        /////////////////////////////////////////////////////////
+        // Circ
+
+        ELOO_FORCE_INLINE float circ_in(float t) {
+            return 1.0f - sqrt(1.0f - t * t);
+        }
+
+        ELOO_FORCE_INLINE float circ_out(float t) {
+            return sqrt(1.0f - (t - 1.0f) * (t - 1.0f));
+        }
+
+        ELOO_FORCE_INLINE float circ_in_out(float t) {
+            t *= 2.0f;
+            return (t < 1.0f ? circ_in(t) : 1.0f + circ_out(t - 1.0f)) * 0.5f;
+        }
+
+
+        /////////////////////////////////////////////////////////
+        // Expo
+
+        ELOO_FORCE_INLINE float expo_in(float t, float power = 10.0f) {
+            return t == 0.0f ? 0.0f : pow(2.0f, power * t - power);
+        }
+
+        ELOO_FORCE_INLINE float expo_out(float t, float power = 10.0f) {
+            return t == 1.0f ? 1.0f : 1.0f - pow(2.0f, -power * t);
+        }
+
+        ELOO_FORCE_INLINE float expo_in_out(float t, float power = 10.0f) {
+            return t < 0.5f ? pow(2.0f * t, power) * 0.5f : 1.0f - pow(2.0f * (1.0f - t), power) * 0.5f;
+        }
+
+
+        /////////////////////////////////////////////////////////
+        // Back
+
+        ELOO_FORCE_INLINE constexpr float back_in(float t, float overshoot = 1.70158f) {
+            const float s3 = overshoot + 1.0f;
+            return s3 * t * t * t - overshoot * t * t;
+        }
+
+        ELOO_FORCE_INLINE constexpr float back_out(float t, float overshoot = 1.70158f) {
+            const float s3 = overshoot + 1.0f;
+            const float tmo = t - 1.0f;
+            return 1.0f + s3 * tmo * tmo * tmo + overshoot * tmo * tmo;
+        }
+
+        ELOO_FORCE_INLINE constexpr float back_in_out(float t, float overshoot = 1.70158f) {
+            t *= 2.0f;
+            const float s = overshoot * 1.525f;
+            return t < 1.0f
+                ? 0.5f * (t * t * ((s + 1.0f) * t - s))
+                : 0.5f * ((t - 2.0f) * (t - 2.0f) * ((s + 1.0f) * (t - 2.0f) + s) + 2.0f);
+        }
+
+
+        /////////////////////////////////////////////////////////
+        // Elastic
+
+        ELOO_FORCE_INLINE float elastic_in(float t) {
+            return -pow(2.0f, 10.0f * (t - 1.0f)) * sin(((t - 0.075f) * f32::TAU) * 3.3333333f);
+        }
+
+        ELOO_FORCE_INLINE float elastic_out(float t) {
+            return 1.0f + pow(2.0f, -10.0f * t) * sin(((t - 0.075f) * f32::TAU) * 3.3333333f);
+        }
+
+        ELOO_FORCE_INLINE float elastic_in_out(float t) {
+            if (t == 0.0f || t == 1.0f) return t;
+            t *= 2.0f;
+            if (t < 1.0f) return -0.5f * pow(2.0f, 10.0f * (t - 1.0f)) * sin(((t - 1.075f) * f32::TAU) * 3.3333333f);
+            return 0.5f + 0.5f * pow(2.0f, -10.0f * (t - 1.0f)) * sin(((t - 1.075f) * f32::TAU) * 3.3333333f);
+        }
+
+
+        /////////////////////////////////////////////////////////
+        // Bounce
+
+        ELOO_FORCE_INLINE constexpr float bounce_out(float t) {
+            constexpr float n1 = 7.5625f;
+            constexpr float d1 = 0.363636f;
+            if (t < d1) { return n1 * t * t; }
+            if (t < d1 * 2.0f) { return n1 * (t - d1 * 1.5f) * (t - d1 * 1.5f) + 0.75f; }
+            if (t < d1 * 2.5f) { return n1 * (t - d1 * 2.25f) * t + 0.9375f; }
+            return n1 * (t - d1 * 2.625f) * t + 0.984375f;
+        }
+
+        ELOO_FORCE_INLINE constexpr float bounce_in(float t) {
+            return 1.0f - bounce_out(1.0f - t);
+        }
+
+        ELOO_FORCE_INLINE constexpr float bounce_in_out(float t) {
+            t *= 2.0f;
+            return (t < 1 ? bounce_in(t) : 1.0f + bounce_out(t - 1.0f)) * 0.5f;
+        }
+
+
+        /////////////////////////////////////////////////////////
+        // Log
+
+        ELOO_FORCE_INLINE float log_in(float t) {
+            return log(1.0f + t * (f32::E - 1.0f));
+        }
+
+        ELOO_FORCE_INLINE float log_out(float t) {
+            return 1.0f - log(1.0f + (1.0f - t) * (f32::E - 1.0f));
+        }
+
+        ELOO_FORCE_INLINE float log_in_out(float t) {
+            t *= 2.0f;
+            return (t < 1 ? log_in(t) : 1.0f + log_out(t - 1.0f)) * 0.5f;
+        }
+
+
+        /////////////////////////////////////////////////////////
+        // Poly
+
+        ELOO_FORCE_INLINE float poly_in(float t, float n) {
+            return pow(t, n);
+        }
+
+        ELOO_FORCE_INLINE float poly_out(float t, float n) {
+            return 1.0f - pow(1.0f - t, n);
+        }
+
+        ELOO_FORCE_INLINE float poly_in_out(float t, float n) {
+            t *= 2.0f;
+            return (t < 1 ? poly_in(t, n) : 1.0f + poly_out(t - 1.0f, n)) * 0.5f;
+        }
+
+
+        /////////////////////////////////////////////////////////
+        // Bezier
+
+        ELOO_FORCE_INLINE constexpr float bezier(float t, float ctrl1 = 0.1f, float ctrl2 = 0.1f) {
+            const float omt = 1.0f - t;
+            return 3.0f * omt * omt * t * ctrl1 + 3.0f * omt * t * t * ctrl2 + t * t * t;
+        }
+
+
+        /////////////////////////////////////////////////////////
+        // Step
+
+        ELOO_FORCE_INLINE float step(float t, unsigned int steps) {
+            return round(t * steps) / static_cast<float>(steps);
+        }
+
+
+        /////////////////////////////////////////////////////////
+        // Spring
+        // https://www.desmos.com/calculator/jr8dd7xjr6
+
+        ELOO_FORCE_INLINE float spring(float t, float frequency = 0.64f, float oscillation = 5.6f, float decay = 1.4f) {
+            return (sin(t * f32::PI * (frequency + oscillation * t * t * t)) * pow(1.0f - t, decay) + t) * (1.0f + (0.8f * pow(1.0f - t, t)));
+        }
+    }
+
+
+    /////////////////////////////////////////////////////////
+    // Compile-time blend selection
+    //
+    // Returns the eased weight for an already saturated t. Curves with parameters forward them
+    // through Params (expo: power, back: overshoot, poly: n, bezier: ctrl1/ctrl2, spring:
+    // frequency/oscillation/decay, step: steps). bezier, spring and step ignore the ease type.
+
+#define ELOO_EASE_SELECT(func, ...) \
+        if constexpr (Ease == ease_type::in)            { return ease::func##_in(__VA_ARGS__); } \
+        else if constexpr (Ease == ease_type::out)      { return ease::func##_out(__VA_ARGS__); } \
+        else                                            { return ease::func##_in_out(__VA_ARGS__); }
+
+    template <blend_func Func, ease_type Ease = ease_type::in, typename... Params>
+    ELOO_FORCE_INLINE constexpr float blend(float t, Params... params) {
+        static_assert(Func != blend_func::_count, "blend_func::_count is not a valid blend function");
+        static_assert(Func != blend_func::poly || sizeof...(Params) == 1, "blend_func::poly requires the exponent 'n' to be passed in");
+        static_assert(Func != blend_func::step || sizeof...(Params) == 1, "blend_func::step requires the step count to be passed in");
+
+        if constexpr (Func == blend_func::lerp)         { return t; }
+        else if constexpr (Func == blend_func::sine)    { ELOO_EASE_SELECT(sine, t) }
+        else if constexpr (Func == blend_func::quad)    { ELOO_EASE_SELECT(quad, t) }
+        else if constexpr (Func == blend_func::cubic)   { ELOO_EASE_SELECT(cubic, t) }
+        else if constexpr (Func == blend_func::quart)   { ELOO_EASE_SELECT(quart, t) }
+        else if constexpr (Func == blend_func::quint)   { ELOO_EASE_SELECT(quint, t) }
+        else if constexpr (Func == blend_func::circ)    { ELOO_EASE_SELECT(circ, t) }
+        else if constexpr (Func == blend_func::elastic) { ELOO_EASE_SELECT(elastic, t) }
+        else if constexpr (Func == blend_func::bounce)  { ELOO_EASE_SELECT(bounce, t) }
+        else if constexpr (Func == blend_func::log)     { ELOO_EASE_SELECT(log, t) }
+        else if constexpr (Func == blend_func::expo)    { ELOO_EASE_SELECT(expo, t, static_cast<float>(params)...) }
+        else if constexpr (Func == blend_func::back)    { ELOO_EASE_SELECT(back, t, static_cast<float>(params)...) }
+        else if constexpr (Func == blend_func::poly)    { ELOO_EASE_SELECT(poly, t, static_cast<float>(params)...) }
+        else if constexpr (Func == blend_func::bezier)  { return ease::bezier(t, static_cast<float>(params)...); }
+        else if constexpr (Func == blend_func::spring)  { return ease::spring(t, static_cast<float>(params)...); }
+        else                                            { return ease::step(t, static_cast<unsigned int>(params)...); }
+    }
+
+#undef ELOO_EASE_SELECT
+
+
+    /////////////////////////////////////////////////////////
+    // Apply an eased weight (not clamped, so overshooting curves are preserved)
+
+    ELOO_FORCE_INLINE constexpr float apply_weight(float from, float to, float w) {
+        return from + (to - from) * w;
+    }
+
+    ELOO_FORCE_INLINE float2_v apply_weight(const float2_v& from, const float2_v& to, float w) {
+        return {
+            from.x() + (to.x() - from.x()) * w,
+            from.y() + (to.y() - from.y()) * w
+        };
+    }
+
+    ELOO_FORCE_INLINE float3_v apply_weight(const float3_v& from, const float3_v& to, float w) {
+        return {
+            from.x() + (to.x() - from.x()) * w,
+            from.y() + (to.y() - from.y()) * w,
+            from.z() + (to.z() - from.z()) * w
+        };
+    }
+
+    ELOO_FORCE_INLINE float4_v apply_weight(const float4_v& from, const float4_v& to, float w) {
+        return {
+            from.x() + (to.x() - from.x()) * w,
+            from.y() + (to.y() - from.y()) * w,
+            from.z() + (to.z() - from.z()) * w,
+            from.w() + (to.w() - from.w()) * w
+        };
+    }
+
+
+    /////////////////////////////////////////////////////////
+    // Interpolation between two values
+
+    template <blend_func Func, ease_type Ease = ease_type::in, typename... Params>
+    ELOO_FORCE_INLINE constexpr float interpolate(float from, float to, float t, Params... params) {
+        return apply_weight(from, to, blend<Func, Ease>(saturate(t), params...));
+    }
+
+    template <blend_func Func, ease_type Ease = ease_type::in, typename... Params>
+    ELOO_FORCE_INLINE float2_v interpolate(const float2_v& from, const float2_v& to, float t, Params... params) {
+        return apply_weight(from, to, blend<Func, Ease>(saturate(t), params...));
+    }
+
+    template <blend_func Func, ease_type Ease = ease_type::in, typename... Params>
+    ELOO_FORCE_INLINE float3_v interpolate(const float3_v& from, const float3_v& to, float t, Params... params) {
+        return apply_weight(from, to, blend<Func, Ease>(saturate(t), params...));
+    }
+
+    template <blend_func Func, ease_type Ease = ease_type::in, typename... Params>
+    ELOO_FORCE_INLINE float4_v interpolate(const float4_v& from, const float4_v& to, float t, Params... params) {
+        return apply_weight(from, to, blend<Func, Ease>(saturate(t), params...));
+    }
+
+
+    /////////////////////////////////////////////////////////
+    // Batch interpolation
+    //
+    // Writes out[i] = interpolate(from[i], to[i], t) for every element. The shared t overloads only
+    // evaluate the curve once; the per-element t overloads evaluate it per element with no dispatch.
+
+    template <blend_func Func, ease_type Ease = ease_type::in, typename T, typename... Params>
+    requires eastl::is_same_v<T, float> || float2::storage_t<T> || float3::storage_t<T> || float4::storage_t<T>
+    inline void interpolate(eastl::span<const eastl::type_identity_t<T>> from, eastl::span<const eastl::type_identity_t<T>> to, float t, eastl::span<T> out, Params... params) {
+        ELOO_ASSERT(from.size() == to.size() && from.size() == out.size(), "Batch interpolation requires equally sized spans.");
+        const float w = blend<Func, Ease>(saturate(t), params...);
+        for (size_t i = 0; i < out.size(); ++i) {
+            out[i] = apply_weight(from[i], to[i], w);
+        }
+    }
+
+    template <blend_func Func, ease_type Ease = ease_type::in, typename T, typename... Params>
+    requires eastl::is_same_v<T, float> || float2::storage_t<T> || float3::storage_t<T> || float4::storage_t<T>
+    inline void interpolate(eastl::span<const eastl::type_identity_t<T>> from, eastl::span<const eastl::type_identity_t<T>> to, eastl::span<const float> t, eastl::span<T> out, Params... params) {
+        ELOO_ASSERT(from.size() == to.size() && from.size() == t.size() && from.size() == out.size(), "Batch interpolation requires equally sized spans.");
+        for (size_t i = 0; i < out.size(); ++i) {
+            out[i] = apply_weight(from[i], to[i], blend<Func, Ease>(saturate(t[i]), params...));
+        }
+    }
+
+
+    /////////////////////////////////////////////////////////
+    // Batch blend weights
+    //
+    // Writes the eased weight for every t (saturated first), without applying it to any values.
+
+    template <blend_func Func, ease_type Ease = ease_type::in, typename... Params>
+    inline void blend(eastl::span<const float> t, eastl::span<float> out, Params... params) {
+        ELOO_ASSERT(t.size() == out.size(), "Batch blend requires equally sized spans.");
+        for (size_t i = 0; i < out.size(); ++i) {
+            out[i] = blend<Func, Ease>(saturate(t[i]), params...);
+        }
+    }
+
+
+    /////////////////////////////////////////////////////////
+    // Runtime dispatched batch blend/interpolation
+    //
+    // Resolves the blend_func/ease_type once per call, then runs the compile-time kernel over the span.
+
+    void blend(eastl::span<const float> t, eastl::span<float> out, blend_func type, blend_opt options = eastl::monostate{});
+    void interpolate(eastl::span<const float> from, eastl::span<const float> to, eastl::span<const float> t, eastl::span<float> out, blend_func type, blend_opt options = eastl::monostate{});
+}
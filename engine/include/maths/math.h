@@ -435,6 +435,14 @@ namespace eloo::math {
     ELOO_FORCE_INLINE constexpr T acos(T rads) { return std::acos(rads); }
     DECLARE_CONSTEXPR_FUNC_FOR_FLOAT16(acos);
 
+    // Abramowitz & Stegun 4.4.45, max error ~7e-5 radians
+    ELOO_FORCE_INLINE float fast_acos(float v) {
+        const float x = std::fabs(v);
+        const float poly = 1.5707288f + x * (-0.2121144f + x * (0.0742610f - 0.0187293f * x));
+        const float result = std::sqrt(1.0f - x) * poly;
+        return v < 0.0f ? f32::PI - result : result;
+    }
+
     template <is_floating_t T>
     ELOO_FORCE_INLINE constexpr T atan(T rads) { return std::atan(rads); }
     DECLARE_CONSTEXPR_FUNC_FOR_FLOAT16(atan);
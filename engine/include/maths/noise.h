@@ -0,0 +1,71 @@
+#pragma once
+
+#include "utility/defines.h"
+
+#include "maths/random.h"
+
+#include "datatypes/float2.h"
+#include "datatypes/float3.h"
+
+#include <EASTL/span.h>
+
+// Coherent noise
+//
+// Value, gradient (Perlin), simplex and cellular (Worley F1) noise in 2, 3 and 4 dimensions, with
+// optional fBm/ridged octave summing. Every noise is written once over a lane abstraction, so
+// single samples run the scalar instantiation and the batch/grid calls run 4 points per
+// step through simd.h. Grids and large batches are split into tiles across the worker pool.
+//
+// The generator is keyed by a 64 bit seed (the same seeds the random generators take), and the
+// output is a pure function of seed, settings and position. All noise types and fractal modes
+// return values in roughly [-1, 1].
+
+namespace eloo::math::noise {
+    enum class type {
+        value,
+        perlin,
+        simplex,
+        worley
+    };
+
+    enum class fractal {
+        none,
+        fbm,
+        ridged
+    };
+
+    struct settings {
+        type kind = type::simplex;
+        fractal mode = fractal::none;
+        uint32_t octaves = 4;       // Ignored when mode is none
+        float frequency = 1.0f;
+        float lacunarity = 2.0f;    // Frequency multiplier per octave
+        float gain = 0.5f;          // Amplitude multiplier per octave
+    };
+
+    class generator {
+    public:
+        explicit generator(uint64_t seed = random::DEFAULT_SEED, const settings& config = {});
+
+        inline const settings& get_settings() const { return mSettings; }
+        inline void set_settings(const settings& config) { mSettings = config; }
+
+        float sample(float x, float y) const;
+        float sample(float x, float y, float z) const;
+        float sample(float x, float y, float z, float w) const;
+
+        // SoA point sets. All spans must be the same length
+        void sample(eastl::span<const float> x, eastl::span<const float> y, eastl::span<float> out) const;
+        void sample(eastl::span<const float> x, eastl::span<const float> y, eastl::span<const float> z, eastl::span<float> out) const;
+        void sample(eastl::span<const float> x, eastl::span<const float> y, eastl::span<const float> z, eastl::span<const float> w, eastl::span<float> out) const;
+
+        // Regular grids, written row-major (x fastest, then y, then z) into 'out', which must hold
+        // every sample. Point (i, j, k) is at origin + (i, j, k) * step
+        void sample_grid(const float2::values& origin, const float2::values& step, uint32_t width, uint32_t height, eastl::span<float> out) const;
+        void sample_grid(const float3::values& origin, const float3::values& step, uint32_t width, uint32_t height, uint32_t depth, eastl::span<float> out) const;
+
+    private:
+        settings mSettings;
+        uint32_t mSeed;
+    };
+}
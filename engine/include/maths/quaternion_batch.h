@@ -0,0 +1,55 @@
+#pragma once
+
+#include "utility/defines.h"
+
+#include "datatypes/quaternion.h"
+#include "datatypes/matrix3x3.h"
+#include "datatypes/matrix4x4.h"
+
+#include <EASTL/span.h>
+
+// Batch quaternion kernels
+//
+// The kernels work on SoA component streams, four quaternions at a time, with a scalar tail for
+// the remainder. AoS overloads are provided for convenience, but they pay for a transpose on the
+// way in and out, so animation code that blends every frame should keep its rotations in SoA.
+//
+// Interpolation parameters are taken as-is; apply any easing with interpolation::blend() over
+// the parameter span first.
+
+namespace eloo::math::quaternion {
+    struct soa_span {
+        eastl::span<float> x, y, z, w;
+        inline size_t size() const { return x.size(); }
+    };
+
+    struct soa_const_span {
+        eastl::span<const float> x, y, z, w;
+        inline size_t size() const { return x.size(); }
+    };
+
+    /////////////////////////////////////////////////////////////////////
+    // Interpolation
+    //
+    // Both take the shortest path, flipping 'to' where the quaternions are in opposite hemispheres.
+    // nlerp is a normalised lerp, which is cheaper but does not move at constant angular velocity.
+    // slerp uses a polynomial acos/sin and renormalises the result, and falls back to nlerp when
+    // the quaternions are nearly parallel.
+
+    void nlerp(const soa_const_span& from, const soa_const_span& to, eastl::span<const float> t, const soa_span& out);
+    void nlerp(const soa_const_span& from, const soa_const_span& to, float t, const soa_span& out);
+    void nlerp(eastl::span<const quaternion_v> from, eastl::span<const quaternion_v> to, eastl::span<const float> t, eastl::span<quaternion_v> out);
+
+    void slerp(const soa_const_span& from, const soa_const_span& to, eastl::span<const float> t, const soa_span& out);
+    void slerp(const soa_const_span& from, const soa_const_span& to, float t, const soa_span& out);
+    void slerp(eastl::span<const quaternion_v> from, eastl::span<const quaternion_v> to, eastl::span<const float> t, eastl::span<quaternion_v> out);
+
+
+    /////////////////////////////////////////////////////////////////////
+    // Conversion to rotation matrices (expects unit quaternions)
+
+    void to_matrix(const soa_const_span& q, eastl::span<matrix3x3_v> out);
+    void to_matrix(const soa_const_span& q, eastl::span<matrix4x4_v> out);
+    void to_matrix(eastl::span<const quaternion_v> q, eastl::span<matrix3x3_v> out);
+    void to_matrix(eastl::span<const quaternion_v> q, eastl::span<matrix4x4_v> out);
+}
@@ -1,22 +1,103 @@
 #pragma once
 
-#include <random>
-#include <chrono>
+#include "utility/defines.h"
 
-#define NUMERIC_TEMPLATE template<typename T> inline eastl::enable_if<eastl::is_arithmetic<T>::value, T>::type
+#include <EASTL/span.h>
+#include <EASTL/type_traits.h>
 
-namespace eloo::Maths::Random {
-namespace {
-unsigned int gSeed = static_cast<unsigned int>(std::chrono::system_clock::now().time_since_epoch().count());
-std::mt19937 gRandomGenerator(gSeed);
+#include <cstdint>
+
+// Random number generation
+//
+// Built on xoshiro256++, which has 32 bytes of state, passes BigCrush, and supports jumping
+// ahead by 2^128 / 2^192 steps to carve out streams that are guaranteed not to overlap.
+//
+// There is no global generator. Code that needs reproducible results should own a generator (or
+// create one per job with create_stream), everything else can use thread_generator(), which is
+// lazily created per thread from the base seed, a long jump apart for each thread.
+
+namespace eloo::math::random {
+    inline constexpr uint64_t DEFAULT_SEED = 0x853C49E6748FEA9Bull;
+
+    class generator {
+    public:
+        // Satisfies UniformRandomBitGenerator, so std/eastl algorithms can use it directly
+        using result_type = uint64_t;
+        static constexpr result_type min() { return 0; }
+        static constexpr result_type max() { return UINT64_MAX; }
+
+    public:
+        explicit generator(uint64_t seed = DEFAULT_SEED);
+
+        // The state is expanded from the seed with SplitMix64, so nearby seeds are uncorrelated
+        void seed(uint64_t seed);
+
+        uint64_t next();
+        inline result_type operator () () { return next(); }
+
+        // Equivalent to 2^128 calls to next(). Use to hand out up to 2^128 parallel streams
+        void jump();
+        // Equivalent to 2^192 calls to next(). Use to hand out streams that will themselves be jumped
+        void long_jump();
+
+        uint32_t next_u32();
+        float uniform();                                // [0, 1)
+        double uniform_double();                        // [0, 1)
+        float range(float minVal, float maxVal);        // [minVal, maxVal)
+        int32_t range(int32_t minVal, int32_t maxVal);  // [minVal, maxVal], unbiased
+        bool boolean(float trueChance = 0.5f);
+        float gaussian(float mean = 0.0f, float dev = 1.0f);
+
+        // Bulk generation, 8 values per step across 4 interleaved streams. The streams are seeded
+        // from this generator, so output is deterministic for a given state and advances it by
+        // a fixed amount regardless of the span size
+        void fill_uniform(eastl::span<float> out);
+        void fill_range(eastl::span<float> out, float minVal, float maxVal);
+        void fill_bits(eastl::span<uint32_t> out);
+
+    private:
+        uint64_t mState[4];
+    };
+
+    // Returns a generator positioned 'streamIndex' jumps along from 'seed'. Handing each job its
+    // own stream index gives reproducible results however the jobs are scheduled
+    generator create_stream(uint64_t seed, uint32_t streamIndex);
+
+    // Base seed used for thread generators created after the call. Also reseeds the calling
+    // thread's generator so single threaded code gets a reproducible sequence straight away
+    void set_seed(uint64_t seed);
+    uint64_t get_seed();
+
+    generator& thread_generator();
+
+
+    /////////////////////////////////////////////////////////////////////
+    // Convenience wrappers over the calling thread's generator
+
+    inline float value()                                        { return thread_generator().uniform(); }
+    inline float range(float minVal, float maxVal)              { return thread_generator().range(minVal, maxVal); }
+    inline int32_t range(int32_t minVal, int32_t maxVal)        { return thread_generator().range(minVal, maxVal); }
+    inline bool boolean(float trueChance = 0.5f)                { return thread_generator().boolean(trueChance); }
+    inline float gaussian(float mean = 0.0f, float dev = 1.0f)  { return thread_generator().gaussian(mean, dev); }
 }
 
-inline void setSeed(unsigned int seed)          { gRandomGenerator.seed(seed); gSeed = seed; }
-inline unsigned int getSeed()                   { return gSeed; }
 
-NUMERIC_TEMPLATE value()                        { return std::uniform_real<T>()(gRandomGenerator); }
-NUMERIC_TEMPLATE range(T minVal, T maxVal)      { return std::uniform_real_distribution<T>(minVal, maxVal)(gRandomGenerator); }
-NUMERIC_TEMPLATE gaussian(T mean, T dev)        { return std::normal_distribution<T>(mean, dev)(gRandomGenerator); }
-inline double range01()                         { return range(0.0, 1.0); }
-inline bool boolean(double trueChance = 0.5)    { return std::bernoulli_distribution(trueChance)(gRandomGenerator); }
-}
\ No newline at end of file
+// Legacy interface, now forwarding to the calling thread's generator
+#define NUMERIC_TEMPLATE template<typename T> inline typename eastl::enable_if<eastl::is_arithmetic<T>::value, T>::type
+
+namespace eloo::Maths::Random {
+inline void setSeed(unsigned int seed)          { math::random::set_seed(seed); }
+inline unsigned int getSeed()                   { return static_cast<unsigned int>(math::random::get_seed()); }
+
+NUMERIC_TEMPLATE value()                        { return static_cast<T>(math::random::thread_generator().uniform_double()); }
+NUMERIC_TEMPLATE range(T minVal, T maxVal) {
+    if constexpr (eastl::is_integral_v<T>) {
+        return static_cast<T>(math::random::thread_generator().range(static_cast<int32_t>(minVal), static_cast<int32_t>(maxVal)));
+    } else {
+        return static_cast<T>(minVal + (maxVal - minVal) * math::random::thread_generator().uniform_double());
+    }
+}
+NUMERIC_TEMPLATE gaussian(T mean, T dev)        { return static_cast<T>(math::random::thread_generator().gaussian(static_cast<float>(mean), static_cast<float>(dev))); }
+inline double range01()                         { return math::random::thread_generator().uniform_double(); }
+inline bool boolean(double trueChance = 0.5)    { return math::random::thread_generator().boolean(static_cast<float>(trueChance)); }
+}
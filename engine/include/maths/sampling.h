@@ -0,0 +1,76 @@
+#pragma once
+
+#include "utility/defines.h"
+
+#include "maths/random.h"
+
+#include "datatypes/float2.h"
+#include "datatypes/float3.h"
+
+#include <EASTL/span.h>
+#include <EASTL/vector.h>
+
+// Distribution samplers
+//
+// All samplers draw from an explicit generator so they can be used with per-job streams. The
+// batch variants pull their uniforms through the generator's bulk fill and then transform them,
+// which is considerably cheaper than sampling element by element.
+
+namespace eloo::math::random {
+
+    /////////////////////////////////////////////////////////////////////
+    // Normal distribution (Marsaglia & Tsang ziggurat, 128 layers)
+
+    float normal(generator& gen);
+    inline float normal(generator& gen, float mean, float dev) { return mean + dev * normal(gen); }
+    void fill_normal(generator& gen, eastl::span<float> out, float mean = 0.0f, float dev = 1.0f);
+
+
+    /////////////////////////////////////////////////////////////////////
+    // Weighted discrete picks (Vose alias method)
+    //
+    // Building is O(n), sampling is O(1) regardless of how skewed the weights are. Weights do not
+    // need to be normalised, but must be non-negative with a positive total.
+
+    class alias_table {
+    public:
+        explicit alias_table(eastl::span<const float> weights);
+
+        inline size_t size() const { return mProbability.size(); }
+
+        uint32_t sample(generator& gen) const;
+        void sample(generator& gen, eastl::span<uint32_t> out) const;
+
+    private:
+        uint32_t pick(uint32_t bucketBits, uint32_t coinBits) const;
+
+    private:
+        eastl::vector<float> mProbability;
+        eastl::vector<uint32_t> mAlias;
+    };
+
+
+    /////////////////////////////////////////////////////////////////////
+    // Geometric samplers
+    //
+    // 'on' samples the surface/edge, 'in' samples the volume/area, both uniformly. Disks and
+    // circles without a normal lie in the XY plane, otherwise they are oriented around the normal.
+    // Cone samples are unit directions within 'halfAngle' radians of 'direction'. Normals and cone
+    // directions are normalised here, so they only need to be non-zero.
+
+    float3::values on_sphere(generator& gen, float radius = 1.0f);
+    float3::values in_sphere(generator& gen, float radius = 1.0f);
+    float2::values on_circle(generator& gen, float radius = 1.0f);
+    float2::values in_disk(generator& gen, float radius = 1.0f);
+    float3::values on_circle(generator& gen, const float3::values& normal, float radius = 1.0f);
+    float3::values in_disk(generator& gen, const float3::values& normal, float radius = 1.0f);
+    float3::values in_cone(generator& gen, const float3::values& direction, float halfAngle);
+
+    void on_sphere(generator& gen, eastl::span<float3::values> out, float radius = 1.0f);
+    void in_sphere(generator& gen, eastl::span<float3::values> out, float radius = 1.0f);
+    void on_circle(generator& gen, eastl::span<float2::values> out, float radius = 1.0f);
+    void in_disk(generator& gen, eastl::span<float2::values> out, float radius = 1.0f);
+    void on_circle(generator& gen, const float3::values& normal, eastl::span<float3::values> out, float radius = 1.0f);
+    void in_disk(generator& gen, const float3::values& normal, eastl::span<float3::values> out, float radius = 1.0f);
+    void in_cone(generator& gen, const float3::values& direction, float halfAngle, eastl::span<float3::values> out);
+}
@@ -0,0 +1,391 @@
+#pragma once
+
+#include "utility/defines.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+// Thin 4-wide float/int wrappers used by the batch kernels
+//
+// Maps onto SSE2 when it is available (always the case on x64), otherwise falls back to plain
+// arrays so the kernels still compile everywhere. Loads and stores
+// are unaligned, since the kernels operate on spans handed in by the caller. Define
+// ELOO_SIMD_DISABLED to force the scalar fallback.
+
+#if !defined(ELOO_SIMD_DISABLED) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define ELOO_SIMD_SSE2 1
+#include <emmintrin.h>
+#if defined(__SSE4_1__)
+#include <smmintrin.h>
+#endif
+#else
+#define ELOO_SIMD_SSE2 0
+#endif
+
+namespace eloo::math::simd {
+    inline constexpr int WIDTH = 4;
+
+#if ELOO_SIMD_SSE2
+    struct f32x4 {
+        __m128 v;
+    };
+
+    ELOO_FORCE_INLINE f32x4 load(const float* p)                        { return { _mm_loadu_ps(p) }; }
+    ELOO_FORCE_INLINE void store(float* p, f32x4 a)                     { _mm_storeu_ps(p, a.v); }
+    ELOO_FORCE_INLINE f32x4 set1(float s)                               { return { _mm_set1_ps(s) }; }
+    ELOO_FORCE_INLINE f32x4 set(float x, float y, float z, float w)     { return { _mm_setr_ps(x, y, z, w) }; }
+    ELOO_FORCE_INLINE f32x4 zero()                                      { return { _mm_setzero_ps() }; }
+
+    ELOO_FORCE_INLINE f32x4 operator + (f32x4 a, f32x4 b)               { return { _mm_add_ps(a.v, b.v) }; }
+    ELOO_FORCE_INLINE f32x4 operator - (f32x4 a, f32x4 b)               { return { _mm_sub_ps(a.v, b.v) }; }
+    ELOO_FORCE_INLINE f32x4 operator * (f32x4 a, f32x4 b)               { return { _mm_mul_ps(a.v, b.v) }; }
+    ELOO_FORCE_INLINE f32x4 operator / (f32x4 a, f32x4 b)               { return { _mm_div_ps(a.v, b.v) }; }
+    ELOO_FORCE_INLINE f32x4 operator - (f32x4 a)                        { return { _mm_xor_ps(a.v, _mm_set1_ps(-0.0f)) }; }
+
+    ELOO_FORCE_INLINE f32x4 min(f32x4 a, f32x4 b)                       { return { _mm_min_ps(a.v, b.v) }; }
+    ELOO_FORCE_INLINE f32x4 max(f32x4 a, f32x4 b)                       { return { _mm_max_ps(a.v, b.v) }; }
+    ELOO_FORCE_INLINE f32x4 abs(f32x4 a)                                { return { _mm_andnot_ps(_mm_set1_ps(-0.0f), a.v) }; }
+    ELOO_FORCE_INLINE f32x4 sqrt(f32x4 a)                               { return { _mm_sqrt_ps(a.v) }; }
+
+    // Comparisons return all-ones lanes where true, for use with select()
+    ELOO_FORCE_INLINE f32x4 cmp_eq(f32x4 a, f32x4 b)                    { return { _mm_cmpeq_ps(a.v, b.v) }; }
+    ELOO_FORCE_INLINE f32x4 cmp_lt(f32x4 a, f32x4 b)                    { return { _mm_cmplt_ps(a.v, b.v) }; }
+    ELOO_FORCE_INLINE f32x4 cmp_le(f32x4 a, f32x4 b)                    { return { _mm_cmple_ps(a.v, b.v) }; }
+    ELOO_FORCE_INLINE f32x4 cmp_gt(f32x4 a, f32x4 b)                    { return { _mm_cmpgt_ps(a.v, b.v) }; }
+    ELOO_FORCE_INLINE f32x4 cmp_ge(f32x4 a, f32x4 b)                    { return { _mm_cmpge_ps(a.v, b.v) }; }
+
+    ELOO_FORCE_INLINE f32x4 bit_and(f32x4 a, f32x4 b)                   { return { _mm_and_ps(a.v, b.v) }; }
+    ELOO_FORCE_INLINE f32x4 bit_or(f32x4 a, f32x4 b)                    { return { _mm_or_ps(a.v, b.v) }; }
+    ELOO_FORCE_INLINE f32x4 bit_xor(f32x4 a, f32x4 b)                   { return { _mm_xor_ps(a.v, b.v) }; }
+
+    // Picks 'a' where the mask is set, otherwise 'b'
+    ELOO_FORCE_INLINE f32x4 select(f32x4 mask, f32x4 a, f32x4 b)        { return { _mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v)) }; }
+
+    // One bit per lane, lane 0 in the lowest bit
+    ELOO_FORCE_INLINE int movemask(f32x4 mask)                          { return _mm_movemask_ps(mask.v); }
+
+    // Copies the sign bit of 'sign' onto 'a'
+    ELOO_FORCE_INLINE f32x4 sign_from(f32x4 sign, f32x4 a) {
+        const __m128 signBit = _mm_set1_ps(-0.0f);
+        return { _mm_or_ps(_mm_andnot_ps(signBit, a.v), _mm_and_ps(signBit, sign.v)) };
+    }
+
+    // Reciprocal square root estimate with one Newton-Raphson step (~22 bits)
+    ELOO_FORCE_INLINE f32x4 rsqrt(f32x4 a) {
+        const __m128 estimate = _mm_rsqrt_ps(a.v);
+        const __m128 halfA = _mm_mul_ps(a.v, _mm_set1_ps(0.5f));
+        const __m128 refine = _mm_sub_ps(_mm_set1_ps(1.5f), _mm_mul_ps(halfA, _mm_mul_ps(estimate, estimate)));
+        return { _mm_mul_ps(estimate, refine) };
+    }
+
+    /////////////////////////////////////////////////////////////////////
+    // 32 bit integer lanes. Arithmetic wraps, shifts are logical
+
+    struct i32x4 {
+        __m128i v;
+    };
+
+    ELOO_FORCE_INLINE i32x4 load_i32(const int32_t* p)                 { return { _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)) }; }
+    ELOO_FORCE_INLINE void store_i32(int32_t* p, i32x4 a)               { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), a.v); }
+    ELOO_FORCE_INLINE i32x4 set1_i32(int32_t s)                         { return { _mm_set1_epi32(s) }; }
+    // Zero extends four consecutive 16 bit values
+    ELOO_FORCE_INLINE i32x4 load_u16(const uint16_t* p)                { return { _mm_unpacklo_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)), _mm_setzero_si128()) }; }
+
+    ELOO_FORCE_INLINE i32x4 operator + (i32x4 a, i32x4 b)               { return { _mm_add_epi32(a.v, b.v) }; }
+    ELOO_FORCE_INLINE i32x4 operator - (i32x4 a, i32x4 b)               { return { _mm_sub_epi32(a.v, b.v) }; }
+    ELOO_FORCE_INLINE i32x4 operator & (i32x4 a, i32x4 b)               { return { _mm_and_si128(a.v, b.v) }; }
+    ELOO_FORCE_INLINE i32x4 operator | (i32x4 a, i32x4 b)               { return { _mm_or_si128(a.v, b.v) }; }
+    ELOO_FORCE_INLINE i32x4 operator ^ (i32x4 a, i32x4 b)               { return { _mm_xor_si128(a.v, b.v) }; }
+    ELOO_FORCE_INLINE i32x4 operator << (i32x4 a, int count)            { return { _mm_sll_epi32(a.v, _mm_cvtsi32_si128(count)) }; }
+    ELOO_FORCE_INLINE i32x4 operator >> (i32x4 a, int count)            { return { _mm_srl_epi32(a.v, _mm_cvtsi32_si128(count)) }; }
+
+    ELOO_FORCE_INLINE i32x4 operator * (i32x4 a, i32x4 b) {
+#if defined(__SSE4_1__)
+        return { _mm_mullo_epi32(a.v, b.v) };
+#else
+        // SSE2 only multiplies even lanes into 64 bits, so do both halves and interleave the low words
+        const __m128i even = _mm_mul_epu32(a.v, b.v);
+        const __m128i odd = _mm_mul_epu32(_mm_srli_si128(a.v, 4), _mm_srli_si128(b.v, 4));
+        return { _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0))) };
+#endif
+    }
+
+    ELOO_FORCE_INLINE i32x4 cmp_eq(i32x4 a, i32x4 b)                    { return { _mm_cmpeq_epi32(a.v, b.v) }; }
+    ELOO_FORCE_INLINE i32x4 cmp_lt(i32x4 a, i32x4 b)                    { return { _mm_cmplt_epi32(a.v, b.v) }; }
+    ELOO_FORCE_INLINE i32x4 cmp_gt(i32x4 a, i32x4 b)                    { return { _mm_cmpgt_epi32(a.v, b.v) }; }
+
+    // Conversions truncate towards zero, casts reinterpret the bits
+    ELOO_FORCE_INLINE i32x4 to_i32(f32x4 a)                             { return { _mm_cvttps_epi32(a.v) }; }
+    ELOO_FORCE_INLINE f32x4 to_f32(i32x4 a)                             { return { _mm_cvtepi32_ps(a.v) }; }
+    ELOO_FORCE_INLINE i32x4 as_i32(f32x4 a)                             { return { _mm_castps_si128(a.v) }; }
+    ELOO_FORCE_INLINE f32x4 as_f32(i32x4 a)                             { return { _mm_castsi128_ps(a.v) }; }
+#else
+    struct f32x4 {
+        float v[4];
+    };
+
+    namespace detail {
+        ELOO_FORCE_INLINE uint32_t lane_bits(float lane) {
+            uint32_t bits;
+            std::memcpy(&bits, &lane, sizeof(bits));
+            return bits;
+        }
+
+        ELOO_FORCE_INLINE float bits_lane(uint32_t bits) {
+            float lane;
+            std::memcpy(&lane, &bits, sizeof(lane));
+            return lane;
+        }
+
+        ELOO_FORCE_INLINE float mask_lane(bool set) {
+            return bits_lane(set ? 0xFFFFFFFFu : 0u);
+        }
+
+        template <typename Fn>
+        ELOO_FORCE_INLINE f32x4 per_lane(f32x4 a, f32x4 b, Fn fn) {
+            f32x4 result;
+            for (int i = 0; i < 4; ++i) {
+                result.v[i] = fn(a.v[i], b.v[i]);
+            }
+            return result;
+        }
+    }
+
+    ELOO_FORCE_INLINE f32x4 load(const float* p)                        { return { { p[0], p[1], p[2], p[3] } }; }
+    ELOO_FORCE_INLINE void store(float* p, f32x4 a)                     { std::memcpy(p, a.v, sizeof(a.v)); }
+    ELOO_FORCE_INLINE f32x4 set1(float s)                               { return { { s, s, s, s } }; }
+    ELOO_FORCE_INLINE f32x4 set(float x, float y, float z, float w)     { return { { x, y, z, w } }; }
+    ELOO_FORCE_INLINE f32x4 zero()                                      { return set1(0.0f); }
+
+    ELOO_FORCE_INLINE f32x4 operator + (f32x4 a, f32x4 b)               { return detail::per_lane(a, b, [](float x, float y) { return x + y; }); }
+    ELOO_FORCE_INLINE f32x4 operator - (f32x4 a, f32x4 b)               { return detail::per_lane(a, b, [](float x, float y) { return x - y; }); }
+    ELOO_FORCE_INLINE f32x4 operator * (f32x4 a, f32x4 b)               { return detail::per_lane(a, b, [](float x, float y) { return x * y; }); }
+    ELOO_FORCE_INLINE f32x4 operator / (f32x4 a, f32x4 b)               { return detail::per_lane(a, b, [](float x, float y) { return x / y; }); }
+    ELOO_FORCE_INLINE f32x4 operator - (f32x4 a)                        { return detail::per_lane(a, a, [](float x, float) { return -x; }); }
+
+    // Like minps/maxps, the second operand is returned when either is NaN
+    ELOO_FORCE_INLINE f32x4 min(f32x4 a, f32x4 b)                       { return detail::per_lane(a, b, [](float x, float y) { return x < y ? x : y; }); }
+    ELOO_FORCE_INLINE f32x4 max(f32x4 a, f32x4 b)                       { return detail::per_lane(a, b, [](float x, float y) { return x > y ? x : y; }); }
+    ELOO_FORCE_INLINE f32x4 abs(f32x4 a)                                { return detail::per_lane(a, a, [](float x, float) { return std::fabs(x); }); }
+    ELOO_FORCE_INLINE f32x4 sqrt(f32x4 a)                               { return detail::per_lane(a, a, [](float x, float) { return std::sqrt(x); }); }
+    ELOO_FORCE_INLINE f32x4 rsqrt(f32x4 a)                              { return detail::per_lane(a, a, [](float x, float) { return 1.0f / std::sqrt(x); }); }
+
+    ELOO_FORCE_INLINE f32x4 cmp_eq(f32x4 a, f32x4 b)                    { return detail::per_lane(a, b, [](float x, float y) { return detail::mask_lane(x == y); }); }
+    ELOO_FORCE_INLINE f32x4 cmp_lt(f32x4 a, f32x4 b)                    { return detail::per_lane(a, b, [](float x, float y) { return detail::mask_lane(x < y); }); }
+    ELOO_FORCE_INLINE f32x4 cmp_le(f32x4 a, f32x4 b)                    { return detail::per_lane(a, b, [](float x, float y) { return detail::mask_lane(x <= y); }); }
+    ELOO_FORCE_INLINE f32x4 cmp_gt(f32x4 a, f32x4 b)                    { return detail::per_lane(a, b, [](float x, float y) { return detail::mask_lane(x > y); }); }
+    ELOO_FORCE_INLINE f32x4 cmp_ge(f32x4 a, f32x4 b)                    { return detail::per_lane(a, b, [](float x, float y) { return detail::mask_lane(x >= y); }); }
+
+    ELOO_FORCE_INLINE f32x4 bit_and(f32x4 a, f32x4 b)                   { return detail::per_lane(a, b, [](float x, float y) { return detail::bits_lane(detail::lane_bits(x) & detail::lane_bits(y)); }); }
+    ELOO_FORCE_INLINE f32x4 bit_or(f32x4 a, f32x4 b)                    { return detail::per_lane(a, b, [](float x, float y) { return detail::bits_lane(detail::lane_bits(x) | detail::lane_bits(y)); }); }
+    ELOO_FORCE_INLINE f32x4 bit_xor(f32x4 a, f32x4 b)                   { return detail::per_lane(a, b, [](float x, float y) { return detail::bits_lane(detail::lane_bits(x) ^ detail::lane_bits(y)); }); }
+
+    ELOO_FORCE_INLINE f32x4 select(f32x4 mask, f32x4 a, f32x4 b) {
+        f32x4 result;
+        for (int i = 0; i < WIDTH; ++i) {
+            result.v[i] = detail::lane_bits(mask.v[i]) ? a.v[i] : b.v[i];
+        }
+        return result;
+    }
+
+    ELOO_FORCE_INLINE int movemask(f32x4 mask) {
+        int bits = 0;
+        for (int i = 0; i < WIDTH; ++i) {
+            bits |= static_cast<int>(detail::lane_bits(mask.v[i]) >> 31) << i;
+        }
+        return bits;
+    }
+
+    ELOO_FORCE_INLINE f32x4 sign_from(f32x4 sign, f32x4 a) {
+        return detail::per_lane(sign, a, [](float s, float x) { return std::copysign(x, s); });
+    }
+
+    struct i32x4 {
+        int32_t v[4];
+    };
+
+    namespace detail {
+        template <typename Fn>
+        ELOO_FORCE_INLINE i32x4 per_lane_i32(i32x4 a, i32x4 b, Fn fn) {
+            i32x4 result;
+            for (int i = 0; i < 4; ++i) {
+                result.v[i] = static_cast<int32_t>(fn(static_cast<uint32_t>(a.v[i]), static_cast<uint32_t>(b.v[i])));
+            }
+            return result;
+        }
+    }
+
+    ELOO_FORCE_INLINE i32x4 load_i32(const int32_t* p)                 { return { { p[0], p[1], p[2], p[3] } }; }
+    ELOO_FORCE_INLINE void store_i32(int32_t* p, i32x4 a)               { std::memcpy(p, a.v, sizeof(a.v)); }
+    ELOO_FORCE_INLINE i32x4 set1_i32(int32_t s)                         { return { { s, s, s, s } }; }
+    ELOO_FORCE_INLINE i32x4 load_u16(const uint16_t* p)                { return { { p[0], p[1], p[2], p[3] } }; }
+
+    ELOO_FORCE_INLINE i32x4 operator + (i32x4 a, i32x4 b)               { return detail::per_lane_i32(a, b, [](uint32_t x, uint32_t y) { return x + y; }); }
+    ELOO_FORCE_INLINE i32x4 operator - (i32x4 a, i32x4 b)               { return detail::per_lane_i32(a, b, [](uint32_t x, uint32_t y) { return x - y; }); }
+    ELOO_FORCE_INLINE i32x4 operator * (i32x4 a, i32x4 b)               { return detail::per_lane_i32(a, b, [](uint32_t x, uint32_t y) { return x * y; }); }
+    ELOO_FORCE_INLINE i32x4 operator & (i32x4 a, i32x4 b)               { return detail::per_lane_i32(a, b, [](uint32_t x, uint32_t y) { return x & y; }); }
+    ELOO_FORCE_INLINE i32x4 operator | (i32x4 a, i32x4 b)               { return detail::per_lane_i32(a, b, [](uint32_t x, uint32_t y) { return x | y; }); }
+    ELOO_FORCE_INLINE i32x4 operator ^ (i32x4 a, i32x4 b)               { return detail::per_lane_i32(a, b, [](uint32_t x, uint32_t y) { return x ^ y; }); }
+    ELOO_FORCE_INLINE i32x4 operator << (i32x4 a, int count)            { return detail::per_lane_i32(a, a, [count](uint32_t x, uint32_t) { return x << count; }); }
+    ELOO_FORCE_INLINE i32x4 operator >> (i32x4 a, int count)            { return detail::per_lane_i32(a, a, [count](uint32_t x, uint32_t) { return x >> count; }); }
+
+    ELOO_FORCE_INLINE i32x4 cmp_eq(i32x4 a, i32x4 b)                    { return detail::per_lane_i32(a, b, [](uint32_t x, uint32_t y) { return x == y ? 0xFFFFFFFFu : 0u; }); }
+    ELOO_FORCE_INLINE i32x4 cmp_lt(i32x4 a, i32x4 b)                    { return detail::per_lane_i32(a, b, [](uint32_t x, uint32_t y) { return static_cast<int32_t>(x) < static_cast<int32_t>(y) ? 0xFFFFFFFFu : 0u; }); }
+    ELOO_FORCE_INLINE i32x4 cmp_gt(i32x4 a, i32x4 b)                    { return detail::per_lane_i32(a, b, [](uint32_t x, uint32_t y) { return static_cast<int32_t>(x) > static_cast<int32_t>(y) ? 0xFFFFFFFFu : 0u; }); }
+
+    ELOO_FORCE_INLINE i32x4 to_i32(f32x4 a) {
+        i32x4 result;
+        for (int i = 0; i < WIDTH; ++i) {
+            result.v[i] = static_cast<int32_t>(a.v[i]);
+        }
+        return result;
+    }
+
+    ELOO_FORCE_INLINE f32x4 to_f32(i32x4 a) {
+        f32x4 result;
+        for (int i = 0; i < WIDTH; ++i) {
+            result.v[i] = static_cast<float>(a.v[i]);
+        }
+        return result;
+    }
+
+    ELOO_FORCE_INLINE i32x4 as_i32(f32x4 a) {
+        i32x4 result;
+        std::memcpy(result.v, a.v, sizeof(a.v));
+        return result;
+    }
+
+    ELOO_FORCE_INLINE f32x4 as_f32(i32x4 a) {
+        f32x4 result;
+        std::memcpy(result.v, a.v, sizeof(a.v));
+        return result;
+    }
+#endif
+
+    // Multiply-add, kept as a separate helper so an FMA path can be slotted in later
+    ELOO_FORCE_INLINE f32x4 madd(f32x4 a, f32x4 b, f32x4 c) { return a * b + c; }
+
+    // Rounds towards negative infinity, valid while |a| < 2^31
+    ELOO_FORCE_INLINE f32x4 floor(f32x4 a) {
+        const f32x4 truncated = to_f32(to_i32(a));
+        return truncated - bit_and(cmp_gt(truncated, a), set1(1.0f));
+    }
+
+    ELOO_FORCE_INLINE i32x4 select(i32x4 mask, i32x4 a, i32x4 b) {
+        return (mask & a) | ((mask ^ set1_i32(-1)) & b);
+    }
+
+    // Transposes the 4x4 block held in a..d, converting 4 AoS elements to SoA lanes and back
+    ELOO_FORCE_INLINE void transpose(f32x4& a, f32x4& b, f32x4& c, f32x4& d) {
+#if ELOO_SIMD_SSE2
+        _MM_TRANSPOSE4_PS(a.v, b.v, c.v, d.v);
+#else
+        f32x4* rows[4] = { &a, &b, &c, &d };
+        for (int row = 0; row < 4; ++row) {
+            for (int column = row + 1; column < 4; ++column) {
+                const float swap = rows[row]->v[column];
+                rows[row]->v[column] = rows[column]->v[row];
+                rows[column]->v[row] = swap;
+            }
+        }
+#endif
+    }
+
+
+    /////////////////////////////////////////////////////////////////////
+    // 16 bit lanes for 8 bit pixel maths
+    //
+    // Bytes are widened in memory order, so each 32 bit pixel occupies 4 consecutive lanes.
+    // Products of two bytes fit, and div255 brings them back down with exact rounding.
+
+#if ELOO_SIMD_SSE2
+    struct u16x8 {
+        __m128i v;
+    };
+
+    ELOO_FORCE_INLINE u16x8 set1_u16(uint16_t s)                        { return { _mm_set1_epi16(static_cast<short>(s)) }; }
+    ELOO_FORCE_INLINE u16x8 widen_lo(i32x4 bytes)                       { return { _mm_unpacklo_epi8(bytes.v, _mm_setzero_si128()) }; }
+    ELOO_FORCE_INLINE u16x8 widen_hi(i32x4 bytes)                       { return { _mm_unpackhi_epi8(bytes.v, _mm_setzero_si128()) }; }
+    // Saturates each lane to [0, 255]
+    ELOO_FORCE_INLINE i32x4 narrow(u16x8 lo, u16x8 hi)                  { return { _mm_packus_epi16(lo.v, hi.v) }; }
+
+    ELOO_FORCE_INLINE u16x8 operator + (u16x8 a, u16x8 b)               { return { _mm_add_epi16(a.v, b.v) }; }
+    ELOO_FORCE_INLINE u16x8 operator - (u16x8 a, u16x8 b)               { return { _mm_sub_epi16(a.v, b.v) }; }
+    ELOO_FORCE_INLINE u16x8 operator * (u16x8 a, u16x8 b)               { return { _mm_mullo_epi16(a.v, b.v) }; }
+    ELOO_FORCE_INLINE u16x8 operator | (u16x8 a, u16x8 b)               { return { _mm_or_si128(a.v, b.v) }; }
+    ELOO_FORCE_INLINE u16x8 operator >> (u16x8 a, int count)            { return { _mm_srl_epi16(a.v, _mm_cvtsi32_si128(count)) }; }
+
+    // Copies lane 'Lane' of each group of 4 across the group, e.g. a pixel's alpha to all channels
+    template <int Lane>
+    ELOO_FORCE_INLINE u16x8 broadcast4(u16x8 a) {
+        constexpr int SHUFFLE = Lane * 0x55;
+        return { _mm_shufflehi_epi16(_mm_shufflelo_epi16(a.v, SHUFFLE), SHUFFLE) };
+    }
+#else
+    struct u16x8 {
+        uint16_t v[8];
+    };
+
+    namespace detail {
+        template <typename Fn>
+        ELOO_FORCE_INLINE u16x8 per_lane_u16(u16x8 a, u16x8 b, Fn fn) {
+            u16x8 result;
+            for (int i = 0; i < 8; ++i) {
+                result.v[i] = static_cast<uint16_t>(fn(a.v[i], b.v[i]));
+            }
+            return result;
+        }
+
+        ELOO_FORCE_INLINE u16x8 widen(i32x4 bytes, int first) {
+            uint8_t raw[16];
+            std::memcpy(raw, bytes.v, sizeof(raw));
+            u16x8 result;
+            for (int i = 0; i < 8; ++i) {
+                result.v[i] = raw[first + i];
+            }
+            return result;
+        }
+
+        ELOO_FORCE_INLINE uint8_t saturate_u8(uint16_t lane) {
+            return static_cast<int16_t>(lane) < 0 ? 0 : (lane > 255 ? 255 : static_cast<uint8_t>(lane));
+        }
+    }
+
+    ELOO_FORCE_INLINE u16x8 set1_u16(uint16_t s)                        { return { { s, s, s, s, s, s, s, s } }; }
+    ELOO_FORCE_INLINE u16x8 widen_lo(i32x4 bytes)                       { return detail::widen(bytes, 0); }
+    ELOO_FORCE_INLINE u16x8 widen_hi(i32x4 bytes)                       { return detail::widen(bytes, 8); }
+
+    ELOO_FORCE_INLINE i32x4 narrow(u16x8 lo, u16x8 hi) {
+        uint8_t raw[16];
+        for (int i = 0; i < 8; ++i) {
+            raw[i] = detail::saturate_u8(lo.v[i]);
+            raw[i + 8] = detail::saturate_u8(hi.v[i]);
+        }
+        i32x4 result;
+        std::memcpy(result.v, raw, sizeof(raw));
+        return result;
+    }
+
+    ELOO_FORCE_INLINE u16x8 operator + (u16x8 a, u16x8 b)               { return detail::per_lane_u16(a, b, [](uint16_t x, uint16_t y) { return x + y; }); }
+    ELOO_FORCE_INLINE u16x8 operator - (u16x8 a, u16x8 b)               { return detail::per_lane_u16(a, b, [](uint16_t x, uint16_t y) { return x - y; }); }
+    ELOO_FORCE_INLINE u16x8 operator * (u16x8 a, u16x8 b)               { return detail::per_lane_u16(a, b, [](uint16_t x, uint16_t y) { return x * y; }); }
+    ELOO_FORCE_INLINE u16x8 operator | (u16x8 a, u16x8 b)               { return detail::per_lane_u16(a, b, [](uint16_t x, uint16_t y) { return x | y; }); }
+    ELOO_FORCE_INLINE u16x8 operator >> (u16x8 a, int count)            { return detail::per_lane_u16(a, a, [count](uint16_t x, uint16_t) { return x >> count; }); }
+
+    template <int Lane>
+    ELOO_FORCE_INLINE u16x8 broadcast4(u16x8 a) {
+        u16x8 result;
+        for (int i = 0; i < 8; ++i) {
+            result.v[i] = a.v[(i & ~3) + Lane];
+        }
+        return result;
+    }
+#endif
+
+    // x / 255 rounded to nearest, exact for x <= 255 * 255
+    ELOO_FORCE_INLINE u16x8 div255(u16x8 x) {
+        const u16x8 biased = x + set1_u16(128);
+        return (biased + (biased >> 8)) >> 8;
+    }
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "utility/defines.h"
+
+#include "datatypes/float3.h"
+
+#include <EASTL/span.h>
+#include <EASTL/vector.h>
+
+// Cubic splines over float3
+//
+// Every supported spline type is converted into per-segment power basis coefficients when the
+// curve is built, so evaluation is the same four multiply-adds per axis regardless of the source
+// representation. The curve also bakes an arc-length table for constant speed motion, and a
+// bounding hierarchy over its segments for nearest point queries.
+
+namespace eloo::math::spline {
+    enum class type : uint8_t {
+        // Passes through every control point except the first and last, which only shape the
+        // tangents. Requires at least 4 points, producing (count - 3) segments
+        catmull_rom,
+
+        // Pairs of (position, tangent). Requires at least 2 pairs, producing (pairs - 1) segments
+        hermite,
+
+        // Cubic bezier with shared end points, i.e. p0 c0 c1 p1 c2 c3 p2 ...
+        // Requires (3 * segments + 1) points
+        bezier
+    };
+
+    struct nearest_result {
+        float parameter = 0.0f;     // Normalised [0,1] curve parameter
+        float distanceSqr = FLT_MAX;
+        float3::values position = float3::ZERO;
+    };
+
+
+    /////////////////////////////////////////////////////////////////////
+    // Single segment evaluation
+
+    float3::values catmull_rom(const float3::values& p0, const float3::values& p1, const float3::values& p2, const float3::values& p3, float t, float tension = 0.0f);
+    float3::values hermite(const float3::values& p0, const float3::values& m0, const float3::values& p1, const float3::values& m1, float t);
+    float3::values bezier(const float3::values& p0, const float3::values& c0, const float3::values& c1, const float3::values& p1, float t);
+
+
+    /////////////////////////////////////////////////////////////////////
+    // Curve
+
+    class curve {
+    public:
+        // 'tension' only applies to catmull_rom, where 0 gives the standard curve and 1 gives straight lines.
+        // 'samplesPerSegment' controls the resolution of the arc-length table
+        curve(type splineType, eastl::span<const float3::values> points, float tension = 0.0f, uint32_t samplesPerSegment = 16);
+
+        inline size_t segment_count() const { return mSegmentCount; }
+        inline float length() const { return mArcLengths.empty() ? 0.0f : mArcLengths.back(); }
+
+        // Evaluation by normalised parameter, where each segment covers an equal share of [0,1]
+        float3::values evaluate(float t) const;
+        float3::values tangent(float t) const;
+
+        // Evaluation by distance along the curve, giving constant speed motion
+        float parameter_at_distance(float distance) const;
+        float3::values evaluate_at_distance(float distance) const;
+
+        // Batch evaluation for many samples on the same curve
+        void evaluate(eastl::span<const float> t, eastl::span<float3::values> out) const;
+        void evaluate(eastl::span<const float> t, eastl::span<float> outX, eastl::span<float> outY, eastl::span<float> outZ) const;
+        void evaluate_at_distance(eastl::span<const float> distances, eastl::span<float3::values> out) const;
+
+        nearest_result nearest_point(const float3::values& point) const;
+
+    private:
+        // x(u) = a + b*u + c*u^2 + d*u^3, with the same for y and z
+        struct segment {
+            float a[3], b[3], c[3], d[3];
+        };
+
+        struct bounds_node {
+            float min[3];
+            float max[3];
+            uint32_t first;     // First child for branches, segment index for leaves
+            uint32_t count;     // 0 for branches, otherwise number of segments
+        };
+
+        void build_arc_lengths(uint32_t samplesPerSegment);
+        void build_bounds();
+        void build_bounds_node(uint32_t nodeIndex, uint32_t first, uint32_t count, const eastl::vector<float>& centres);
+
+        ELOO_FORCE_INLINE void resolve_segment(float t, uint32_t& index, float& u) const;
+
+        float refine_nearest(uint32_t segmentIndex, const float3::values& point, float& distanceSqr) const;
+
+    private:
+        eastl::vector<segment> mSegments;
+        size_t mSegmentCount = 0;
+
+        // Cumulative length at evenly spaced parameters, (segments * samples + 1) entries
+        eastl::vector<float> mArcLengths;
+
+        eastl::vector<bounds_node> mBounds;
+        eastl::vector<uint32_t> mBoundsSegments;
+    };
+}
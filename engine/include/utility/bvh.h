@@ -0,0 +1,147 @@
+#pragma once
+
+#include "utility/raycast.h"
+#include "utility/raycast_batch.h"
+#include "utility/raycast_packet.h"
+#include "utility/spherecast.h"
+
+#include <EASTL/span.h>
+#include <EASTL/vector.h>
+
+#include <cfloat>
+#include <cstdint>
+
+// Bounding volume hierarchies
+//
+// Both trees are built top down with binned SAH: at every node the primitive centroids are
+// dropped into a fixed number of bins per axis and the split with the lowest surface area cost
+// is taken, or a leaf when splitting costs more than testing everything. Nodes are 32 bytes and
+// stored depth first, so the first child always sits directly after its parent and a node only
+// needs to remember where its second child is. Primitives are copied into leaf order so a leaf
+// reads one contiguous run.
+//
+// Builds run across the parallel worker pool. The top levels are split one node at a time with
+// the binning and partitioning passes spread over the workers, then once ranges are small
+// enough each subtree is built serially as its own task. Where that switch happens depends only
+// on primitive counts, so the same input gives the same nodes whatever the thread count. The
+// lbvh method skips SAH, instead sorting primitives along a Morton curve and splitting where the
+// codes' highest differing bit changes. It builds much faster for content that is rebuilt often,
+// at the cost of slower queries.
+//
+// tree is built over boxes and mesh over triangles. Queries take prepared rays and sweeps and
+// report primitives by their index in the arrays the tree was built from. Closest hit queries
+// visit the nearer child first and prune against the best hit so far, any-hit queries stop at
+// the first primitive hit, and overlap queries append every primitive whose bounds overlap the
+// box. Triangles are tested with raycast::test_tri and spherecast::test_tri, and as the latter
+// measures its face hits along the normalized direction, sweeps against a mesh want unit
+// directions.
+//
+// Packet occlusion queries walk the tree once for up to 16 rays, such as the lines of sight from
+// a group of agents to their targets. A node is entered while any unblocked lane reaches it,
+// and the walk ends once every lane is blocked. The result is the mask of blocked lanes.
+
+namespace eloo::bvh {
+    struct aabb {
+        float3::values min = { FLT_MAX, FLT_MAX, FLT_MAX };
+        float3::values max = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+    };
+
+    // Interior nodes have a count of 0 and 'offset' is the index of their second child. Leaves
+    // cover 'count' primitives starting at 'offset' in leaf order
+    struct node {
+        float min[3];
+        uint32_t offset;
+        float max[3];
+        uint32_t count;
+
+        inline bool is_leaf() const { return count != 0; }
+    };
+    static_assert(sizeof(node) == 32, "BVH nodes are expected to be 32 bytes");
+
+    enum class build_method {
+        sah,
+        lbvh
+    };
+
+    struct build_settings {
+        build_method method = build_method::sah;
+        // Candidate split planes per axis are binCount - 1, up to MAX_BINS
+        uint32_t binCount = 16;
+        // Ranges at or below this size become leaves when splitting doesn't pay off, and lbvh
+        // builds split until they reach it
+        uint32_t maxLeafSize = 4;
+        // Cost of visiting a node relative to testing one primitive
+        float traversalCost = 1.0f;
+    };
+
+    constexpr uint32_t MAX_BINS = 32;
+    // Deeper ranges are made into leaves, which bounds the traversal stacks
+    constexpr uint32_t MAX_DEPTH = 64;
+
+    using raycast::batch_hit;
+
+    class tree {
+    public:
+        tree() = default;
+        explicit tree(eastl::span<const aabb> boxes, const build_settings& settings = {});
+
+        void build(eastl::span<const aabb> boxes, const build_settings& settings = {});
+        void clear();
+
+        inline bool empty() const { return mNodes.empty(); }
+        inline size_t size() const { return mIndices.size(); }
+        inline eastl::span<const node> nodes() const { return mNodes; }
+        // Input index of each primitive in leaf order, which leaf offsets point into
+        inline eastl::span<const uint32_t> indices() const { return mIndices; }
+        aabb bounds() const;
+
+        bool raycast(const raycast::ray& query, batch_hit& closest) const;
+        bool occluded(const raycast::ray& query) const;
+        template <int Lanes>
+        uint32_t occluded(const raycast::packet<Lanes>& rays) const;
+        bool spherecast(const spherecast::sweep& query, batch_hit& closest) const;
+        size_t overlap(const aabb& box, eastl::vector<uint32_t>& indices) const;
+
+    private:
+        eastl::vector<node> mNodes;
+        eastl::vector<aabb> mBoxes;
+        eastl::vector<uint32_t> mIndices;
+    };
+
+    class mesh {
+    public:
+        mesh() = default;
+        mesh(eastl::span<const float3::values> vertices, eastl::span<const uint32_t> indices, const build_settings& settings = {});
+        explicit mesh(eastl::span<const float3::values> vertices, const build_settings& settings = {});
+
+        // Indexed triangles, three indices per triangle
+        void build(eastl::span<const float3::values> vertices, eastl::span<const uint32_t> indices, const build_settings& settings = {});
+        // A triangle soup, three vertices per triangle
+        void build(eastl::span<const float3::values> vertices, const build_settings& settings = {});
+        void clear();
+
+        inline bool empty() const { return mNodes.empty(); }
+        inline size_t size() const { return mIndices.size(); }
+        inline eastl::span<const node> nodes() const { return mNodes; }
+        aabb bounds() const;
+        size_t memory_bytes() const;
+
+        bool raycast(const raycast::ray& query, batch_hit& closest) const;
+        bool occluded(const raycast::ray& query) const;
+        template <int Lanes>
+        uint32_t occluded(const raycast::packet<Lanes>& rays) const;
+        bool spherecast(const spherecast::sweep& query, batch_hit& closest) const;
+        size_t overlap(const aabb& box, eastl::vector<uint32_t>& indices) const;
+
+    private:
+        struct triangle {
+            float3::values vertex1;
+            float3::values vertex2;
+            float3::values vertex3;
+        };
+
+        eastl::vector<node> mNodes;
+        eastl::vector<triangle> mTriangles;
+        eastl::vector<uint32_t> mIndices;
+    };
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "utility/bvh.h"
+
+#include <EASTL/span.h>
+#include <EASTL/vector.h>
+
+#include <cstdint>
+
+// Compressed triangle BVH
+//
+// A smaller sibling of bvh::mesh with the same queries, for large static geometry. It starts
+// from the same binned SAH build, then collapses the binary tree into nodes of 4 or 8 children
+// by repeatedly opening the largest interior child. Each node keeps its own box as a float origin
+// and per axis step, and its children's boxes as 16 bit multiples of that step, rounded outwards
+// so the decoded boxes always contain the real ones. Leaves live in their parent's slots rather
+// than as nodes of their own, interior children are stored together so one index finds them all,
+// and triangles are kept as vertex indices into a single copy of the vertex array.
+//
+// Traversal decodes and tests 4 children at a time in SIMD lanes. The decoded boxes are a little
+// larger than the real ones, so more triangles get tested, but every hit is still found by the
+// same raycast::test_tri and spherecast::test_tri calls as in bvh::mesh.
+
+namespace eloo::bvh {
+    template <int Width>
+    struct alignas(16) wide_node {
+        static_assert(Width == 4 || Width == 8, "Compressed BVH nodes are 4 or 8 wide");
+
+        // Children decode to origin + q * scale on each axis
+        float origin[3];
+        float scale[3];
+        uint16_t lo[3][Width];
+        uint16_t hi[3][Width];
+        // Interior children are stored in slot order from firstChild, and leaf children's
+        // triangles in slot order from firstTriangle
+        uint32_t firstChild;
+        uint32_t firstTriangle;
+        uint16_t triangleCount[Width];
+        uint8_t validMask;
+        uint8_t interiorMask;
+    };
+
+    template <int Width>
+    class compressed_mesh {
+    public:
+        using node = wide_node<Width>;
+
+        compressed_mesh() = default;
+        compressed_mesh(eastl::span<const float3::values> vertices, eastl::span<const uint32_t> indices, const build_settings& settings = {});
+        explicit compressed_mesh(eastl::span<const float3::values> vertices, const build_settings& settings = {});
+
+        // Indexed triangles, three indices per triangle
+        void build(eastl::span<const float3::values> vertices, eastl::span<const uint32_t> indices, const build_settings& settings = {});
+        // A triangle soup, three vertices per triangle
+        void build(eastl::span<const float3::values> vertices, const build_settings& settings = {});
+        void clear();
+
+        inline bool empty() const { return mNodes.empty(); }
+        inline size_t size() const { return mIndices.size(); }
+        inline eastl::span<const node> nodes() const { return mNodes; }
+        aabb bounds() const;
+        size_t memory_bytes() const;
+
+        bool raycast(const raycast::ray& query, batch_hit& closest) const;
+        bool occluded(const raycast::ray& query) const;
+        bool spherecast(const spherecast::sweep& query, batch_hit& closest) const;
+        size_t overlap(const aabb& box, eastl::vector<uint32_t>& indices) const;
+
+    private:
+        void collapse(const tree& binary, eastl::span<const uint32_t> indices);
+
+    private:
+        eastl::vector<node> mNodes;
+        eastl::vector<float3::values> mVertices;
+        // Three vertex indices per triangle, in leaf order
+        eastl::vector<uint32_t> mTriangles;
+        // Input index of each triangle, in leaf order
+        eastl::vector<uint32_t> mIndices;
+        aabb mBounds;
+    };
+
+    using compressed_mesh4 = compressed_mesh<4>;
+    using compressed_mesh8 = compressed_mesh<8>;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "utility/colour.h"
+
+#include "datatypes/float4.h"
+
+#include <EASTL/span.h>
+
+// Colour space conversion
+//
+// Scalar references and span kernels for moving packed colour_t values in and out of float
+// RGBA, linear light, HSV and HSL. The span kernels unpack 4 colours at a time through the
+// component shifts in colour.h, so they follow the IS_BIG_ENDIAN layout, and produce exactly
+// what the scalar functions (or make_hsva/make_hsla for the HSV/HSL packs) produce.
+//
+// Float colours are (r, g, b, a) in [0, 1]. HSV/HSL colours are (h, s, v/l, a), all in [0, 1].
+// Packing clamps and rounds to nearest, except the HSV/HSL packs which truncate like make_hsva.
+
+namespace eloo::colour {
+
+    /////////////////////////////////////////////////////////////////////
+    // Scalar references
+
+    // IEC 61966-2-1 transfer functions, on a single [0, 1] component
+    float srgb_to_linear(float srgb);
+    float linear_to_srgb(float linear);
+
+    float4::values to_float4(colour_t colour);
+    colour_t from_float4(const float4::values& rgba);
+
+    // Colour channels are decoded from sRGB, alpha is passed through
+    float4::values to_linear(colour_t colour);
+    colour_t from_linear(const float4::values& rgba);
+
+    float4::values to_hsva(colour_t colour);
+    float4::values to_hsla(colour_t colour);
+
+
+    /////////////////////////////////////////////////////////////////////
+    // Span kernels, 'in' and 'out' must be the same length
+
+    void to_float4(eastl::span<const colour_t> in, eastl::span<float4::values> out);
+    void from_float4(eastl::span<const float4::values> in, eastl::span<colour_t> out);
+
+    void to_linear(eastl::span<const colour_t> in, eastl::span<float4::values> out);
+    void from_linear(eastl::span<const float4::values> in, eastl::span<colour_t> out);
+
+    void to_hsva(eastl::span<const colour_t> in, eastl::span<float4::values> out);
+    void from_hsva(eastl::span<const float4::values> in, eastl::span<colour_t> out);
+    void to_hsla(eastl::span<const colour_t> in, eastl::span<float4::values> out);
+    void from_hsla(eastl::span<const float4::values> in, eastl::span<colour_t> out);
+}
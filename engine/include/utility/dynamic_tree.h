@@ -0,0 +1,116 @@
+#pragma once
+
+#include "utility/bvh.h"
+
+#include <EASTL/functional.h>
+#include <EASTL/span.h>
+#include <EASTL/vector.h>
+
+#include <cstdint>
+
+// Dynamic AABB tree
+//
+// A bounding volume hierarchy for objects that move, are added and are removed while it is in
+// use. Each object is a proxy holding a fat box, its bounds grown by a margin, so small movements
+// leave the tree untouched: move() only reinserts a proxy once it leaves its fat box, and can
+// stretch the box along the displacement to predict where it is going. refit() instead updates a
+// proxy's box in place and grows or shrinks its ancestors to match, which is cheaper but lets the
+// tree degrade until rebalance() is run.
+//
+// Inserts pick the sibling that adds the least surface area, and inserts and removals rotate
+// nodes on the way back up to keep the tree height balanced. rebalance() is meant to be called
+// periodically, working through a budget of nodes per call and rotating grandchildren where it
+// reduces surface area without unbalancing the tree.
+//
+// Nodes live in one pooled array with a free list, which only grows by doubling. Proxy ids are
+// indices into it and stay valid until the proxy is removed. Queries report each object by the
+// user data it was inserted with, and leave the exact shape test to a callback given the prepared
+// ray or sweep, and occluded() returns as soon as the callback reports any hit. The batch queries
+// spread their queries across the worker pool, so callbacks must be safe to call from several
+// threads. Their results still come back in query order.
+
+namespace eloo::bvh {
+    class dynamic_tree {
+    public:
+        static constexpr uint32_t INVALID_PROXY = UINT32_MAX;
+        // Deepest tree the queries can walk. Height balancing keeps real trees far below it
+        static constexpr uint32_t MAX_HEIGHT = 128;
+
+        // Exact tests against a proxy's object, given its user data. Hits must lie within the
+        // query's [tmin, tmax], as the prepared tests ensure
+        using ray_test = eastl::function<bool(uint32_t userData, const raycast::ray& query, raycast::result& hit)>;
+        using sweep_test = eastl::function<bool(uint32_t userData, const spherecast::sweep& query, raycast::result& hit)>;
+
+        struct overlap_pair {
+            uint32_t query;
+            uint32_t userData;
+        };
+
+        explicit dynamic_tree(float margin = 0.1f);
+
+        void reserve(size_t proxies);
+        void clear();
+
+        uint32_t insert(const aabb& box, uint32_t userData);
+        void remove(uint32_t proxy);
+        // Returns true when the proxy left its fat box and was reinserted
+        bool move(uint32_t proxy, const aabb& box, const float3::values& displacement = float3::ZERO);
+        void refit(uint32_t proxy, const aabb& box);
+        void rebalance(uint32_t budget);
+
+        inline size_t size() const { return mProxyCount; }
+        inline float margin() const { return mMargin; }
+        uint32_t height() const;
+        uint32_t user_data(uint32_t proxy) const;
+        aabb fat_bounds(uint32_t proxy) const;
+        aabb bounds() const;
+
+        bool raycast(const raycast::ray& query, const ray_test& test, batch_hit& closest) const;
+        bool occluded(const raycast::ray& query, const ray_test& test) const;
+        bool spherecast(const spherecast::sweep& query, const sweep_test& test, batch_hit& closest) const;
+        size_t overlap(const aabb& box, eastl::vector<uint32_t>& userData) const;
+
+        void raycast(eastl::span<const raycast::ray> queries, const ray_test& test, eastl::span<batch_hit> closest) const;
+        // 'blocked' is set to 1 for each query with any hit and 0 otherwise
+        void occluded(eastl::span<const raycast::ray> queries, const ray_test& test, eastl::span<uint8_t> blocked) const;
+        void spherecast(eastl::span<const spherecast::sweep> queries, const sweep_test& test, eastl::span<batch_hit> closest) const;
+        size_t overlap(eastl::span<const aabb> boxes, eastl::vector<overlap_pair>& pairs) const;
+
+    private:
+        // Leaves have no children. 'parent' links the free list while a node is pooled, and
+        // 'height' is -1 then
+        struct node {
+            float min[3];
+            float max[3];
+            uint32_t parent;
+            uint32_t child1;
+            uint32_t child2;
+            int32_t height;
+            uint32_t userData;
+
+            inline bool is_leaf() const { return child1 == INVALID_PROXY; }
+        };
+
+        void grow_pool(size_t capacity);
+        uint32_t allocate_node();
+        void free_node(uint32_t index);
+        void set_fat_box(node& n, const aabb& box, const float3::values& displacement) const;
+        void insert_leaf(uint32_t leaf);
+        void remove_leaf(uint32_t leaf);
+        void refit_upwards(uint32_t index, bool balanceNodes);
+        uint32_t balance(uint32_t index);
+        void replace_child(uint32_t parent, uint32_t oldChild, uint32_t newChild);
+        bool try_rotate(uint32_t index);
+
+        template <typename Query, typename Test>
+        bool closest_hit(Query& query, float inflate, const Test& test, batch_hit& closest) const;
+
+    private:
+        eastl::vector<node> mNodes;
+        uint32_t mRoot = INVALID_PROXY;
+        uint32_t mFreeList = INVALID_PROXY;
+        uint32_t mRebalanceCursor = 0;
+        size_t mProxyCount = 0;
+        float mMargin;
+    };
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "datatypes/float3.h"
+
+#include <EASTL/span.h>
+
+#include <cstdint>
+
+// Convex shape queries
+//
+// GJK finds the distance between two convex shapes by searching their Minkowski difference for
+// the point closest to the origin, which only needs each shape's support point: its furthest
+// point along a direction. Shapes are described in world space the same way as the raycast
+// tests: spheres and capsules by origin, radius and height along UP, boxes by min and max, axis
+// aligned ellipsoids by origin and radii, and convex hulls by their vertices.
+//
+// Spheres and capsules are run as a point or a segment with their radius added afterwards, which
+// makes those pairs exact and quick to converge, and gives penetration depth directly whenever
+// the cores themselves stay apart. Shapes whose cores overlap fall back to EPA, which grows the
+// GJK simplex into a polytope around the origin until it reaches the face of the Minkowski
+// difference closest to it.
+//
+// A cache kept per pair warm starts the next query from the directions of the last simplex,
+// which for shapes that moved a little usually settles in one or two iterations. Batch entry
+// points run pairs across the worker pool.
+//
+// Results always satisfy pointB - pointA = normal * distance, with the normal pointing from A to
+// B. Distance is the gap between separated shapes and minus the penetration depth otherwise.
+
+namespace eloo::gjk {
+    enum class shape_type : uint8_t {
+        sphere,
+        capsule,
+        box,
+        ellipsoid,
+        hull
+    };
+
+    struct shape {
+        shape_type type;
+        // Centre, or the min corner of a box
+        float3::values origin;
+        // Max corner of a box, or the radii of an ellipsoid
+        float3::values extent;
+        float height;
+        float radius;
+        // Hull vertices, which must outlive the shape
+        eastl::span<const float3::values> vertices;
+
+        static shape sphere(const float3::values& origin, float radius);
+        static shape capsule(const float3::values& origin, float height, float radius);
+        static shape box(const float3::values& min, const float3::values& max);
+        static shape ellipsoid(const float3::values& origin, const float3::values& radii);
+        static shape hull(eastl::span<const float3::values> vertices);
+    };
+
+    // Furthest point of the shape along 'direction', which need not be normalized
+    float3::values support(const shape& convex, const float3::values& direction);
+
+    // Support directions of the last simplex for a pair, to warm start the next query on it
+    struct cache {
+        float3::values directions[4] = { float3::ZERO, float3::ZERO, float3::ZERO, float3::ZERO };
+        uint32_t count = 0;
+    };
+
+    struct result {
+        float distance = 0.0f;
+        float3::values normal = float3::ZERO;
+        float3::values pointA = float3::ZERO;
+        float3::values pointB = float3::ZERO;
+        uint32_t iterations = 0;
+        bool overlapping = false;
+    };
+
+    bool overlap(const shape& a, const shape& b, cache* warm = nullptr);
+    // Returns true when the shapes are apart. Overlapping shapes only get a distance when their
+    // cores stay apart, and report a distance of 0 otherwise
+    bool closest_points(const shape& a, const shape& b, result& info, cache* warm = nullptr);
+    // Returns true when the shapes overlap, with the penetration depth from EPA if needed.
+    // Separated shapes get the same result as closest_points()
+    bool penetration(const shape& a, const shape& b, result& info, cache* warm = nullptr);
+
+
+    /////////////////////////////////////////////////////////////////////
+    // Batches
+
+    // Indices of two shapes in the batch's shape list
+    struct shape_pair {
+        uint32_t a;
+        uint32_t b;
+    };
+
+    // 'caches' is either empty or holds one cache per pair
+    void overlap(eastl::span<const shape> shapes, eastl::span<const shape_pair> pairs, eastl::span<uint8_t> overlapping, eastl::span<cache> caches = {});
+    void closest_points(eastl::span<const shape> shapes, eastl::span<const shape_pair> pairs, eastl::span<result> results, eastl::span<cache> caches = {});
+    void penetration(eastl::span<const shape> shapes, eastl::span<const shape_pair> pairs, eastl::span<result> results, eastl::span<cache> caches = {});
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "utility/colour.h"
+
+#include "datatypes/float4.h"
+#include "maths/interpolation.h"
+
+#include <EASTL/span.h>
+#include <EASTL/vector.h>
+
+// Multi-stop colour gradients
+//
+// Stops hold linear light RGBA, so blends don't darken through the middle the way blending
+// sRGB bytes does. Each stop can carry an easing curve that shapes the segment running from it
+// to the next stop. In HSV mode the segments blend hue along the shorter arc instead of blending
+// the channels.
+//
+// evaluate() is exact but pays for a segment search and easing per sample. Anything sampling
+// per particle or per pixel should bake() once and sample the resulting lookup table.
+
+namespace eloo::colour {
+    class gradient_lut {
+    public:
+        gradient_lut() = default;
+
+        inline size_t size() const { return mEntries.size(); }
+        inline eastl::span<const colour_t> entries() const { return mEntries; }
+
+        // Nearest entry, 't' clamped to [0, 1]
+        colour_t sample(float t) const;
+        void sample(eastl::span<const float> t, eastl::span<colour_t> out) const;
+
+    private:
+        friend class gradient;
+        eastl::vector<colour_t> mEntries;
+    };
+
+    class gradient {
+    public:
+        enum class mode {
+            rgb,
+            hsv
+        };
+
+    public:
+        explicit gradient(mode blendMode = mode::rgb);
+
+        // Stops are kept sorted by position. A stop added at the same position as an existing
+        // one goes after it, giving a hard edge
+        void add_stop(float position, const float4::values& linearColour,
+            math::interpolation::blend_func blend = math::interpolation::blend_func::lerp,
+            math::interpolation::blend_opt options = eastl::monostate{});
+        // Takes an sRGB encoded colour, as authored in colour pickers
+        void add_stop(float position, colour_t colour,
+            math::interpolation::blend_func blend = math::interpolation::blend_func::lerp,
+            math::interpolation::blend_opt options = eastl::monostate{});
+        void clear();
+
+        inline size_t stop_count() const { return mStops.size(); }
+        inline mode get_mode() const { return mMode; }
+        inline void set_mode(mode blendMode) { mMode = blendMode; }
+
+        // Linear light RGBA at 't'. Before the first stop and after the last the end colours hold
+        float4::values evaluate(float t) const;
+        void evaluate(eastl::span<const float> t, eastl::span<float4::values> out) const;
+
+        // Samples 'resolution' evenly spaced points over [0, 1] into sRGB encoded colours
+        gradient_lut bake(uint32_t resolution = 256) const;
+
+    private:
+        struct stop {
+            float position;
+            float4::values colour;
+            float4::values hsv;
+            math::interpolation::blend_func blend;
+            math::interpolation::blend_opt options;
+        };
+
+        eastl::vector<stop> mStops;
+        mode mMode;
+    };
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+#include "datatypes/float4.h"
+#include "datatypes/int3.h"
+#include "utility/bvh.h"
+
+#include <EASTL/functional.h>
+#include <EASTL/span.h>
+#include <EASTL/vector.h>
+
+#include <cstdint>
+
+// Loose octree
+//
+// An octree over boxes of very different sizes, from terrain pieces down to small props, which
+// can be added, moved and removed at any time. Each object lives in exactly one node, picked by
+// its size: the deepest level whose cells are at least as large as the object's longest side,
+// in the cell holding its centre. Every node's bounds are its cell grown by half a cell on each
+// side, so an object placed that way always fits inside them and never has to be split or
+// pushed up because it straddles a cell boundary. Objects that reach outside the world bounds
+// climb until a node holds them, and the root holds whatever fits nowhere else, growing its
+// bounds to match.
+//
+// Nodes have no pointers. Each is found by its depth and int3 cell coordinates through an open
+// addressing hash table, and keeps a mask of which of its eight children exist. Nodes are created along the path
+// to an object as it is inserted and released again once they hold nothing.
+//
+// Overlap and frustum queries walk down from the root through the nodes they touch, and a node
+// entirely inside the frustum reports its whole subtree without testing any further. Ray queries
+// visit nodes front to back by entry distance, test each object's box before calling back for
+// the exact test, and stop once the next node starts beyond the closest hit so far. Queries
+// report each object by the user data it was inserted with.
+
+namespace eloo::spatial {
+    using bvh::aabb;
+    using raycast::batch_hit;
+
+    class loose_octree {
+    public:
+        static constexpr uint32_t INVALID_PROXY = UINT32_MAX;
+        // Cell coordinates take 19 bits per axis in node keys
+        static constexpr uint32_t MAX_DEPTH = 19;
+
+        // Exact test against an object, given its user data. Hits must lie within the query's
+        // [tmin, tmax], as the prepared tests ensure
+        using ray_test = eastl::function<bool(uint32_t userData, const raycast::ray& query, raycast::result& hit)>;
+
+        // The world bounds are extended along their shorter sides to make the root a cube
+        explicit loose_octree(const aabb& worldBounds, uint32_t maxDepth = 8);
+
+        uint32_t insert(const aabb& box, uint32_t userData);
+        void remove(uint32_t proxy);
+        // Returns true when the proxy moved to a different node
+        bool update(uint32_t proxy, const aabb& box);
+        void clear();
+
+        inline size_t size() const { return mObjectCount; }
+        inline size_t node_count() const { return mNodeCount; }
+        inline uint32_t max_depth() const { return mMaxDepth; }
+        uint32_t user_data(uint32_t proxy) const;
+        aabb bounds(uint32_t proxy) const;
+        // Loose bounds of the node at 'depth' and 'cell', whether or not it exists
+        aabb node_bounds(uint32_t depth, const int3::values& cell) const;
+
+        size_t overlap(const aabb& box, eastl::vector<uint32_t>& userData) const;
+        // Planes are (normal, w) with the inside where dot(normal, point) + w >= 0
+        size_t frustum(eastl::span<const float4::values> planes, eastl::vector<uint32_t>& userData) const;
+        bool raycast(const raycast::ray& query, const ray_test& test, batch_hit& closest) const;
+        bool occluded(const raycast::ray& query, const ray_test& test) const;
+
+    private:
+        struct object {
+            float min[3];
+            float max[3];
+            uint32_t userData;
+            uint32_t node;
+            // Links through the objects of the same node. 'next' links the free list while an
+            // object is pooled, and 'node' is INVALID_PROXY then
+            uint32_t prev;
+            uint32_t next;
+        };
+
+        struct node {
+            uint64_t key;
+            uint32_t firstObject;
+            uint32_t objectCount;
+            uint8_t childMask;
+        };
+
+        // A hash table slot, empty when 'key' is FREE_KEY
+        struct slot {
+            uint64_t key;
+            uint32_t node;
+        };
+
+        struct box3 {
+            float min[3];
+            float max[3];
+        };
+
+        static uint64_t key_of(uint32_t depth, const int3::values& cell);
+        static uint32_t depth_of(uint64_t key);
+        static int3::values cell_of(uint64_t key);
+        static uint64_t child_key(uint64_t key, uint32_t child);
+
+        box3 loose_bounds(uint64_t key) const;
+        uint64_t place(const box3& box) const;
+        uint32_t find_node(uint64_t key) const;
+        void index_node(uint64_t key, uint32_t node);
+        void unindex_node(uint64_t key);
+        uint32_t acquire_node(uint64_t key);
+        void link(uint32_t proxy, uint64_t key);
+        void unlink(uint32_t proxy);
+        void release_empty(uint32_t index);
+
+        template <typename NodeFn>
+        void walk(NodeFn nodeFn) const;
+        void report_subtree(uint32_t index, eastl::vector<uint32_t>& userData) const;
+
+        template <typename Visit>
+        bool walk_front_to_back(raycast::ray& query, Visit visit) const;
+
+    private:
+        eastl::vector<object> mObjects;
+        eastl::vector<node> mNodes;
+        eastl::vector<slot> mSlots;
+        uint32_t mFreeObject = INVALID_PROXY;
+        uint32_t mFreeNode = INVALID_PROXY;
+        size_t mObjectCount = 0;
+        size_t mNodeCount = 0;
+        float mOrigin[3];
+        float mSize;
+        uint32_t mMaxDepth;
+        // Root bounds, grown by anything stored at the root that reaches outside the world
+        box3 mRootBounds;
+    };
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "utility/colour.h"
+#include "utility/surface.h"
+
+#include <EASTL/span.h>
+#include <EASTL/vector.h>
+
+// Palette quantization
+//
+// Reduces RGBA8 images to at most 256 colours. build() picks the palette, either by median cut
+// over a 5 bit per channel histogram or by refining that result with k-means passes over every
+// pixel. A mapper then finds the nearest palette entry for any colour, with distances measured
+// as squared RGBA differences in 8 bit units. It buckets colour space into 8 levels per channel
+// and keeps, per bucket, only the entries that can be nearest to something inside it, so lookups
+// scan a handful of candidates 4 at a time and still return the exact answer.
+//
+// remap() and apply() run the whole image through a mapper, optionally dithering the RGB
+// channels. Ordered dithering uses an 8x8 Bayer matrix and runs across the worker pool.
+// Error diffusion is serpentine Floyd-Steinberg and is serial, as each pixel depends on the ones
+// before it. Alpha is matched but never dithered.
+
+namespace eloo::palette {
+    constexpr uint32_t MAX_COLOURS = 256;
+
+    enum class method {
+        median_cut,
+        kmeans
+    };
+
+    enum class dither {
+        none,
+        ordered,
+        diffusion
+    };
+
+    // Up to 'count' colours, fewer if the image doesn't have that many distinct ones. 'iterations'
+    // is the upper bound on k-means passes, which stop early once the palette settles
+    eastl::vector<colour_t> build(const surface::const_view& src, uint32_t count, method kind = method::median_cut, uint32_t iterations = 8);
+
+    class mapper {
+    public:
+        explicit mapper(eastl::span<const colour_t> colours);
+
+        inline size_t size() const { return mColours.size(); }
+        inline eastl::span<const colour_t> colours() const { return mColours; }
+
+        // Index of the closest palette entry, the lowest index winning ties
+        uint8_t nearest(colour_t colour) const;
+        void nearest(eastl::span<const colour_t> in, eastl::span<uint8_t> out) const;
+
+    private:
+        // Four candidates in SoA form, with the palette index stored as a float for select()
+        struct candidates {
+            float r[4];
+            float g[4];
+            float b[4];
+            float a[4];
+            float index[4];
+        };
+
+        struct bucket {
+            uint32_t first;
+            uint32_t count;
+        };
+
+        eastl::vector<colour_t> mColours;
+        eastl::vector<bucket> mBuckets;
+        eastl::vector<candidates> mCandidates;
+    };
+
+    // Writes one palette index per pixel into 'indices', rows tightly packed. 'strength' scales
+    // the dither, 1 being tuned to the palette size
+    void remap(const surface::const_view& src, const mapper& palette, eastl::span<uint8_t> indices,
+        dither mode = dither::none, float strength = 1.0f);
+
+    // Replaces every pixel with its palette colour
+    void apply(const surface::view& target, const mapper& palette, dither mode = dither::none, float strength = 1.0f);
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "utility/defines.h"
+
+#include <EASTL/functional.h>
+
+#include <cstddef>
+
+// Minimal data parallel helper
+//
+// A fixed pool of worker threads is created on first use. parallel_for splits [0, count) into
+// chunks of 'grain' items which the workers and the calling thread pull from a shared counter,
+// and returns once every chunk has run. Only one range is in flight at a time: calls made from
+// inside a chunk, or while another thread owns the pool, run serially on the calling thread.
+
+namespace eloo::parallel {
+    using range_fn = eastl::function<void(size_t begin, size_t end)>;
+
+    // Number of threads that take part in a parallel_for, including the caller
+    size_t worker_count();
+
+    void parallel_for(size_t count, size_t grain, const range_fn& fn);
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include "utility/raycast_batch.h"
+#include "utility/spherecast.h"
+
+#include <EASTL/functional.h>
+#include <EASTL/vector.h>
+
+#include <cstdint>
+#include <mutex>
+
+// Batched scene queries
+//
+// Gameplay systems queue their raycasts, occlusion tests and spherecasts through the frame
+// instead of running them on the spot, and flush() runs everything queued at one sync point. The
+// queries are sorted by the octant of their direction and then along a Morton curve through
+// their origins, so neighbouring queries take similar paths through the scene and find its
+// nodes already in cache. The sorted queries are spread across the parallel worker pool.
+//
+// The scheduler knows nothing about the scene itself. It calls the scene functions it was given
+// from several threads at once, so they must be safe to call concurrently. A bvh::mesh or a
+// bvh::dynamic_tree query wrapped in a lambda qualifies. Results are written into the slots
+// given to the queries and passed to their callbacks. This happens on the thread calling flush(),
+// in the order the queries were queued, and the results can also be read by query id until the
+// next flush. Queries may be queued from any thread, including from inside a callback, in which
+// case they wait for the next flush.
+
+namespace eloo::raycast {
+    struct query_result {
+        bool hit = false;
+        // Occlusion tests stop at the first hit and leave this unset
+        batch_hit closest;
+    };
+
+    class query_scheduler {
+    public:
+        using query_id = uint32_t;
+        static constexpr query_id INVALID_QUERY = UINT32_MAX;
+
+        using ray_fn = eastl::function<bool(const ray& query, batch_hit& closest)>;
+        using occluded_fn = eastl::function<bool(const ray& query)>;
+        using sweep_fn = eastl::function<bool(const spherecast::sweep& query, batch_hit& closest)>;
+        using callback = eastl::function<void(query_id id, const query_result& result)>;
+
+        // Scene functions for each query kind. Kinds without one report no hits
+        struct scene {
+            ray_fn raycast;
+            occluded_fn occluded;
+            sweep_fn spherecast;
+        };
+
+        // Totals for the last flush. Latency runs from a query being queued to its result being
+        // ready, so it includes the time spent waiting for the sync point
+        struct stats {
+            uint32_t raycasts = 0;
+            uint32_t occlusions = 0;
+            uint32_t spherecasts = 0;
+            uint32_t hits = 0;
+            float sortMs = 0.0f;
+            float executeMs = 0.0f;
+            float deliverMs = 0.0f;
+            float meanLatencyMs = 0.0f;
+            float maxLatencyMs = 0.0f;
+
+            inline uint32_t total() const { return raycasts + occlusions + spherecasts; }
+        };
+
+    public:
+        query_scheduler() = default;
+        explicit query_scheduler(const scene& target);
+
+        void set_scene(const scene& target);
+        void reserve(size_t queries);
+
+        // Ids count up from 0 in queue order for each flush, and result() knows them from the
+        // flush that runs them until the next one
+        query_id raycast(const ray& query, query_result* slot = nullptr);
+        query_id raycast(const ray& query, const callback& onResult);
+        query_id occluded(const ray& query, query_result* slot = nullptr);
+        query_id occluded(const ray& query, const callback& onResult);
+        query_id spherecast(const spherecast::sweep& query, query_result* slot = nullptr);
+        query_id spherecast(const spherecast::sweep& query, const callback& onResult);
+
+        // Runs everything queued so far and delivers the results
+        void flush();
+
+        size_t pending() const;
+        // Results of the last flush, by query id
+        const query_result& result(query_id id) const;
+        inline const stats& last_stats() const { return mStats; }
+
+    private:
+        enum class query_kind : uint8_t {
+            raycast,
+            occluded,
+            spherecast
+        };
+
+        struct queued_query {
+            spherecast::sweep query;
+            query_kind kind;
+            query_result* slot;
+            uint32_t callbackIndex;
+            int64_t queuedAt;
+        };
+
+        // One frame's worth of queries and everything flush() builds from them
+        struct frame {
+            eastl::vector<queued_query> queries;
+            eastl::vector<callback> callbacks;
+            eastl::vector<uint32_t> order;
+            eastl::vector<query_result> results;
+
+            void clear();
+        };
+
+    private:
+        query_id push(const spherecast::sweep& query, query_kind kind, query_result* slot, const callback* onResult);
+        void sort(frame& batch) const;
+
+    private:
+        scene mScene;
+        mutable std::mutex mMutex;
+        frame mPending;
+        frame mFlushed;
+        stats mStats;
+    };
+}
@@ -12,6 +12,26 @@ namespace eloo::raycast {
         float3::values position = float3::ZERO;
     };
 
+    // A ray with its direction dependent terms worked out once, for testing against many
+    // primitives. Hits are accepted within [tmin, tmax], and shrink() pulls tmax in so that later
+    // tests only report closer hits
+    struct ray {
+        float3::values origin;
+        float3::values direction;
+        float3::values invDirection;
+        // 1 per axis where the direction's sign bit is set, so a -0 component agrees with its
+        // -infinity inverse
+        uint32_t sign[3];
+        float dirLengthSqr;
+        float tmin = 0.0f;
+        float tmax = FLT_MAX;
+
+        ray(const float3::values& rayOrigin, const float3::values& rayDir, float rayLength = FLT_MAX);
+
+        inline void shrink(float distance) { tmax = distance < tmax ? distance : tmax; }
+        inline bool accepts(float distance) const { return distance >= tmin && distance <= tmax; }
+    };
+
 #define ELOO_RAYCAST_PARAMS_1 const float3::values& rayOrigin, const float3::values& rayDir, float rayLength
 #define ELOO_RAYCAST_PARAMS_2 FLOAT3_DECLARE_PARAMS(rayOrigin), FLOAT3_DECLARE_PARAMS(rayDir), float rayLength
 #define ELOO_RAYCAST_PARAMS_3 const float3::values& rayOrigin, const float3::values& rayDir
@@ -52,6 +72,25 @@ namespace eloo::raycast {
     bool test_capsule(ELOO_RAYCAST_PARAMS_3, const float3::values& origin, float height, float radius, result& info);
     bool test_capsule(ELOO_RAYCAST_PARAMS_4, FLOAT3_DECLARE_PARAMS(origin), float height, float radius, result& info);
 
+    bool test_plane(const ray& query, const float4::values& plane, result& info);
+    bool test_quad(const ray& query, const float4::values& quad, float width, float height, result& info);
+    bool test_tri(const ray& query, const float3::values& vertex1, const float3::values& vertex2, const float3::values& vertex3, result& info);
+    bool test_aabb(const ray& query, const float3::values& min, const float3::values& max, result& info);
+    bool test_sphere(const ray& query, const float3::values& origin, float radius, result& info);
+    bool test_ellipsoid(const ray& query, const float3::values& origin, const float3::values& radii, result& info);
+    bool test_capsule(const ray& query, const float3::values& origin, float height, float radius, result& info);
+
+    // Any-hit tests for line of sight checks: true when the prepared test would report a hit, without
+    // working out where. Planes, triangles, boxes and spheres skip the hit point entirely, the
+    // other shapes still run their full test
+    bool occluded_plane(const ray& query, const float4::values& plane);
+    bool occluded_quad(const ray& query, const float4::values& quad, float width, float height);
+    bool occluded_tri(const ray& query, const float3::values& vertex1, const float3::values& vertex2, const float3::values& vertex3);
+    bool occluded_aabb(const ray& query, const float3::values& min, const float3::values& max);
+    bool occluded_sphere(const ray& query, const float3::values& origin, float radius);
+    bool occluded_ellipsoid(const ray& query, const float3::values& origin, const float3::values& radii);
+    bool occluded_capsule(const ray& query, const float3::values& origin, float height, float radius);
+
 #undef ELOO_RAYCAST_PARAMS_1
 #undef ELOO_RAYCAST_PARAMS_2
 #undef ELOO_RAYCAST_PARAMS_3
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "utility/raycast.h"
+#include "utility/spherecast.h"
+
+#include <EASTL/span.h>
+#include <EASTL/vector.h>
+
+#include <cstdint>
+
+// One ray against many primitives
+//
+// Primitive sets are SoA spans, one per component, all of the same length. Terms that only
+// depend on the ray are computed once per call, and the primitives are then evaluated 8 at a
+// time in two interleaved groups of 4 SIMD lanes. Per primitive the tests follow the single ray
+// versions. The AABB test multiplies by the inverse direction rather than dividing, so distances
+// can differ from test_aabb in the last bit.
+//
+// The closest variants report the nearest hit, the lowest index winning ties. The all-hit
+// variants append every hit to 'hits' in index order and return how many were added, and the
+// occluded variants return at the first group of lanes with any hit, without distances.
+// The spherecast versions inflate each primitive by the cast radius as it is loaded. Prepared
+// rays and sweeps are tested over their [tmin, tmax] interval.
+
+namespace eloo::raycast {
+    struct sphere_set {
+        eastl::span<const float> x;
+        eastl::span<const float> y;
+        eastl::span<const float> z;
+        eastl::span<const float> radius;
+
+        inline size_t size() const { return x.size(); }
+    };
+
+    struct aabb_set {
+        eastl::span<const float> minX;
+        eastl::span<const float> minY;
+        eastl::span<const float> minZ;
+        eastl::span<const float> maxX;
+        eastl::span<const float> maxY;
+        eastl::span<const float> maxZ;
+
+        inline size_t size() const { return minX.size(); }
+    };
+
+    struct batch_hit {
+        static constexpr uint32_t INVALID_INDEX = UINT32_MAX;
+
+        uint32_t index = INVALID_INDEX;
+        result hit;
+    };
+
+    bool test_spheres(const ray& query, const sphere_set& spheres, batch_hit& closest);
+    bool test_spheres(const float3::values& rayOrigin, const float3::values& rayDir, float rayLength, const sphere_set& spheres, batch_hit& closest);
+    bool test_spheres(const float3::values& rayOrigin, const float3::values& rayDir, const sphere_set& spheres, batch_hit& closest);
+    size_t test_spheres(const ray& query, const sphere_set& spheres, eastl::vector<batch_hit>& hits);
+    size_t test_spheres(const float3::values& rayOrigin, const float3::values& rayDir, float rayLength, const sphere_set& spheres, eastl::vector<batch_hit>& hits);
+    size_t test_spheres(const float3::values& rayOrigin, const float3::values& rayDir, const sphere_set& spheres, eastl::vector<batch_hit>& hits);
+    bool occluded_spheres(const ray& query, const sphere_set& spheres);
+    bool occluded_spheres(const float3::values& rayOrigin, const float3::values& rayDir, float rayLength, const sphere_set& spheres);
+    bool occluded_spheres(const float3::values& rayOrigin, const float3::values& rayDir, const sphere_set& spheres);
+
+    bool test_aabbs(const ray& query, const aabb_set& boxes, batch_hit& closest);
+    bool test_aabbs(const float3::values& rayOrigin, const float3::values& rayDir, float rayLength, const aabb_set& boxes, batch_hit& closest);
+    bool test_aabbs(const float3::values& rayOrigin, const float3::values& rayDir, const aabb_set& boxes, batch_hit& closest);
+    size_t test_aabbs(const ray& query, const aabb_set& boxes, eastl::vector<batch_hit>& hits);
+    size_t test_aabbs(const float3::values& rayOrigin, const float3::values& rayDir, float rayLength, const aabb_set& boxes, eastl::vector<batch_hit>& hits);
+    size_t test_aabbs(const float3::values& rayOrigin, const float3::values& rayDir, const aabb_set& boxes, eastl::vector<batch_hit>& hits);
+    bool occluded_aabbs(const ray& query, const aabb_set& boxes);
+    bool occluded_aabbs(const float3::values& rayOrigin, const float3::values& rayDir, float rayLength, const aabb_set& boxes);
+    bool occluded_aabbs(const float3::values& rayOrigin, const float3::values& rayDir, const aabb_set& boxes);
+}
+
+namespace eloo::spherecast {
+    using raycast::sphere_set;
+    using raycast::aabb_set;
+    using raycast::batch_hit;
+
+    bool test_spheres(const sweep& query, const sphere_set& spheres, batch_hit& closest);
+    bool test_spheres(const float3::values& rayOrigin, const float3::values& rayDir, float rayLength, float castRadius, const sphere_set& spheres, batch_hit& closest);
+    bool test_spheres(const float3::values& rayOrigin, const float3::values& rayDir, float castRadius, const sphere_set& spheres, batch_hit& closest);
+    size_t test_spheres(const sweep& query, const sphere_set& spheres, eastl::vector<batch_hit>& hits);
+    size_t test_spheres(const float3::values& rayOrigin, const float3::values& rayDir, float rayLength, float castRadius, const sphere_set& spheres, eastl::vector<batch_hit>& hits);
+    size_t test_spheres(const float3::values& rayOrigin, const float3::values& rayDir, float castRadius, const sphere_set& spheres, eastl::vector<batch_hit>& hits);
+    bool occluded_spheres(const sweep& query, const sphere_set& spheres);
+    bool occluded_spheres(const float3::values& rayOrigin, const float3::values& rayDir, float rayLength, float castRadius, const sphere_set& spheres);
+    bool occluded_spheres(const float3::values& rayOrigin, const float3::values& rayDir, float castRadius, const sphere_set& spheres);
+
+    bool test_aabbs(const sweep& query, const aabb_set& boxes, batch_hit& closest);
+    bool test_aabbs(const float3::values& rayOrigin, const float3::values& rayDir, float rayLength, float castRadius, const aabb_set& boxes, batch_hit& closest);
+    bool test_aabbs(const float3::values& rayOrigin, const float3::values& rayDir, float castRadius, const aabb_set& boxes, batch_hit& closest);
+    size_t test_aabbs(const sweep& query, const aabb_set& boxes, eastl::vector<batch_hit>& hits);
+    size_t test_aabbs(const float3::values& rayOrigin, const float3::values& rayDir, float rayLength, float castRadius, const aabb_set& boxes, eastl::vector<batch_hit>& hits);
+    size_t test_aabbs(const float3::values& rayOrigin, const float3::values& rayDir, float castRadius, const aabb_set& boxes, eastl::vector<batch_hit>& hits);
+    bool occluded_aabbs(const sweep& query, const aabb_set& boxes);
+    bool occluded_aabbs(const float3::values& rayOrigin, const float3::values& rayDir, float rayLength, float castRadius, const aabb_set& boxes);
+    bool occluded_aabbs(const float3::values& rayOrigin, const float3::values& rayDir, float castRadius, const aabb_set& boxes);
+}
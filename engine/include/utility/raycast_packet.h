@@ -0,0 +1,78 @@
+#pragma once
+
+#include "utility/raycast.h"
+
+#include <cfloat>
+#include <cstdint>
+
+// Packet raycasts
+//
+// A packet bundles 4, 8 or 16 rays in SoA form so one primitive can be tested against all of them
+// in SIMD lanes, 4 at a time. Each lane follows the same conventions as the single ray tests:
+// directions need not be normalized and distances are in units of the direction's length.
+//
+// The tests return a bit mask of the lanes that hit, which is also stored in the result. Only
+// lanes in that mask have their result written. Inactive lanes are skipped, and every group of
+// 4 lanes stops as soon as all of its lanes have been rejected. The occluded forms return the
+// same mask without writing any results, for visibility checks such as many agents against
+// many targets, where lanes found occluded can be cleared from 'active' before the next test.
+
+namespace eloo::raycast {
+    template <int Lanes>
+    struct packet {
+        static_assert(Lanes == 4 || Lanes == 8 || Lanes == 16, "Ray packets are 4, 8 or 16 lanes wide");
+        static constexpr int LANES = Lanes;
+        static constexpr uint32_t ALL_LANES = (1u << Lanes) - 1u;
+
+        alignas(16) float originX[Lanes] = {};
+        alignas(16) float originY[Lanes] = {};
+        alignas(16) float originZ[Lanes] = {};
+        alignas(16) float dirX[Lanes] = {};
+        alignas(16) float dirY[Lanes] = {};
+        alignas(16) float dirZ[Lanes] = {};
+        alignas(16) float length[Lanes] = {};
+        uint32_t active = 0;
+
+        // Fills a lane and marks it active
+        inline void set(int lane, const float3::values& rayOrigin, const float3::values& rayDir, float rayLength = FLT_MAX) {
+            originX[lane] = rayOrigin.x();
+            originY[lane] = rayOrigin.y();
+            originZ[lane] = rayOrigin.z();
+            dirX[lane] = rayDir.x();
+            dirY[lane] = rayDir.y();
+            dirZ[lane] = rayDir.z();
+            length[lane] = rayLength;
+            active |= 1u << lane;
+        }
+    };
+
+    template <int Lanes>
+    struct packet_result {
+        result hits[Lanes];
+        uint32_t mask = 0;
+
+        inline bool hit(int lane) const { return (mask >> lane) & 1u; }
+    };
+
+    using packet4 = packet<4>;
+    using packet8 = packet<8>;
+    using packet16 = packet<16>;
+
+    template <int Lanes>
+    uint32_t test_aabb(const packet<Lanes>& rays, const float3::values& min, const float3::values& max, packet_result<Lanes>& hits);
+
+    template <int Lanes>
+    uint32_t test_sphere(const packet<Lanes>& rays, const float3::values& origin, float radius, packet_result<Lanes>& hits);
+
+    template <int Lanes>
+    uint32_t test_tri(const packet<Lanes>& rays, const float3::values& vertex1, const float3::values& vertex2, const float3::values& vertex3, packet_result<Lanes>& hits);
+
+    template <int Lanes>
+    uint32_t occluded_aabb(const packet<Lanes>& rays, const float3::values& min, const float3::values& max);
+
+    template <int Lanes>
+    uint32_t occluded_sphere(const packet<Lanes>& rays, const float3::values& origin, float radius);
+
+    template <int Lanes>
+    uint32_t occluded_tri(const packet<Lanes>& rays, const float3::values& vertex1, const float3::values& vertex2, const float3::values& vertex3);
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "utility/raycast.h"
+#include "utility/raycast_packet.h"
+
+#include <EASTL/span.h>
+#include <EASTL/vector.h>
+
+#include <cfloat>
+#include <cstdint>
+
+// Watertight ray/triangle tests
+//
+// test_tri computes edges from the vertices it is given, so two triangles sharing an edge can
+// both reject a ray through it. These tests follow Woop, Benthin and Wald's watertight algorithm
+// instead: each ray picks its dominant axis and a shear that maps its direction onto that axis,
+// vertices are moved into that space, and the 2D edge functions decide the hit. A shared edge's
+// function comes out exactly negated between its two triangles, as the same products are taken
+// in the other order, so a ray always hits at least one of them. Edge functions of exactly zero
+// are redone in double precision so the sign is right. This relies on the vertices being stored
+// as is, which is why the records keep all three rather than an edge form.
+//
+// A triangle_record is 64 bytes with the vertices first so the batch test can load four records
+// and transpose them into SIMD lanes. Distances are in units of the ray direction's length, as
+// with the other prepared tests, and hits report the barycentric weights of the second and third
+// vertices, the record's id and its unit geometric normal, wound from vertex1 through vertex2 to
+// vertex3 whichever side was hit. Degenerate triangles are never hit. The occluded forms make
+// the same decisions but stop at the first hit and fill in nothing.
+
+namespace eloo::raycast {
+    struct alignas(16) triangle_record {
+        float vertex1[3];
+        float vertex2[3];
+        float vertex3[3];
+        float normal[3];
+        uint32_t id;
+        uint32_t padding[3];
+
+        triangle_record() = default;
+        triangle_record(const float3::values& v1, const float3::values& v2, const float3::values& v3, uint32_t triangleId);
+    };
+    static_assert(sizeof(triangle_record) == 64, "Triangle records are expected to be 64 bytes");
+
+    struct triangle_hit {
+        static constexpr uint32_t INVALID_ID = UINT32_MAX;
+
+        uint32_t id = INVALID_ID;
+        result hit;
+        // The hit is vertex1 * (1 - u - v) + vertex2 * u + vertex3 * v
+        float u = 0.0f;
+        float v = 0.0f;
+        float3::values normal = float3::ZERO;
+    };
+
+    // A prepared ray with the shear terms of the watertight test worked out
+    struct watertight_ray {
+        float origin[3];
+        float direction[3];
+        float shear[3];
+        uint32_t axis[3];
+        float tmin;
+        float tmax;
+
+        explicit watertight_ray(const ray& query);
+        watertight_ray(const float3::values& rayOrigin, const float3::values& rayDir, float rayLength = FLT_MAX);
+
+        inline void shrink(float distance) { tmax = distance < tmax ? distance : tmax; }
+        inline bool accepts(float distance) const { return distance >= tmin && distance <= tmax; }
+    };
+
+    template <int Lanes>
+    struct packet_triangle_result {
+        triangle_hit hits[Lanes];
+        uint32_t mask = 0;
+
+        inline bool hit(int lane) const { return (mask >> lane) & 1u; }
+    };
+
+    // Records for indexed triangles, three indices per triangle, with ids counting from firstId
+    void build_records(eastl::span<const float3::values> vertices, eastl::span<const uint32_t> indices, eastl::vector<triangle_record>& records, uint32_t firstId = 0);
+
+    bool test_tri(const watertight_ray& query, const triangle_record& tri, triangle_hit& hit);
+    bool occluded_tri(const watertight_ray& query, const triangle_record& tri);
+
+    // The closest hit, the lower position in 'tris' winning ties, or every hit appended in order
+    bool test_tris(const watertight_ray& query, eastl::span<const triangle_record> tris, triangle_hit& closest);
+    size_t test_tris(const watertight_ray& query, eastl::span<const triangle_record> tris, eastl::vector<triangle_hit>& hits);
+    bool occluded_tris(const watertight_ray& query, eastl::span<const triangle_record> tris);
+
+    template <int Lanes>
+    uint32_t test_tri(const packet<Lanes>& rays, const triangle_record& tri, packet_triangle_result<Lanes>& hits);
+    template <int Lanes>
+    uint32_t occluded_tri(const packet<Lanes>& rays, const triangle_record& tri);
+}
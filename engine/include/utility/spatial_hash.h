@@ -0,0 +1,92 @@
+#pragma once
+
+#include "datatypes/int3.h"
+#include "utility/bvh.h"
+
+#include <EASTL/span.h>
+#include <EASTL/vector.h>
+
+#include <cstdint>
+
+// Spatial hash grid
+//
+// A uniform grid over points, for neighbour and proximity queries on content that moves every
+// frame. Space is split into cubic cells and each int3 cell hashes into a power of two table of
+// buckets, so only occupied cells cost memory and the grid has no fixed extent. build() fills it
+// from scratch with a counting sort instead of per cell containers: points are first spread
+// into coarse ranges of buckets across the worker pool, then each range is sorted by bucket on
+// its own. Every pass is linear in the point count or the table size, so rebuilding 1M points
+// costs the same every frame however they are arranged, and the same input gives the same order
+// whatever the thread count. Positions are copied into bucket order so a bucket reads one
+// contiguous run.
+//
+// Cells that share a bucket are told apart by recomputing each point's cell, so queries never
+// report a point twice. Queries report points by their index in the columns the grid was built
+// from. Radius and box queries append every point inside. nearest() searches rings of cells
+// outwards from the query point and returns the k closest, nearest first. raycast() treats every
+// point as a sphere of the given radius and walks the cells along the ray with a 3D DDA, testing
+// each sphere with raycast::test_sphere and stopping once the ray passes the closest hit. Cells
+// should be at least as large as the typical query radius, as queries visit every cell their
+// bounds touch.
+
+namespace eloo::spatial {
+    using bvh::aabb;
+    using raycast::batch_hit;
+
+    class hash_grid {
+    public:
+        explicit hash_grid(float cellSize = 1.0f);
+
+        // 'tableSize' is rounded up to a power of two, or chosen from the point count when 0
+        void build(eastl::span<const float> x, eastl::span<const float> y, eastl::span<const float> z, uint32_t tableSize = 0);
+        void set_cell_size(float cellSize);
+        void clear();
+
+        inline bool empty() const { return mIndices.empty(); }
+        inline size_t size() const { return mIndices.size(); }
+        inline float cell_size() const { return mCellSize; }
+        inline size_t table_size() const { return mBucketStarts.empty() ? 0 : mBucketStarts.size() - 1; }
+        // Bounds of every point, empty when there are none
+        inline const aabb& bounds() const { return mBounds; }
+
+        int3::values cell_of(const float3::values& position) const;
+        uint32_t bucket_of(const int3::values& cell) const;
+
+        size_t overlap(const float3::values& centre, float radius, eastl::vector<uint32_t>& indices) const;
+        size_t overlap(const aabb& box, eastl::vector<uint32_t>& indices) const;
+        // Up to 'k' points within 'maxDistance', nearest first, with ties going to the lower index
+        size_t nearest(const float3::values& position, uint32_t k, eastl::vector<uint32_t>& indices, float maxDistance = FLT_MAX) const;
+        bool raycast(const raycast::ray& query, float pointRadius, batch_hit& closest) const;
+
+    private:
+        struct scratch_point {
+            float x;
+            float y;
+            float z;
+            uint32_t bucket;
+            uint32_t index;
+        };
+
+        template <typename CellFn>
+        void for_each_in_cell(int cx, int cy, int cz, CellFn cellFn) const;
+
+    private:
+        float mCellSize;
+        float mInvCellSize;
+        uint32_t mBucketMask = 0;
+        // Points of bucket b are [mBucketStarts[b], mBucketStarts[b + 1]) of the sorted columns
+        eastl::vector<uint32_t> mBucketStarts;
+        eastl::vector<float> mX;
+        eastl::vector<float> mY;
+        eastl::vector<float> mZ;
+        eastl::vector<uint32_t> mIndices;
+        aabb mBounds;
+        // Range of occupied cells, which bounds the cells queries visit
+        int mCellMin[3] = { 0, 0, 0 };
+        int mCellMax[3] = { -1, -1, -1 };
+        // Kept between builds so rebuilding every frame doesn't reallocate
+        eastl::vector<uint32_t> mScratchBuckets;
+        eastl::vector<uint32_t> mScratchOffsets;
+        eastl::vector<scratch_point> mScratchPoints;
+    };
+}
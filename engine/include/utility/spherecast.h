@@ -2,17 +2,24 @@
 
 #include "datatypes/float3.h"
 #include "datatypes/float4.h"
+#include "utility/raycast.h"
 
 #include <EASTL/optional.h>
 
 
-namespace eloo::raycast {
-    struct result;
-};
-
 namespace eloo::spherecast {
     using result = raycast::result;
 
+    // A prepared ray swept by a sphere of 'radius', see raycast::ray
+    struct sweep : raycast::ray {
+        float radius;
+
+        sweep(const float3::values& rayOrigin, const float3::values& rayDir, float castRadius, float rayLength = FLT_MAX)
+            : raycast::ray(rayOrigin, rayDir, rayLength), radius(castRadius) {}
+        sweep(const raycast::ray& path, float castRadius)
+            : raycast::ray(path), radius(castRadius) {}
+    };
+
 #define ELOO_SPHERECAST_PARAMS_1 const float3::values& rayOrigin, const float3::values& rayDir, float rayLength, float castRadius
 #define ELOO_SPHERECAST_PARAMS_2 FLOAT3_DECLARE_PARAMS(rayOrigin), FLOAT3_DECLARE_PARAMS(rayDir), float rayLength, float castRadius
 #define ELOO_SPHERECAST_PARAMS_3 const float3::values& rayOrigin, const float3::values& rayDir, float castRadius
@@ -53,6 +60,14 @@ namespace eloo::spherecast {
     bool test_capsule(ELOO_SPHERECAST_PARAMS_3, const float3::values& origin, float height, float radius, result& info);
     bool test_capsule(ELOO_SPHERECAST_PARAMS_4, FLOAT3_DECLARE_PARAMS(origin), float height, float radius, result& info);
 
+    bool test_plane(const sweep& query, const float4::values& plane, result& info);
+    bool test_quad(const sweep& query, const float4::values& quad, float width, float height, result& info);
+    bool test_tri(const sweep& query, const float3::values& vertex1, const float3::values& vertex2, const float3::values& vertex3, result& info);
+    bool test_aabb(const sweep& query, const float3::values& min, const float3::values& max, result& info);
+    bool test_sphere(const sweep& query, const float3::values& origin, float radius, result& info);
+    bool test_ellipsoid(const sweep& query, const float3::values& origin, const float3::values& radii, result& info);
+    bool test_capsule(const sweep& query, const float3::values& origin, float height, float radius, result& info);
+
 #undef ELOO_SPHERECAST_PARAMS_1
 #undef ELOO_SPHERECAST_PARAMS_2
 #undef ELOO_SPHERECAST_PARAMS_3
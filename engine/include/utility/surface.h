@@ -0,0 +1,83 @@
+#pragma once
+
+#include "utility/colour.h"
+
+// CPU image compositing
+//
+// Surfaces are non-owning views over colour_t pixels, with the stride in pixels so sub-rectangles
+// of a larger image can be addressed directly. The kernels work on 8 bit channels with exact
+// rounding, 4 pixels per step, and split the destination into bands of rows across the worker
+// pool. Blits are clipped against the destination, so positions may be negative or overhang.
+//
+// Colours are straight (non-premultiplied) alpha unless the mode says otherwise. Per channel,
+// with 's' the source, 'd' the destination and 'sa' the source alpha, all in [0, 1]:
+//   replace        d = s
+//   alpha          rgb = s * sa + d * (1 - sa), a = sa + da * (1 - sa)
+//   premultiplied  d = s + d * (1 - sa), source colour already multiplied by its alpha
+//   additive       rgb = d + s * sa, a = da + sa, saturating
+//   multiply       rgb = d * lerp(1, s, sa), a = da
+
+namespace eloo::surface {
+    struct view {
+        colour_t* pixels = nullptr;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t stride = 0;
+
+        view() = default;
+        // A stride of 0 means tightly packed rows
+        view(colour_t* pixels, uint32_t width, uint32_t height, uint32_t stride = 0)
+            : pixels(pixels), width(width), height(height), stride(stride != 0 ? stride : width) {}
+
+        inline colour_t* row(uint32_t y) const { return pixels + static_cast<size_t>(y) * stride; }
+        inline colour_t& at(uint32_t x, uint32_t y) const { return row(y)[x]; }
+
+        // Sub-rectangle, clipped to this view
+        view sub(int32_t x, int32_t y, uint32_t w, uint32_t h) const;
+    };
+
+    struct const_view {
+        const colour_t* pixels = nullptr;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t stride = 0;
+
+        const_view() = default;
+        const_view(const colour_t* pixels, uint32_t width, uint32_t height, uint32_t stride = 0)
+            : pixels(pixels), width(width), height(height), stride(stride != 0 ? stride : width) {}
+        const_view(const view& other)
+            : pixels(other.pixels), width(other.width), height(other.height), stride(other.stride) {}
+
+        inline const colour_t* row(uint32_t y) const { return pixels + static_cast<size_t>(y) * stride; }
+        inline colour_t at(uint32_t x, uint32_t y) const { return row(y)[x]; }
+
+        const_view sub(int32_t x, int32_t y, uint32_t w, uint32_t h) const;
+    };
+
+    enum class blend_mode {
+        replace,
+        alpha,
+        premultiplied,
+        additive,
+        multiply
+    };
+
+    void fill(const view& dst, colour_t colour, blend_mode mode = blend_mode::replace);
+
+    // Draws 'src' with its top left corner at (x, y)
+    void blit(const view& dst, const const_view& src, int32_t x, int32_t y, blend_mode mode = blend_mode::alpha);
+
+    // As blit, with the source multiplied per channel (alpha included) by 'tint' first. For
+    // premultiplied sources the tint should be premultiplied too
+    void blit_tinted(const view& dst, const const_view& src, int32_t x, int32_t y, colour_t tint, blend_mode mode = blend_mode::alpha);
+
+    // Bilinear resample of 'src' into the rectangle (x, y, width, height), edges clamped. Filtering
+    // straight alpha pulls in the colour of transparent texels, so prefer premultiplied sources
+    void blit_scaled(const view& dst, const const_view& src, int32_t x, int32_t y, uint32_t width, uint32_t height,
+        blend_mode mode = blend_mode::alpha, colour_t tint = colour::C_WHITE);
+
+    // In place conversion between straight and premultiplied alpha. Unpremultiplying rounds to
+    // nearest and leaves fully transparent pixels as transparent black
+    void premultiply(const view& target);
+    void unpremultiply(const view& target);
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "utility/raycast_batch.h"
+
+#include <EASTL/vector.h>
+
+#include <cstdint>
+
+// Sweep and prune broadphase
+//
+// Finds every overlapping pair among a set of moving boxes. Each axis keeps the boxes' min and
+// max endpoints sorted, and two boxes overlap when their intervals overlap on all three axes.
+// Moving a box insertion sorts its endpoints into place, which from one frame to the next only
+// passes the few endpoints it actually crossed. Every crossing of a min and a max is an interval
+// starting or ending on that axis, so pairs are added and removed as the endpoints move rather
+// than found by searching. Equal values sort mins before maxes, so touching boxes overlap.
+//
+// Current pairs live in an open addressing hash table keyed by the two proxy ids. A pair can
+// come and go several times between calls to flush_events(), which reports only the pairs that
+// started or stopped overlapping since the last call. Pairs carry the user data both proxies had
+// when the pair last changed, so removals can still be matched up after a proxy is gone.
+//
+// Sweep and prune suits many similar sized boxes moving a little each frame. Boxes that jump
+// across the world each cost a pass over every endpoint in between. raycast() walks the sorted x
+// endpoints for the boxes within the ray's reach and confirms each with raycast::test_aabb.
+
+namespace eloo::spatial {
+    using raycast::batch_hit;
+
+    class sweep_and_prune {
+    public:
+        static constexpr uint32_t INVALID_PROXY = UINT32_MAX;
+
+        // 'proxyA' is always the lower id
+        struct overlap_pair {
+            uint32_t proxyA;
+            uint32_t proxyB;
+            uint32_t userDataA;
+            uint32_t userDataB;
+        };
+
+        sweep_and_prune();
+
+        void reserve(size_t proxies);
+        void clear();
+
+        // Boxes must be finite
+        uint32_t insert(const float3::values& min, const float3::values& max, uint32_t userData);
+        void remove(uint32_t proxy);
+        void update(uint32_t proxy, const float3::values& min, const float3::values& max);
+
+        inline size_t size() const { return mProxyCount; }
+        inline size_t pair_count() const { return mPairCount; }
+        uint32_t user_data(uint32_t proxy) const;
+        float3::values min(uint32_t proxy) const;
+        float3::values max(uint32_t proxy) const;
+        bool overlapping(uint32_t proxyA, uint32_t proxyB) const;
+
+        // Appends every current pair
+        size_t pairs(eastl::vector<overlap_pair>& out) const;
+        // Appends the pairs that started and stopped overlapping since the last call
+        void flush_events(eastl::vector<overlap_pair>& added, eastl::vector<overlap_pair>& removed);
+
+        // The closest box hit, reported by user data
+        bool raycast(const raycast::ray& query, batch_hit& closest) const;
+
+    private:
+        struct box_proxy {
+            uint32_t minIndex[3];
+            uint32_t maxIndex[3];
+            // Links the free list while the proxy is pooled, and minIndex[0] is INVALID_PROXY then
+            uint32_t userData;
+        };
+
+        // A hash table slot, empty when 'key' is EMPTY_KEY. 'state' tracks whether the pair
+        // overlaps now, whether it did at the last flush_events(), and whether it changed since
+        struct pair_slot {
+            uint64_t key;
+            uint32_t userDataA;
+            uint32_t userDataB;
+            uint8_t state;
+        };
+
+        void sort_down(int axis, uint32_t index, bool updatePairs);
+        void sort_up(int axis, uint32_t index, bool updatePairs);
+        bool overlaps_off_axis(uint32_t a, uint32_t b, int axis) const;
+
+        uint32_t find_slot(uint64_t key) const;
+        void add_pair(uint32_t a, uint32_t b);
+        void remove_pair(uint32_t a, uint32_t b);
+        pair_slot& touch_pair(uint64_t key, uint32_t slot);
+        void erase_slot(uint32_t slot);
+
+    private:
+        eastl::vector<box_proxy> mProxies;
+        // Sorted endpoints per axis, between a -infinity and an infinity sentinel. Each end is
+        // the proxy id shifted up one, with the low bit set for a max
+        eastl::vector<float> mValues[3];
+        eastl::vector<uint32_t> mEnds[3];
+        eastl::vector<pair_slot> mSlots;
+        // Keys of pairs changed since the last flush_events()
+        eastl::vector<uint64_t> mChanged;
+        // Removal events for pairs that ended along with one of their proxies
+        eastl::vector<overlap_pair> mEnded;
+        uint32_t mFreeProxy = INVALID_PROXY;
+        size_t mProxyCount = 0;
+        size_t mPairCount = 0;
+        // Slots holding a pair, current or waiting to be reported as removed
+        size_t mUsedSlots = 0;
+    };
+}
@@ -0,0 +1,272 @@
+#include "animation/tween.h"
+
+#include "maths/easing.h"
+
+using namespace eloo;
+using namespace eloo::tween;
+
+namespace {
+    ELOO_FORCE_INLINE float unpack_channel(colour_t colour, int channel) {
+        switch (channel) {
+            case 0:  return colour::get_r(colour);
+            case 1:  return colour::get_g(colour);
+            case 2:  return colour::get_b(colour);
+            default: return colour::get_a(colour);
+        }
+    }
+
+    ELOO_FORCE_INLINE uint8_t pack_channel(float value) {
+        return static_cast<uint8_t>(math::clamp(value, 0.0f, 255.0f) + 0.5f);
+    }
+}
+
+
+/////////////////////////////////////////////////////////////////////
+// Groups
+
+group_id_t tween::manager::create_group(math::interpolation::blend_func func, math::interpolation::blend_opt options, float timeScale) {
+    group& grp = mGroups.emplace_back();
+    grp.func = func;
+    grp.options = options;
+    grp.timeScale = timeScale;
+    return static_cast<group_id_t>(mGroups.size() - 1);
+}
+
+void tween::manager::set_group_time_scale(group_id_t group, float timeScale) {
+    ELOO_ASSERT(group < mGroups.size(), "Invalid tween group %u", group);
+    mGroups[group].timeScale = timeScale;
+}
+
+void tween::manager::set_group_paused(group_id_t group, bool isPaused) {
+    ELOO_ASSERT(group < mGroups.size(), "Invalid tween group %u", group);
+    mGroups[group].isPaused = isPaused;
+}
+
+void tween::manager::clear_group(group_id_t group) {
+    ELOO_ASSERT(group < mGroups.size(), "Invalid tween group %u", group);
+    auto& grp = mGroups[group];
+    while (grp.scalars.size() > 0) { try_release(grp.scalars.ids.back()); }
+    while (grp.vectors.size() > 0) { try_release(grp.vectors.ids.back()); }
+    while (grp.colours.size() > 0) { try_release(grp.colours.ids.back()); }
+}
+
+
+/////////////////////////////////////////////////////////////////////
+// Tracks
+
+tween::id_t tween::manager::create(group_id_t group, float* target, float from, float to, float duration, uint8_t trackFlags) {
+    ELOO_ASSERT_FATAL(group < mGroups.size(), "Invalid tween group %u", group);
+    return push_track(group, track_kind::scalar, mGroups[group].scalars, target, &from, &to, duration, trackFlags);
+}
+
+tween::id_t tween::manager::create(group_id_t group, float3::values* target, const float3::values& from, const float3::values& to, float duration, uint8_t trackFlags) {
+    ELOO_ASSERT_FATAL(group < mGroups.size(), "Invalid tween group %u", group);
+    const float fromArr[3] = { FLOAT3_UNPACK(from) };
+    const float toArr[3] = { FLOAT3_UNPACK(to) };
+    return push_track(group, track_kind::vector3, mGroups[group].vectors, target, fromArr, toArr, duration, trackFlags);
+}
+
+tween::id_t tween::manager::create(group_id_t group, colour_t* target, colour_t from, colour_t to, float duration, uint8_t trackFlags) {
+    ELOO_ASSERT_FATAL(group < mGroups.size(), "Invalid tween group %u", group);
+    float fromArr[4], toArr[4];
+    for (int channel = 0; channel < 4; ++channel) {
+        fromArr[channel] = unpack_channel(from, channel);
+        toArr[channel] = unpack_channel(to, channel);
+    }
+    return push_track(group, track_kind::colour, mGroups[group].colours, target, fromArr, toArr, duration, trackFlags);
+}
+
+bool tween::manager::try_release(id_t id) {
+    if (!is_valid(id)) {
+        return false;
+    }
+    const location loc = mLocations[id];
+    group& grp = mGroups[loc.group];
+    switch (loc.kind) {
+        case track_kind::scalar:    remove_track(grp.scalars, loc.index); break;
+        case track_kind::vector3:   remove_track(grp.vectors, loc.index); break;
+        case track_kind::colour:    remove_track(grp.colours, loc.index); break;
+        default: break;
+    }
+    return true;
+}
+
+bool tween::manager::is_valid(id_t id) const {
+    return id < mLocations.size() && mLocations[id].kind != track_kind::invalid;
+}
+
+void tween::manager::set_paused(id_t id, bool isPaused) {
+    if (!is_valid(id)) {
+        ELOO_ASSERT_FALSE("Attempting to pause invalid tween %zu", static_cast<size_t>(id));
+        return;
+    }
+    uint8_t& trackFlags = track_flags(mLocations[id]);
+    trackFlags = isPaused ? (trackFlags | flags::paused) : (trackFlags & ~flags::paused);
+}
+
+size_t tween::manager::count() const {
+    size_t total = 0;
+    for (const group& grp : mGroups) {
+        total += grp.scalars.size() + grp.vectors.size() + grp.colours.size();
+    }
+    return total;
+}
+
+uint8_t& tween::manager::track_flags(const location& loc) {
+    group& grp = mGroups[loc.group];
+    switch (loc.kind) {
+        case track_kind::scalar:    return grp.scalars.trackFlags[loc.index];
+        case track_kind::vector3:   return grp.vectors.trackFlags[loc.index];
+        default:                    return grp.colours.trackFlags[loc.index];
+    }
+}
+
+
+/////////////////////////////////////////////////////////////////////
+// Update
+
+void tween::manager::update(float deltaTime) {
+    mCompleted.clear();
+    for (group& grp : mGroups) {
+        if (grp.isPaused) {
+            continue;
+        }
+        const float scaledDelta = deltaTime * grp.timeScale;
+        advance_pool(grp, grp.scalars, scaledDelta);
+        advance_pool(grp, grp.vectors, scaledDelta);
+        advance_pool(grp, grp.colours, scaledDelta);
+    }
+
+    if (!mCompleted.empty()) {
+        mOnCompleted.broadcast(eastl::span<const id_t>(mCompleted.data(), mCompleted.size()));
+    }
+}
+
+template <int ChannelCount, typename TargetT>
+void tween::manager::advance_pool(const group& grp, track_pool<ChannelCount, TargetT>& pool, float deltaTime) {
+    const size_t count = pool.size();
+    if (count == 0) {
+        return;
+    }
+
+    // 1) Advance time and resolve the normalised time of every track
+    mScratchT.resize(count);
+    mScratchWeights.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        const uint8_t trackFlags = pool.trackFlags[i];
+        const float duration = pool.duration[i];
+        float elapsed = pool.elapsed[i] + ((trackFlags & flags::paused) ? 0.0f : deltaTime);
+
+        float t;
+        if (trackFlags & flags::ping_pong) {
+            elapsed = std::fmod(elapsed, duration * 2.0f);
+            t = elapsed / duration;
+            t = t > 1.0f ? 2.0f - t : t;
+        } else if (trackFlags & flags::looping) {
+            elapsed = std::fmod(elapsed, duration);
+            t = elapsed / duration;
+        } else {
+            t = elapsed / duration;
+        }
+
+        pool.elapsed[i] = elapsed;
+        mScratchT[i] = t;
+    }
+
+    // 2) One curve evaluation over the whole pool
+    math::interpolation::blend(
+        eastl::span<const float>(mScratchT.data(), count),
+        eastl::span<float>(mScratchWeights.data(), count),
+        grp.func, grp.options);
+
+    // 3) Write the results straight into the targets
+    const float* weights = mScratchWeights.data();
+    if constexpr (eastl::is_same_v<TargetT, float>) {
+        for (size_t i = 0; i < count; ++i) {
+            *pool.targets[i] = pool.from[0][i] + pool.delta[0][i] * weights[i];
+        }
+    } else if constexpr (eastl::is_same_v<TargetT, float3::values>) {
+        for (size_t i = 0; i < count; ++i) {
+            float3::values& target = *pool.targets[i];
+            target.x() = pool.from[0][i] + pool.delta[0][i] * weights[i];
+            target.y() = pool.from[1][i] + pool.delta[1][i] * weights[i];
+            target.z() = pool.from[2][i] + pool.delta[2][i] * weights[i];
+        }
+    } else {
+        for (size_t i = 0; i < count; ++i) {
+            *pool.targets[i] = colour::make_rgba(
+                pack_channel(pool.from[0][i] + pool.delta[0][i] * weights[i]),
+                pack_channel(pool.from[1][i] + pool.delta[1][i] * weights[i]),
+                pack_channel(pool.from[2][i] + pool.delta[2][i] * weights[i]),
+                pack_channel(pool.from[3][i] + pool.delta[3][i] * weights[i]));
+        }
+    }
+
+    // 4) Collect and release completed tracks. Walking backwards keeps swap-removal valid
+    for (size_t i = count; i-- > 0;) {
+        if ((pool.trackFlags[i] & (flags::looping | flags::ping_pong)) == 0 && pool.elapsed[i] >= pool.duration[i]) {
+            mCompleted.push_back(pool.ids[i]);
+            remove_track(pool, i);
+        }
+    }
+}
+
+
+/////////////////////////////////////////////////////////////////////
+// Pool management
+
+template <int ChannelCount, typename TargetT>
+tween::id_t tween::manager::push_track(group_id_t groupID, track_kind kind, track_pool<ChannelCount, TargetT>& pool, TargetT* target, const float* from, const float* to, float duration, uint8_t trackFlags) {
+    ELOO_ASSERT(target != nullptr, "Tween target cannot be null");
+
+    size_t id = mLocations.size();
+    if (!mUnusedIDs.empty()) {
+        id = mUnusedIDs.back();
+        mUnusedIDs.pop_back();
+    } else {
+        mLocations.emplace_back();
+    }
+
+    mLocations[id] = { groupID, kind, static_cast<uint32_t>(pool.size()) };
+
+    pool.elapsed.push_back(0.0f);
+    pool.duration.push_back(math::max(duration, math::f32::EPSILON));
+    pool.trackFlags.push_back(trackFlags);
+    for (int channel = 0; channel < ChannelCount; ++channel) {
+        pool.from[channel].push_back(from[channel]);
+        pool.delta[channel].push_back(to[channel] - from[channel]);
+    }
+    pool.targets.push_back(target);
+    pool.ids.push_back(id);
+    return id;
+}
+
+template <int ChannelCount, typename TargetT>
+void tween::manager::remove_track(track_pool<ChannelCount, TargetT>& pool, size_t index) {
+    const size_t last = pool.size() - 1;
+    mLocations[pool.ids[index]].kind = track_kind::invalid;
+    mUnusedIDs.push_back(pool.ids[index]);
+
+    if (index != last) {
+        pool.elapsed[index] = pool.elapsed[last];
+        pool.duration[index] = pool.duration[last];
+        pool.trackFlags[index] = pool.trackFlags[last];
+        for (int channel = 0; channel < ChannelCount; ++channel) {
+            pool.from[channel][index] = pool.from[channel][last];
+            pool.delta[channel][index] = pool.delta[channel][last];
+        }
+        pool.targets[index] = pool.targets[last];
+        pool.ids[index] = pool.ids[last];
+        mLocations[pool.ids[index]].index = static_cast<uint32_t>(index);
+    }
+
+    pool.elapsed.pop_back();
+    pool.duration.pop_back();
+    pool.trackFlags.pop_back();
+    for (int channel = 0; channel < ChannelCount; ++channel) {
+        pool.from[channel].pop_back();
+        pool.delta[channel].pop_back();
+    }
+    pool.targets.pop_back();
+    pool.ids.pop_back();
+}
@@ -1,256 +1,73 @@
-#include "maths/math.h"
+#include "maths/easing.h"
 
 #include "utility/defines.h"
 
+#include <EASTL/algorithm.h>
 #include <EASTL/array.h>
 
 
-#define DEFINE_INTERPOLATION_TYPE(interp_t) ELOO_FORCE_INLINE float blend_##interp_t(float t, eloo::math::interpolation::ease_type ease) { \
-    switch (ease) { \
-        case eloo::math::interpolation::ease_type::in:      return interp_t##_in(t); \
-        case eloo::math::interpolation::ease_type::out:     return interp_t##_out(t); \
-        case eloo::math::interpolation::ease_type::in_out:  return interp_t##_in_out(t); \
+using namespace eloo::math::interpolation;
+
+#define DEFINE_INTERPOLATION_TYPE(interp_t) ELOO_FORCE_INLINE float blend_##interp_t(float t, ease_type easeType) { \
+    switch (easeType) { \
+        case ease_type::in:      return ease::interp_t##_in(t); \
+        case ease_type::out:     return ease::interp_t##_out(t); \
+        case ease_type::in_out:  return ease::interp_t##_in_out(t); \
         default: ELOO_ASSERT_FALSE("Attempting to use " #interp_t " interpolation with unknown ease type %i", \
-                                   static_cast<int>(ease)); \
+                                   static_cast<int>(easeType)); \
         } \
     return 0.0f; \
 }
 
 #define DEFINE_INTERPOLATION_TYPE_PARAM(interp_t, param_t, param_name, param_default_value) \
-ELOO_FORCE_INLINE float blend_##interp_t(float t, eloo::math::interpolation::ease_type ease, param_t param_name = param_default_value) { \
-    switch (ease) { \
-        case eloo::math::interpolation::ease_type::in:      return interp_t##_in(t, param_name); \
-        case eloo::math::interpolation::ease_type::out:     return interp_t##_out(t, param_name); \
-        case eloo::math::interpolation::ease_type::in_out:  return interp_t##_in_out(t, param_name); \
+ELOO_FORCE_INLINE float blend_##interp_t(float t, ease_type easeType, param_t param_name = param_default_value) { \
+    switch (easeType) { \
+        case ease_type::in:      return ease::interp_t##_in(t, param_name); \
+        case ease_type::out:     return ease::interp_t##_out(t, param_name); \
+        case ease_type::in_out:  return ease::interp_t##_in_out(t, param_name); \
         default: ELOO_ASSERT_FALSE("Attempting to use " #interp_t " interpolation with unknown ease type %i", \
-                                   static_cast<int>(ease)); \
+                                   static_cast<int>(easeType)); \
         } \
     return 0.0f; \
 }
 
 namespace {
-    // Sine         //////////////////////////////////////
-    ELOO_FORCE_INLINE float sine_in(float t) {
-        return 1.0f - eloo::math::cos(t * eloo::math::f32::PI * 0.5f);
-    }
-
-    ELOO_FORCE_INLINE float sine_out(float t) {
-        return eloo::math::sin(t * eloo::math::f32::PI * 0.5f);
-    }
-
-    ELOO_FORCE_INLINE float sine_in_out(float t) {
-        return -(eloo::math::cos(t * eloo::math::f32::PI) - 1.0f) * 0.5f;
-    }
-
     DEFINE_INTERPOLATION_TYPE(sine)
-
-    // Quad         //////////////////////////////////////
-    ELOO_FORCE_INLINE float quad_in(float t) {
-        return t * t;
-    }
-
-    ELOO_FORCE_INLINE float quad_out(float t) {
-        const float omt = 1.0f - t;
-        return 1.0f - omt * omt;
-    }
-
-    ELOO_FORCE_INLINE float quad_in_out(float t) {
-        const float omt = 1.0f - t;
-        return t < 0.5f ? 2.0f * t * t : 1.0f - 2.0f * omt * omt;
-    }
-
     DEFINE_INTERPOLATION_TYPE(quad)
-
-    // Cubic        //////////////////////////////////////
-    ELOO_FORCE_INLINE float cubic_in(float t) {
-        return t * t * t;
-    }
-
-    ELOO_FORCE_INLINE float cubic_out(float t) {
-        const float omt = 1.0f - t;
-        return 1.0f - omt * omt * omt;
-    }
-
-    ELOO_FORCE_INLINE float cubic_in_out(float t) {
-        const float omt = 1.0f - t;
-        return t < 0.5f ? 4.0f * t * t * t : 1.0f - 4.0f * omt * omt * omt;
-    }
-
     DEFINE_INTERPOLATION_TYPE(cubic)
-
-    // Quart        //////////////////////////////////////
-    ELOO_FORCE_INLINE float quart_in(float t) {
-        return t * t * t * t;
-    }
-
-    ELOO_FORCE_INLINE float quart_out(float t) {
-        const float omt = 1.0f - t;
-        return 1.0f - omt * omt * omt * omt;
-    }
-
-    ELOO_FORCE_INLINE float quart_in_out(float t) {
-        const float omt = 1.0f - t;
-        return t < 0.5f ? 8.0f * t * t * t * t : 1.0f - 8.0f * omt * omt * omt * omt;
-    }
-
     DEFINE_INTERPOLATION_TYPE(quart)
-
-    // Quint        //////////////////////////////////////
-    ELOO_FORCE_INLINE float quint_in(float t) {
-        return t * t * t * t * t;
-    }
-
-    ELOO_FORCE_INLINE float quint_out(float t) {
-        const float omt = 1.0f - t;
-        return 1.0f - omt * omt * omt * omt * omt;
-    }
-
-    ELOO_FORCE_INLINE float quint_in_out(float t) {
-        const float omt = 1.0f - t;
-        return t < 0.5f ? 16.0f * t * t * t * t * t : 1.0f - 16.0f * omt * omt * omt * omt * omt;
-    }
-
     DEFINE_INTERPOLATION_TYPE(quint)
-
-    // Circ         //////////////////////////////////////
-    ELOO_FORCE_INLINE float circ_in(float t) {
-        return 1.0f - sqrt(1.0f - pow(t, 2.0f));
-    }
-
-    ELOO_FORCE_INLINE float circ_out(float t) {
-        return sqrt(1.0f - pow(t - 1.0f, 2.0f));
-    }
-
-    ELOO_FORCE_INLINE float circ_in_out(float t) {
-        t *= 2.0f;
-        return (t < 1.0f ? circ_in(t) : 1.0f + circ_out(t - 1.0f)) * 0.5f;
-    }
-
     DEFINE_INTERPOLATION_TYPE(circ)
-
-    // Expo         //////////////////////////////////////
-    ELOO_FORCE_INLINE float expo_in(float t, float power = 10.0f) {
-        return t == 0.0f ? 0.0f : pow(2.0f, power * t - power);
-    }
-
-    ELOO_FORCE_INLINE float expo_out(float t, float power = 10.0f) {
-        return t == 1.0f ? 1.0f : 1.0f - pow(2.0f, -power * t);
-    }
-
-    ELOO_FORCE_INLINE float expo_in_out(float t, float power = 10.0f) {
-        return t < 0.5f ? pow(2.0f * t, power) * 0.5f : 1.0f - pow(2.0f * (1.0f - t), power) * 0.5f;
-    }
-
-    DEFINE_INTERPOLATION_TYPE_PARAM(expo, float, power, 10)
-
-    // Back         //////////////////////////////////////
-    ELOO_FORCE_INLINE float back_in(float t, float overshoot = 1.70158f) {
-        const float s3 = overshoot + 1.0f;
-        return s3 * t * t * t - overshoot * t * t;
-    }
-
-    ELOO_FORCE_INLINE float back_out(float t, float overshoot = 1.70158f) {
-        const float s3 = overshoot + 1.0f;
-        const float tmo = t - 1.0f;
-        return 1.0f + s3 * tmo * tmo * tmo + overshoot * tmo * tmo;
-    }
-
-    ELOO_FORCE_INLINE float back_in_out(float t, float overshoot = 1.70158f) {
-        t *= 2.0f;
-        const float s = overshoot * 1.525f;
-        return t < 1.0f
-            ? 0.5f * (t * t * ((s + 1.0f) * t - s))
-            : 0.5f * ((t - 2.0f) * (t - 2.0f) * ((s + 1.0f) * (t - 2.0f) + s) + 2.0f);
-    }
-
-    DEFINE_INTERPOLATION_TYPE_PARAM(back, float, overshoot, 1.70158f)
-
-    // Elastic      //////////////////////////////////////
-    ELOO_FORCE_INLINE float elastic_in(float t) {
-        return -eloo::math::pow(2.0f, 10.0f * (t - 1.0f)) * eloo::math::sin(((t - 0.075f) * eloo::math::f32::TAU) * 3.3333333f);
-    }
-
-    ELOO_FORCE_INLINE float elastic_out(float t) {
-        return 1.0f + eloo::math::pow(2.0f, -10.0f * t) * eloo::math::sin(((t - 0.075f) * eloo::math::f32::TAU) * 3.3333333f);
-    }
-
-    ELOO_FORCE_INLINE float elastic_in_out(float t) {
-        if (t == 0.0f || t == 1.0f) return t;
-        t *= 2.0f;
-        if (t < 1.0f) return -0.5f * eloo::math::pow(2.0f, 10.0f * (t - 1.0f)) * eloo::math::sin(((t - 1.075f) * eloo::math::f32::TAU) * 3.3333333f);
-        return 0.5f + 0.5f * eloo::math::pow(2.0f, -10.0f * (t - 1.0f)) * eloo::math::sin(((t - 1.075f) * eloo::math::f32::TAU) * 3.3333333f);
-    }
-
     DEFINE_INTERPOLATION_TYPE(elastic)
-
-    // Bounce       //////////////////////////////////////
-    ELOO_FORCE_INLINE float bounce_out(float t) {
-        float n1 = 7.5625f;
-        float d1 = 0.363636f;
-        if (t < d1) { return n1 * t * t; }
-        if (t < d1 * 2.0f) { return n1 * (t - d1 * 1.5f) * (t - d1 * 1.5f) + 0.75f; }
-        if (t < d1 * 2.5f) { return n1 * (t - d1 * 2.25f) * t + 0.9375f; }
-        return n1 * (t - d1 * 2.625f) * t + 0.984375f;
-    }
-
-    ELOO_FORCE_INLINE float bounce_in(float t) {
-        return 1.0f - bounce_out(1.0f - t);
-    }
-
-    ELOO_FORCE_INLINE float bounce_in_out(float t) {
-        t *= 2.0f;
-        return (t < 1 ? bounce_in(t) : 1.0f + bounce_out(t - 1.0f)) * 0.5f;
-    }
-
     DEFINE_INTERPOLATION_TYPE(bounce)
-
-    // Log          //////////////////////////////////////
-    ELOO_FORCE_INLINE float log_in(float t) {
-        return eloo::math::log(1.0f + t * (eloo::math::f32::E - 1.0f));
-    }
-
-    ELOO_FORCE_INLINE float log_out(float t) {
-        return 1.0f - eloo::math::log(1.0f + (1.0f - t) * (eloo::math::f32::E - 1.0f));
-    }
-
-    ELOO_FORCE_INLINE float log_in_out(float t) {
-        t *= 2.0f;
-        return (t < 1 ? log_in(t) : 1.0f + log_out(t - 1.0f)) * 0.5f;
-    }
-
     DEFINE_INTERPOLATION_TYPE(log)
-
-    // Poly         //////////////////////////////////////
-    ELOO_FORCE_INLINE float poly_in(float t, float n) {
-        return pow(t, n);
-    }
-
-    ELOO_FORCE_INLINE float poly_out(float t, float  n) {
-        return 1.0f - pow(1.0f - t, n);
-    }
-
-    ELOO_FORCE_INLINE float poly_in_out(float t, float n) {
-        t *= 2.0f;
-        return (t < 1 ? poly_in(t, n) : 1.0f + poly_out(t - 1.0f, n)) * 0.5f;
-    }
-
+    DEFINE_INTERPOLATION_TYPE_PARAM(expo, float, power, 10)
+    DEFINE_INTERPOLATION_TYPE_PARAM(back, float, overshoot, 1.70158f)
     DEFINE_INTERPOLATION_TYPE_PARAM(poly, float, n, 5)
 
-    // Bezier       //////////////////////////////////////
     ELOO_FORCE_INLINE float blend_bezier(float t, float ctrl1 = 0.1f, float ctrl2 = 0.1f) {
-        const float omt = 1.0f - t;
-        return 3.0f * omt * omt * t * ctrl1 + 3.0f * omt * t * t * ctrl2 + t * t * t;
+        return ease::bezier(t, ctrl1, ctrl2);
     }
 
-    // Step         //////////////////////////////////////
     ELOO_FORCE_INLINE float blend_step(float t, unsigned int steps) {
-        return round(t * steps) / static_cast<float>(steps);
+        return ease::step(t, steps);
     }
 
-    // Spring       //////////////////////////////////////
-    //https://www.desmos.com/calculator/jr8dd7xjr6
     ELOO_FORCE_INLINE float blend_spring(float t, float frequency = 0.64f, float oscillation = 5.6f, float decay = 1.4f) {
-        return (sin(t * eloo::math::f32::PI * (frequency + oscillation * t * t * t)) * pow(1.0f - t, decay) + t) * (1.0f + (0.8f * pow(1.0f - t, t)));
+        return ease::spring(t, frequency, oscillation, decay);
+    }
+
+    // Resolves the ease type of a blend function at runtime, then hands the whole span to the
+    // compile-time kernel so the inner loop has no dispatch
+    template <blend_func Func, typename... Params>
+    void blend_batch(eastl::span<const float> t, eastl::span<float> out, ease_type ease, Params... params) {
+        switch (ease) {
+            case ease_type::in:     blend<Func, ease_type::in>(t, out, params...); return;
+            case ease_type::out:    blend<Func, ease_type::out>(t, out, params...); return;
+            case ease_type::in_out: blend<Func, ease_type::in_out>(t, out, params...); return;
+            default: ELOO_ASSERT_FALSE("Attempting to use batch blending with unknown ease type %i",
+                                       static_cast<int>(ease));
+        }
     }
 }
 
@@ -342,4 +159,108 @@ float eloo::math::interpolation::interpolate(float from, float to, float t, blen
     }
 
     return to;
+}
+
+void eloo::math::interpolation::blend(eastl::span<const float> t, eastl::span<float> out, blend_func type, blend_opt options) {
+    ease_type ease = ease_type::in;
+    if (eastl::holds_alternative<ease_opt>(options)) {
+        ease = eastl::get<ease_opt>(options).ease;
+    }
+
+    switch (type) {
+        case blend_func::lerp:      blend_batch<blend_func::lerp>(t, out, ease); return;
+        case blend_func::sine:      blend_batch<blend_func::sine>(t, out, ease); return;
+        case blend_func::quad:      blend_batch<blend_func::quad>(t, out, ease); return;
+        case blend_func::cubic:     blend_batch<blend_func::cubic>(t, out, ease); return;
+        case blend_func::quart:     blend_batch<blend_func::quart>(t, out, ease); return;
+        case blend_func::quint:     blend_batch<blend_func::quint>(t, out, ease); return;
+        case blend_func::circ:      blend_batch<blend_func::circ>(t, out, ease); return;
+        case blend_func::elastic:   blend_batch<blend_func::elastic>(t, out, ease); return;
+        case blend_func::bounce:    blend_batch<blend_func::bounce>(t, out, ease); return;
+        case blend_func::log:       blend_batch<blend_func::log>(t, out, ease); return;
+
+        //////////////////////////////////////////////
+        // Types with optional data
+
+        case blend_func::expo: {
+            if (eastl::holds_alternative<expo_opt>(options)) {
+                const expo_opt& data = eastl::get<expo_opt>(options);
+                blend_batch<blend_func::expo>(t, out, data.ease, data.power);
+                return;
+            }
+            blend_batch<blend_func::expo>(t, out, ease);
+            return;
+        }
+
+        case blend_func::back: {
+            if (eastl::holds_alternative<back_opt>(options)) {
+                const back_opt& data = eastl::get<back_opt>(options);
+                blend_batch<blend_func::back>(t, out, data.ease, data.overshoot);
+                return;
+            }
+            blend_batch<blend_func::back>(t, out, ease);
+            return;
+        }
+
+        case blend_func::bezier: {
+            if (eastl::holds_alternative<bezier_opt>(options)) {
+                const bezier_opt& data = eastl::get<bezier_opt>(options);
+                blend<blend_func::bezier>(t, out, data.ctrl1, data.ctrl2);
+                return;
+            }
+            blend<blend_func::bezier>(t, out);
+            return;
+        }
+
+        case blend_func::spring: {
+            if (eastl::holds_alternative<spring_opt>(options)) {
+                const spring_opt& data = eastl::get<spring_opt>(options);
+                blend<blend_func::spring>(t, out, data.frequency, data.oscillation, data.decay);
+                return;
+            }
+            blend<blend_func::spring>(t, out);
+            return;
+        }
+
+        //////////////////////////////////////////////
+        // Types with REQUIRED data
+
+        case blend_func::poly: {
+            if (eastl::holds_alternative<poly_opt>(options)) {
+                const poly_opt& data = eastl::get<poly_opt>(options);
+                blend_batch<blend_func::poly>(t, out, data.ease, data.n);
+                return;
+            }
+            ELOO_ASSERT_FALSE("Attempting to call interpolation::interpolate() of blend_func::blend_poly without passing in a poly_opt struct.");
+            break;
+        }
+
+        case blend_func::step: {
+            if (eastl::holds_alternative<step_opt>(options)) {
+                const step_opt& data = eastl::get<step_opt>(options);
+                blend<blend_func::step>(t, out, data.steps);
+                return;
+            }
+            ELOO_ASSERT_FALSE("Attempting to call interpolation::interpolate() of blend_func::blend_steps without passing in a step_opt struct.");
+            break;
+        }
+
+        // Unknown type
+        default: {
+            ELOO_ASSERT_FALSE("Attempting to call interpolation::interpolate() with unknown type %i",
+                static_cast<int>(type));
+            break;
+        }
+    }
+
+    // Matches the scalar path, which returns 'to' when it cannot resolve the blend
+    eastl::fill(out.begin(), out.end(), 1.0f);
+}
+
+void eloo::math::interpolation::interpolate(eastl::span<const float> from, eastl::span<const float> to, eastl::span<const float> t, eastl::span<float> out, blend_func type, blend_opt options) {
+    ELOO_ASSERT(from.size() == to.size() && from.size() == t.size() && from.size() == out.size(), "Batch interpolation requires equally sized spans.");
+    blend(t, out, type, options);
+    for (size_t i = 0; i < out.size(); ++i) {
+        out[i] = apply_weight(from[i], to[i], out[i]);
+    }
 }
\ No newline at end of file
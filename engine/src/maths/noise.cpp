@@ -0,0 +1,545 @@
+#include "maths/noise.h"
+
+#include "maths/simd.h"
+#include "utility/parallel.h"
+
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+using namespace eloo;
+using namespace eloo::math::noise;
+
+namespace {
+    constexpr uint32_t PRIMES[4] = { 501125321u, 1136930381u, 1720413743u, 1066037191u };
+    constexpr uint32_t OCTAVE_SEED_STEP = 0x9E3779B9u;
+    constexpr size_t TILE_SAMPLES = 4096;
+
+    // Output scales, measured so each noise peaks at roughly +-1
+    constexpr float PERLIN_SCALE[5] = { 0.0f, 0.0f, 1.48f, 1.0f, 0.87f };
+    constexpr float SIMPLEX_SCALE[5] = { 0.0f, 0.0f, 91.0f, 76.0f, 62.0f };
+
+
+    /////////////////////////////////////////////////////////////////////
+    // Lanes
+    //
+    // Each noise is written once against these, 'F' holding positions, 'I' wrapping 32 bit
+    // lattice hashes and 'M' comparison results.
+
+    struct scalar_lanes {
+        using F = float;
+        using I = uint32_t;
+        using M = bool;
+
+        static ELOO_FORCE_INLINE F set(float s)                 { return s; }
+        static ELOO_FORCE_INLINE I iset(uint32_t s)             { return s; }
+        static ELOO_FORCE_INLINE F floor(F a)                   { return std::floor(a); }
+        static ELOO_FORCE_INLINE F min(F a, F b)                { return a < b ? a : b; }
+        static ELOO_FORCE_INLINE F max(F a, F b)                { return a > b ? a : b; }
+        static ELOO_FORCE_INLINE F abs(F a)                     { return std::fabs(a); }
+        static ELOO_FORCE_INLINE F sqrt(F a)                    { return std::sqrt(a); }
+        static ELOO_FORCE_INLINE M gt(F a, F b)                 { return a > b; }
+        static ELOO_FORCE_INLINE M ge(F a, F b)                 { return a >= b; }
+        static ELOO_FORCE_INLINE M both(M a, M b)               { return a && b; }
+        static ELOO_FORCE_INLINE M either(M a, M b)             { return a || b; }
+        static ELOO_FORCE_INLINE M invert(M a)                  { return !a; }
+        static ELOO_FORCE_INLINE F select(M m, F a, F b)        { return m ? a : b; }
+        static ELOO_FORCE_INLINE I iselect(M m, I a, I b)       { return m ? a : b; }
+        static ELOO_FORCE_INLINE I to_int(F a)                  { return static_cast<uint32_t>(static_cast<int32_t>(a)); }
+        static ELOO_FORCE_INLINE F to_float(I a)                { return static_cast<float>(static_cast<int32_t>(a)); }
+        static ELOO_FORCE_INLINE M less(I a, uint32_t b)        { return static_cast<int32_t>(a) < static_cast<int32_t>(b); }
+        static ELOO_FORCE_INLINE M equal(I a, uint32_t b)       { return a == b; }
+        static ELOO_FORCE_INLINE M has_bits(I a, uint32_t bits) { return (a & bits) != 0; }
+
+        // Negates 'a' where bit 'bit' of 'h' is set
+        static ELOO_FORCE_INLINE F flip(F a, I h, int bit) {
+            uint32_t bits;
+            std::memcpy(&bits, &a, sizeof(bits));
+            bits ^= (h << (31 - bit)) & 0x80000000u;
+            std::memcpy(&a, &bits, sizeof(bits));
+            return a;
+        }
+    };
+
+    struct simd_lanes {
+        using F = math::simd::f32x4;
+        using I = math::simd::i32x4;
+        using M = math::simd::f32x4;
+
+        static ELOO_FORCE_INLINE F set(float s)                 { return math::simd::set1(s); }
+        static ELOO_FORCE_INLINE I iset(uint32_t s)             { return math::simd::set1_i32(static_cast<int32_t>(s)); }
+        static ELOO_FORCE_INLINE F floor(F a)                   { return math::simd::floor(a); }
+        static ELOO_FORCE_INLINE F min(F a, F b)                { return math::simd::min(a, b); }
+        static ELOO_FORCE_INLINE F max(F a, F b)                { return math::simd::max(a, b); }
+        static ELOO_FORCE_INLINE F abs(F a)                     { return math::simd::abs(a); }
+        static ELOO_FORCE_INLINE F sqrt(F a)                    { return math::simd::sqrt(a); }
+        static ELOO_FORCE_INLINE M gt(F a, F b)                 { return math::simd::cmp_gt(a, b); }
+        static ELOO_FORCE_INLINE M ge(F a, F b)                 { return math::simd::cmp_ge(a, b); }
+        static ELOO_FORCE_INLINE M both(M a, M b)               { return math::simd::bit_and(a, b); }
+        static ELOO_FORCE_INLINE M either(M a, M b)             { return math::simd::bit_or(a, b); }
+        static ELOO_FORCE_INLINE M invert(M a)                  { return math::simd::as_f32(math::simd::as_i32(a) ^ iset(0xFFFFFFFFu)); }
+        static ELOO_FORCE_INLINE F select(M m, F a, F b)        { return math::simd::select(m, a, b); }
+        static ELOO_FORCE_INLINE I iselect(M m, I a, I b)       { return math::simd::select(math::simd::as_i32(m), a, b); }
+        static ELOO_FORCE_INLINE I to_int(F a)                  { return math::simd::to_i32(a); }
+        static ELOO_FORCE_INLINE F to_float(I a)                { return math::simd::to_f32(a); }
+        static ELOO_FORCE_INLINE M less(I a, uint32_t b)        { return math::simd::as_f32(math::simd::cmp_lt(a, iset(b))); }
+        static ELOO_FORCE_INLINE M equal(I a, uint32_t b)       { return math::simd::as_f32(math::simd::cmp_eq(a, iset(b))); }
+        static ELOO_FORCE_INLINE M has_bits(I a, uint32_t bits) { return invert(equal(a & iset(bits), 0)); }
+
+        static ELOO_FORCE_INLINE F flip(F a, I h, int bit) {
+            return math::simd::as_f32(math::simd::as_i32(a) ^ ((h << (31 - bit)) & iset(0x80000000u)));
+        }
+    };
+
+
+    /////////////////////////////////////////////////////////////////////
+    // Shared helpers
+
+    // Coordinates are premultiplied by their axis prime, the combined value goes through the
+    // lowbias32 finaliser so every output bit depends on every input bit
+    template <typename L, int Dims>
+    ELOO_FORCE_INLINE typename L::I hash(typename L::I seed, const typename L::I* primed) {
+        typename L::I h = seed;
+        for (int a = 0; a < Dims; ++a) {
+            h = h ^ primed[a];
+        }
+        h = h ^ (h >> 16);
+        h = h * L::iset(0x7FEB352Du);
+        h = h ^ (h >> 15);
+        h = h * L::iset(0x846CA68Bu);
+        return h ^ (h >> 16);
+    }
+
+    // Top 24 bits of the hash mapped onto [-1, 1]
+    template <typename L>
+    ELOO_FORCE_INLINE typename L::F unit(typename L::I h) {
+        return L::to_float(h >> 8) * L::set(2.0f / 16777215.0f) - L::set(1.0f);
+    }
+
+    template <typename L>
+    ELOO_FORCE_INLINE typename L::F fade(typename L::F t) {
+        return t * t * t * (t * (t * L::set(6.0f) - L::set(15.0f)) + L::set(10.0f));
+    }
+
+    template <typename L>
+    ELOO_FORCE_INLINE typename L::F lerp(typename L::F a, typename L::F b, typename L::F t) {
+        return a + (b - a) * t;
+    }
+
+    // Dot product of the offset with one of a fixed set of gradients picked by the top hash bits
+    template <typename L, int Dims>
+    ELOO_FORCE_INLINE typename L::F gradient(typename L::I h, const typename L::F* d) {
+        using F = typename L::F;
+        const typename L::I g = h >> 27;
+
+        if constexpr (Dims == 2) {
+            // (+-1, +-0.5) and (+-0.5, +-1)
+            const typename L::M swap = L::has_bits(g, 2);
+            const F u = L::select(swap, d[1], d[0]);
+            const F v = L::select(swap, d[0], d[1]);
+            return L::flip(u, g, 0) + L::flip(v, g, 1) * L::set(0.5f);
+        } else if constexpr (Dims == 3) {
+            // Ken Perlin's 12 cube edges, with 4 repeated to make 16
+            const typename L::I e = g & L::iset(15);
+            const F u = L::select(L::less(e, 8), d[0], d[1]);
+            const F v = L::select(L::less(e, 4), d[1], L::select(L::either(L::equal(e, 12), L::equal(e, 14)), d[0], d[2]));
+            return L::flip(u, e, 0) + L::flip(v, e, 1);
+        } else {
+            // 32 edges of the tesseract
+            const F u = L::select(L::less(g, 24), d[0], d[1]);
+            const F v = L::select(L::less(g, 16), d[1], d[2]);
+            const F w = L::select(L::less(g, 8), d[2], d[3]);
+            return L::flip(u, g, 0) + L::flip(v, g, 1) + L::flip(w, g, 2);
+        }
+    }
+
+    // Multilinear blend of the lattice corners, bit 'a' of 'corner' choosing the upper side of axis 'a'
+    template <typename L, int Axis, typename CornerFn>
+    ELOO_FORCE_INLINE typename L::F blend_corners(const typename L::F* t, uint32_t corner, const CornerFn& cornerFn) {
+        if constexpr (Axis < 0) {
+            return cornerFn(corner);
+        } else {
+            const typename L::F lower = blend_corners<L, Axis - 1>(t, corner, cornerFn);
+            const typename L::F upper = blend_corners<L, Axis - 1>(t, corner | (1u << Axis), cornerFn);
+            return lerp<L>(lower, upper, t[Axis]);
+        }
+    }
+
+
+    /////////////////////////////////////////////////////////////////////
+    // Lattice noise (value and Perlin)
+
+    template <typename L, int Dims, bool Gradient>
+    typename L::F lattice(typename L::I seed, const typename L::F* p) {
+        using F = typename L::F;
+        using I = typename L::I;
+
+        I cell[Dims];
+        F frac[Dims];
+        F t[Dims];
+        for (int a = 0; a < Dims; ++a) {
+            const F lower = L::floor(p[a]);
+            cell[a] = L::to_int(lower) * L::iset(PRIMES[a]);
+            frac[a] = p[a] - lower;
+            t[a] = fade<L>(frac[a]);
+        }
+
+        auto cornerFn = [&](uint32_t corner) {
+            I primed[Dims];
+            F offset[Dims];
+            for (int a = 0; a < Dims; ++a) {
+                const bool upper = (corner >> a) & 1u;
+                primed[a] = upper ? cell[a] + L::iset(PRIMES[a]) : cell[a];
+                offset[a] = upper ? frac[a] - L::set(1.0f) : frac[a];
+            }
+            const I h = hash<L, Dims>(seed, primed);
+            if constexpr (Gradient) {
+                return gradient<L, Dims>(h, offset);
+            } else {
+                return unit<L>(h);
+            }
+        };
+
+        const F result = blend_corners<L, Dims - 1>(t, 0, cornerFn);
+        return Gradient ? result * L::set(PERLIN_SCALE[Dims]) : result;
+    }
+
+
+    /////////////////////////////////////////////////////////////////////
+    // Simplex noise
+    //
+    // The skewed cell is split into Dims! simplices, the one containing the point is found by
+    // ranking the offset components, then each vertex contributes (r^2 - d^2)^4 * gradient.
+
+    template <typename L, int Dims>
+    ELOO_FORCE_INLINE typename L::F simplex_vertex(typename L::I seed, const typename L::I* primed, const typename L::F* d, float radiusSqr) {
+        using F = typename L::F;
+        F lengthSqr = d[0] * d[0];
+        for (int a = 1; a < Dims; ++a) {
+            lengthSqr = lengthSqr + d[a] * d[a];
+        }
+        F falloff = L::max(L::set(radiusSqr) - lengthSqr, L::set(0.0f));
+        falloff = falloff * falloff;
+        return falloff * falloff * gradient<L, Dims>(hash<L, Dims>(seed, primed), d);
+    }
+
+    template <typename L, int Dims>
+    typename L::F simplex(typename L::I seed, const typename L::F* p) {
+        using F = typename L::F;
+        using I = typename L::I;
+        using M = typename L::M;
+
+        // Skew factors (sqrt(n + 1) - 1) / n and unskew factors (n + 1 - sqrt(n + 1)) / (n * (n + 1))
+        constexpr float SKEW = Dims == 2 ? 0.36602540378f : Dims == 3 ? 1.0f / 3.0f : 0.30901699437f;
+        constexpr float UNSKEW = Dims == 2 ? 0.21132486540f : Dims == 3 ? 1.0f / 6.0f : 0.13819660113f;
+        constexpr float RADIUS_SQR = 0.5f;
+
+        F sum = p[0];
+        for (int a = 1; a < Dims; ++a) {
+            sum = sum + p[a];
+        }
+        const F skew = sum * L::set(SKEW);
+
+        F lower[Dims];
+        F cellSum = L::set(0.0f);
+        for (int a = 0; a < Dims; ++a) {
+            lower[a] = L::floor(p[a] + skew);
+            cellSum = cellSum + lower[a];
+        }
+        const F unskew = cellSum * L::set(UNSKEW);
+
+        I cell[Dims];
+        F d0[Dims];
+        for (int a = 0; a < Dims; ++a) {
+            cell[a] = L::to_int(lower[a]) * L::iset(PRIMES[a]);
+            d0[a] = p[a] - lower[a] + unskew;
+        }
+
+        // Rank of each component, the vertex 'v' steps (0 < v < Dims) move along every axis ranked >= Dims - v
+        F rank[Dims];
+        for (int a = 0; a < Dims; ++a) {
+            rank[a] = L::set(0.0f);
+        }
+        for (int a = 0; a < Dims; ++a) {
+            for (int b = a + 1; b < Dims; ++b) {
+                const M aFirst = L::ge(d0[a], d0[b]);
+                rank[a] = rank[a] + L::select(aFirst, L::set(1.0f), L::set(0.0f));
+                rank[b] = rank[b] + L::select(aFirst, L::set(0.0f), L::set(1.0f));
+            }
+        }
+
+        F result = simplex_vertex<L, Dims>(seed, cell, d0, RADIUS_SQR);
+        for (int v = 1; v <= Dims; ++v) {
+            I primed[Dims];
+            F d[Dims];
+            for (int a = 0; a < Dims; ++a) {
+                const M step = L::gt(rank[a], L::set(static_cast<float>(Dims - v) - 0.5f));
+                primed[a] = cell[a] + L::iselect(step, L::iset(PRIMES[a]), L::iset(0));
+                d[a] = d0[a] - L::select(step, L::set(1.0f), L::set(0.0f)) + L::set(UNSKEW * static_cast<float>(v));
+            }
+            result = result + simplex_vertex<L, Dims>(seed, primed, d, RADIUS_SQR);
+        }
+        return result * L::set(SIMPLEX_SCALE[Dims]);
+    }
+
+
+    /////////////////////////////////////////////////////////////////////
+    // Cellular noise
+    //
+    // One jittered feature point per cell, returning the distance to the closest (F1) remapped
+    // from [0, 1] onto [-1, 1]. The jitter takes up to 10 hash bits per axis.
+
+    template <typename L, int Dims>
+    typename L::F worley(typename L::I seed, const typename L::F* p) {
+        using F = typename L::F;
+        using I = typename L::I;
+
+        constexpr int JITTER_BITS = 32 / Dims < 10 ? 32 / Dims : 10;
+        constexpr uint32_t JITTER_MASK = (1u << JITTER_BITS) - 1;
+        constexpr float JITTER_SCALE = 1.0f / static_cast<float>(JITTER_MASK);
+        constexpr int NEIGHBOURS = Dims == 2 ? 9 : Dims == 3 ? 27 : 81;
+
+        I cell[Dims];
+        F frac[Dims];
+        for (int a = 0; a < Dims; ++a) {
+            const F lower = L::floor(p[a]);
+            cell[a] = L::to_int(lower) * L::iset(PRIMES[a]);
+            frac[a] = p[a] - lower;
+        }
+
+        F closestSqr = L::set(FLT_MAX);
+        for (int n = 0; n < NEIGHBOURS; ++n) {
+            I primed[Dims];
+            float offset[Dims];
+            for (int a = 0, rest = n; a < Dims; ++a, rest /= 3) {
+                offset[a] = static_cast<float>(rest % 3 - 1);
+                primed[a] = cell[a] + L::iset(PRIMES[a] * static_cast<uint32_t>(rest % 3 - 1));
+            }
+
+            const I h = hash<L, Dims>(seed, primed);
+            F distanceSqr = L::set(0.0f);
+            for (int a = 0; a < Dims; ++a) {
+                const F jitter = L::to_float((h >> (a * JITTER_BITS)) & L::iset(JITTER_MASK)) * L::set(JITTER_SCALE);
+                const F delta = frac[a] - L::set(offset[a]) - jitter;
+                distanceSqr = distanceSqr + delta * delta;
+            }
+            closestSqr = L::min(closestSqr, distanceSqr);
+        }
+        return L::min(L::sqrt(closestSqr), L::set(1.0f)) * L::set(2.0f) - L::set(1.0f);
+    }
+
+
+    /////////////////////////////////////////////////////////////////////
+    // Fractal evaluation
+
+    template <typename L, int Dims>
+    ELOO_FORCE_INLINE typename L::F base_noise(type kind, typename L::I seed, const typename L::F* p) {
+        switch (kind) {
+        case type::value:
+            return lattice<L, Dims, false>(seed, p);
+        case type::perlin:
+            return lattice<L, Dims, true>(seed, p);
+        case type::simplex:
+            return simplex<L, Dims>(seed, p);
+        case type::worley:
+            return worley<L, Dims>(seed, p);
+        }
+        ELOO_ASSERT_FALSE("Unknown noise type %d", static_cast<int>(kind));
+        return L::set(0.0f);
+    }
+
+    template <typename L, int Dims>
+    typename L::F evaluate(const settings& config, uint32_t seed, const typename L::F* p) {
+        using F = typename L::F;
+
+        F q[Dims];
+        for (int a = 0; a < Dims; ++a) {
+            q[a] = p[a] * L::set(config.frequency);
+        }
+
+        if (config.mode == fractal::none || config.octaves <= 1) {
+            const F n = base_noise<L, Dims>(config.kind, L::iset(seed), q);
+            if (config.mode == fractal::ridged) {
+                const F ridge = L::set(1.0f) - L::abs(n);
+                return ridge * ridge * L::set(2.0f) - L::set(1.0f);
+            }
+            return n;
+        }
+
+        F sum = L::set(0.0f);
+        float amplitude = 1.0f;
+        float totalAmplitude = 0.0f;
+        uint32_t octaveSeed = seed;
+        for (uint32_t octave = 0; octave < config.octaves; ++octave) {
+            const F n = base_noise<L, Dims>(config.kind, L::iset(octaveSeed), q);
+            if (config.mode == fractal::ridged) {
+                const F ridge = L::set(1.0f) - L::abs(n);
+                sum = sum + ridge * ridge * L::set(amplitude);
+            } else {
+                sum = sum + n * L::set(amplitude);
+            }
+
+            totalAmplitude += amplitude;
+            amplitude *= config.gain;
+            octaveSeed += OCTAVE_SEED_STEP;
+            for (int a = 0; a < Dims; ++a) {
+                q[a] = q[a] * L::set(config.lacunarity);
+            }
+        }
+
+        const F normalised = sum * L::set(1.0f / totalAmplitude);
+        return config.mode == fractal::ridged ? normalised * L::set(2.0f) - L::set(1.0f) : normalised;
+    }
+
+
+    /////////////////////////////////////////////////////////////////////
+    // Batch drivers
+
+    template <int Dims>
+    float sample_one(const settings& config, uint32_t seed, const float (&p)[Dims]) {
+        return evaluate<scalar_lanes, Dims>(config, seed, p);
+    }
+
+    // Evaluates SoA points [begin, end), padding the last step through the 4-wide kernel
+    template <int Dims>
+    void sample_range(const settings& config, uint32_t seed, const float* const* axes, float* out, size_t begin, size_t end) {
+        using F = simd_lanes::F;
+        constexpr int W = math::simd::WIDTH;
+
+        size_t i = begin;
+        for (; i + W <= end; i += W) {
+            F p[Dims];
+            for (int a = 0; a < Dims; ++a) {
+                p[a] = math::simd::load(axes[a] + i);
+            }
+            math::simd::store(out + i, evaluate<simd_lanes, Dims>(config, seed, p));
+        }
+
+        if (i < end) {
+            float padded[Dims][W] = {};
+            for (size_t lane = 0; i + lane < end; ++lane) {
+                for (int a = 0; a < Dims; ++a) {
+                    padded[a][lane] = axes[a][i + lane];
+                }
+            }
+            F p[Dims];
+            for (int a = 0; a < Dims; ++a) {
+                p[a] = math::simd::load(padded[a]);
+            }
+            float result[W];
+            math::simd::store(result, evaluate<simd_lanes, Dims>(config, seed, p));
+            for (size_t lane = 0; i + lane < end; ++lane) {
+                out[i + lane] = result[lane];
+            }
+        }
+    }
+
+    template <int Dims>
+    void sample_points(const settings& config, uint32_t seed, const float* const* axes, float* out, size_t count) {
+        parallel::parallel_for(count, TILE_SAMPLES, [&](size_t begin, size_t end) {
+            sample_range<Dims>(config, seed, axes, out, begin, end);
+        });
+    }
+
+    // Evaluates grid rows [rowBegin, rowEnd), where row 'r' sits at y = r % height, z = r / height
+    template <int Dims>
+    void sample_rows(const settings& config, uint32_t seed, const float* origin, const float* step, uint32_t width, uint32_t height, float* out, size_t rowBegin, size_t rowEnd) {
+        using F = simd_lanes::F;
+        constexpr int W = math::simd::WIDTH;
+
+        const F lanes = math::simd::set(0.0f, 1.0f, 2.0f, 3.0f);
+        const F stepX = math::simd::set1(step[0]);
+        const F originX = math::simd::set1(origin[0]);
+        for (size_t row = rowBegin; row < rowEnd; ++row) {
+            F p[Dims];
+            p[1] = math::simd::set1(origin[1] + static_cast<float>(row % height) * step[1]);
+            if constexpr (Dims == 3) {
+                p[2] = math::simd::set1(origin[2] + static_cast<float>(row / height) * step[2]);
+            }
+
+            float* dst = out + row * width;
+            uint32_t i = 0;
+            for (; i + W <= width; i += W) {
+                p[0] = math::simd::madd(lanes + math::simd::set1(static_cast<float>(i)), stepX, originX);
+                math::simd::store(dst + i, evaluate<simd_lanes, Dims>(config, seed, p));
+            }
+            if (i < width) {
+                p[0] = math::simd::madd(lanes + math::simd::set1(static_cast<float>(i)), stepX, originX);
+                float result[W];
+                math::simd::store(result, evaluate<simd_lanes, Dims>(config, seed, p));
+                for (uint32_t lane = 0; i + lane < width; ++lane) {
+                    dst[i + lane] = result[lane];
+                }
+            }
+        }
+    }
+
+    template <int Dims>
+    void sample_grid_rows(const settings& config, uint32_t seed, const float* origin, const float* step, uint32_t width, uint32_t height, size_t rows, float* out) {
+        const size_t rowsPerTile = width < TILE_SAMPLES ? TILE_SAMPLES / width : 1;
+        parallel::parallel_for(rows, rowsPerTile, [&](size_t begin, size_t end) {
+            sample_rows<Dims>(config, seed, origin, step, width, height, out, begin, end);
+        });
+    }
+}
+
+
+/////////////////////////////////////////////////////////////////////
+// Generator
+
+math::noise::generator::generator(uint64_t seed, const settings& config)
+    : mSettings(config)
+    , mSeed(random::generator(seed).next_u32()) {
+    ELOO_ASSERT(config.octaves > 0, "Noise needs at least one octave");
+}
+
+float math::noise::generator::sample(float x, float y) const {
+    return sample_one<2>(mSettings, mSeed, { x, y });
+}
+
+float math::noise::generator::sample(float x, float y, float z) const {
+    return sample_one<3>(mSettings, mSeed, { x, y, z });
+}
+
+float math::noise::generator::sample(float x, float y, float z, float w) const {
+    return sample_one<4>(mSettings, mSeed, { x, y, z, w });
+}
+
+void math::noise::generator::sample(eastl::span<const float> x, eastl::span<const float> y, eastl::span<float> out) const {
+    ELOO_ASSERT_FATAL(x.size() == out.size() && y.size() == out.size(), "Noise batch spans differ in length");
+    const float* axes[2] = { x.data(), y.data() };
+    sample_points<2>(mSettings, mSeed, axes, out.data(), out.size());
+}
+
+void math::noise::generator::sample(eastl::span<const float> x, eastl::span<const float> y, eastl::span<const float> z, eastl::span<float> out) const {
+    ELOO_ASSERT_FATAL(x.size() == out.size() && y.size() == out.size() && z.size() == out.size(), "Noise batch spans differ in length");
+    const float* axes[3] = { x.data(), y.data(), z.data() };
+    sample_points<3>(mSettings, mSeed, axes, out.data(), out.size());
+}
+
+void math::noise::generator::sample(eastl::span<const float> x, eastl::span<const float> y, eastl::span<const float> z, eastl::span<const float> w, eastl::span<float> out) const {
+    ELOO_ASSERT_FATAL(x.size() == out.size() && y.size() == out.size() && z.size() == out.size() && w.size() == out.size(), "Noise batch spans differ in length");
+    const float* axes[4] = { x.data(), y.data(), z.data(), w.data() };
+    sample_points<4>(mSettings, mSeed, axes, out.data(), out.size());
+}
+
+void math::noise::generator::sample_grid(const float2::values& origin, const float2::values& step, uint32_t width, uint32_t height, eastl::span<float> out) const {
+    ELOO_ASSERT_FATAL(out.size() >= static_cast<size_t>(width) * height, "Noise grid output holds %zu samples, needs %zu", out.size(), static_cast<size_t>(width) * height);
+    if (width == 0 || height == 0) {
+        return;
+    }
+    const float originValues[2] = { origin.x(), origin.y() };
+    const float stepValues[2] = { step.x(), step.y() };
+    sample_grid_rows<2>(mSettings, mSeed, originValues, stepValues, width, height, height, out.data());
+}
+
+void math::noise::generator::sample_grid(const float3::values& origin, const float3::values& step, uint32_t width, uint32_t height, uint32_t depth, eastl::span<float> out) const {
+    const size_t rows = static_cast<size_t>(height) * depth;
+    ELOO_ASSERT_FATAL(out.size() >= rows * width, "Noise grid output holds %zu samples, needs %zu", out.size(), rows * width);
+    if (width == 0 || rows == 0) {
+        return;
+    }
+    const float originValues[3] = { origin.x(), origin.y(), origin.z() };
+    const float stepValues[3] = { step.x(), step.y(), step.z() };
+    sample_grid_rows<3>(mSettings, mSeed, originValues, stepValues, width, height, rows, out.data());
+}
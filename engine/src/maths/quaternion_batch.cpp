@@ -0,0 +1,268 @@
+#include "maths/quaternion_batch.h"
+
+#include "maths/math.h"
+#include "maths/simd.h"
+
+using namespace eloo;
+using namespace eloo::math::simd;
+
+namespace {
+    // Past this the arc is short enough that nlerp is indistinguishable from slerp
+    constexpr float SLERP_NLERP_THRESHOLD = 0.9995f;
+
+    struct quat4 {
+        f32x4 x, y, z, w;
+    };
+
+    // Loads up to 4 lanes, padding the remainder so the tail can run through the same kernel
+    ELOO_FORCE_INLINE f32x4 load_lanes(const float* p, size_t lanes, float pad) {
+        if (lanes == WIDTH) {
+            return load(p);
+        }
+        float tmp[WIDTH] = { pad, pad, pad, pad };
+        for (size_t i = 0; i < lanes; ++i) {
+            tmp[i] = p[i];
+        }
+        return load(tmp);
+    }
+
+    ELOO_FORCE_INLINE void store_lanes(float* p, size_t lanes, f32x4 v) {
+        if (lanes == WIDTH) {
+            store(p, v);
+            return;
+        }
+        float tmp[WIDTH];
+        store(tmp, v);
+        for (size_t i = 0; i < lanes; ++i) {
+            p[i] = tmp[i];
+        }
+    }
+
+    ELOO_FORCE_INLINE quat4 load_soa(const math::quaternion::soa_const_span& q, size_t index, size_t lanes) {
+        return {
+            load_lanes(q.x.data() + index, lanes, 0.0f),
+            load_lanes(q.y.data() + index, lanes, 0.0f),
+            load_lanes(q.z.data() + index, lanes, 0.0f),
+            load_lanes(q.w.data() + index, lanes, 1.0f)
+        };
+    }
+
+    ELOO_FORCE_INLINE void store_soa(const math::quaternion::soa_span& q, size_t index, size_t lanes, const quat4& v) {
+        store_lanes(q.x.data() + index, lanes, v.x);
+        store_lanes(q.y.data() + index, lanes, v.y);
+        store_lanes(q.z.data() + index, lanes, v.z);
+        store_lanes(q.w.data() + index, lanes, v.w);
+    }
+
+    ELOO_FORCE_INLINE quat4 load_aos(const quaternion_v* q, size_t lanes) {
+        float x[WIDTH] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        float y[WIDTH] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        float z[WIDTH] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        float w[WIDTH] = { 1.0f, 1.0f, 1.0f, 1.0f };
+        for (size_t i = 0; i < lanes; ++i) {
+            x[i] = q[i].x();
+            y[i] = q[i].y();
+            z[i] = q[i].z();
+            w[i] = q[i].w();
+        }
+        return { load(x), load(y), load(z), load(w) };
+    }
+
+    ELOO_FORCE_INLINE void store_aos(quaternion_v* q, size_t lanes, const quat4& v) {
+        float x[WIDTH], y[WIDTH], z[WIDTH], w[WIDTH];
+        store(x, v.x);
+        store(y, v.y);
+        store(z, v.z);
+        store(w, v.w);
+        for (size_t i = 0; i < lanes; ++i) {
+            q[i] = { x[i], y[i], z[i], w[i] };
+        }
+    }
+
+    ELOO_FORCE_INLINE f32x4 dot4(const quat4& a, const quat4& b) {
+        return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+    }
+
+    ELOO_FORCE_INLINE quat4 normalize4(const quat4& q) {
+        const f32x4 inv = rsqrt(dot4(q, q));
+        return { q.x * inv, q.y * inv, q.z * inv, q.w * inv };
+    }
+
+    // Flips 'b' into the same hemisphere as 'a' and returns the (now positive) cosine
+    ELOO_FORCE_INLINE f32x4 align_hemisphere(const quat4& a, quat4& b) {
+        const f32x4 cosTheta = dot4(a, b);
+        const f32x4 flip = bit_and(cosTheta, set1(-0.0f));
+        b.x = bit_xor(b.x, flip);
+        b.y = bit_xor(b.y, flip);
+        b.z = bit_xor(b.z, flip);
+        b.w = bit_xor(b.w, flip);
+        return abs(cosTheta);
+    }
+
+    ELOO_FORCE_INLINE quat4 blend4(const quat4& a, const quat4& b, f32x4 wa, f32x4 wb) {
+        return {
+            madd(a.x, wa, b.x * wb),
+            madd(a.y, wa, b.y * wb),
+            madd(a.z, wa, b.z * wb),
+            madd(a.w, wa, b.w * wb)
+        };
+    }
+
+    // Same approximation as math::fast_acos, only valid for [0,1] here since the input is aligned
+    ELOO_FORCE_INLINE f32x4 fast_acos4(f32x4 x) {
+        const f32x4 poly = madd(madd(madd(set1(-0.0187293f), x, set1(0.0742610f)), x, set1(-0.2121144f)), x, set1(1.5707288f));
+        return sqrt(max(set1(1.0f) - x, zero())) * poly;
+    }
+
+    // Taylor series to x^9, accurate to ~4e-6 over [0, pi/2] which covers every angle slerp produces
+    ELOO_FORCE_INLINE f32x4 fast_sin4(f32x4 x) {
+        const f32x4 x2 = x * x;
+        const f32x4 poly = madd(madd(madd(madd(set1(1.0f / 362880.0f), x2, set1(-1.0f / 5040.0f)), x2, set1(1.0f / 120.0f)), x2, set1(-1.0f / 6.0f)), x2, set1(1.0f));
+        return x * poly;
+    }
+
+    ELOO_FORCE_INLINE quat4 nlerp4(const quat4& a, quat4 b, f32x4 t) {
+        align_hemisphere(a, b);
+        return normalize4(blend4(a, b, set1(1.0f) - t, t));
+    }
+
+    ELOO_FORCE_INLINE quat4 slerp4(const quat4& a, quat4 b, f32x4 t) {
+        const f32x4 cosTheta = min(align_hemisphere(a, b), set1(1.0f));
+        const f32x4 theta = fast_acos4(cosTheta);
+        const f32x4 invSinTheta = set1(1.0f) / max(fast_sin4(theta), set1(math::f32::EPSILON));
+        const f32x4 oneMinusT = set1(1.0f) - t;
+
+        const f32x4 isNearlyParallel = cmp_gt(cosTheta, set1(SLERP_NLERP_THRESHOLD));
+        const f32x4 wa = select(isNearlyParallel, oneMinusT, fast_sin4(oneMinusT * theta) * invSinTheta);
+        const f32x4 wb = select(isNearlyParallel, t, fast_sin4(t * theta) * invSinTheta);
+
+        // Renormalising absorbs the error from the polynomial approximations
+        return normalize4(blend4(a, b, wa, wb));
+    }
+
+    template <typename Kernel>
+    ELOO_FORCE_INLINE void for_each_block(size_t count, Kernel&& kernel) {
+        for (size_t i = 0; i < count; i += WIDTH) {
+            kernel(i, math::min(count - i, static_cast<size_t>(WIDTH)));
+        }
+    }
+
+    template <typename BlendFn>
+    void run_soa(const math::quaternion::soa_const_span& from, const math::quaternion::soa_const_span& to, const float* t, float tScalar, const math::quaternion::soa_span& out, BlendFn blendFn) {
+        const size_t count = from.size();
+        ELOO_ASSERT(to.size() >= count && out.size() >= count, "Quaternion batch spans are mismatched (%zu from, %zu to, %zu out)", count, to.size(), out.size());
+        for_each_block(count, [&](size_t index, size_t lanes) {
+            const f32x4 t4 = t ? load_lanes(t + index, lanes, 0.0f) : set1(tScalar);
+            store_soa(out, index, lanes, blendFn(load_soa(from, index, lanes), load_soa(to, index, lanes), t4));
+        });
+    }
+
+    template <typename BlendFn>
+    void run_aos(eastl::span<const quaternion_v> from, eastl::span<const quaternion_v> to, eastl::span<const float> t, eastl::span<quaternion_v> out, BlendFn blendFn) {
+        const size_t count = from.size();
+        ELOO_ASSERT(to.size() >= count && t.size() >= count && out.size() >= count, "Quaternion batch spans are mismatched (%zu from, %zu to, %zu t, %zu out)", count, to.size(), t.size(), out.size());
+        for_each_block(count, [&](size_t index, size_t lanes) {
+            const f32x4 t4 = load_lanes(t.data() + index, lanes, 0.0f);
+            store_aos(out.data() + index, lanes, blendFn(load_aos(from.data() + index, lanes), load_aos(to.data() + index, lanes), t4));
+        });
+    }
+
+    // Rotation matrix cells, row major, for column vectors (matching the matrix helpers in math.h)
+    struct rotation4 {
+        f32x4 cells[9];
+    };
+
+    ELOO_FORCE_INLINE rotation4 rotation_cells(const quat4& q) {
+        const f32x4 two = set1(2.0f);
+        const f32x4 one = set1(1.0f);
+        const f32x4 x2 = q.x * two, y2 = q.y * two, z2 = q.z * two;
+        const f32x4 xx = q.x * x2, yy = q.y * y2, zz = q.z * z2;
+        const f32x4 xy = q.x * y2, xz = q.x * z2, yz = q.y * z2;
+        const f32x4 wx = q.w * x2, wy = q.w * y2, wz = q.w * z2;
+        return { {
+            one - (yy + zz), xy - wz,         xz + wy,
+            xy + wz,         one - (xx + zz), yz - wx,
+            xz - wy,         yz + wx,         one - (xx + yy)
+        } };
+    }
+
+    template <typename MatrixT, typename LoadFn>
+    void write_matrices(size_t count, eastl::span<MatrixT> out, LoadFn loadFn) {
+        constexpr int columns = eastl::is_same_v<MatrixT, matrix4x4_v> ? 4 : 3;
+        ELOO_ASSERT(out.size() >= count, "Matrix output span too small (%zu < %zu)", out.size(), count);
+        for_each_block(count, [&](size_t index, size_t lanes) {
+            const rotation4 rotation = rotation_cells(loadFn(index, lanes));
+            float cells[9][WIDTH];
+            for (int cell = 0; cell < 9; ++cell) {
+                store(cells[cell], rotation.cells[cell]);
+            }
+            for (size_t lane = 0; lane < lanes; ++lane) {
+                float* dst = out[index + lane].as_array().data();
+                for (int row = 0; row < 3; ++row) {
+                    for (int column = 0; column < 3; ++column) {
+                        dst[row * columns + column] = cells[row * 3 + column][lane];
+                    }
+                }
+                if constexpr (columns == 4) {
+                    dst[matrix4x4::R1C4] = 0.0f;
+                    dst[matrix4x4::R2C4] = 0.0f;
+                    dst[matrix4x4::R3C4] = 0.0f;
+                    dst[matrix4x4::R4C1] = 0.0f;
+                    dst[matrix4x4::R4C2] = 0.0f;
+                    dst[matrix4x4::R4C3] = 0.0f;
+                    dst[matrix4x4::R4C4] = 1.0f;
+                }
+            }
+        });
+    }
+}
+
+
+/////////////////////////////////////////////////////////////////////
+// Interpolation
+
+void math::quaternion::nlerp(const soa_const_span& from, const soa_const_span& to, eastl::span<const float> t, const soa_span& out) {
+    ELOO_ASSERT(t.size() >= from.size(), "Quaternion batch needs one t per element (%zu < %zu)", t.size(), from.size());
+    run_soa(from, to, t.data(), 0.0f, out, nlerp4);
+}
+
+void math::quaternion::nlerp(const soa_const_span& from, const soa_const_span& to, float t, const soa_span& out) {
+    run_soa(from, to, nullptr, t, out, nlerp4);
+}
+
+void math::quaternion::nlerp(eastl::span<const quaternion_v> from, eastl::span<const quaternion_v> to, eastl::span<const float> t, eastl::span<quaternion_v> out) {
+    run_aos(from, to, t, out, nlerp4);
+}
+
+void math::quaternion::slerp(const soa_const_span& from, const soa_const_span& to, eastl::span<const float> t, const soa_span& out) {
+    ELOO_ASSERT(t.size() >= from.size(), "Quaternion batch needs one t per element (%zu < %zu)", t.size(), from.size());
+    run_soa(from, to, t.data(), 0.0f, out, slerp4);
+}
+
+void math::quaternion::slerp(const soa_const_span& from, const soa_const_span& to, float t, const soa_span& out) {
+    run_soa(from, to, nullptr, t, out, slerp4);
+}
+
+void math::quaternion::slerp(eastl::span<const quaternion_v> from, eastl::span<const quaternion_v> to, eastl::span<const float> t, eastl::span<quaternion_v> out) {
+    run_aos(from, to, t, out, slerp4);
+}
+
+
+/////////////////////////////////////////////////////////////////////
+// Conversion to rotation matrices
+
+void math::quaternion::to_matrix(const soa_const_span& q, eastl::span<matrix3x3_v> out) {
+    write_matrices(q.size(), out, [&q](size_t index, size_t lanes) { return load_soa(q, index, lanes); });
+}
+
+void math::quaternion::to_matrix(const soa_const_span& q, eastl::span<matrix4x4_v> out) {
+    write_matrices(q.size(), out, [&q](size_t index, size_t lanes) { return load_soa(q, index, lanes); });
+}
+
+void math::quaternion::to_matrix(eastl::span<const quaternion_v> q, eastl::span<matrix3x3_v> out) {
+    write_matrices(q.size(), out, [&q](size_t index, size_t lanes) { return load_aos(q.data() + index, lanes); });
+}
+
+void math::quaternion::to_matrix(eastl::span<const quaternion_v> q, eastl::span<matrix4x4_v> out) {
+    write_matrices(q.size(), out, [&q](size_t index, size_t lanes) { return load_aos(q.data() + index, lanes); });
+}
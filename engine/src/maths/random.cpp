@@ -0,0 +1,293 @@
+#include "maths/random.h"
+
+#include "maths/math.h"
+#include "maths/sampling.h"
+#include "maths/simd.h"
+
+#include <EASTL/atomic.h>
+
+using namespace eloo;
+using namespace eloo::math::random;
+
+namespace {
+    constexpr int STREAM_COUNT = 4;
+    constexpr int VALUES_PER_STEP = STREAM_COUNT * 2;
+    constexpr float U24_TO_FLOAT = 1.0f / 16777216.0f;
+    constexpr double U53_TO_DOUBLE = 1.0 / 9007199254740992.0;
+
+    eastl::atomic<uint64_t> gBaseSeed { DEFAULT_SEED };
+    eastl::atomic<uint32_t> gThreadCount { 0 };
+
+    ELOO_FORCE_INLINE uint64_t rotl(uint64_t x, int k) {
+        return (x << k) | (x >> (64 - k));
+    }
+
+    ELOO_FORCE_INLINE uint64_t splitmix64(uint64_t& state) {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    ELOO_FORCE_INLINE uint64_t xoshiro_next(uint64_t* s) {
+        const uint64_t result = rotl(s[0] + s[3], 23) + s[0];
+        const uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+        return result;
+    }
+
+    void xoshiro_jump(uint64_t* s, const uint64_t (&table)[4]) {
+        uint64_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+        for (const uint64_t word : table) {
+            for (int bit = 0; bit < 64; ++bit) {
+                if (word & (1ull << bit)) {
+                    s0 ^= s[0];
+                    s1 ^= s[1];
+                    s2 ^= s[2];
+                    s3 ^= s[3];
+                }
+                xoshiro_next(s);
+            }
+        }
+        s[0] = s0;
+        s[1] = s1;
+        s[2] = s2;
+        s[3] = s3;
+    }
+
+    // Four interleaved xoshiro256++ streams, producing 8 x 32 bits per step. Lanes are ordered
+    // stream by stream, low half first, so both paths produce the same sequence
+    struct stream_bank {
+#if ELOO_SIMD_SSE2
+        // Word 'w' of streams 0/1 in lo[w] and streams 2/3 in hi[w]
+        __m128i lo[4];
+        __m128i hi[4];
+
+        explicit stream_bank(const uint64_t (&states)[STREAM_COUNT][4]) {
+            for (int w = 0; w < 4; ++w) {
+                lo[w] = _mm_set_epi64x(static_cast<int64_t>(states[1][w]), static_cast<int64_t>(states[0][w]));
+                hi[w] = _mm_set_epi64x(static_cast<int64_t>(states[3][w]), static_cast<int64_t>(states[2][w]));
+            }
+        }
+
+        static ELOO_FORCE_INLINE __m128i rotl(__m128i x, int k) {
+            return _mm_or_si128(_mm_slli_epi64(x, k), _mm_srli_epi64(x, 64 - k));
+        }
+
+        static ELOO_FORCE_INLINE __m128i step(__m128i* s) {
+            const __m128i result = _mm_add_epi64(rotl(_mm_add_epi64(s[0], s[3]), 23), s[0]);
+            const __m128i t = _mm_slli_epi64(s[1], 17);
+            s[2] = _mm_xor_si128(s[2], s[0]);
+            s[3] = _mm_xor_si128(s[3], s[1]);
+            s[1] = _mm_xor_si128(s[1], s[2]);
+            s[0] = _mm_xor_si128(s[0], s[3]);
+            s[2] = _mm_xor_si128(s[2], t);
+            s[3] = rotl(s[3], 45);
+            return result;
+        }
+
+        ELOO_FORCE_INLINE void next_bits(uint32_t* out) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out), step(lo));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 4), step(hi));
+        }
+
+        // Top 24 bits of each 32 bit lane, scaled into [0, 1)
+        ELOO_FORCE_INLINE void next_uniform(float* out) {
+            const __m128 scale = _mm_set1_ps(U24_TO_FLOAT);
+            _mm_storeu_ps(out, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(step(lo), 8)), scale));
+            _mm_storeu_ps(out + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(step(hi), 8)), scale));
+        }
+#else
+        uint64_t streams[STREAM_COUNT][4];
+
+        explicit stream_bank(const uint64_t (&states)[STREAM_COUNT][4]) {
+            for (int stream = 0; stream < STREAM_COUNT; ++stream) {
+                for (int w = 0; w < 4; ++w) {
+                    streams[stream][w] = states[stream][w];
+                }
+            }
+        }
+
+        ELOO_FORCE_INLINE void next_bits(uint32_t* out) {
+            for (int stream = 0; stream < STREAM_COUNT; ++stream) {
+                const uint64_t bits = xoshiro_next(streams[stream]);
+                out[stream * 2] = static_cast<uint32_t>(bits);
+                out[stream * 2 + 1] = static_cast<uint32_t>(bits >> 32);
+            }
+        }
+
+        ELOO_FORCE_INLINE void next_uniform(float* out) {
+            uint32_t bits[VALUES_PER_STEP];
+            next_bits(bits);
+            for (int i = 0; i < VALUES_PER_STEP; ++i) {
+                out[i] = static_cast<float>(bits[i] >> 8) * U24_TO_FLOAT;
+            }
+        }
+#endif
+    };
+
+    stream_bank make_bank(generator& gen) {
+        uint64_t states[STREAM_COUNT][4];
+        for (int stream = 0; stream < STREAM_COUNT; ++stream) {
+            uint64_t seed = gen.next();
+            for (int w = 0; w < 4; ++w) {
+                states[stream][w] = splitmix64(seed);
+            }
+        }
+        return stream_bank(states);
+    }
+
+    template <typename T, typename StepFn>
+    void fill_steps(eastl::span<T> out, StepFn stepFn) {
+        const size_t count = out.size();
+        const size_t whole = count - (count % VALUES_PER_STEP);
+        T* dst = out.data();
+        for (size_t i = 0; i < whole; i += VALUES_PER_STEP) {
+            stepFn(dst + i);
+        }
+        if (whole < count) {
+            T tail[VALUES_PER_STEP];
+            stepFn(tail);
+            for (size_t i = whole; i < count; ++i) {
+                dst[i] = tail[i - whole];
+            }
+        }
+    }
+}
+
+
+/////////////////////////////////////////////////////////////////////
+// Generator
+
+generator::generator(uint64_t seed) {
+    this->seed(seed);
+}
+
+void generator::seed(uint64_t seed) {
+    uint64_t splitState = seed;
+    for (uint64_t& word : mState) {
+        word = splitmix64(splitState);
+    }
+}
+
+uint64_t generator::next() {
+    return xoshiro_next(mState);
+}
+
+void generator::jump() {
+    static constexpr uint64_t JUMP[4] = { 0x180EC6D33CFD0ABAull, 0xD5A61266F0C9392Cull, 0xA9582618E03FC9AAull, 0x39ABDC4529B1661Cull };
+    xoshiro_jump(mState, JUMP);
+}
+
+void generator::long_jump() {
+    static constexpr uint64_t LONG_JUMP[4] = { 0x76E15D3EFEFDCBBFull, 0xC5004E441C522FB3ull, 0x77710069854EE241ull, 0x39109BB02ACBE635ull };
+    xoshiro_jump(mState, LONG_JUMP);
+}
+
+uint32_t generator::next_u32() {
+    return static_cast<uint32_t>(next() >> 32);
+}
+
+float generator::uniform() {
+    return static_cast<float>(next() >> 40) * U24_TO_FLOAT;
+}
+
+double generator::uniform_double() {
+    return static_cast<double>(next() >> 11) * U53_TO_DOUBLE;
+}
+
+float generator::range(float minVal, float maxVal) {
+    return minVal + (maxVal - minVal) * uniform();
+}
+
+int32_t generator::range(int32_t minVal, int32_t maxVal) {
+    if (maxVal <= minVal) {
+        ELOO_ASSERT(maxVal == minVal, "Invalid random range [%d, %d]", minVal, maxVal);
+        return minVal;
+    }
+
+    // Lemire's nearly divisionless method, rejecting only the biased low products
+    const uint64_t span = static_cast<uint64_t>(static_cast<int64_t>(maxVal) - minVal) + 1;
+    if (span > UINT32_MAX) {
+        return static_cast<int32_t>(next_u32());
+    }
+    const uint32_t span32 = static_cast<uint32_t>(span);
+    uint64_t product = static_cast<uint64_t>(next_u32()) * span32;
+    uint32_t low = static_cast<uint32_t>(product);
+    if (low < span32) {
+        const uint32_t threshold = (0u - span32) % span32;
+        while (low < threshold) {
+            product = static_cast<uint64_t>(next_u32()) * span32;
+            low = static_cast<uint32_t>(product);
+        }
+    }
+    return static_cast<int32_t>(static_cast<int64_t>(minVal) + static_cast<int64_t>(product >> 32));
+}
+
+bool generator::boolean(float trueChance) {
+    return uniform() < trueChance;
+}
+
+float generator::gaussian(float mean, float dev) {
+    return normal(*this, mean, dev);
+}
+
+void generator::fill_uniform(eastl::span<float> out) {
+    stream_bank bank = make_bank(*this);
+    fill_steps(out, [&bank](float* dst) { bank.next_uniform(dst); });
+}
+
+void generator::fill_range(eastl::span<float> out, float minVal, float maxVal) {
+    stream_bank bank = make_bank(*this);
+    const simd::f32x4 offset = simd::set1(minVal);
+    const simd::f32x4 scale = simd::set1(maxVal - minVal);
+    fill_steps(out, [&](float* dst) {
+        bank.next_uniform(dst);
+        simd::store(dst, simd::madd(simd::load(dst), scale, offset));
+        simd::store(dst + 4, simd::madd(simd::load(dst + 4), scale, offset));
+    });
+}
+
+void generator::fill_bits(eastl::span<uint32_t> out) {
+    stream_bank bank = make_bank(*this);
+    fill_steps(out, [&bank](uint32_t* dst) { bank.next_bits(dst); });
+}
+
+
+/////////////////////////////////////////////////////////////////////
+// Streams and thread generators
+
+generator math::random::create_stream(uint64_t seed, uint32_t streamIndex) {
+    generator gen(seed);
+    for (uint32_t i = 0; i < streamIndex; ++i) {
+        gen.jump();
+    }
+    return gen;
+}
+
+void math::random::set_seed(uint64_t seed) {
+    gBaseSeed.store(seed);
+    thread_generator().seed(seed);
+}
+
+uint64_t math::random::get_seed() {
+    return gBaseSeed.load();
+}
+
+generator& math::random::thread_generator() {
+    // Each thread takes the next long jump from the base seed, so threads never share a stream
+    thread_local generator tGenerator = [] {
+        generator gen(gBaseSeed.load());
+        const uint32_t threadIndex = gThreadCount.fetch_add(1);
+        for (uint32_t i = 0; i < threadIndex; ++i) {
+            gen.long_jump();
+        }
+        return gen;
+    }();
+    return tGenerator;
+}
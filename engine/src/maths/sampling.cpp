@@ -0,0 +1,330 @@
+#include "maths/sampling.h"
+
+#include "maths/math.h"
+
+#include <EASTL/array.h>
+
+using namespace eloo;
+using namespace eloo::math::random;
+
+namespace {
+    constexpr int ZIGGURAT_LAYERS = 128;
+    constexpr double ZIGGURAT_R = 3.442619855899;
+    constexpr double ZIGGURAT_AREA = 9.91256303526217e-3;
+    constexpr double ZIGGURAT_SCALE = 2147483648.0;
+
+    // Batch samplers transform uniforms in chunks of this many elements
+    constexpr size_t BATCH_CHUNK = 128;
+
+    struct ziggurat_tables {
+        uint32_t k[ZIGGURAT_LAYERS];    // Layer widths, for the fast accept test
+        float w[ZIGGURAT_LAYERS];       // Scale from a signed 32 bit value to x
+        float f[ZIGGURAT_LAYERS];       // Density at each layer edge
+
+        ziggurat_tables() {
+            double dn = ZIGGURAT_R;
+            double tn = dn;
+            const double q = ZIGGURAT_AREA / std::exp(-0.5 * dn * dn);
+
+            k[0] = static_cast<uint32_t>((dn / q) * ZIGGURAT_SCALE);
+            k[1] = 0;
+            w[0] = static_cast<float>(q / ZIGGURAT_SCALE);
+            w[ZIGGURAT_LAYERS - 1] = static_cast<float>(dn / ZIGGURAT_SCALE);
+            f[0] = 1.0f;
+            f[ZIGGURAT_LAYERS - 1] = static_cast<float>(std::exp(-0.5 * dn * dn));
+
+            for (int i = ZIGGURAT_LAYERS - 2; i >= 1; --i) {
+                dn = std::sqrt(-2.0 * std::log(ZIGGURAT_AREA / dn + std::exp(-0.5 * dn * dn)));
+                k[i + 1] = static_cast<uint32_t>((dn / tn) * ZIGGURAT_SCALE);
+                tn = dn;
+                f[i] = static_cast<float>(std::exp(-0.5 * dn * dn));
+                w[i] = static_cast<float>(dn / ZIGGURAT_SCALE);
+            }
+        }
+    };
+
+    const ziggurat_tables& get_ziggurat() {
+        static const ziggurat_tables tables;
+        return tables;
+    }
+
+    // (0, 1], safe to take the log of
+    ELOO_FORCE_INLINE float uniform_open(generator& gen) {
+        return 1.0f - gen.uniform();
+    }
+
+    // One ziggurat draw from a signed 32 bit value and a layer. Returns false when the draw is
+    // rejected and has to be made again from fresh bits
+    ELOO_FORCE_INLINE bool ziggurat_draw(generator& gen, const ziggurat_tables& zig, int32_t hz, uint32_t iz, float& x) {
+        const uint32_t magnitude = hz < 0 ? 0u - static_cast<uint32_t>(hz) : static_cast<uint32_t>(hz);
+        x = static_cast<float>(hz) * zig.w[iz];
+        if (ELOO_LIKELY(magnitude < zig.k[iz])) {
+            return true;
+        }
+
+        if (iz == 0) {
+            // Base layer, sample the tail beyond R
+            float tailX, tailY;
+            do {
+                tailX = -std::log(uniform_open(gen)) / static_cast<float>(ZIGGURAT_R);
+                tailY = -std::log(uniform_open(gen));
+            } while (tailY + tailY < tailX * tailX);
+            const float tail = static_cast<float>(ZIGGURAT_R) + tailX;
+            x = hz > 0 ? tail : -tail;
+            return true;
+        }
+
+        // Wedge between layers, accept against the real density
+        return zig.f[iz] + gen.uniform() * (zig.f[iz - 1] - zig.f[iz]) < std::exp(-0.5f * x * x);
+    }
+
+    // Branchless orthonormal basis (Duff et al. 2017), 'n' must be normalised
+    ELOO_FORCE_INLINE void make_basis(const float3::values& n, float3::values& tangent, float3::values& bitangent) {
+        const float sign = std::copysign(1.0f, n.z());
+        const float a = -1.0f / (sign + n.z());
+        const float b = n.x() * n.y() * a;
+        tangent = { 1.0f + sign * n.x() * n.x() * a, sign * b, -sign * n.x() };
+        bitangent = { b, sign + n.y() * n.y() * a, -n.y() };
+    }
+
+    ELOO_FORCE_INLINE float3::values sphere_point(float u, float v) {
+        const float z = 1.0f - 2.0f * u;
+        const float r = std::sqrt(math::max(0.0f, 1.0f - z * z));
+        const float phi = math::f32::TWO_PI * v;
+        return { r * std::cos(phi), r * std::sin(phi), z };
+    }
+
+    ELOO_FORCE_INLINE float2::values circle_point(float u) {
+        const float phi = math::f32::TWO_PI * u;
+        return { std::cos(phi), std::sin(phi) };
+    }
+
+    ELOO_FORCE_INLINE float3::values orient(const float2::values& p, const float3::values& tangent, const float3::values& bitangent) {
+        return tangent * p.x() + bitangent * p.y();
+    }
+
+    ELOO_FORCE_INLINE float3::values cone_direction(float u, float v, float cosHalfAngle, const float3::values& axis, const float3::values& tangent, const float3::values& bitangent) {
+        const float cosTheta = 1.0f - u * (1.0f - cosHalfAngle);
+        const float sinTheta = std::sqrt(math::max(0.0f, 1.0f - cosTheta * cosTheta));
+        const float2::values around = circle_point(v);
+        return tangent * (around.x() * sinTheta) + bitangent * (around.y() * sinTheta) + axis * cosTheta;
+    }
+
+    ELOO_FORCE_INLINE void fill_draws(generator& gen, eastl::span<float> out) {
+        gen.fill_uniform(out);
+    }
+
+    ELOO_FORCE_INLINE void fill_draws(generator& gen, eastl::span<uint32_t> out) {
+        gen.fill_bits(out);
+    }
+
+    // Fills 'Dimensions' uniforms (or raw 32 bit words) per element in chunks, then hands each
+    // element its draws
+    template <int Dimensions, typename Draw = float, typename T, typename TransformFn>
+    void batch_transform(generator& gen, eastl::span<T> out, TransformFn transformFn) {
+        eastl::array<Draw, BATCH_CHUNK * Dimensions> draws;
+        for (size_t start = 0; start < out.size(); start += BATCH_CHUNK) {
+            const size_t count = math::min(BATCH_CHUNK, out.size() - start);
+            fill_draws(gen, eastl::span<Draw>(draws.data(), count * Dimensions));
+            for (size_t i = 0; i < count; ++i) {
+                out[start + i] = transformFn(draws.data() + i * Dimensions);
+            }
+        }
+    }
+}
+
+
+/////////////////////////////////////////////////////////////////////
+// Normal distribution
+
+float math::random::normal(generator& gen) {
+    const ziggurat_tables& zig = get_ziggurat();
+    float x;
+    for (;;) {
+        // Sign and magnitude from the top half, layer from independent low bits
+        const uint64_t bits = gen.next();
+        const int32_t hz = static_cast<int32_t>(bits >> 32);
+        const uint32_t iz = static_cast<uint32_t>(bits) & (ZIGGURAT_LAYERS - 1);
+        if (ziggurat_draw(gen, zig, hz, iz, x)) {
+            return x;
+        }
+    }
+}
+
+void math::random::fill_normal(generator& gen, eastl::span<float> out, float mean, float dev) {
+    const ziggurat_tables& zig = get_ziggurat();
+    // Sign and magnitude from one word, layer from the next. The rare rejected draw is made
+    // again one at a time
+    batch_transform<2, uint32_t>(gen, out, [&](const uint32_t* bits) {
+        float x;
+        if (!ziggurat_draw(gen, zig, static_cast<int32_t>(bits[0]), bits[1] & (ZIGGURAT_LAYERS - 1), x)) {
+            x = normal(gen);
+        }
+        return mean + dev * x;
+    });
+}
+
+
+/////////////////////////////////////////////////////////////////////
+// Alias table
+
+alias_table::alias_table(eastl::span<const float> weights) {
+    const size_t count = weights.size();
+    ELOO_ASSERT(count > 0 && count <= UINT32_MAX, "Alias table needs between 1 and 2^32 weights, %zu provided", count);
+
+    double total = 0.0;
+    for (const float weight : weights) {
+        ELOO_ASSERT(weight >= 0.0f, "Alias table weights must be non-negative");
+        total += weight;
+    }
+    ELOO_ASSERT(total > 0.0, "Alias table weights must have a positive total");
+
+    mProbability.resize(count);
+    mAlias.resize(count);
+
+    // Scale so the average bucket holds exactly 1, then pair each underfull bucket with an overfull one
+    eastl::vector<double> scaled(count);
+    eastl::vector<uint32_t> small, large;
+    small.reserve(count);
+    large.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        scaled[i] = weights[i] * static_cast<double>(count) / total;
+        (scaled[i] < 1.0 ? small : large).push_back(static_cast<uint32_t>(i));
+    }
+
+    while (!small.empty() && !large.empty()) {
+        const uint32_t less = small.back();
+        const uint32_t more = large.back();
+        small.pop_back();
+
+        mProbability[less] = static_cast<float>(scaled[less]);
+        mAlias[less] = more;
+
+        scaled[more] = (scaled[more] + scaled[less]) - 1.0;
+        if (scaled[more] < 1.0) {
+            large.pop_back();
+            small.push_back(more);
+        }
+    }
+
+    // Whatever is left is full to within rounding error
+    for (const uint32_t index : large) {
+        mProbability[index] = 1.0f;
+        mAlias[index] = index;
+    }
+    for (const uint32_t index : small) {
+        mProbability[index] = 1.0f;
+        mAlias[index] = index;
+    }
+}
+
+uint32_t alias_table::sample(generator& gen) const {
+    const uint64_t bits = gen.next();
+    return pick(static_cast<uint32_t>(bits >> 32), static_cast<uint32_t>(bits));
+}
+
+void alias_table::sample(generator& gen, eastl::span<uint32_t> out) const {
+    batch_transform<2, uint32_t>(gen, out, [this](const uint32_t* bits) {
+        return pick(bits[0], bits[1]);
+    });
+}
+
+uint32_t alias_table::pick(uint32_t bucketBits, uint32_t coinBits) const {
+    // Bucket scaled from all 32 bits, coin flip from the top 24 of the other word
+    const uint32_t bucket = static_cast<uint32_t>((static_cast<uint64_t>(bucketBits) * mProbability.size()) >> 32);
+    const float coin = static_cast<float>(coinBits >> 8) * (1.0f / 16777216.0f);
+    return coin < mProbability[bucket] ? bucket : mAlias[bucket];
+}
+
+
+/////////////////////////////////////////////////////////////////////
+// Geometric samplers
+
+float3::values math::random::on_sphere(generator& gen, float radius) {
+    return sphere_point(gen.uniform(), gen.uniform()) * radius;
+}
+
+float3::values math::random::in_sphere(generator& gen, float radius) {
+    const float3::values direction = sphere_point(gen.uniform(), gen.uniform());
+    return direction * (radius * std::cbrt(gen.uniform()));
+}
+
+float2::values math::random::on_circle(generator& gen, float radius) {
+    return circle_point(gen.uniform()) * radius;
+}
+
+float2::values math::random::in_disk(generator& gen, float radius) {
+    const float2::values direction = circle_point(gen.uniform());
+    return direction * (radius * std::sqrt(gen.uniform()));
+}
+
+float3::values math::random::on_circle(generator& gen, const float3::values& normal, float radius) {
+    float3::values tangent = float3::ZERO, bitangent = float3::ZERO;
+    make_basis(math::vector::normalize(normal), tangent, bitangent);
+    return orient(on_circle(gen, radius), tangent, bitangent);
+}
+
+float3::values math::random::in_disk(generator& gen, const float3::values& normal, float radius) {
+    float3::values tangent = float3::ZERO, bitangent = float3::ZERO;
+    make_basis(math::vector::normalize(normal), tangent, bitangent);
+    return orient(in_disk(gen, radius), tangent, bitangent);
+}
+
+float3::values math::random::in_cone(generator& gen, const float3::values& direction, float halfAngle) {
+    const float3::values axis = math::vector::normalize(direction);
+    float3::values tangent = float3::ZERO, bitangent = float3::ZERO;
+    make_basis(axis, tangent, bitangent);
+    const float u = gen.uniform();
+    const float v = gen.uniform();
+    return cone_direction(u, v, std::cos(halfAngle), axis, tangent, bitangent);
+}
+
+void math::random::on_sphere(generator& gen, eastl::span<float3::values> out, float radius) {
+    batch_transform<2>(gen, out, [radius](const float* u) {
+        return sphere_point(u[0], u[1]) * radius;
+    });
+}
+
+void math::random::in_sphere(generator& gen, eastl::span<float3::values> out, float radius) {
+    batch_transform<3>(gen, out, [radius](const float* u) {
+        return sphere_point(u[0], u[1]) * (radius * std::cbrt(u[2]));
+    });
+}
+
+void math::random::on_circle(generator& gen, eastl::span<float2::values> out, float radius) {
+    batch_transform<1>(gen, out, [radius](const float* u) {
+        return circle_point(u[0]) * radius;
+    });
+}
+
+void math::random::in_disk(generator& gen, eastl::span<float2::values> out, float radius) {
+    batch_transform<2>(gen, out, [radius](const float* u) {
+        return circle_point(u[0]) * (radius * std::sqrt(u[1]));
+    });
+}
+
+void math::random::on_circle(generator& gen, const float3::values& normal, eastl::span<float3::values> out, float radius) {
+    float3::values tangent = float3::ZERO, bitangent = float3::ZERO;
+    make_basis(math::vector::normalize(normal), tangent, bitangent);
+    batch_transform<1>(gen, out, [&](const float* u) {
+        return orient(circle_point(u[0]) * radius, tangent, bitangent);
+    });
+}
+
+void math::random::in_disk(generator& gen, const float3::values& normal, eastl::span<float3::values> out, float radius) {
+    float3::values tangent = float3::ZERO, bitangent = float3::ZERO;
+    make_basis(math::vector::normalize(normal), tangent, bitangent);
+    batch_transform<2>(gen, out, [&](const float* u) {
+        return orient(circle_point(u[0]) * (radius * std::sqrt(u[1])), tangent, bitangent);
+    });
+}
+
+void math::random::in_cone(generator& gen, const float3::values& direction, float halfAngle, eastl::span<float3::values> out) {
+    const float3::values axis = math::vector::normalize(direction);
+    float3::values tangent = float3::ZERO, bitangent = float3::ZERO;
+    make_basis(axis, tangent, bitangent);
+    const float cosHalfAngle = std::cos(halfAngle);
+    batch_transform<2>(gen, out, [&](const float* u) {
+        return cone_direction(u[0], u[1], cosHalfAngle, axis, tangent, bitangent);
+    });
+}
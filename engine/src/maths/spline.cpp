@@ -0,0 +1,428 @@
+#include "maths/spline.h"
+
+#include "maths/math.h"
+
+#include <EASTL/algorithm.h>
+#include <EASTL/sort.h>
+
+using namespace eloo;
+using namespace eloo::math::spline;
+
+namespace {
+    // 3 point Gauss-Legendre quadrature over [0,1]
+    constexpr float GAUSS_OFFSETS[3] = { 0.11270166537925831f, 0.5f, 0.88729833462074169f };
+    constexpr float GAUSS_WEIGHTS[3] = { 0.27777777777777778f, 0.44444444444444444f, 0.27777777777777778f };
+
+    constexpr uint32_t BOUNDS_LEAF_SIZE = 2;
+    constexpr uint32_t NEAREST_COARSE_SAMPLES = 8;
+    constexpr uint32_t NEAREST_NEWTON_STEPS = 4;
+
+    ELOO_FORCE_INLINE float3::values sample_values(const float* a, const float* b, const float* c, const float* d, float u) {
+        return {
+            a[0] + u * (b[0] + u * (c[0] + u * d[0])),
+            a[1] + u * (b[1] + u * (c[1] + u * d[1])),
+            a[2] + u * (b[2] + u * (c[2] + u * d[2]))
+        };
+    }
+
+    ELOO_FORCE_INLINE float3::values sample_derivative(const float* b, const float* c, const float* d, float u) {
+        return {
+            b[0] + u * (2.0f * c[0] + u * 3.0f * d[0]),
+            b[1] + u * (2.0f * c[1] + u * 3.0f * d[1]),
+            b[2] + u * (2.0f * c[2] + u * 3.0f * d[2])
+        };
+    }
+
+    ELOO_FORCE_INLINE float3::values sample_second_derivative(const float* c, const float* d, float u) {
+        return {
+            2.0f * c[0] + 6.0f * d[0] * u,
+            2.0f * c[1] + 6.0f * d[1] * u,
+            2.0f * c[2] + 6.0f * d[2] * u
+        };
+    }
+
+    // The convex hull of the equivalent bezier control points bounds the segment
+    ELOO_FORCE_INLINE void segment_bounds(const float* a, const float* b, const float* c, const float* d, float* outMin, float* outMax) {
+        for (int axis = 0; axis < 3; ++axis) {
+            const float p0 = a[axis];
+            const float c0 = p0 + b[axis] / 3.0f;
+            const float c1 = c0 + (b[axis] + c[axis]) / 3.0f;
+            const float p1 = a[axis] + b[axis] + c[axis] + d[axis];
+            outMin[axis] = math::min(math::min(p0, c0), math::min(c1, p1));
+            outMax[axis] = math::max(math::max(p0, c0), math::max(c1, p1));
+        }
+    }
+
+    ELOO_FORCE_INLINE float distance_sqr_to_bounds(const float3::values& point, const float* min, const float* max) {
+        const float dx = math::max(math::max(min[0] - point.x(), 0.0f), point.x() - max[0]);
+        const float dy = math::max(math::max(min[1] - point.y(), 0.0f), point.y() - max[1]);
+        const float dz = math::max(math::max(min[2] - point.z(), 0.0f), point.z() - max[2]);
+        return dx * dx + dy * dy + dz * dz;
+    }
+}
+
+
+/////////////////////////////////////////////////////////////////////
+// Single segment evaluation
+
+float3::values math::spline::catmull_rom(const float3::values& p0, const float3::values& p1, const float3::values& p2, const float3::values& p3, float t, float tension) {
+    const float scale = (1.0f - tension) * 0.5f;
+    return hermite(p1, (p2 - p0) * scale, p2, (p3 - p1) * scale, t);
+}
+
+float3::values math::spline::hermite(const float3::values& p0, const float3::values& m0, const float3::values& p1, const float3::values& m1, float t) {
+    const float t2 = t * t;
+    const float t3 = t2 * t;
+    const float h00 = 2.0f * t3 - 3.0f * t2 + 1.0f;
+    const float h10 = t3 - 2.0f * t2 + t;
+    const float h01 = -2.0f * t3 + 3.0f * t2;
+    const float h11 = t3 - t2;
+    return p0 * h00 + m0 * h10 + p1 * h01 + m1 * h11;
+}
+
+float3::values math::spline::bezier(const float3::values& p0, const float3::values& c0, const float3::values& c1, const float3::values& p1, float t) {
+    const float it = 1.0f - t;
+    return p0 * (it * it * it) + c0 * (3.0f * it * it * t) + c1 * (3.0f * it * t * t) + p1 * (t * t * t);
+}
+
+
+/////////////////////////////////////////////////////////////////////
+// Construction
+
+curve::curve(type splineType, eastl::span<const float3::values> points, float tension, uint32_t samplesPerSegment) {
+    const size_t pointCount = points.size();
+
+    // Every type is reduced to hermite form (p0, m0, p1, m1) before being expanded to power basis
+    auto push_hermite = [this](const float3::values& p0, const float3::values& m0, const float3::values& p1, const float3::values& m1) {
+        segment& seg = mSegments.emplace_back();
+        const float p0a[3] = { FLOAT3_UNPACK(p0) };
+        const float m0a[3] = { FLOAT3_UNPACK(m0) };
+        const float p1a[3] = { FLOAT3_UNPACK(p1) };
+        const float m1a[3] = { FLOAT3_UNPACK(m1) };
+        for (int axis = 0; axis < 3; ++axis) {
+            seg.a[axis] = p0a[axis];
+            seg.b[axis] = m0a[axis];
+            seg.c[axis] = -3.0f * p0a[axis] - 2.0f * m0a[axis] + 3.0f * p1a[axis] - m1a[axis];
+            seg.d[axis] = 2.0f * p0a[axis] + m0a[axis] - 2.0f * p1a[axis] + m1a[axis];
+        }
+    };
+
+    switch (splineType) {
+        case type::catmull_rom: {
+            ELOO_ASSERT(pointCount >= 4, "Catmull-Rom spline requires at least 4 points, %zu provided", pointCount);
+            const float scale = (1.0f - tension) * 0.5f;
+            for (size_t i = 1; i + 2 < pointCount; ++i) {
+                push_hermite(points[i], (points[i + 1] - points[i - 1]) * scale, points[i + 1], (points[i + 2] - points[i]) * scale);
+            }
+            break;
+        }
+        case type::hermite: {
+            ELOO_ASSERT(pointCount >= 4 && (pointCount % 2) == 0, "Hermite spline requires position/tangent pairs, %zu points provided", pointCount);
+            for (size_t i = 0; i + 3 < pointCount; i += 2) {
+                push_hermite(points[i], points[i + 1], points[i + 2], points[i + 3]);
+            }
+            break;
+        }
+        case type::bezier: {
+            ELOO_ASSERT(pointCount >= 4 && (pointCount - 1) % 3 == 0, "Bezier spline requires 3n+1 points, %zu provided", pointCount);
+            for (size_t i = 0; i + 3 < pointCount; i += 3) {
+                push_hermite(points[i], (points[i + 1] - points[i]) * 3.0f, points[i + 3], (points[i + 3] - points[i + 2]) * 3.0f);
+            }
+            break;
+        }
+    }
+
+    mSegmentCount = mSegments.size();
+    if (mSegmentCount == 0) {
+        return;
+    }
+
+    build_arc_lengths(math::max(samplesPerSegment, 1u));
+    build_bounds();
+}
+
+void curve::build_arc_lengths(uint32_t samplesPerSegment) {
+    mArcLengths.resize(mSegmentCount * samplesPerSegment + 1);
+    mArcLengths[0] = 0.0f;
+
+    const float step = 1.0f / static_cast<float>(samplesPerSegment);
+    float total = 0.0f;
+    size_t entry = 1;
+    for (const segment& seg : mSegments) {
+        for (uint32_t sample = 0; sample < samplesPerSegment; ++sample) {
+            const float u0 = sample * step;
+            float length = 0.0f;
+            for (int g = 0; g < 3; ++g) {
+                const float3::values deriv = sample_derivative(seg.b, seg.c, seg.d, u0 + GAUSS_OFFSETS[g] * step);
+                length += GAUSS_WEIGHTS[g] * math::vector::magnitude(deriv);
+            }
+            total += length * step;
+            mArcLengths[entry++] = total;
+        }
+    }
+}
+
+void curve::build_bounds() {
+    eastl::vector<float> centres(mSegmentCount * 3);
+    mBoundsSegments.resize(mSegmentCount);
+    for (uint32_t i = 0; i < mSegmentCount; ++i) {
+        const segment& seg = mSegments[i];
+        float min[3], max[3];
+        segment_bounds(seg.a, seg.b, seg.c, seg.d, min, max);
+        for (int axis = 0; axis < 3; ++axis) {
+            centres[i * 3 + axis] = (min[axis] + max[axis]) * 0.5f;
+        }
+        mBoundsSegments[i] = i;
+    }
+
+    mBounds.clear();
+    mBounds.reserve(mSegmentCount * 2);
+    mBounds.emplace_back();
+    build_bounds_node(0, 0, static_cast<uint32_t>(mSegmentCount), centres);
+}
+
+void curve::build_bounds_node(uint32_t nodeIndex, uint32_t first, uint32_t count, const eastl::vector<float>& centres) {
+    bounds_node node;
+    float centreMin[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+    float centreMax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+    for (int axis = 0; axis < 3; ++axis) {
+        node.min[axis] = FLT_MAX;
+        node.max[axis] = -FLT_MAX;
+    }
+
+    uint32_t* segments = mBoundsSegments.data() + first;
+    for (uint32_t i = 0; i < count; ++i) {
+        const segment& seg = mSegments[segments[i]];
+        float min[3], max[3];
+        segment_bounds(seg.a, seg.b, seg.c, seg.d, min, max);
+        for (int axis = 0; axis < 3; ++axis) {
+            node.min[axis] = math::min(node.min[axis], min[axis]);
+            node.max[axis] = math::max(node.max[axis], max[axis]);
+
+            const float centre = centres[segments[i] * 3 + axis];
+            centreMin[axis] = math::min(centreMin[axis], centre);
+            centreMax[axis] = math::max(centreMax[axis], centre);
+        }
+    }
+
+    if (count <= BOUNDS_LEAF_SIZE) {
+        node.first = first;
+        node.count = count;
+        mBounds[nodeIndex] = node;
+        return;
+    }
+
+    // Median split along the axis with the widest spread of centres
+    int splitAxis = 0;
+    for (int axis = 1; axis < 3; ++axis) {
+        if (centreMax[axis] - centreMin[axis] > centreMax[splitAxis] - centreMin[splitAxis]) {
+            splitAxis = axis;
+        }
+    }
+    eastl::sort(segments, segments + count, [&centres, splitAxis](uint32_t lhs, uint32_t rhs) {
+        return centres[lhs * 3 + splitAxis] < centres[rhs * 3 + splitAxis];
+    });
+
+    // Children are stored as a pair so the branch only needs the first index
+    node.first = static_cast<uint32_t>(mBounds.size());
+    node.count = 0;
+    mBounds[nodeIndex] = node;
+    mBounds.emplace_back();
+    mBounds.emplace_back();
+
+    const uint32_t half = count / 2;
+    build_bounds_node(node.first, first, half, centres);
+    build_bounds_node(node.first + 1, first + half, count - half, centres);
+}
+
+
+/////////////////////////////////////////////////////////////////////
+// Evaluation
+
+void curve::resolve_segment(float t, uint32_t& index, float& u) const {
+    const float scaled = math::saturate(t) * static_cast<float>(mSegmentCount);
+    index = math::min(static_cast<uint32_t>(scaled), static_cast<uint32_t>(mSegmentCount - 1));
+    u = scaled - static_cast<float>(index);
+}
+
+float3::values curve::evaluate(float t) const {
+    if (mSegmentCount == 0) {
+        return float3::ZERO;
+    }
+    uint32_t index;
+    float u;
+    resolve_segment(t, index, u);
+    const segment& seg = mSegments[index];
+    return sample_values(seg.a, seg.b, seg.c, seg.d, u);
+}
+
+float3::values curve::tangent(float t) const {
+    if (mSegmentCount == 0) {
+        return float3::ZERO;
+    }
+    uint32_t index;
+    float u;
+    resolve_segment(t, index, u);
+    const segment& seg = mSegments[index];
+    return sample_derivative(seg.b, seg.c, seg.d, u);
+}
+
+float curve::parameter_at_distance(float distance) const {
+    if (mSegmentCount == 0) {
+        return 0.0f;
+    }
+
+    const float total = mArcLengths.back();
+    if (distance <= 0.0f) {
+        return 0.0f;
+    } else if (distance >= total) {
+        return 1.0f;
+    }
+
+    // Find the sample interval containing the distance, then interpolate linearly inside it
+    const auto it = eastl::upper_bound(mArcLengths.begin(), mArcLengths.end(), distance);
+    const size_t hi = static_cast<size_t>(it - mArcLengths.begin());
+    const size_t lo = hi - 1;
+    const float span = mArcLengths[hi] - mArcLengths[lo];
+    const float frac = span > 0.0f ? (distance - mArcLengths[lo]) / span : 0.0f;
+    return (static_cast<float>(lo) + frac) / static_cast<float>(mArcLengths.size() - 1);
+}
+
+float3::values curve::evaluate_at_distance(float distance) const {
+    return evaluate(parameter_at_distance(distance));
+}
+
+void curve::evaluate(eastl::span<const float> t, eastl::span<float3::values> out) const {
+    ELOO_ASSERT(out.size() >= t.size(), "Spline output span too small (%zu < %zu)", out.size(), t.size());
+    if (mSegmentCount == 0) {
+        eastl::fill(out.begin(), out.begin() + t.size(), float3::ZERO);
+        return;
+    }
+    for (size_t i = 0; i < t.size(); ++i) {
+        uint32_t index;
+        float u;
+        resolve_segment(t[i], index, u);
+        const segment& seg = mSegments[index];
+        out[i] = sample_values(seg.a, seg.b, seg.c, seg.d, u);
+    }
+}
+
+void curve::evaluate(eastl::span<const float> t, eastl::span<float> outX, eastl::span<float> outY, eastl::span<float> outZ) const {
+    ELOO_ASSERT(outX.size() >= t.size() && outY.size() >= t.size() && outZ.size() >= t.size(), "Spline output spans too small for %zu samples", t.size());
+    if (mSegmentCount == 0) {
+        eastl::fill(outX.begin(), outX.begin() + t.size(), 0.0f);
+        eastl::fill(outY.begin(), outY.begin() + t.size(), 0.0f);
+        eastl::fill(outZ.begin(), outZ.begin() + t.size(), 0.0f);
+        return;
+    }
+    for (size_t i = 0; i < t.size(); ++i) {
+        uint32_t index;
+        float u;
+        resolve_segment(t[i], index, u);
+        const segment& seg = mSegments[index];
+        outX[i] = seg.a[0] + u * (seg.b[0] + u * (seg.c[0] + u * seg.d[0]));
+        outY[i] = seg.a[1] + u * (seg.b[1] + u * (seg.c[1] + u * seg.d[1]));
+        outZ[i] = seg.a[2] + u * (seg.b[2] + u * (seg.c[2] + u * seg.d[2]));
+    }
+}
+
+void curve::evaluate_at_distance(eastl::span<const float> distances, eastl::span<float3::values> out) const {
+    ELOO_ASSERT(out.size() >= distances.size(), "Spline output span too small (%zu < %zu)", out.size(), distances.size());
+    for (size_t i = 0; i < distances.size(); ++i) {
+        out[i] = evaluate(parameter_at_distance(distances[i]));
+    }
+}
+
+
+/////////////////////////////////////////////////////////////////////
+// Nearest point
+
+float curve::refine_nearest(uint32_t segmentIndex, const float3::values& point, float& distanceSqr) const {
+    const segment& seg = mSegments[segmentIndex];
+
+    // Coarse pass to pick the right basin, then Newton iterations on (C(u) - p) . C'(u) = 0
+    float bestU = 0.0f;
+    float bestDistSqr = FLT_MAX;
+    for (uint32_t sample = 0; sample <= NEAREST_COARSE_SAMPLES; ++sample) {
+        const float u = static_cast<float>(sample) / NEAREST_COARSE_SAMPLES;
+        const float distSqr = math::vector::distance_sqr(sample_values(seg.a, seg.b, seg.c, seg.d, u), point);
+        if (distSqr < bestDistSqr) {
+            bestDistSqr = distSqr;
+            bestU = u;
+        }
+    }
+
+    float u = bestU;
+    for (uint32_t step = 0; step < NEAREST_NEWTON_STEPS; ++step) {
+        const float3::values offset = sample_values(seg.a, seg.b, seg.c, seg.d, u) - point;
+        const float3::values d1 = sample_derivative(seg.b, seg.c, seg.d, u);
+        const float3::values d2 = sample_second_derivative(seg.c, seg.d, u);
+        const float numerator = math::vector::dot(offset, d1);
+        const float denominator = math::vector::dot(d1, d1) + math::vector::dot(offset, d2);
+        if (math::abs(denominator) <= math::f32::EPSILON) {
+            break;
+        }
+        u = math::saturate(u - numerator / denominator);
+    }
+
+    const float refinedDistSqr = math::vector::distance_sqr(sample_values(seg.a, seg.b, seg.c, seg.d, u), point);
+    if (refinedDistSqr < bestDistSqr) {
+        bestDistSqr = refinedDistSqr;
+        bestU = u;
+    }
+
+    distanceSqr = bestDistSqr;
+    return bestU;
+}
+
+nearest_result curve::nearest_point(const float3::values& point) const {
+    nearest_result result;
+    if (mSegmentCount == 0) {
+        return result;
+    }
+
+    uint32_t bestSegment = 0;
+    float bestU = 0.0f;
+
+    uint32_t stack[64];
+    uint32_t stackSize = 0;
+    stack[stackSize++] = 0;
+    while (stackSize > 0) {
+        const bounds_node& node = mBounds[stack[--stackSize]];
+        if (distance_sqr_to_bounds(point, node.min, node.max) >= result.distanceSqr) {
+            continue;
+        }
+
+        if (node.count > 0) {
+            for (uint32_t i = 0; i < node.count; ++i) {
+                const uint32_t segmentIndex = mBoundsSegments[node.first + i];
+                float distSqr;
+                const float u = refine_nearest(segmentIndex, point, distSqr);
+                if (distSqr < result.distanceSqr) {
+                    result.distanceSqr = distSqr;
+                    bestSegment = segmentIndex;
+                    bestU = u;
+                }
+            }
+            continue;
+        }
+
+        // Visit the closer child first so the far one is more likely to be culled
+        const bounds_node& left = mBounds[node.first];
+        const bounds_node& right = mBounds[node.first + 1];
+        const float leftDistSqr = distance_sqr_to_bounds(point, left.min, left.max);
+        const float rightDistSqr = distance_sqr_to_bounds(point, right.min, right.max);
+        if (leftDistSqr < rightDistSqr) {
+            stack[stackSize++] = node.first + 1;
+            stack[stackSize++] = node.first;
+        } else {
+            stack[stackSize++] = node.first;
+            stack[stackSize++] = node.first + 1;
+        }
+    }
+
+    const segment& seg = mSegments[bestSegment];
+    result.parameter = (static_cast<float>(bestSegment) + bestU) / static_cast<float>(mSegmentCount);
+    result.position = sample_values(seg.a, seg.b, seg.c, seg.d, bestU);
+    return result;
+}
@@ -0,0 +1,1125 @@
+#include "utility/bvh.h"
+
+#include "maths/math.h"
+#include "maths/simd.h"
+#include "utility/parallel.h"
+
+#include <EASTL/algorithm.h>
+
+using namespace eloo;
+using namespace eloo::bvh;
+
+namespace {
+    // Entry distance reported for nodes the ray misses
+    constexpr float MISS = FLT_MAX;
+
+    struct bounds3 {
+        float min[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+        float max[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+    };
+
+    struct centre3 {
+        float v[3];
+    };
+
+    ELOO_FORCE_INLINE void grow(bounds3& bounds, const bounds3& other) {
+        for (int axis = 0; axis < 3; ++axis) {
+            bounds.min[axis] = math::min(bounds.min[axis], other.min[axis]);
+            bounds.max[axis] = math::max(bounds.max[axis], other.max[axis]);
+        }
+    }
+
+    ELOO_FORCE_INLINE void grow(bounds3& bounds, const centre3& point) {
+        for (int axis = 0; axis < 3; ++axis) {
+            bounds.min[axis] = math::min(bounds.min[axis], point.v[axis]);
+            bounds.max[axis] = math::max(bounds.max[axis], point.v[axis]);
+        }
+    }
+
+    // Half the surface area, which is all SAH needs as only ratios are compared
+    ELOO_FORCE_INLINE float half_area(const bounds3& bounds) {
+        const float x = bounds.max[0] - bounds.min[0];
+        const float y = bounds.max[1] - bounds.min[1];
+        const float z = bounds.max[2] - bounds.min[2];
+        return x < 0.0f ? 0.0f : x * y + y * z + z * x;
+    }
+
+    bounds3 to_bounds(const aabb& box) {
+        bounds3 bounds;
+        bounds.min[0] = box.min.x(); bounds.min[1] = box.min.y(); bounds.min[2] = box.min.z();
+        bounds.max[0] = box.max.x(); bounds.max[1] = box.max.y(); bounds.max[2] = box.max.z();
+        return bounds;
+    }
+
+    bounds3 to_bounds(const float3::values& vertex1, const float3::values& vertex2, const float3::values& vertex3) {
+        bounds3 bounds;
+        grow(bounds, centre3 { { vertex1.x(), vertex1.y(), vertex1.z() } });
+        grow(bounds, centre3 { { vertex2.x(), vertex2.y(), vertex2.z() } });
+        grow(bounds, centre3 { { vertex3.x(), vertex3.y(), vertex3.z() } });
+        return bounds;
+    }
+
+    aabb to_aabb(const node& n) {
+        return { { n.min[0], n.min[1], n.min[2] }, { n.max[0], n.max[1], n.max[2] } };
+    }
+
+    // Ranges up to this many primitives are built serially as one task, larger ones are split by
+    // the parallel passes. Being counts rather than thread based, the layout doesn't depend on
+    // how many workers there are
+    constexpr uint32_t TASK_PRIMITIVES = 4096;
+    // Primitives per chunk in the parallel passes
+    constexpr uint32_t PARALLEL_GRAIN = 16384;
+    constexpr uint32_t NO_TASK = UINT32_MAX;
+
+    // Morton codes take 10 bits per axis
+    constexpr uint32_t MORTON_LEVELS = 1024;
+    constexpr uint32_t MORTON_TOP_BIT = 1u << 29;
+
+    struct range_bounds {
+        bounds3 nodeBounds;
+        bounds3 centreBounds;
+    };
+
+    struct bin {
+        bounds3 bounds;
+        uint32_t count = 0;
+    };
+
+    struct bin_set {
+        bin bins[3][MAX_BINS];
+    };
+
+    // Maps centres onto bins, per axis
+    struct bin_grid {
+        float origin[3];
+        float scale[3];
+    };
+
+    struct split_plane {
+        int axis = -1;
+        uint32_t index = 0;
+        float cost = FLT_MAX;
+    };
+
+    // Spreads the low 10 bits of 'v' out so two zero bits follow each one
+    ELOO_FORCE_INLINE uint32_t expand_bits(uint32_t v) {
+        v = (v * 0x00010001u) & 0xFF0000FFu;
+        v = (v * 0x00000101u) & 0x0F00F00Fu;
+        v = (v * 0x00000011u) & 0xC30C30C3u;
+        v = (v * 0x00000005u) & 0x49249249u;
+        return v;
+    }
+
+    // Builds the node array in two phases. The top levels are split one node at a time with each
+    // pass over the primitives spread across the workers, until ranges are small enough to be
+    // tasks. Every task then builds its subtree serially into its own array, the tasks running in
+    // parallel, and the pieces are spliced together in depth first order. Only the primitive order
+    // is shared, and each task reorders just its own range of it
+    class builder {
+    public:
+        builder(eastl::span<const bounds3> boxes, const build_settings& settings, eastl::vector<node>& nodes, eastl::vector<uint32_t>& order)
+            : mBoxes(boxes)
+            , mSettings(settings)
+            , mNodes(nodes)
+            , mOrder(order) {
+            ELOO_ASSERT_FATAL(settings.binCount >= 2 && settings.binCount <= MAX_BINS, "BVH bin count must be between 2 and %u, got %u", MAX_BINS, settings.binCount);
+            ELOO_ASSERT_FATAL(settings.maxLeafSize >= 1, "BVH leaves must hold at least one primitive");
+        }
+
+        void run() {
+            const uint32_t count = static_cast<uint32_t>(mBoxes.size());
+            mNodes.clear();
+            mOrder.resize(count);
+            if (count == 0) {
+                return;
+            }
+
+            mCentres.resize(count);
+            parallel::parallel_for(count, PARALLEL_GRAIN, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) {
+                    for (int axis = 0; axis < 3; ++axis) {
+                        mCentres[i].v[axis] = (mBoxes[i].min[axis] + mBoxes[i].max[axis]) * 0.5f;
+                    }
+                    mOrder[i] = static_cast<uint32_t>(i);
+                }
+            });
+
+            const bool lbvh = mSettings.method == build_method::lbvh;
+            eastl::vector<node> top;
+            push_top(top);
+            if (lbvh) {
+                sort_by_morton_code();
+                split_top_lbvh(top, 0, 0, count, 0);
+            }
+            else {
+                mScratch.resize(count);
+                split_top(top, 0, 0, count, 0);
+            }
+
+            mSubtrees.resize(mTasks.size());
+            parallel::parallel_for(mTasks.size(), 1, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) {
+                    const task& work = mTasks[i];
+                    eastl::vector<node>& nodes = mSubtrees[i];
+                    // A binary tree over n leaves never needs more than 2n - 1 nodes, so reserving
+                    // that keeps node references stable while the children are appended
+                    nodes.reserve(work.count * 2 - 1);
+                    nodes.push_back({});
+                    if (lbvh) {
+                        split_lbvh(nodes, 0, work.first, work.count, work.depth);
+                    }
+                    else {
+                        split(nodes, 0, work.first, work.count, work.depth);
+                    }
+                }
+            });
+
+            size_t total = top.size() - mTasks.size();
+            for (const eastl::vector<node>& nodes : mSubtrees) {
+                total += nodes.size();
+            }
+            mNodes.reserve(total);
+            splice(top, 0);
+
+            // LBVH interiors only get their bounds now. Children always follow their parent, so a
+            // backwards pass sees both before it
+            if (lbvh) {
+                for (size_t i = mNodes.size(); i-- > 0;) {
+                    node& n = mNodes[i];
+                    if (!n.is_leaf()) {
+                        const node& left = mNodes[i + 1];
+                        const node& right = mNodes[n.offset];
+                        for (int axis = 0; axis < 3; ++axis) {
+                            n.min[axis] = math::min(left.min[axis], right.min[axis]);
+                            n.max[axis] = math::max(left.max[axis], right.max[axis]);
+                        }
+                    }
+                }
+            }
+        }
+
+    private:
+        struct task {
+            uint32_t first;
+            uint32_t count;
+            uint32_t depth;
+        };
+
+        static void set_bounds(node& n, const bounds3& bounds) {
+            for (int axis = 0; axis < 3; ++axis) {
+                n.min[axis] = bounds.min[axis];
+                n.max[axis] = bounds.max[axis];
+            }
+        }
+
+        static void make_leaf(node& n, uint32_t first, uint32_t count) {
+            n.offset = first;
+            n.count = count;
+        }
+
+        uint32_t push_top(eastl::vector<node>& top) {
+            top.push_back({});
+            mTopTasks.push_back(NO_TASK);
+            return static_cast<uint32_t>(top.size() - 1);
+        }
+
+        void add_task(uint32_t topIndex, uint32_t first, uint32_t count, uint32_t depth) {
+            mTopTasks[topIndex] = static_cast<uint32_t>(mTasks.size());
+            mTasks.push_back({ first, count, depth });
+        }
+
+        // Copies the top levels out depth first, with each task's subtree in place of its node
+        void splice(const eastl::vector<node>& top, uint32_t topIndex) {
+            const uint32_t taskIndex = mTopTasks[topIndex];
+            if (taskIndex != NO_TASK) {
+                const uint32_t base = static_cast<uint32_t>(mNodes.size());
+                for (const node& n : mSubtrees[taskIndex]) {
+                    mNodes.push_back(n);
+                    if (!n.is_leaf()) {
+                        mNodes.back().offset += base;
+                    }
+                }
+                return;
+            }
+
+            const uint32_t outIndex = static_cast<uint32_t>(mNodes.size());
+            mNodes.push_back(top[topIndex]);
+            if (top[topIndex].is_leaf()) {
+                return;
+            }
+            splice(top, topIndex + 1);
+            mNodes[outIndex].offset = static_cast<uint32_t>(mNodes.size());
+            splice(top, top[topIndex].offset);
+        }
+
+        // Passes over a range, either serial or spread across the workers
+
+        range_bounds gather_bounds(uint32_t first, uint32_t count) const {
+            range_bounds bounds;
+            for (uint32_t i = first; i < first + count; ++i) {
+                grow(bounds.nodeBounds, mBoxes[mOrder[i]]);
+                grow(bounds.centreBounds, mCentres[mOrder[i]]);
+            }
+            return bounds;
+        }
+
+        range_bounds gather_bounds_parallel(uint32_t first, uint32_t count) const {
+            const size_t chunks = (count + PARALLEL_GRAIN - 1) / PARALLEL_GRAIN;
+            eastl::vector<range_bounds> partial(chunks);
+            parallel::parallel_for(count, PARALLEL_GRAIN, [&](size_t begin, size_t end) {
+                partial[begin / PARALLEL_GRAIN] = gather_bounds(first + static_cast<uint32_t>(begin), static_cast<uint32_t>(end - begin));
+            });
+
+            range_bounds bounds;
+            for (const range_bounds& part : partial) {
+                grow(bounds.nodeBounds, part.nodeBounds);
+                grow(bounds.centreBounds, part.centreBounds);
+            }
+            return bounds;
+        }
+
+        bin_grid make_grid(const bounds3& centreBounds) const {
+            bin_grid grid;
+            for (int axis = 0; axis < 3; ++axis) {
+                const float extent = centreBounds.max[axis] - centreBounds.min[axis];
+                grid.origin[axis] = centreBounds.min[axis];
+                grid.scale[axis] = extent > 0.0f ? static_cast<float>(mSettings.binCount) / extent : 0.0f;
+            }
+            return grid;
+        }
+
+        ELOO_FORCE_INLINE uint32_t bin_index(const centre3& centre, const bin_grid& grid, int axis) const {
+            const uint32_t index = static_cast<uint32_t>((centre.v[axis] - grid.origin[axis]) * grid.scale[axis]);
+            return index < mSettings.binCount ? index : mSettings.binCount - 1;
+        }
+
+        void fill_bins(uint32_t first, uint32_t count, const bin_grid& grid, bin_set& set) const {
+            for (uint32_t i = first; i < first + count; ++i) {
+                const uint32_t primitive = mOrder[i];
+                for (int axis = 0; axis < 3; ++axis) {
+                    bin& target = set.bins[axis][bin_index(mCentres[primitive], grid, axis)];
+                    grow(target.bounds, mBoxes[primitive]);
+                    ++target.count;
+                }
+            }
+        }
+
+        void fill_bins_parallel(uint32_t first, uint32_t count, const bin_grid& grid, bin_set& set) const {
+            const size_t chunks = (count + PARALLEL_GRAIN - 1) / PARALLEL_GRAIN;
+            eastl::vector<bin_set> partial(chunks);
+            parallel::parallel_for(count, PARALLEL_GRAIN, [&](size_t begin, size_t end) {
+                fill_bins(first + static_cast<uint32_t>(begin), static_cast<uint32_t>(end - begin), grid, partial[begin / PARALLEL_GRAIN]);
+            });
+
+            for (const bin_set& part : partial) {
+                for (int axis = 0; axis < 3; ++axis) {
+                    for (uint32_t i = 0; i < mSettings.binCount; ++i) {
+                        grow(set.bins[axis][i].bounds, part.bins[axis][i].bounds);
+                        set.bins[axis][i].count += part.bins[axis][i].count;
+                    }
+                }
+            }
+        }
+
+        // Tries every bin boundary on every axis, costing each side by its area times its count
+        split_plane choose_split(const bin_set& set, const range_bounds& bounds, uint32_t count) const {
+            const uint32_t binCount = mSettings.binCount;
+            const float parentArea = half_area(bounds.nodeBounds);
+            const float invParentArea = parentArea > 0.0f ? 1.0f / parentArea : 0.0f;
+            split_plane best;
+            for (int axis = 0; axis < 3; ++axis) {
+                if (bounds.centreBounds.max[axis] - bounds.centreBounds.min[axis] <= 0.0f) {
+                    continue;
+                }
+
+                const bin* bins = set.bins[axis];
+                float rightCost[MAX_BINS];
+                bounds3 rightBounds;
+                uint32_t rightCount = 0;
+                for (uint32_t i = binCount - 1; i > 0; --i) {
+                    grow(rightBounds, bins[i].bounds);
+                    rightCount += bins[i].count;
+                    rightCost[i] = half_area(rightBounds) * static_cast<float>(rightCount);
+                }
+
+                bounds3 leftBounds;
+                uint32_t leftCount = 0;
+                for (uint32_t i = 1; i < binCount; ++i) {
+                    grow(leftBounds, bins[i - 1].bounds);
+                    leftCount += bins[i - 1].count;
+                    if (leftCount == 0 || leftCount == count) {
+                        continue;
+                    }
+
+                    const float cost = mSettings.traversalCost + (half_area(leftBounds) * static_cast<float>(leftCount) + rightCost[i]) * invParentArea;
+                    if (cost < best.cost) {
+                        best.axis = axis;
+                        best.index = i;
+                        best.cost = cost;
+                    }
+                }
+            }
+            return best;
+        }
+
+        // Splitting is skipped for small ranges it doesn't pay off for. Ranges whose centres all
+        // coincide can't be binned, and are halved when too big for a leaf
+        bool keep_as_leaf(const split_plane& plane, uint32_t count) const {
+            return count <= mSettings.maxLeafSize && (plane.axis < 0 || plane.cost >= static_cast<float>(count));
+        }
+
+        void split_top(eastl::vector<node>& top, uint32_t nodeIndex, uint32_t first, uint32_t count, uint32_t depth) {
+            if (count <= TASK_PRIMITIVES) {
+                add_task(nodeIndex, first, count, depth);
+                return;
+            }
+
+            const range_bounds bounds = gather_bounds_parallel(first, count);
+            set_bounds(top[nodeIndex], bounds.nodeBounds);
+            if (depth + 1 >= MAX_DEPTH) {
+                make_leaf(top[nodeIndex], first, count);
+                return;
+            }
+
+            const bin_grid grid = make_grid(bounds.centreBounds);
+            bin_set set;
+            fill_bins_parallel(first, count, grid, set);
+            const split_plane plane = choose_split(set, bounds, count);
+            if (keep_as_leaf(plane, count)) {
+                make_leaf(top[nodeIndex], first, count);
+                return;
+            }
+
+            const uint32_t middle = plane.axis < 0 ? first + count / 2 : partition_parallel(first, count, grid, plane);
+            top[nodeIndex].count = 0;
+            split_top(top, push_top(top), first, middle - first, depth + 1);
+            const uint32_t rightIndex = push_top(top);
+            top[nodeIndex].offset = rightIndex;
+            split_top(top, rightIndex, middle, first + count - middle, depth + 1);
+        }
+
+        // Stable, so the order doesn't depend on how the range was chunked. The chunks are fixed
+        // runs of PARALLEL_GRAIN primitives, so the counting and scatter passes agree on them
+        // however parallel_for splits the work
+        uint32_t partition_parallel(uint32_t first, uint32_t count, const bin_grid& grid, const split_plane& plane) {
+            const auto goesLeft = [&](uint32_t primitive) {
+                return bin_index(mCentres[primitive], grid, plane.axis) < plane.index;
+            };
+
+            const size_t chunks = (count + PARALLEL_GRAIN - 1) / PARALLEL_GRAIN;
+            eastl::vector<uint32_t> leftBefore(chunks);
+            parallel::parallel_for(chunks, 1, [&](size_t firstChunk, size_t lastChunk) {
+                for (size_t chunk = firstChunk; chunk < lastChunk; ++chunk) {
+                    const size_t end = eastl::min<size_t>(count, (chunk + 1) * PARALLEL_GRAIN);
+                    uint32_t left = 0;
+                    for (size_t i = chunk * PARALLEL_GRAIN; i < end; ++i) {
+                        left += goesLeft(mOrder[first + i]) ? 1u : 0u;
+                    }
+                    leftBefore[chunk] = left;
+                }
+            });
+
+            uint32_t leftCount = 0;
+            for (uint32_t& chunkLeft : leftBefore) {
+                const uint32_t chunkCount = chunkLeft;
+                chunkLeft = leftCount;
+                leftCount += chunkCount;
+            }
+
+            parallel::parallel_for(chunks, 1, [&](size_t firstChunk, size_t lastChunk) {
+                for (size_t chunk = firstChunk; chunk < lastChunk; ++chunk) {
+                    const size_t begin = chunk * PARALLEL_GRAIN;
+                    const size_t end = eastl::min<size_t>(count, begin + PARALLEL_GRAIN);
+                    uint32_t left = leftBefore[chunk];
+                    uint32_t right = leftCount + static_cast<uint32_t>(begin) - left;
+                    for (size_t i = begin; i < end; ++i) {
+                        const uint32_t primitive = mOrder[first + i];
+                        mScratch[goesLeft(primitive) ? left++ : right++] = primitive;
+                    }
+                }
+            });
+            parallel::parallel_for(count, PARALLEL_GRAIN, [&](size_t begin, size_t end) {
+                eastl::copy(mScratch.begin() + begin, mScratch.begin() + end, mOrder.begin() + first + begin);
+            });
+            return first + leftCount;
+        }
+
+        void split(eastl::vector<node>& nodes, uint32_t nodeIndex, uint32_t first, uint32_t count, uint32_t depth) {
+            const range_bounds bounds = gather_bounds(first, count);
+            node& n = nodes[nodeIndex];
+            set_bounds(n, bounds.nodeBounds);
+            if (count == 1 || depth + 1 >= MAX_DEPTH) {
+                make_leaf(n, first, count);
+                return;
+            }
+
+            const bin_grid grid = make_grid(bounds.centreBounds);
+            bin_set set;
+            fill_bins(first, count, grid, set);
+            const split_plane plane = choose_split(set, bounds, count);
+            if (keep_as_leaf(plane, count)) {
+                make_leaf(n, first, count);
+                return;
+            }
+
+            uint32_t middle = first + count / 2;
+            if (plane.axis >= 0) {
+                uint32_t* left = mOrder.data() + first;
+                uint32_t* right = left + count;
+                while (left < right) {
+                    if (bin_index(mCentres[*left], grid, plane.axis) < plane.index) {
+                        ++left;
+                    }
+                    else {
+                        eastl::swap(*left, *--right);
+                    }
+                }
+                middle = static_cast<uint32_t>(left - mOrder.data());
+            }
+
+            n.count = 0;
+            const uint32_t leftIndex = static_cast<uint32_t>(nodes.size());
+            nodes.push_back({});
+            split(nodes, leftIndex, first, middle - first, depth + 1);
+
+            const uint32_t rightIndex = static_cast<uint32_t>(nodes.size());
+            nodes.push_back({});
+            nodes[nodeIndex].offset = rightIndex;
+            split(nodes, rightIndex, middle, first + count - middle, depth + 1);
+        }
+
+        // Orders the primitives along a Morton curve through the centre bounds. The radix sort is
+        // stable, so equal codes stay in index order
+        void sort_by_morton_code() {
+            const uint32_t count = static_cast<uint32_t>(mOrder.size());
+            const bin_grid grid = [&] {
+                const bounds3 centreBounds = gather_bounds_parallel(0, count).centreBounds;
+                bin_grid g;
+                for (int axis = 0; axis < 3; ++axis) {
+                    const float extent = centreBounds.max[axis] - centreBounds.min[axis];
+                    g.origin[axis] = centreBounds.min[axis];
+                    g.scale[axis] = extent > 0.0f ? static_cast<float>(MORTON_LEVELS) / extent : 0.0f;
+                }
+                return g;
+            }();
+
+            eastl::vector<uint32_t> codes(count);
+            parallel::parallel_for(count, PARALLEL_GRAIN, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) {
+                    uint32_t code = 0;
+                    for (int axis = 0; axis < 3; ++axis) {
+                        const uint32_t cell = static_cast<uint32_t>((mCentres[i].v[axis] - grid.origin[axis]) * grid.scale[axis]);
+                        code |= expand_bits(cell < MORTON_LEVELS ? cell : MORTON_LEVELS - 1) << (2 - axis);
+                    }
+                    codes[i] = code;
+                }
+            });
+
+            eastl::vector<uint32_t> codesOut(count);
+            eastl::vector<uint32_t> orderOut(count);
+            for (uint32_t shift = 0; shift < 32; shift += 8) {
+                uint32_t offsets[256] = {};
+                for (uint32_t i = 0; i < count; ++i) {
+                    ++offsets[(codes[i] >> shift) & 0xFFu];
+                }
+                uint32_t sum = 0;
+                for (uint32_t& offset : offsets) {
+                    const uint32_t digitCount = offset;
+                    offset = sum;
+                    sum += digitCount;
+                }
+                for (uint32_t i = 0; i < count; ++i) {
+                    const uint32_t slot = offsets[(codes[i] >> shift) & 0xFFu]++;
+                    codesOut[slot] = codes[i];
+                    orderOut[slot] = mOrder[i];
+                }
+                codes.swap(codesOut);
+                mOrder.swap(orderOut);
+            }
+            mCodes = eastl::move(codes);
+        }
+
+        // Splits where the highest bit that differs across the range turns on, or in half when
+        // every code is the same
+        uint32_t morton_split(uint32_t first, uint32_t count) const {
+            const uint32_t last = first + count - 1;
+            const uint32_t diff = mCodes[first] ^ mCodes[last];
+            if (diff == 0) {
+                return first + count / 2;
+            }
+
+            uint32_t bit = MORTON_TOP_BIT;
+            while ((diff & bit) == 0) {
+                bit >>= 1;
+            }
+
+            // The codes share every bit above 'bit', so those with it clear come first
+            uint32_t clear = first;
+            uint32_t set = last;
+            while (set - clear > 1) {
+                const uint32_t mid = clear + (set - clear) / 2;
+                if (mCodes[mid] & bit) {
+                    set = mid;
+                }
+                else {
+                    clear = mid;
+                }
+            }
+            return set;
+        }
+
+        void split_top_lbvh(eastl::vector<node>& top, uint32_t nodeIndex, uint32_t first, uint32_t count, uint32_t depth) {
+            if (count <= TASK_PRIMITIVES) {
+                add_task(nodeIndex, first, count, depth);
+                return;
+            }
+            if (depth + 1 >= MAX_DEPTH) {
+                set_bounds(top[nodeIndex], gather_bounds_parallel(first, count).nodeBounds);
+                make_leaf(top[nodeIndex], first, count);
+                return;
+            }
+
+            const uint32_t middle = morton_split(first, count);
+            top[nodeIndex].count = 0;
+            split_top_lbvh(top, push_top(top), first, middle - first, depth + 1);
+            const uint32_t rightIndex = push_top(top);
+            top[nodeIndex].offset = rightIndex;
+            split_top_lbvh(top, rightIndex, middle, first + count - middle, depth + 1);
+        }
+
+        // Interior bounds are left for the backwards pass once everything is spliced
+        void split_lbvh(eastl::vector<node>& nodes, uint32_t nodeIndex, uint32_t first, uint32_t count, uint32_t depth) const {
+            node& n = nodes[nodeIndex];
+            if (count <= mSettings.maxLeafSize || depth + 1 >= MAX_DEPTH) {
+                set_bounds(n, gather_bounds(first, count).nodeBounds);
+                make_leaf(n, first, count);
+                return;
+            }
+
+            const uint32_t middle = morton_split(first, count);
+            n.count = 0;
+            const uint32_t leftIndex = static_cast<uint32_t>(nodes.size());
+            nodes.push_back({});
+            split_lbvh(nodes, leftIndex, first, middle - first, depth + 1);
+
+            const uint32_t rightIndex = static_cast<uint32_t>(nodes.size());
+            nodes.push_back({});
+            nodes[nodeIndex].offset = rightIndex;
+            split_lbvh(nodes, rightIndex, middle, first + count - middle, depth + 1);
+        }
+
+    private:
+        eastl::span<const bounds3> mBoxes;
+        const build_settings& mSettings;
+        eastl::vector<node>& mNodes;
+        eastl::vector<uint32_t>& mOrder;
+        eastl::vector<centre3> mCentres;
+        eastl::vector<uint32_t> mCodes;
+        eastl::vector<uint32_t> mScratch;
+
+        eastl::vector<task> mTasks;
+        eastl::vector<uint32_t> mTopTasks;
+        eastl::vector<eastl::vector<node>> mSubtrees;
+    };
+
+    // Ray terms unpacked for the slab tests. Sweeps inflate every node by their radius
+    struct node_query {
+        float origin[3];
+        float invDirection[3];
+        uint32_t sign[3];
+        float inflate;
+
+        node_query(const raycast::ray& query, float inflateBy)
+            : origin { query.origin.x(), query.origin.y(), query.origin.z() }
+            , invDirection { query.invDirection.x(), query.invDirection.y(), query.invDirection.z() }
+            , sign { query.sign[0], query.sign[1], query.sign[2] }
+            , inflate(inflateBy) {
+        }
+    };
+
+    // Distance at which the ray enters the node within [tmin, tmax], or MISS. A slab the ray runs
+    // along produces NaNs, which the argument order below drops rather than spreads
+    ELOO_FORCE_INLINE float entry_distance(const node& n, const node_query& query, float tmin, float tmax) {
+        float tNear = tmin;
+        float tFar = tmax;
+        for (int axis = 0; axis < 3; ++axis) {
+            const float lo = n.min[axis] - query.inflate;
+            const float hi = n.max[axis] + query.inflate;
+            const float t0 = ((query.sign[axis] ? hi : lo) - query.origin[axis]) * query.invDirection[axis];
+            const float t1 = ((query.sign[axis] ? lo : hi) - query.origin[axis]) * query.invDirection[axis];
+            tNear = math::max(t0, tNear);
+            tFar = math::min(t1, tFar);
+        }
+        return tNear <= tFar ? tNear : MISS;
+    }
+
+    // Walks the nodes the ray enters, nearest child first. 'leafFn' tests a leaf's primitives,
+    // shrinking the ray as it finds hits, and returns true to end the walk early. Nodes whose entry
+    // lies beyond the shrunk ray are skipped when popped
+    template <typename LeafFn>
+    bool traverse(eastl::span<const node> nodes, raycast::ray& query, float inflate, LeafFn leafFn) {
+        if (nodes.empty()) {
+            return false;
+        }
+
+        const node_query terms(query, inflate);
+        if (entry_distance(nodes[0], terms, query.tmin, query.tmax) == MISS) {
+            return false;
+        }
+
+        struct entry {
+            uint32_t index;
+            float distance;
+        };
+        entry stack[MAX_DEPTH];
+        uint32_t top = 0;
+        uint32_t index = 0;
+        for (;;) {
+            const node& n = nodes[index];
+            if (n.is_leaf()) {
+                if (leafFn(n.offset, n.count)) {
+                    return true;
+                }
+            }
+            else {
+                uint32_t nearIndex = index + 1;
+                uint32_t farIndex = n.offset;
+                float nearDistance = entry_distance(nodes[nearIndex], terms, query.tmin, query.tmax);
+                float farDistance = entry_distance(nodes[farIndex], terms, query.tmin, query.tmax);
+                if (farDistance < nearDistance) {
+                    eastl::swap(nearIndex, farIndex);
+                    eastl::swap(nearDistance, farDistance);
+                }
+                if (nearDistance != MISS) {
+                    if (farDistance != MISS) {
+                        stack[top++] = { farIndex, farDistance };
+                    }
+                    index = nearIndex;
+                    continue;
+                }
+            }
+
+            entry next;
+            do {
+                if (top == 0) {
+                    return false;
+                }
+                next = stack[--top];
+            } while (next.distance > query.tmax);
+            index = next.index;
+        }
+    }
+
+    // Calls 'leafFn' for every leaf whose bounds overlap 'box'
+    template <typename LeafFn>
+    void traverse(eastl::span<const node> nodes, const aabb& box, LeafFn leafFn) {
+        if (nodes.empty()) {
+            return;
+        }
+
+        const float boxMin[3] = { box.min.x(), box.min.y(), box.min.z() };
+        const float boxMax[3] = { box.max.x(), box.max.y(), box.max.z() };
+        const auto overlaps = [&](const node& n) {
+            return n.min[0] <= boxMax[0] && n.max[0] >= boxMin[0]
+                && n.min[1] <= boxMax[1] && n.max[1] >= boxMin[1]
+                && n.min[2] <= boxMax[2] && n.max[2] >= boxMin[2];
+        };
+        if (!overlaps(nodes[0])) {
+            return;
+        }
+
+        uint32_t stack[MAX_DEPTH];
+        uint32_t top = 0;
+        uint32_t index = 0;
+        for (;;) {
+            const node& n = nodes[index];
+            if (n.is_leaf()) {
+                leafFn(n.offset, n.count);
+            }
+            else {
+                const bool nearOverlaps = overlaps(nodes[index + 1]);
+                const bool farOverlaps = overlaps(nodes[n.offset]);
+                if (nearOverlaps) {
+                    if (farOverlaps) {
+                        stack[top++] = n.offset;
+                    }
+                    index = index + 1;
+                    continue;
+                }
+                if (farOverlaps) {
+                    index = n.offset;
+                    continue;
+                }
+            }
+
+            if (top == 0) {
+                return;
+            }
+            index = stack[--top];
+        }
+    }
+
+    // Packet lanes unpacked for the node tests. Each lane picks its near and far slabs by the
+    // sign of its inverse direction, so NaNs from slabs a lane runs along are dropped as above
+    template <int Lanes>
+    struct packet_terms {
+        static constexpr int GROUPS = Lanes / math::simd::WIDTH;
+
+        math::simd::f32x4 origin[GROUPS][3];
+        math::simd::f32x4 invDirection[GROUPS][3];
+        math::simd::f32x4 negative[GROUPS][3];
+        math::simd::f32x4 length[GROUPS];
+
+        explicit packet_terms(const raycast::packet<Lanes>& rays) {
+            using namespace math::simd;
+            for (int group = 0; group < GROUPS; ++group) {
+                const int first = group * WIDTH;
+                const f32x4 directions[3] = { load(rays.dirX + first), load(rays.dirY + first), load(rays.dirZ + first) };
+                origin[group][0] = load(rays.originX + first);
+                origin[group][1] = load(rays.originY + first);
+                origin[group][2] = load(rays.originZ + first);
+                for (int axis = 0; axis < 3; ++axis) {
+                    invDirection[group][axis] = set1(1.0f) / directions[axis];
+                    negative[group][axis] = cmp_lt(invDirection[group][axis], zero());
+                }
+                length[group] = load(rays.length + first);
+            }
+        }
+
+        // Lanes in 'lanes' whose ray enters the node within [0, length]
+        ELOO_FORCE_INLINE uint32_t enter(const node& n, uint32_t lanes) const {
+            using namespace math::simd;
+            uint32_t entered = 0;
+            for (int group = 0; group < GROUPS; ++group) {
+                if (((lanes >> (group * WIDTH)) & 0xFu) == 0) {
+                    continue;
+                }
+                f32x4 tNear = zero();
+                f32x4 tFar = length[group];
+                for (int axis = 0; axis < 3; ++axis) {
+                    const f32x4 lo = set1(n.min[axis]);
+                    const f32x4 hi = set1(n.max[axis]);
+                    const f32x4 t0 = (select(negative[group][axis], hi, lo) - origin[group][axis]) * invDirection[group][axis];
+                    const f32x4 t1 = (select(negative[group][axis], lo, hi) - origin[group][axis]) * invDirection[group][axis];
+                    tNear = math::simd::max(t0, tNear);
+                    tFar = math::simd::min(t1, tFar);
+                }
+                entered |= static_cast<uint32_t>(movemask(cmp_le(tNear, tFar))) << (group * WIDTH);
+            }
+            return entered & lanes;
+        }
+    };
+
+    // Walks the nodes any unblocked lane enters. 'leafFn' tests a leaf's primitives against the
+    // lanes given and returns those it found blocked. The walk ends once every lane is blocked
+    template <int Lanes, typename LeafFn>
+    uint32_t traverse(eastl::span<const node> nodes, const raycast::packet<Lanes>& rays, LeafFn leafFn) {
+        uint32_t open = rays.active;
+        if (nodes.empty() || open == 0) {
+            return 0;
+        }
+
+        const packet_terms<Lanes> terms(rays);
+        uint32_t blocked = 0;
+        uint32_t stack[MAX_DEPTH];
+        uint32_t top = 0;
+        uint32_t index = 0;
+        for (;;) {
+            const node& n = nodes[index];
+            const uint32_t lanes = terms.enter(n, open);
+            if (lanes != 0) {
+                if (!n.is_leaf()) {
+                    stack[top++] = n.offset;
+                    index = index + 1;
+                    continue;
+                }
+                blocked |= leafFn(n.offset, n.count, lanes);
+                open &= ~blocked;
+                if (open == 0) {
+                    return blocked;
+                }
+            }
+
+            if (top == 0) {
+                return blocked;
+            }
+            index = stack[--top];
+        }
+    }
+
+    ELOO_FORCE_INLINE bool overlaps(const bounds3& a, const aabb& b) {
+        return a.min[0] <= b.max.x() && a.max[0] >= b.min.x()
+            && a.min[1] <= b.max.y() && a.max[1] >= b.min.y()
+            && a.min[2] <= b.max.z() && a.max[2] >= b.min.z();
+    }
+
+    // Hits are accepted up to the current best distance, so equal distances fall back to the
+    // lower index to keep results independent of the tree layout
+    ELOO_FORCE_INLINE void keep_closest(batch_hit& closest, uint32_t index, const raycast::result& hit) {
+        if (hit.distance < closest.hit.distance || index < closest.index) {
+            closest.index = index;
+            closest.hit = hit;
+        }
+    }
+}
+
+
+/////////////////////////////////////////////////////////////////////
+// Box tree
+
+tree::tree(eastl::span<const aabb> boxes, const build_settings& settings) {
+    build(boxes, settings);
+}
+
+void tree::build(eastl::span<const aabb> boxes, const build_settings& settings) {
+    eastl::vector<bounds3> bounds;
+    bounds.reserve(boxes.size());
+    for (const aabb& box : boxes) {
+        bounds.push_back(to_bounds(box));
+    }
+
+    builder(bounds, settings, mNodes, mIndices).run();
+
+    mBoxes.clear();
+    mBoxes.reserve(mIndices.size());
+    for (const uint32_t index : mIndices) {
+        mBoxes.push_back(boxes[index]);
+    }
+}
+
+void tree::clear() {
+    mNodes.clear();
+    mBoxes.clear();
+    mIndices.clear();
+}
+
+aabb tree::bounds() const {
+    return mNodes.empty() ? aabb() : to_aabb(mNodes[0]);
+}
+
+bool tree::raycast(const raycast::ray& query, batch_hit& closest) const {
+    closest = batch_hit();
+
+    raycast::ray local = query;
+    traverse(mNodes, local, 0.0f, [&](uint32_t first, uint32_t count) {
+        for (uint32_t i = first; i < first + count; ++i) {
+            raycast::result hit;
+            if (raycast::test_aabb(local, mBoxes[i].min, mBoxes[i].max, hit)) {
+                keep_closest(closest, mIndices[i], hit);
+                local.shrink(hit.distance);
+            }
+        }
+        return false;
+    });
+    return closest.index != batch_hit::INVALID_INDEX;
+}
+
+bool tree::occluded(const raycast::ray& query) const {
+    raycast::ray local = query;
+    return traverse(mNodes, local, 0.0f, [&](uint32_t first, uint32_t count) {
+        for (uint32_t i = first; i < first + count; ++i) {
+            if (raycast::occluded_aabb(local, mBoxes[i].min, mBoxes[i].max)) {
+                return true;
+            }
+        }
+        return false;
+    });
+}
+
+template <int Lanes>
+uint32_t tree::occluded(const raycast::packet<Lanes>& rays) const {
+    raycast::packet<Lanes> local = rays;
+    return traverse(mNodes, rays, [&](uint32_t first, uint32_t count, uint32_t lanes) {
+        local.active = lanes;
+        uint32_t blocked = 0;
+        for (uint32_t i = first; i < first + count && local.active != 0; ++i) {
+            const uint32_t hits = raycast::occluded_aabb(local, mBoxes[i].min, mBoxes[i].max);
+            blocked |= hits;
+            local.active &= ~hits;
+        }
+        return blocked;
+    });
+}
+
+bool tree::spherecast(const spherecast::sweep& query, batch_hit& closest) const {
+    closest = batch_hit();
+
+    spherecast::sweep local = query;
+    traverse(mNodes, local, query.radius, [&](uint32_t first, uint32_t count) {
+        for (uint32_t i = first; i < first + count; ++i) {
+            raycast::result hit;
+            if (spherecast::test_aabb(local, mBoxes[i].min, mBoxes[i].max, hit)) {
+                keep_closest(closest, mIndices[i], hit);
+                local.shrink(hit.distance);
+            }
+        }
+        return false;
+    });
+    return closest.index != batch_hit::INVALID_INDEX;
+}
+
+size_t tree::overlap(const aabb& box, eastl::vector<uint32_t>& indices) const {
+    const size_t initialSize = indices.size();
+    traverse(mNodes, box, [&](uint32_t first, uint32_t count) {
+        for (uint32_t i = first; i < first + count; ++i) {
+            if (overlaps(to_bounds(mBoxes[i]), box)) {
+                indices.push_back(mIndices[i]);
+            }
+        }
+    });
+    return indices.size() - initialSize;
+}
+
+
+/////////////////////////////////////////////////////////////////////
+// Triangle mesh
+
+mesh::mesh(eastl::span<const float3::values> vertices, eastl::span<const uint32_t> indices, const build_settings& settings) {
+    build(vertices, indices, settings);
+}
+
+mesh::mesh(eastl::span<const float3::values> vertices, const build_settings& settings) {
+    build(vertices, settings);
+}
+
+void mesh::build(eastl::span<const float3::values> vertices, eastl::span<const uint32_t> indices, const build_settings& settings) {
+    ELOO_ASSERT_FATAL(indices.size() % 3 == 0, "Triangle indices come in threes, got %zu", indices.size());
+
+    const size_t triangleCount = indices.size() / 3;
+    eastl::vector<bounds3> bounds;
+    bounds.reserve(triangleCount);
+    for (size_t i = 0; i < indices.size(); i += 3) {
+        ELOO_ASSERT(indices[i] < vertices.size() && indices[i + 1] < vertices.size() && indices[i + 2] < vertices.size(),
+            "Triangle %zu indexes past the %zu vertices", i / 3, vertices.size());
+        bounds.push_back(to_bounds(vertices[indices[i]], vertices[indices[i + 1]], vertices[indices[i + 2]]));
+    }
+
+    builder(bounds, settings, mNodes, mIndices).run();
+
+    mTriangles.clear();
+    mTriangles.reserve(mIndices.size());
+    for (const uint32_t index : mIndices) {
+        mTriangles.push_back({ vertices[indices[index * 3]], vertices[indices[index * 3 + 1]], vertices[indices[index * 3 + 2]] });
+    }
+}
+
+void mesh::build(eastl::span<const float3::values> vertices, const build_settings& settings) {
+    ELOO_ASSERT_FATAL(vertices.size() % 3 == 0, "Triangle soups hold three vertices per triangle, got %zu", vertices.size());
+
+    const size_t triangleCount = vertices.size() / 3;
+    eastl::vector<bounds3> bounds;
+    bounds.reserve(triangleCount);
+    for (size_t i = 0; i < vertices.size(); i += 3) {
+        bounds.push_back(to_bounds(vertices[i], vertices[i + 1], vertices[i + 2]));
+    }
+
+    builder(bounds, settings, mNodes, mIndices).run();
+
+    mTriangles.clear();
+    mTriangles.reserve(mIndices.size());
+    for (const uint32_t index : mIndices) {
+        mTriangles.push_back({ vertices[index * 3], vertices[index * 3 + 1], vertices[index * 3 + 2] });
+    }
+}
+
+void mesh::clear() {
+    mNodes.clear();
+    mTriangles.clear();
+    mIndices.clear();
+}
+
+aabb mesh::bounds() const {
+    return mNodes.empty() ? aabb() : to_aabb(mNodes[0]);
+}
+
+size_t mesh::memory_bytes() const {
+    return mNodes.size() * sizeof(node) + mTriangles.size() * sizeof(triangle) + mIndices.size() * sizeof(uint32_t);
+}
+
+bool mesh::raycast(const raycast::ray& query, batch_hit& closest) const {
+    closest = batch_hit();
+
+    raycast::ray local = query;
+    traverse(mNodes, local, 0.0f, [&](uint32_t first, uint32_t count) {
+        for (uint32_t i = first; i < first + count; ++i) {
+            const triangle& tri = mTriangles[i];
+            raycast::result hit;
+            if (raycast::test_tri(local, tri.vertex1, tri.vertex2, tri.vertex3, hit)) {
+                keep_closest(closest, mIndices[i], hit);
+                local.shrink(hit.distance);
+            }
+        }
+        return false;
+    });
+    return closest.index != batch_hit::INVALID_INDEX;
+}
+
+bool mesh::occluded(const raycast::ray& query) const {
+    raycast::ray local = query;
+    return traverse(mNodes, local, 0.0f, [&](uint32_t first, uint32_t count) {
+        for (uint32_t i = first; i < first + count; ++i) {
+            const triangle& tri = mTriangles[i];
+            if (raycast::occluded_tri(local, tri.vertex1, tri.vertex2, tri.vertex3)) {
+                return true;
+            }
+        }
+        return false;
+    });
+}
+
+template <int Lanes>
+uint32_t mesh::occluded(const raycast::packet<Lanes>& rays) const {
+    raycast::packet<Lanes> local = rays;
+    return traverse(mNodes, rays, [&](uint32_t first, uint32_t count, uint32_t lanes) {
+        local.active = lanes;
+        uint32_t blocked = 0;
+        for (uint32_t i = first; i < first + count && local.active != 0; ++i) {
+            const triangle& tri = mTriangles[i];
+            const uint32_t hits = raycast::occluded_tri(local, tri.vertex1, tri.vertex2, tri.vertex3);
+            blocked |= hits;
+            local.active &= ~hits;
+        }
+        return blocked;
+    });
+}
+
+bool mesh::spherecast(const spherecast::sweep& query, batch_hit& closest) const {
+    closest = batch_hit();
+
+    spherecast::sweep local = query;
+    traverse(mNodes, local, query.radius, [&](uint32_t first, uint32_t count) {
+        for (uint32_t i = first; i < first + count; ++i) {
+            const triangle& tri = mTriangles[i];
+            raycast::result hit;
+            if (spherecast::test_tri(local, tri.vertex1, tri.vertex2, tri.vertex3, hit)) {
+                keep_closest(closest, mIndices[i], hit);
+                local.shrink(hit.distance);
+            }
+        }
+        return false;
+    });
+    return closest.index != batch_hit::INVALID_INDEX;
+}
+
+size_t mesh::overlap(const aabb& box, eastl::vector<uint32_t>& indices) const {
+    const size_t initialSize = indices.size();
+    traverse(mNodes, box, [&](uint32_t first, uint32_t count) {
+        for (uint32_t i = first; i < first + count; ++i) {
+            const triangle& tri = mTriangles[i];
+            if (overlaps(to_bounds(tri.vertex1, tri.vertex2, tri.vertex3), box)) {
+                indices.push_back(mIndices[i]);
+            }
+        }
+    });
+    return indices.size() - initialSize;
+}
+
+#define ELOO_BVH_PACKET_INSTANTIATE(LANES) \
+    template uint32_t tree::occluded<LANES>(const raycast::packet<LANES>&) const; \
+    template uint32_t mesh::occluded<LANES>(const raycast::packet<LANES>&) const;
+
+ELOO_BVH_PACKET_INSTANTIATE(4)
+ELOO_BVH_PACKET_INSTANTIATE(8)
+ELOO_BVH_PACKET_INSTANTIATE(16)
+
+#undef ELOO_BVH_PACKET_INSTANTIATE
@@ -0,0 +1,495 @@
+#include "utility/bvh_compressed.h"
+
+#include "maths/math.h"
+#include "maths/simd.h"
+
+#include <EASTL/algorithm.h>
+
+using namespace eloo;
+using namespace eloo::bvh;
+
+namespace {
+    constexpr uint32_t QUANTIZED_MAX = UINT16_MAX;
+    constexpr uint32_t EMPTY_SLOT = UINT32_MAX;
+
+    // The one expression every dequantization goes through, so the build can check its rounding
+    // against exactly what traversal will compute
+    ELOO_FORCE_INLINE math::simd::f32x4 decode(math::simd::i32x4 quantized, float scale, float origin) {
+        return math::simd::madd(math::simd::to_f32(quantized), math::simd::set1(scale), math::simd::set1(origin));
+    }
+
+    float decode(uint32_t quantized, float scale, float origin) {
+        float lanes[4];
+        math::simd::store(lanes, decode(math::simd::set1_i32(static_cast<int32_t>(quantized)), scale, origin));
+        return lanes[0];
+    }
+
+    // Smallest step that takes the node's min to at least its max within the 16 bit range
+    float quantize_scale(float lo, float hi) {
+        float scale = (hi - lo) / QUANTIZED_MAX;
+        while (decode(QUANTIZED_MAX, scale, lo) < hi) {
+            scale = math::max(scale * (1.0f + 1.0f / 1024.0f), FLT_MIN);
+        }
+        return scale;
+    }
+
+    // Decoding is monotonic in the quantized value, so the outward rounded values are found by
+    // binary search. decode(0) is the node's min and decode(QUANTIZED_MAX) at least its max, so
+    // both searches always succeed
+    uint16_t quantize_down(float value, float scale, float origin) {
+        uint32_t lo = 0;
+        uint32_t hi = QUANTIZED_MAX;
+        while (lo < hi) {
+            const uint32_t mid = (lo + hi + 1) / 2;
+            if (decode(mid, scale, origin) <= value) {
+                lo = mid;
+            }
+            else {
+                hi = mid - 1;
+            }
+        }
+        return static_cast<uint16_t>(lo);
+    }
+
+    uint16_t quantize_up(float value, float scale, float origin) {
+        uint32_t lo = 0;
+        uint32_t hi = QUANTIZED_MAX;
+        while (lo < hi) {
+            const uint32_t mid = (lo + hi) / 2;
+            if (decode(mid, scale, origin) >= value) {
+                hi = mid;
+            }
+            else {
+                lo = mid + 1;
+            }
+        }
+        return static_cast<uint16_t>(lo);
+    }
+
+    ELOO_FORCE_INLINE float half_area(const node& n) {
+        const float x = n.max[0] - n.min[0];
+        const float y = n.max[1] - n.min[1];
+        const float z = n.max[2] - n.min[2];
+        return x * y + y * z + z * x;
+    }
+
+    aabb to_aabb(const float3::values& vertex1, const float3::values& vertex2, const float3::values& vertex3) {
+        aabb box;
+        box.min = { math::min(vertex1.x(), math::min(vertex2.x(), vertex3.x())),
+                    math::min(vertex1.y(), math::min(vertex2.y(), vertex3.y())),
+                    math::min(vertex1.z(), math::min(vertex2.z(), vertex3.z())) };
+        box.max = { math::max(vertex1.x(), math::max(vertex2.x(), vertex3.x())),
+                    math::max(vertex1.y(), math::max(vertex2.y(), vertex3.y())),
+                    math::max(vertex1.z(), math::max(vertex2.z(), vertex3.z())) };
+        return box;
+    }
+
+    ELOO_FORCE_INLINE bool overlaps(const aabb& a, const aabb& b) {
+        return a.min.x() <= b.max.x() && a.max.x() >= b.min.x()
+            && a.min.y() <= b.max.y() && a.max.y() >= b.min.y()
+            && a.min.z() <= b.max.z() && a.max.z() >= b.min.z();
+    }
+
+    // Ray terms broadcast once per query. Sweeps inflate every child by their radius
+    struct lane_query {
+        math::simd::f32x4 origin[3];
+        math::simd::f32x4 invDirection[3];
+        math::simd::f32x4 nearInflate[3];
+        math::simd::f32x4 farInflate[3];
+        uint32_t sign[3];
+
+        lane_query(const raycast::ray& query, float inflate)
+            : origin { math::simd::set1(query.origin.x()), math::simd::set1(query.origin.y()), math::simd::set1(query.origin.z()) }
+            , invDirection { math::simd::set1(query.invDirection.x()), math::simd::set1(query.invDirection.y()), math::simd::set1(query.invDirection.z()) }
+            , sign { query.sign[0], query.sign[1], query.sign[2] } {
+            for (int axis = 0; axis < 3; ++axis) {
+                nearInflate[axis] = math::simd::set1(sign[axis] ? inflate : -inflate);
+                farInflate[axis] = math::simd::set1(sign[axis] ? -inflate : inflate);
+            }
+        }
+    };
+
+    // Entry distances of a node's children within [tmin, tmax], four at a time. Returns a bit per
+    // child the ray enters. As in the binary tree, NaNs from slabs the ray runs along are dropped
+    // by the argument order
+    template <int Width>
+    ELOO_FORCE_INLINE uint32_t entry_distances(const wide_node<Width>& n, const lane_query& query, float tmin, float tmax, float* distances) {
+        uint32_t hits = 0;
+        for (int group = 0; group < Width; group += 4) {
+            math::simd::f32x4 tNear = math::simd::set1(tmin);
+            math::simd::f32x4 tFar = math::simd::set1(tmax);
+            for (int axis = 0; axis < 3; ++axis) {
+                const uint16_t* nearBound = query.sign[axis] ? n.hi[axis] : n.lo[axis];
+                const uint16_t* farBound = query.sign[axis] ? n.lo[axis] : n.hi[axis];
+                const math::simd::f32x4 nearPlane = decode(math::simd::load_u16(nearBound + group), n.scale[axis], n.origin[axis]) + query.nearInflate[axis];
+                const math::simd::f32x4 farPlane = decode(math::simd::load_u16(farBound + group), n.scale[axis], n.origin[axis]) + query.farInflate[axis];
+                const math::simd::f32x4 t0 = (nearPlane - query.origin[axis]) * query.invDirection[axis];
+                const math::simd::f32x4 t1 = (farPlane - query.origin[axis]) * query.invDirection[axis];
+                tNear = math::simd::max(t0, tNear);
+                tFar = math::simd::min(t1, tFar);
+            }
+            math::simd::store(distances + group, tNear);
+            hits |= static_cast<uint32_t>(math::simd::movemask(math::simd::cmp_le(tNear, tFar))) << group;
+        }
+        return hits & n.validMask;
+    }
+
+    // Leaf children are pushed as their triangle run, interior children with a count of 0
+    struct entry {
+        uint32_t first;
+        uint32_t count;
+        float distance;
+    };
+
+    // Walks the children the ray enters, nearest first. 'leafFn' tests a run of triangles,
+    // shrinking the ray as it finds hits, and returns true to end the walk early. Entries beyond
+    // the shrunk ray are skipped when popped
+    template <int Width, typename LeafFn>
+    bool traverse(eastl::span<const wide_node<Width>> nodes, raycast::ray& query, float inflate, LeafFn leafFn) {
+        if (nodes.empty()) {
+            return false;
+        }
+
+        const lane_query terms(query, inflate);
+        entry stack[Width * MAX_DEPTH];
+        uint32_t top = 0;
+        stack[top++] = { 0, 0, query.tmin };
+        while (top != 0) {
+            const entry current = stack[--top];
+            if (current.distance > query.tmax) {
+                continue;
+            }
+            if (current.count != 0) {
+                if (leafFn(current.first, current.count)) {
+                    return true;
+                }
+                continue;
+            }
+
+            const wide_node<Width>& n = nodes[current.first];
+            float distances[Width];
+            const uint32_t hits = entry_distances(n, terms, query.tmin, query.tmax, distances);
+
+            entry children[Width];
+            uint32_t childCount = 0;
+            uint32_t child = n.firstChild;
+            uint32_t triangle = n.firstTriangle;
+            for (uint32_t slot = 0; slot < Width; ++slot) {
+                const bool interior = (n.interiorMask >> slot) & 1;
+                if ((hits >> slot) & 1) {
+                    // Insertion sort, farthest first so the nearest ends up on top of the stack
+                    const entry candidate = interior ? entry { child, 0, distances[slot] } : entry { triangle, n.triangleCount[slot], distances[slot] };
+                    uint32_t position = childCount++;
+                    while (position > 0 && children[position - 1].distance < candidate.distance) {
+                        children[position] = children[position - 1];
+                        --position;
+                    }
+                    children[position] = candidate;
+                }
+                if (interior) {
+                    ++child;
+                }
+                else {
+                    triangle += n.triangleCount[slot];
+                }
+            }
+            for (uint32_t i = 0; i < childCount; ++i) {
+                stack[top++] = children[i];
+            }
+        }
+        return false;
+    }
+
+    // Calls 'leafFn' for every leaf child whose decoded bounds overlap 'box'
+    template <int Width, typename LeafFn>
+    void traverse(eastl::span<const wide_node<Width>> nodes, const aabb& box, LeafFn leafFn) {
+        if (nodes.empty()) {
+            return;
+        }
+
+        const math::simd::f32x4 boxMin[3] = { math::simd::set1(box.min.x()), math::simd::set1(box.min.y()), math::simd::set1(box.min.z()) };
+        const math::simd::f32x4 boxMax[3] = { math::simd::set1(box.max.x()), math::simd::set1(box.max.y()), math::simd::set1(box.max.z()) };
+
+        uint32_t stack[Width * MAX_DEPTH];
+        uint32_t top = 0;
+        stack[top++] = 0;
+        while (top != 0) {
+            const wide_node<Width>& n = nodes[stack[--top]];
+            uint32_t hits = 0;
+            for (int group = 0; group < Width; group += 4) {
+                math::simd::f32x4 mask = math::simd::cmp_eq(math::simd::zero(), math::simd::zero());
+                for (int axis = 0; axis < 3; ++axis) {
+                    const math::simd::f32x4 lo = decode(math::simd::load_u16(n.lo[axis] + group), n.scale[axis], n.origin[axis]);
+                    const math::simd::f32x4 hi = decode(math::simd::load_u16(n.hi[axis] + group), n.scale[axis], n.origin[axis]);
+                    mask = math::simd::bit_and(mask, math::simd::bit_and(math::simd::cmp_le(lo, boxMax[axis]), math::simd::cmp_ge(hi, boxMin[axis])));
+                }
+                hits |= static_cast<uint32_t>(math::simd::movemask(mask)) << group;
+            }
+            hits &= n.validMask;
+
+            uint32_t child = n.firstChild;
+            uint32_t triangle = n.firstTriangle;
+            for (uint32_t slot = 0; slot < Width; ++slot) {
+                if ((n.interiorMask >> slot) & 1) {
+                    if ((hits >> slot) & 1) {
+                        stack[top++] = child;
+                    }
+                    ++child;
+                }
+                else {
+                    if ((hits >> slot) & 1) {
+                        leafFn(triangle, n.triangleCount[slot]);
+                    }
+                    triangle += n.triangleCount[slot];
+                }
+            }
+        }
+    }
+
+    // Hits are accepted up to the current best distance, so equal distances fall back to the
+    // lower index to keep results independent of the tree layout
+    ELOO_FORCE_INLINE void keep_closest(batch_hit& closest, uint32_t index, const raycast::result& hit) {
+        if (hit.distance < closest.hit.distance || index < closest.index) {
+            closest.index = index;
+            closest.hit = hit;
+        }
+    }
+}
+
+
+/////////////////////////////////////////////////////////////////////
+// Building
+
+template <int Width>
+compressed_mesh<Width>::compressed_mesh(eastl::span<const float3::values> vertices, eastl::span<const uint32_t> indices, const build_settings& settings) {
+    build(vertices, indices, settings);
+}
+
+template <int Width>
+compressed_mesh<Width>::compressed_mesh(eastl::span<const float3::values> vertices, const build_settings& settings) {
+    build(vertices, settings);
+}
+
+template <int Width>
+void compressed_mesh<Width>::build(eastl::span<const float3::values> vertices, eastl::span<const uint32_t> indices, const build_settings& settings) {
+    ELOO_ASSERT_FATAL(indices.size() % 3 == 0, "Triangle index count %zu isn't a multiple of 3", indices.size());
+
+    eastl::vector<aabb> boxes;
+    boxes.reserve(indices.size() / 3);
+    for (size_t i = 0; i < indices.size(); i += 3) {
+        boxes.push_back(to_aabb(vertices[indices[i]], vertices[indices[i + 1]], vertices[indices[i + 2]]));
+    }
+
+    const tree binary(boxes, settings);
+    mVertices.assign(vertices.begin(), vertices.end());
+    collapse(binary, indices);
+}
+
+template <int Width>
+void compressed_mesh<Width>::build(eastl::span<const float3::values> vertices, const build_settings& settings) {
+    ELOO_ASSERT_FATAL(vertices.size() % 3 == 0, "Triangle soup vertex count %zu isn't a multiple of 3", vertices.size());
+
+    eastl::vector<uint32_t> indices(vertices.size());
+    for (size_t i = 0; i < indices.size(); ++i) {
+        indices[i] = static_cast<uint32_t>(i);
+    }
+    build(vertices, indices, settings);
+}
+
+template <int Width>
+void compressed_mesh<Width>::clear() {
+    mNodes.clear();
+    mVertices.clear();
+    mTriangles.clear();
+    mIndices.clear();
+    mBounds = aabb();
+}
+
+template <int Width>
+void compressed_mesh<Width>::collapse(const tree& binary, eastl::span<const uint32_t> indices) {
+    mNodes.clear();
+    mTriangles.clear();
+    mIndices.clear();
+    mBounds = binary.bounds();
+
+    const eastl::span<const bvh::node> binaryNodes = binary.nodes();
+    const eastl::span<const uint32_t> order = binary.indices();
+    if (binaryNodes.empty()) {
+        return;
+    }
+    mTriangles.reserve(order.size() * 3);
+    mIndices.reserve(order.size());
+
+    // Each wide node is made from a binary node, whose box gives the quantization frame
+    struct pending {
+        uint32_t wide;
+        uint32_t binary;
+    };
+    eastl::vector<pending> work;
+    work.push_back({ 0, 0 });
+    mNodes.push_back(node());
+    while (!work.empty()) {
+        const pending current = work.back();
+        work.pop_back();
+        const bvh::node& parent = binaryNodes[current.binary];
+
+        // Open the largest interior child until the slots are full. A leaf root keeps itself as
+        // its only child
+        uint32_t slots[Width];
+        uint32_t slotCount = 0;
+        if (parent.is_leaf()) {
+            slots[slotCount++] = current.binary;
+        }
+        else {
+            slots[slotCount++] = current.binary + 1;
+            slots[slotCount++] = parent.offset;
+        }
+        while (slotCount < Width) {
+            uint32_t largest = EMPTY_SLOT;
+            float largestArea = -1.0f;
+            for (uint32_t slot = 0; slot < slotCount; ++slot) {
+                const bvh::node& n = binaryNodes[slots[slot]];
+                if (!n.is_leaf() && half_area(n) > largestArea) {
+                    largest = slot;
+                    largestArea = half_area(n);
+                }
+            }
+            if (largest == EMPTY_SLOT) {
+                break;
+            }
+            const uint32_t opened = slots[largest];
+            slots[largest] = opened + 1;
+            slots[slotCount++] = binaryNodes[opened].offset;
+        }
+
+        node wide = {};
+        wide.firstChild = static_cast<uint32_t>(mNodes.size());
+        wide.firstTriangle = static_cast<uint32_t>(mIndices.size());
+        for (int axis = 0; axis < 3; ++axis) {
+            wide.origin[axis] = parent.min[axis];
+            wide.scale[axis] = quantize_scale(parent.min[axis], parent.max[axis]);
+        }
+
+        uint32_t interiorCount = 0;
+        for (uint32_t slot = 0; slot < Width; ++slot) {
+            if (slot >= slotCount) {
+                // Empty slots decode to an inverted box and are masked out anyway
+                for (int axis = 0; axis < 3; ++axis) {
+                    wide.lo[axis][slot] = static_cast<uint16_t>(QUANTIZED_MAX);
+                    wide.hi[axis][slot] = 0;
+                }
+                continue;
+            }
+
+            const bvh::node& child = binaryNodes[slots[slot]];
+            for (int axis = 0; axis < 3; ++axis) {
+                wide.lo[axis][slot] = quantize_down(child.min[axis], wide.scale[axis], wide.origin[axis]);
+                wide.hi[axis][slot] = quantize_up(child.max[axis], wide.scale[axis], wide.origin[axis]);
+            }
+            wide.validMask |= static_cast<uint8_t>(1u << slot);
+
+            if (child.is_leaf()) {
+                ELOO_ASSERT_FATAL(child.count <= UINT16_MAX, "Leaf of %u triangles is too large for a compressed node", child.count);
+                wide.triangleCount[slot] = static_cast<uint16_t>(child.count);
+                for (uint32_t i = child.offset; i < child.offset + child.count; ++i) {
+                    const uint32_t triangle = order[i];
+                    mTriangles.push_back(indices[triangle * 3]);
+                    mTriangles.push_back(indices[triangle * 3 + 1]);
+                    mTriangles.push_back(indices[triangle * 3 + 2]);
+                    mIndices.push_back(triangle);
+                }
+            }
+            else {
+                wide.interiorMask |= static_cast<uint8_t>(1u << slot);
+                work.push_back({ wide.firstChild + interiorCount++, slots[slot] });
+            }
+        }
+
+        mNodes.resize(mNodes.size() + interiorCount);
+        mNodes[current.wide] = wide;
+    }
+}
+
+template <int Width>
+aabb compressed_mesh<Width>::bounds() const {
+    return mBounds;
+}
+
+template <int Width>
+size_t compressed_mesh<Width>::memory_bytes() const {
+    return mNodes.size() * sizeof(node) + mVertices.size() * sizeof(float3::values)
+        + mTriangles.size() * sizeof(uint32_t) + mIndices.size() * sizeof(uint32_t);
+}
+
+
+/////////////////////////////////////////////////////////////////////
+// Queries
+
+template <int Width>
+bool compressed_mesh<Width>::raycast(const raycast::ray& query, batch_hit& closest) const {
+    closest = batch_hit();
+
+    raycast::ray local = query;
+    traverse<Width>(mNodes, local, 0.0f, [&](uint32_t first, uint32_t count) {
+        for (uint32_t i = first; i < first + count; ++i) {
+            const uint32_t* tri = &mTriangles[i * 3];
+            raycast::result hit;
+            if (raycast::test_tri(local, mVertices[tri[0]], mVertices[tri[1]], mVertices[tri[2]], hit)) {
+                keep_closest(closest, mIndices[i], hit);
+                local.shrink(hit.distance);
+            }
+        }
+        return false;
+    });
+    return closest.index != batch_hit::INVALID_INDEX;
+}
+
+template <int Width>
+bool compressed_mesh<Width>::occluded(const raycast::ray& query) const {
+    raycast::ray local = query;
+    return traverse<Width>(mNodes, local, 0.0f, [&](uint32_t first, uint32_t count) {
+        for (uint32_t i = first; i < first + count; ++i) {
+            const uint32_t* tri = &mTriangles[i * 3];
+            if (raycast::occluded_tri(local, mVertices[tri[0]], mVertices[tri[1]], mVertices[tri[2]])) {
+                return true;
+            }
+        }
+        return false;
+    });
+}
+
+template <int Width>
+bool compressed_mesh<Width>::spherecast(const spherecast::sweep& query, batch_hit& closest) const {
+    closest = batch_hit();
+
+    spherecast::sweep local = query;
+    traverse<Width>(mNodes, local, query.radius, [&](uint32_t first, uint32_t count) {
+        for (uint32_t i = first; i < first + count; ++i) {
+            const uint32_t* tri = &mTriangles[i * 3];
+            raycast::result hit;
+            if (spherecast::test_tri(local, mVertices[tri[0]], mVertices[tri[1]], mVertices[tri[2]], hit)) {
+                keep_closest(closest, mIndices[i], hit);
+                local.shrink(hit.distance);
+            }
+        }
+        return false;
+    });
+    return closest.index != batch_hit::INVALID_INDEX;
+}
+
+template <int Width>
+size_t compressed_mesh<Width>::overlap(const aabb& box, eastl::vector<uint32_t>& indices) const {
+    const size_t initialSize = indices.size();
+    traverse<Width>(mNodes, box, [&](uint32_t first, uint32_t count) {
+        for (uint32_t i = first; i < first + count; ++i) {
+            const uint32_t* tri = &mTriangles[i * 3];
+            if (overlaps(to_aabb(mVertices[tri[0]], mVertices[tri[1]], mVertices[tri[2]]), box)) {
+                indices.push_back(mIndices[i]);
+            }
+        }
+    });
+    return indices.size() - initialSize;
+}
+
+template class eloo::bvh::compressed_mesh<4>;
+template class eloo::bvh::compressed_mesh<8>;
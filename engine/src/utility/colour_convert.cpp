@@ -0,0 +1,425 @@
+#include "utility/colour_convert.h"
+
+#include "maths/simd.h"
+
+#include <cmath>
+#include <cstring>
+
+using namespace eloo;
+using namespace eloo::math::simd;
+
+namespace {
+    constexpr float INV_255 = 1.0f / 255.0f;
+
+    // Linear to sRGB8 goes through a table bucketed on the top bits of the float representation,
+    // 8 mantissa bits per octave over [2^-13, 1). Buckets are narrow enough to hold at most one
+    // output step, so each entry stores the bucket's base output (high half) and the low bits of
+    // the first input that rounds one higher (low half, 0x8000 when there is none). Everything
+    // below 2^-13 rounds to 0
+    constexpr uint32_t SRGB_MIN_BITS = (127u - 13u) << 23;
+    constexpr uint32_t SRGB_MAX_BITS = 0x3F7FFFFFu;
+    constexpr int SRGB_BUCKET_SHIFT = 15;
+    constexpr uint32_t SRGB_BUCKET_MASK = (1u << SRGB_BUCKET_SHIFT) - 1;
+    constexpr uint32_t SRGB_BUCKET_COUNT = (0x3F800000u - SRGB_MIN_BITS) >> SRGB_BUCKET_SHIFT;
+
+    struct srgb_tables {
+        float toLinear[256];
+        uint32_t toSrgb[SRGB_BUCKET_COUNT];
+    };
+
+    ELOO_FORCE_INLINE float bits_to_float(uint32_t bits) {
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    ELOO_FORCE_INLINE uint32_t float_to_bits(float value) {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+
+    ELOO_FORCE_INLINE float clamp01(float value) {
+        return value > 0.0f ? (value < 1.0f ? value : 1.0f) : 0.0f;
+    }
+
+    // Clamps into the table's range, NaN going to the bottom
+    ELOO_FORCE_INLINE float clamp_srgb_input(float linear) {
+        const float minInput = bits_to_float(SRGB_MIN_BITS);
+        const float maxInput = bits_to_float(SRGB_MAX_BITS);
+        return linear > minInput ? (linear < maxInput ? linear : maxInput) : minInput;
+    }
+
+    ELOO_FORCE_INLINE uint8_t srgb8_reference(float linear) {
+        return static_cast<uint8_t>(colour::linear_to_srgb(clamp_srgb_input(linear)) * 255.0f + 0.5f);
+    }
+
+    const srgb_tables& get_srgb_tables() {
+        static const srgb_tables gTables = [] {
+            srgb_tables tables;
+            for (uint32_t i = 0; i < 256; ++i) {
+                tables.toLinear[i] = colour::srgb_to_linear(static_cast<float>(i) * INV_255);
+            }
+
+            // The reference is monotonic, so binary search each bucket for its step
+            for (uint32_t bucket = 0; bucket < SRGB_BUCKET_COUNT; ++bucket) {
+                const uint32_t first = SRGB_MIN_BITS + (bucket << SRGB_BUCKET_SHIFT);
+                const uint32_t last = first + SRGB_BUCKET_MASK;
+                const uint32_t base = srgb8_reference(bits_to_float(first));
+                uint32_t step = 0x8000u;
+                if (srgb8_reference(bits_to_float(last)) != base) {
+                    ELOO_ASSERT(srgb8_reference(bits_to_float(last)) == base + 1, "sRGB bucket %u spans more than one step", bucket);
+                    uint32_t lo = first;
+                    uint32_t hi = last;
+                    while (lo < hi) {
+                        const uint32_t mid = lo + (hi - lo) / 2;
+                        if (srgb8_reference(bits_to_float(mid)) == base) {
+                            lo = mid + 1;
+                        } else {
+                            hi = mid;
+                        }
+                    }
+                    step = lo & SRGB_BUCKET_MASK;
+                }
+                tables.toSrgb[bucket] = (base << 16) | step;
+            }
+            return tables;
+        }();
+        return gTables;
+    }
+
+    // 'bits' must already be clamped into [SRGB_MIN_BITS, SRGB_MAX_BITS]
+    ELOO_FORCE_INLINE uint32_t srgb8_from_bits(const srgb_tables& tables, uint32_t bits) {
+        const uint32_t entry = tables.toSrgb[(bits - SRGB_MIN_BITS) >> SRGB_BUCKET_SHIFT];
+        return (entry >> 16) + ((bits & SRGB_BUCKET_MASK) >= (entry & 0xFFFFu) ? 1u : 0u);
+    }
+
+    // Hue in [0, 1) from whichever channel holds the maximum, r winning ties over g over b
+    float hue(float r, float g, float b, float maxC, float delta) {
+        if (!(delta > 0.0f)) {
+            return 0.0f;
+        }
+        float h;
+        if (maxC == r) {
+            h = (g - b) / delta;
+        } else if (maxC == g) {
+            h = (b - r) / delta + 2.0f;
+        } else {
+            h = (r - g) / delta + 4.0f;
+        }
+        h *= 1.0f / 6.0f;
+        if (h < 0.0f) {
+            h += 1.0f;
+        }
+        return h;
+    }
+
+
+    /////////////////////////////////////////////////////////////////////
+    // 4-wide kernels
+
+    struct rgba4 {
+        f32x4 r, g, b, a;
+    };
+
+    ELOO_FORCE_INLINE i32x4 load_colours(const colour_t* p, size_t lanes) {
+        if (lanes == WIDTH) {
+            return load_i32(reinterpret_cast<const int32_t*>(p));
+        }
+        int32_t tmp[WIDTH] = {};
+        std::memcpy(tmp, p, lanes * sizeof(colour_t));
+        return load_i32(tmp);
+    }
+
+    ELOO_FORCE_INLINE void store_colours(colour_t* p, size_t lanes, i32x4 colours) {
+        if (lanes == WIDTH) {
+            store_i32(reinterpret_cast<int32_t*>(p), colours);
+            return;
+        }
+        int32_t tmp[WIDTH];
+        store_i32(tmp, colours);
+        std::memcpy(p, tmp, lanes * sizeof(colour_t));
+    }
+
+    ELOO_FORCE_INLINE f32x4 unpack_component(i32x4 colours, uint32_t shift) {
+        return to_f32((colours >> static_cast<int>(shift)) & set1_i32(0xFF)) * set1(INV_255);
+    }
+
+    ELOO_FORCE_INLINE rgba4 unpack(i32x4 colours) {
+        return {
+            unpack_component(colours, colour::R_COMPONENT_SHIFT),
+            unpack_component(colours, colour::G_COMPONENT_SHIFT),
+            unpack_component(colours, colour::B_COMPONENT_SHIFT),
+            unpack_component(colours, colour::A_COMPONENT_SHIFT)
+        };
+    }
+
+    // 'bias' of 0.5 rounds to nearest, 0 truncates
+    ELOO_FORCE_INLINE i32x4 pack_component(f32x4 value, uint32_t shift, f32x4 bias) {
+        const f32x4 clamped = min(max(value, zero()), set1(1.0f));
+        return to_i32(clamped * set1(255.0f) + bias) << static_cast<int>(shift);
+    }
+
+    ELOO_FORCE_INLINE i32x4 pack(const rgba4& c, float bias) {
+        const f32x4 biasV = set1(bias);
+        return pack_component(c.r, colour::R_COMPONENT_SHIFT, biasV) |
+            pack_component(c.g, colour::G_COMPONENT_SHIFT, biasV) |
+            pack_component(c.b, colour::B_COMPONENT_SHIFT, biasV) |
+            pack_component(c.a, colour::A_COMPONENT_SHIFT, biasV);
+    }
+
+    ELOO_FORCE_INLINE rgba4 load_float4(const float4::values* p, size_t lanes) {
+        f32x4 rows[WIDTH];
+        for (size_t i = 0; i < WIDTH; ++i) {
+            rows[i] = i < lanes ? load(&p[i].x()) : zero();
+        }
+        transpose(rows[0], rows[1], rows[2], rows[3]);
+        return { rows[0], rows[1], rows[2], rows[3] };
+    }
+
+    ELOO_FORCE_INLINE void store_float4(float4::values* p, size_t lanes, rgba4 c) {
+        transpose(c.r, c.g, c.b, c.a);
+        const f32x4 rows[WIDTH] = { c.r, c.g, c.b, c.a };
+        for (size_t i = 0; i < lanes; ++i) {
+            store(&p[i].x(), rows[i]);
+        }
+    }
+
+    ELOO_FORCE_INLINE f32x4 hue(const rgba4& c, f32x4 maxC, f32x4 delta) {
+        const f32x4 fromR = (c.g - c.b) / delta;
+        const f32x4 fromG = (c.b - c.r) / delta + set1(2.0f);
+        const f32x4 fromB = (c.r - c.g) / delta + set1(4.0f);
+        f32x4 h = select(cmp_eq(maxC, c.r), fromR, select(cmp_eq(maxC, c.g), fromG, fromB)) * set1(1.0f / 6.0f);
+        h = h + bit_and(cmp_lt(h, zero()), set1(1.0f));
+        return bit_and(cmp_gt(delta, zero()), h);
+    }
+
+    ELOO_FORCE_INLINE rgba4 rgb_to_hsv(const rgba4& c) {
+        const f32x4 maxC = max(c.r, max(c.g, c.b));
+        const f32x4 delta = maxC - min(c.r, min(c.g, c.b));
+        const f32x4 s = bit_and(cmp_gt(maxC, zero()), delta / maxC);
+        return { hue(c, maxC, delta), s, maxC, c.a };
+    }
+
+    ELOO_FORCE_INLINE rgba4 rgb_to_hsl(const rgba4& c) {
+        const f32x4 maxC = max(c.r, max(c.g, c.b));
+        const f32x4 minC = min(c.r, min(c.g, c.b));
+        const f32x4 delta = maxC - minC;
+        const f32x4 l = (maxC + minC) * set1(0.5f);
+        const f32x4 s = select(cmp_gt(l, set1(0.5f)), delta / (set1(2.0f) - maxC - minC), delta / (maxC + minC));
+        return { hue(c, maxC, delta), bit_and(cmp_gt(delta, zero()), s), l, c.a };
+    }
+
+    // Mirrors make_hsva's sector switch
+    ELOO_FORCE_INLINE rgba4 hsv_to_rgb(const rgba4& hsv) {
+        const f32x4 h = hsv.r;
+        const f32x4 s = hsv.g;
+        const f32x4 v = hsv.b;
+        const f32x4 one = set1(1.0f);
+
+        const f32x4 h6 = h * set1(6.0f);
+        const i32x4 sector = to_i32(h6);
+        const f32x4 f = h6 - to_f32(sector);
+        const f32x4 p = v * (one - s);
+        const f32x4 q = v * (one - f * s);
+        const f32x4 t = v * (one - (one - f) * s);
+
+        const f32x4 s0 = as_f32(cmp_eq(sector, set1_i32(0)) | cmp_eq(sector, set1_i32(6)));
+        const f32x4 s1 = as_f32(cmp_eq(sector, set1_i32(1)));
+        const f32x4 s2 = as_f32(cmp_eq(sector, set1_i32(2)));
+        const f32x4 s3 = as_f32(cmp_eq(sector, set1_i32(3)));
+        const f32x4 s4 = as_f32(cmp_eq(sector, set1_i32(4)));
+
+        return {
+            select(s0, v, select(s1, q, select(s2, p, select(s3, p, select(s4, t, v))))),
+            select(s0, t, select(s1, v, select(s2, v, select(s3, q, select(s4, p, p))))),
+            select(s0, p, select(s1, p, select(s2, t, select(s3, v, select(s4, v, q))))),
+            hsv.a
+        };
+    }
+
+    ELOO_FORCE_INLINE f32x4 hue_to_rgb(f32x4 p, f32x4 q, f32x4 t) {
+        const f32x4 one = set1(1.0f);
+        t = t + bit_and(cmp_lt(t, zero()), one);
+        t = t - bit_and(cmp_gt(t, one), one);
+        const f32x4 rising = p + (q - p) * set1(6.0f) * t;
+        const f32x4 falling = p + (q - p) * (set1(2.0f / 3.0f) - t) * set1(6.0f);
+        return select(cmp_lt(t, set1(1.0f / 6.0f)), rising,
+            select(cmp_lt(t, set1(1.0f / 2.0f)), q,
+            select(cmp_lt(t, set1(2.0f / 3.0f)), falling, p)));
+    }
+
+    // Mirrors make_hsla
+    ELOO_FORCE_INLINE rgba4 hsl_to_rgb(const rgba4& hsl) {
+        const f32x4 h = hsl.r;
+        const f32x4 s = hsl.g;
+        const f32x4 l = hsl.b;
+
+        const f32x4 q = select(cmp_lt(l, set1(0.5f)), l * (set1(1.0f) + s), l + s - l * s);
+        const f32x4 p = set1(2.0f) * l - q;
+        const f32x4 achromatic = cmp_eq(s, zero());
+        return {
+            select(achromatic, l, hue_to_rgb(p, q, h + set1(1.0f / 3.0f))),
+            select(achromatic, l, hue_to_rgb(p, q, h)),
+            select(achromatic, l, hue_to_rgb(p, q, h - set1(1.0f / 3.0f))),
+            hsl.a
+        };
+    }
+
+    template <typename BlockFn>
+    void for_each_block(size_t count, BlockFn blockFn) {
+        for (size_t i = 0; i < count; i += WIDTH) {
+            blockFn(i, count - i < WIDTH ? count - i : WIDTH);
+        }
+    }
+
+    template <typename ConvertFn>
+    void colours_to_float4(eastl::span<const colour_t> in, eastl::span<float4::values> out, ConvertFn convertFn) {
+        ELOO_ASSERT_FATAL(in.size() == out.size(), "Colour conversion spans differ in length (%zu vs %zu)", in.size(), out.size());
+        for_each_block(in.size(), [&](size_t i, size_t lanes) {
+            store_float4(out.data() + i, lanes, convertFn(unpack(load_colours(in.data() + i, lanes))));
+        });
+    }
+
+    template <typename ConvertFn>
+    void float4_to_colours(eastl::span<const float4::values> in, eastl::span<colour_t> out, float bias, ConvertFn convertFn) {
+        ELOO_ASSERT_FATAL(in.size() == out.size(), "Colour conversion spans differ in length (%zu vs %zu)", in.size(), out.size());
+        for_each_block(in.size(), [&](size_t i, size_t lanes) {
+            store_colours(out.data() + i, lanes, pack(convertFn(load_float4(in.data() + i, lanes)), bias));
+        });
+    }
+}
+
+
+/////////////////////////////////////////////////////////////////////
+// Scalar references
+
+float colour::srgb_to_linear(float srgb) {
+    return srgb <= 0.04045f ? srgb * (1.0f / 12.92f) : std::pow((srgb + 0.055f) * (1.0f / 1.055f), 2.4f);
+}
+
+float colour::linear_to_srgb(float linear) {
+    return linear <= 0.0031308f ? linear * 12.92f : 1.055f * std::pow(linear, 1.0f / 2.4f) - 0.055f;
+}
+
+float4::values colour::to_float4(colour_t colour) {
+    return { get_r(colour) * INV_255, get_g(colour) * INV_255, get_b(colour) * INV_255, get_a(colour) * INV_255 };
+}
+
+colour_t colour::from_float4(const float4::values& rgba) {
+    return make_rgba(
+        static_cast<uint8_t>(clamp01(rgba.x()) * 255.0f + 0.5f),
+        static_cast<uint8_t>(clamp01(rgba.y()) * 255.0f + 0.5f),
+        static_cast<uint8_t>(clamp01(rgba.z()) * 255.0f + 0.5f),
+        static_cast<uint8_t>(clamp01(rgba.w()) * 255.0f + 0.5f));
+}
+
+float4::values colour::to_linear(colour_t colour) {
+    return {
+        srgb_to_linear(get_r(colour) * INV_255),
+        srgb_to_linear(get_g(colour) * INV_255),
+        srgb_to_linear(get_b(colour) * INV_255),
+        get_a(colour) * INV_255
+    };
+}
+
+colour_t colour::from_linear(const float4::values& rgba) {
+    return make_rgba(
+        srgb8_reference(rgba.x()),
+        srgb8_reference(rgba.y()),
+        srgb8_reference(rgba.z()),
+        static_cast<uint8_t>(clamp01(rgba.w()) * 255.0f + 0.5f));
+}
+
+float4::values colour::to_hsva(colour_t colour) {
+    const float r = get_r(colour) * INV_255;
+    const float g = get_g(colour) * INV_255;
+    const float b = get_b(colour) * INV_255;
+    const float maxC = math::max(r, math::max(g, b));
+    const float delta = maxC - math::min(r, math::min(g, b));
+    const float s = maxC > 0.0f ? delta / maxC : 0.0f;
+    return { hue(r, g, b, maxC, delta), s, maxC, get_a(colour) * INV_255 };
+}
+
+float4::values colour::to_hsla(colour_t colour) {
+    const float r = get_r(colour) * INV_255;
+    const float g = get_g(colour) * INV_255;
+    const float b = get_b(colour) * INV_255;
+    const float maxC = math::max(r, math::max(g, b));
+    const float minC = math::min(r, math::min(g, b));
+    const float delta = maxC - minC;
+    const float l = (maxC + minC) * 0.5f;
+    float s = 0.0f;
+    if (delta > 0.0f) {
+        s = l > 0.5f ? delta / (2.0f - maxC - minC) : delta / (maxC + minC);
+    }
+    return { hue(r, g, b, maxC, delta), s, l, get_a(colour) * INV_255 };
+}
+
+
+/////////////////////////////////////////////////////////////////////
+// Span kernels
+
+void colour::to_float4(eastl::span<const colour_t> in, eastl::span<float4::values> out) {
+    colours_to_float4(in, out, [](const rgba4& c) { return c; });
+}
+
+void colour::from_float4(eastl::span<const float4::values> in, eastl::span<colour_t> out) {
+    float4_to_colours(in, out, 0.5f, [](const rgba4& c) { return c; });
+}
+
+void colour::to_linear(eastl::span<const colour_t> in, eastl::span<float4::values> out) {
+    ELOO_ASSERT_FATAL(in.size() == out.size(), "Colour conversion spans differ in length (%zu vs %zu)", in.size(), out.size());
+
+    // A straight table lookup per channel, there's nothing left for SIMD to win
+    const float* toLinear = get_srgb_tables().toLinear;
+    for (size_t i = 0; i < in.size(); ++i) {
+        const colour_t c = in[i];
+        out[i] = { toLinear[get_r(c)], toLinear[get_g(c)], toLinear[get_b(c)], get_a(c) * INV_255 };
+    }
+}
+
+void colour::from_linear(eastl::span<const float4::values> in, eastl::span<colour_t> out) {
+    ELOO_ASSERT_FATAL(in.size() == out.size(), "Colour conversion spans differ in length (%zu vs %zu)", in.size(), out.size());
+
+    const srgb_tables& tables = get_srgb_tables();
+    const f32x4 minInput = set1(bits_to_float(SRGB_MIN_BITS));
+    const f32x4 maxInput = set1(bits_to_float(SRGB_MAX_BITS));
+    const f32x4 half = set1(0.5f);
+    for_each_block(in.size(), [&](size_t i, size_t lanes) {
+        const rgba4 c = load_float4(in.data() + i, lanes);
+
+        // Clamp and extract the bits 4-wide, then finish each channel with a table lookup. max()
+        // takes the second operand for NaN, so NaN inputs clamp to the bottom like the reference
+        int32_t bits[3][WIDTH];
+        store_i32(bits[0], as_i32(min(max(c.r, minInput), maxInput)));
+        store_i32(bits[1], as_i32(min(max(c.g, minInput), maxInput)));
+        store_i32(bits[2], as_i32(min(max(c.b, minInput), maxInput)));
+        int32_t alpha[WIDTH];
+        store_i32(alpha, to_i32(min(max(c.a, zero()), set1(1.0f)) * set1(255.0f) + half));
+
+        for (size_t lane = 0; lane < lanes; ++lane) {
+            out[i + lane] = make_rgba(
+                static_cast<uint8_t>(srgb8_from_bits(tables, static_cast<uint32_t>(bits[0][lane]))),
+                static_cast<uint8_t>(srgb8_from_bits(tables, static_cast<uint32_t>(bits[1][lane]))),
+                static_cast<uint8_t>(srgb8_from_bits(tables, static_cast<uint32_t>(bits[2][lane]))),
+                static_cast<uint8_t>(alpha[lane]));
+        }
+    });
+}
+
+void colour::to_hsva(eastl::span<const colour_t> in, eastl::span<float4::values> out) {
+    colours_to_float4(in, out, rgb_to_hsv);
+}
+
+void colour::from_hsva(eastl::span<const float4::values> in, eastl::span<colour_t> out) {
+    float4_to_colours(in, out, 0.0f, hsv_to_rgb);
+}
+
+void colour::to_hsla(eastl::span<const colour_t> in, eastl::span<float4::values> out) {
+    colours_to_float4(in, out, rgb_to_hsl);
+}
+
+void colour::from_hsla(eastl::span<const float4::values> in, eastl::span<colour_t> out) {
+    float4_to_colours(in, out, 0.0f, hsl_to_rgb);
+}
@@ -0,0 +1,660 @@
+#include "utility/dynamic_tree.h"
+
+#include "maths/math.h"
+#include "utility/parallel.h"
+
+using namespace eloo;
+using namespace eloo::bvh;
+
+namespace {
+    constexpr uint32_t NONE = dynamic_tree::INVALID_PROXY;
+
+    // Entry distance reported for nodes the ray misses
+    constexpr float MISS = FLT_MAX;
+
+    // Batch queries are handed to the workers in runs of this many
+    constexpr size_t QUERY_GRAIN = 64;
+
+    // The pool starts with this many nodes and doubles from there
+    constexpr size_t INITIAL_POOL = 16;
+
+    // A fat box that has grown beyond the object's by more than this many margins, as happens
+    // when something fast comes to rest, is shrunk on its next move
+    constexpr float HUGE_MARGINS = 4.0f;
+
+    struct box3 {
+        float min[3];
+        float max[3];
+    };
+
+    // Half the surface area, as only ratios and differences are compared
+    template <typename Box>
+    ELOO_FORCE_INLINE float half_area(const Box& box) {
+        const float x = box.max[0] - box.min[0];
+        const float y = box.max[1] - box.min[1];
+        const float z = box.max[2] - box.min[2];
+        return x * y + y * z + z * x;
+    }
+
+    template <typename BoxA, typename BoxB>
+    ELOO_FORCE_INLINE box3 combine(const BoxA& a, const BoxB& b) {
+        box3 box;
+        for (int axis = 0; axis < 3; ++axis) {
+            box.min[axis] = math::min(a.min[axis], b.min[axis]);
+            box.max[axis] = math::max(a.max[axis], b.max[axis]);
+        }
+        return box;
+    }
+
+    template <typename BoxA, typename BoxB>
+    ELOO_FORCE_INLINE bool contains(const BoxA& outer, const BoxB& inner) {
+        return outer.min[0] <= inner.min[0] && outer.min[1] <= inner.min[1] && outer.min[2] <= inner.min[2]
+            && outer.max[0] >= inner.max[0] && outer.max[1] >= inner.max[1] && outer.max[2] >= inner.max[2];
+    }
+
+    template <typename Box>
+    box3 to_box(const Box& box) {
+        return { { box.min[0], box.min[1], box.min[2] }, { box.max[0], box.max[1], box.max[2] } };
+    }
+
+    box3 to_box(const aabb& box) {
+        return { { box.min.x(), box.min.y(), box.min.z() }, { box.max.x(), box.max.y(), box.max.z() } };
+    }
+
+    template <typename Box>
+    aabb to_aabb(const Box& box) {
+        return { { box.min[0], box.min[1], box.min[2] }, { box.max[0], box.max[1], box.max[2] } };
+    }
+
+    // Ray terms unpacked for the slab tests. Sweeps inflate every node by their radius
+    struct node_query {
+        float origin[3];
+        float invDirection[3];
+        uint32_t sign[3];
+        float inflate;
+
+        node_query(const raycast::ray& query, float inflateBy)
+            : origin { query.origin.x(), query.origin.y(), query.origin.z() }
+            , invDirection { query.invDirection.x(), query.invDirection.y(), query.invDirection.z() }
+            , sign { query.sign[0], query.sign[1], query.sign[2] }
+            , inflate(inflateBy) {
+        }
+    };
+
+    // Distance at which the ray enters the box within [tmin, tmax], or MISS. A slab the ray runs
+    // along produces NaNs, which the argument order below drops rather than spreads
+    template <typename Box>
+    ELOO_FORCE_INLINE float entry_distance(const Box& box, const node_query& query, float tmin, float tmax) {
+        float tNear = tmin;
+        float tFar = tmax;
+        for (int axis = 0; axis < 3; ++axis) {
+            const float lo = box.min[axis] - query.inflate;
+            const float hi = box.max[axis] + query.inflate;
+            const float t0 = ((query.sign[axis] ? hi : lo) - query.origin[axis]) * query.invDirection[axis];
+            const float t1 = ((query.sign[axis] ? lo : hi) - query.origin[axis]) * query.invDirection[axis];
+            tNear = math::max(t0, tNear);
+            tFar = math::min(t1, tFar);
+        }
+        return tNear <= tFar ? tNear : MISS;
+    }
+
+    // Hits are accepted up to the current best distance, so equal distances fall back to the
+    // lower user data to keep results independent of the tree's shape
+    ELOO_FORCE_INLINE void keep_closest(batch_hit& closest, uint32_t userData, const raycast::result& hit) {
+        if (hit.distance < closest.hit.distance || userData < closest.index) {
+            closest.index = userData;
+            closest.hit = hit;
+        }
+    }
+}
+
+
+/////////////////////////////////////////////////////////////////////
+// Pool
+
+dynamic_tree::dynamic_tree(float margin)
+    : mMargin(margin) {
+    ELOO_ASSERT_FATAL(margin >= 0.0f, "Dynamic tree margins can't be negative, got %f", margin);
+}
+
+void dynamic_tree::reserve(size_t proxies) {
+    // n leaves take 2n - 1 nodes
+    if (proxies * 2 > mNodes.size()) {
+        grow_pool(proxies * 2);
+    }
+}
+
+void dynamic_tree::clear() {
+    mNodes.clear();
+    mRoot = NONE;
+    mFreeList = NONE;
+    mRebalanceCursor = 0;
+    mProxyCount = 0;
+}
+
+void dynamic_tree::grow_pool(size_t capacity) {
+    const uint32_t first = static_cast<uint32_t>(mNodes.size());
+    const uint32_t last = static_cast<uint32_t>(capacity);
+    mNodes.resize(capacity);
+    for (uint32_t i = first; i < last; ++i) {
+        mNodes[i].parent = i + 1 < last ? i + 1 : mFreeList;
+        mNodes[i].height = -1;
+    }
+    mFreeList = first;
+}
+
+uint32_t dynamic_tree::allocate_node() {
+    if (mFreeList == NONE) {
+        grow_pool(mNodes.empty() ? INITIAL_POOL : mNodes.size() * 2);
+    }
+
+    const uint32_t index = mFreeList;
+    node& n = mNodes[index];
+    mFreeList = n.parent;
+    n.parent = NONE;
+    n.child1 = NONE;
+    n.child2 = NONE;
+    n.height = 0;
+    n.userData = 0;
+    return index;
+}
+
+void dynamic_tree::free_node(uint32_t index) {
+    node& n = mNodes[index];
+    n.parent = mFreeList;
+    n.height = -1;
+    mFreeList = index;
+}
+
+
+/////////////////////////////////////////////////////////////////////
+// Proxies
+
+uint32_t dynamic_tree::insert(const aabb& box, uint32_t userData) {
+    const uint32_t leaf = allocate_node();
+    node& n = mNodes[leaf];
+    set_fat_box(n, box, float3::ZERO);
+    n.userData = userData;
+    insert_leaf(leaf);
+    ++mProxyCount;
+    return leaf;
+}
+
+void dynamic_tree::remove(uint32_t proxy) {
+    ELOO_ASSERT_FATAL(proxy < mNodes.size() && mNodes[proxy].height == 0, "%u is not a live dynamic tree proxy", proxy);
+
+    remove_leaf(proxy);
+    free_node(proxy);
+    --mProxyCount;
+}
+
+bool dynamic_tree::move(uint32_t proxy, const aabb& box, const float3::values& displacement) {
+    ELOO_ASSERT_FATAL(proxy < mNodes.size() && mNodes[proxy].height == 0, "%u is not a live dynamic tree proxy", proxy);
+
+    node& n = mNodes[proxy];
+    node fat = n;
+    set_fat_box(fat, box, displacement);
+    if (contains(n, to_box(box))) {
+        box3 huge;
+        for (int axis = 0; axis < 3; ++axis) {
+            huge.min[axis] = fat.min[axis] - HUGE_MARGINS * mMargin;
+            huge.max[axis] = fat.max[axis] + HUGE_MARGINS * mMargin;
+        }
+        if (contains(huge, n)) {
+            return false;
+        }
+    }
+
+    remove_leaf(proxy);
+    set_fat_box(mNodes[proxy], box, displacement);
+    insert_leaf(proxy);
+    return true;
+}
+
+void dynamic_tree::refit(uint32_t proxy, const aabb& box) {
+    ELOO_ASSERT_FATAL(proxy < mNodes.size() && mNodes[proxy].height == 0, "%u is not a live dynamic tree proxy", proxy);
+
+    set_fat_box(mNodes[proxy], box, float3::ZERO);
+    refit_upwards(mNodes[proxy].parent, false);
+}
+
+void dynamic_tree::rebalance(uint32_t budget) {
+    for (uint32_t i = 0; i < budget && !mNodes.empty(); ++i) {
+        if (mRebalanceCursor >= mNodes.size()) {
+            mRebalanceCursor = 0;
+        }
+        if (mNodes[mRebalanceCursor].height >= 2) {
+            try_rotate(mRebalanceCursor);
+        }
+        ++mRebalanceCursor;
+    }
+}
+
+uint32_t dynamic_tree::height() const {
+    return mRoot == NONE ? 0 : static_cast<uint32_t>(mNodes[mRoot].height);
+}
+
+uint32_t dynamic_tree::user_data(uint32_t proxy) const {
+    ELOO_ASSERT_FATAL(proxy < mNodes.size() && mNodes[proxy].height == 0, "%u is not a live dynamic tree proxy", proxy);
+    return mNodes[proxy].userData;
+}
+
+aabb dynamic_tree::fat_bounds(uint32_t proxy) const {
+    ELOO_ASSERT_FATAL(proxy < mNodes.size() && mNodes[proxy].height == 0, "%u is not a live dynamic tree proxy", proxy);
+    return to_aabb(mNodes[proxy]);
+}
+
+aabb dynamic_tree::bounds() const {
+    return mRoot == NONE ? aabb() : to_aabb(mNodes[mRoot]);
+}
+
+// The margin pads every side, and the displacement stretches the side the proxy is heading for
+void dynamic_tree::set_fat_box(node& n, const aabb& box, const float3::values& displacement) const {
+    const box3 tight = to_box(box);
+    const float move[3] = { displacement.x(), displacement.y(), displacement.z() };
+    for (int axis = 0; axis < 3; ++axis) {
+        n.min[axis] = tight.min[axis] - mMargin + (move[axis] < 0.0f ? move[axis] : 0.0f);
+        n.max[axis] = tight.max[axis] + mMargin + (move[axis] > 0.0f ? move[axis] : 0.0f);
+    }
+}
+
+
+/////////////////////////////////////////////////////////////////////
+// Structure
+
+void dynamic_tree::insert_leaf(uint32_t leaf) {
+    if (mRoot == NONE) {
+        mRoot = leaf;
+        mNodes[leaf].parent = NONE;
+        return;
+    }
+
+    // Walk down towards the sibling that adds the least area. Every node on the way grows to
+    // take the leaf in, so that growth is carried down as the inheritance cost
+    const box3 leafBox = to_box(mNodes[leaf]);
+    uint32_t index = mRoot;
+    while (!mNodes[index].is_leaf()) {
+        const node& n = mNodes[index];
+        const float area = half_area(n);
+        const float combinedArea = half_area(combine(n, leafBox));
+        const float cost = 2.0f * combinedArea;
+        const float inheritanceCost = 2.0f * (combinedArea - area);
+
+        const auto descendCost = [&](uint32_t child) {
+            const node& c = mNodes[child];
+            const float grownArea = half_area(combine(c, leafBox));
+            return (c.is_leaf() ? grownArea : grownArea - half_area(c)) + inheritanceCost;
+        };
+        const float cost1 = descendCost(n.child1);
+        const float cost2 = descendCost(n.child2);
+        if (cost < cost1 && cost < cost2) {
+            break;
+        }
+        index = cost1 < cost2 ? n.child1 : n.child2;
+    }
+
+    const uint32_t sibling = index;
+    const uint32_t oldParent = mNodes[sibling].parent;
+    const uint32_t newParent = allocate_node();
+    node& parent = mNodes[newParent];
+    const box3 parentBox = combine(mNodes[sibling], leafBox);
+    for (int axis = 0; axis < 3; ++axis) {
+        parent.min[axis] = parentBox.min[axis];
+        parent.max[axis] = parentBox.max[axis];
+    }
+    parent.parent = oldParent;
+    parent.child1 = sibling;
+    parent.child2 = leaf;
+    parent.height = mNodes[sibling].height + 1;
+    mNodes[sibling].parent = newParent;
+    mNodes[leaf].parent = newParent;
+    replace_child(oldParent, sibling, newParent);
+
+    refit_upwards(mNodes[leaf].parent, true);
+}
+
+void dynamic_tree::remove_leaf(uint32_t leaf) {
+    if (leaf == mRoot) {
+        mRoot = NONE;
+        return;
+    }
+
+    const uint32_t parent = mNodes[leaf].parent;
+    const uint32_t grandParent = mNodes[parent].parent;
+    const uint32_t sibling = mNodes[parent].child1 == leaf ? mNodes[parent].child2 : mNodes[parent].child1;
+
+    replace_child(grandParent, parent, sibling);
+    mNodes[sibling].parent = grandParent;
+    free_node(parent);
+    refit_upwards(grandParent, true);
+}
+
+void dynamic_tree::replace_child(uint32_t parent, uint32_t oldChild, uint32_t newChild) {
+    if (parent == NONE) {
+        mRoot = newChild;
+    }
+    else if (mNodes[parent].child1 == oldChild) {
+        mNodes[parent].child1 = newChild;
+    }
+    else {
+        mNodes[parent].child2 = newChild;
+    }
+}
+
+void dynamic_tree::refit_upwards(uint32_t index, bool balanceNodes) {
+    while (index != NONE) {
+        if (balanceNodes) {
+            index = balance(index);
+        }
+
+        node& n = mNodes[index];
+        const node& child1 = mNodes[n.child1];
+        const node& child2 = mNodes[n.child2];
+        const box3 box = combine(child1, child2);
+        for (int axis = 0; axis < 3; ++axis) {
+            n.min[axis] = box.min[axis];
+            n.max[axis] = box.max[axis];
+        }
+        n.height = 1 + math::max(child1.height, child2.height);
+        index = n.parent;
+    }
+}
+
+// Rotates the taller child up when the children's heights differ by more than one, returning
+// the node now in this one's place
+uint32_t dynamic_tree::balance(uint32_t indexA) {
+    node& a = mNodes[indexA];
+    if (a.is_leaf() || a.height < 2) {
+        return indexA;
+    }
+
+    const uint32_t indexB = a.child1;
+    const uint32_t indexC = a.child2;
+    node& b = mNodes[indexB];
+    node& c = mNodes[indexC];
+    const int32_t balanceFactor = c.height - b.height;
+    if (balanceFactor >= -1 && balanceFactor <= 1) {
+        return indexA;
+    }
+
+    // The taller child takes A's place, A adopting the shorter grandchild in exchange
+    const bool raiseC = balanceFactor > 1;
+    const uint32_t indexUp = raiseC ? indexC : indexB;
+    const uint32_t indexStay = raiseC ? indexB : indexC;
+    node& up = raiseC ? c : b;
+    const uint32_t indexF = up.child1;
+    const uint32_t indexG = up.child2;
+    node& f = mNodes[indexF];
+    node& g = mNodes[indexG];
+
+    up.child1 = indexA;
+    up.parent = a.parent;
+    a.parent = indexUp;
+    replace_child(up.parent, indexA, indexUp);
+
+    const bool keepF = f.height > g.height;
+    const uint32_t indexKeep = keepF ? indexF : indexG;
+    const uint32_t indexGive = keepF ? indexG : indexF;
+    node& keep = keepF ? f : g;
+    node& give = keepF ? g : f;
+    up.child2 = indexKeep;
+    if (raiseC) {
+        a.child2 = indexGive;
+    }
+    else {
+        a.child1 = indexGive;
+    }
+    give.parent = indexA;
+
+    const node& stay = mNodes[indexStay];
+    const box3 boxA = combine(stay, give);
+    for (int axis = 0; axis < 3; ++axis) {
+        a.min[axis] = boxA.min[axis];
+        a.max[axis] = boxA.max[axis];
+    }
+    a.height = 1 + math::max(stay.height, give.height);
+
+    const box3 boxUp = combine(a, keep);
+    for (int axis = 0; axis < 3; ++axis) {
+        up.min[axis] = boxUp.min[axis];
+        up.max[axis] = boxUp.max[axis];
+    }
+    up.height = 1 + math::max(a.height, keep.height);
+    return indexUp;
+}
+
+// Swaps a child with one of its sibling's children when that shrinks the sibling and both
+// levels stay height balanced. The node's own box is unchanged, only heights above may move
+bool dynamic_tree::try_rotate(uint32_t index) {
+    const node& n = mNodes[index];
+    const uint32_t children[2] = { n.child1, n.child2 };
+
+    float bestGain = 0.0f;
+    uint32_t bestUncle = NONE;
+    uint32_t bestGrandchild = NONE;
+    for (int side = 0; side < 2; ++side) {
+        const uint32_t uncle = children[side];
+        const node& p = mNodes[children[1 - side]];
+        if (p.is_leaf()) {
+            continue;
+        }
+
+        const int32_t uncleHeight = mNodes[uncle].height;
+        const float parentArea = half_area(p);
+        const uint32_t grandchildren[2] = { p.child1, p.child2 };
+        for (int pick = 0; pick < 2; ++pick) {
+            const node& grandchild = mNodes[grandchildren[pick]];
+            const node& kept = mNodes[grandchildren[1 - pick]];
+            const int32_t keptHeight = 1 + math::max(uncleHeight, kept.height);
+            if (math::abs(uncleHeight - kept.height) > 1 || math::abs(grandchild.height - keptHeight) > 1) {
+                continue;
+            }
+
+            const float gain = parentArea - half_area(combine(mNodes[uncle], kept));
+            if (gain > bestGain) {
+                bestGain = gain;
+                bestUncle = uncle;
+                bestGrandchild = grandchildren[pick];
+            }
+        }
+    }
+    if (bestUncle == NONE) {
+        return false;
+    }
+
+    const uint32_t parent = mNodes[bestGrandchild].parent;
+    replace_child(parent, bestGrandchild, bestUncle);
+    mNodes[bestUncle].parent = parent;
+    replace_child(index, bestUncle, bestGrandchild);
+    mNodes[bestGrandchild].parent = index;
+    refit_upwards(parent, false);
+    return true;
+}
+
+
+/////////////////////////////////////////////////////////////////////
+// Queries
+
+template <typename Query, typename Test>
+bool dynamic_tree::closest_hit(Query& query, float inflate, const Test& test, batch_hit& closest) const {
+    closest = batch_hit();
+    if (mRoot == NONE) {
+        return false;
+    }
+
+    const node_query terms(query, inflate);
+    if (entry_distance(mNodes[mRoot], terms, query.tmin, query.tmax) == MISS) {
+        return false;
+    }
+    ELOO_ASSERT_FATAL(mNodes[mRoot].height < static_cast<int32_t>(MAX_HEIGHT), "Dynamic tree height %d is past the query limit", mNodes[mRoot].height);
+
+    struct entry {
+        uint32_t index;
+        float distance;
+    };
+    entry stack[MAX_HEIGHT];
+    uint32_t top = 0;
+    uint32_t index = mRoot;
+    for (;;) {
+        const node& n = mNodes[index];
+        if (n.is_leaf()) {
+            raycast::result hit;
+            if (test(n.userData, query, hit)) {
+                keep_closest(closest, n.userData, hit);
+                query.shrink(hit.distance);
+            }
+        }
+        else {
+            uint32_t nearIndex = n.child1;
+            uint32_t farIndex = n.child2;
+            float nearDistance = entry_distance(mNodes[nearIndex], terms, query.tmin, query.tmax);
+            float farDistance = entry_distance(mNodes[farIndex], terms, query.tmin, query.tmax);
+            if (farDistance < nearDistance) {
+                eastl::swap(nearIndex, farIndex);
+                eastl::swap(nearDistance, farDistance);
+            }
+            if (nearDistance != MISS) {
+                if (farDistance != MISS) {
+                    stack[top++] = { farIndex, farDistance };
+                }
+                index = nearIndex;
+                continue;
+            }
+        }
+
+        entry next;
+        do {
+            if (top == 0) {
+                return closest.index != batch_hit::INVALID_INDEX;
+            }
+            next = stack[--top];
+        } while (next.distance > query.tmax);
+        index = next.index;
+    }
+}
+
+bool dynamic_tree::raycast(const raycast::ray& query, const ray_test& test, batch_hit& closest) const {
+    raycast::ray local = query;
+    return closest_hit(local, 0.0f, test, closest);
+}
+
+// Any hit will do, so children are walked in tree order without working out which is nearer
+bool dynamic_tree::occluded(const raycast::ray& query, const ray_test& test) const {
+    if (mRoot == NONE) {
+        return false;
+    }
+    ELOO_ASSERT_FATAL(mNodes[mRoot].height < static_cast<int32_t>(MAX_HEIGHT), "Dynamic tree height %d is past the query limit", mNodes[mRoot].height);
+
+    const node_query terms(query, 0.0f);
+    uint32_t stack[MAX_HEIGHT];
+    uint32_t top = 0;
+    stack[top++] = mRoot;
+    while (top > 0) {
+        const node& n = mNodes[stack[--top]];
+        if (entry_distance(n, terms, query.tmin, query.tmax) == MISS) {
+            continue;
+        }
+        if (n.is_leaf()) {
+            raycast::result hit;
+            if (test(n.userData, query, hit)) {
+                return true;
+            }
+        }
+        else {
+            stack[top++] = n.child2;
+            stack[top++] = n.child1;
+        }
+    }
+    return false;
+}
+
+bool dynamic_tree::spherecast(const spherecast::sweep& query, const sweep_test& test, batch_hit& closest) const {
+    spherecast::sweep local = query;
+    return closest_hit(local, query.radius, test, closest);
+}
+
+size_t dynamic_tree::overlap(const aabb& box, eastl::vector<uint32_t>& userData) const {
+    const size_t initialSize = userData.size();
+    if (mRoot == NONE) {
+        return 0;
+    }
+    ELOO_ASSERT_FATAL(mNodes[mRoot].height < static_cast<int32_t>(MAX_HEIGHT), "Dynamic tree height %d is past the query limit", mNodes[mRoot].height);
+
+    const box3 query = to_box(box);
+    const auto overlaps = [&](const node& n) {
+        return n.min[0] <= query.max[0] && n.max[0] >= query.min[0]
+            && n.min[1] <= query.max[1] && n.max[1] >= query.min[1]
+            && n.min[2] <= query.max[2] && n.max[2] >= query.min[2];
+    };
+
+    uint32_t stack[MAX_HEIGHT];
+    uint32_t top = 0;
+    stack[top++] = mRoot;
+    while (top > 0) {
+        const node& n = mNodes[stack[--top]];
+        if (!overlaps(n)) {
+            continue;
+        }
+        if (n.is_leaf()) {
+            userData.push_back(n.userData);
+        }
+        else {
+            stack[top++] = n.child2;
+            stack[top++] = n.child1;
+        }
+    }
+    return userData.size() - initialSize;
+}
+
+void dynamic_tree::raycast(eastl::span<const raycast::ray> queries, const ray_test& test, eastl::span<batch_hit> closest) const {
+    ELOO_ASSERT_FATAL(queries.size() == closest.size(), "Batch raycast spans differ in length (%zu vs %zu)", queries.size(), closest.size());
+
+    parallel::parallel_for(queries.size(), QUERY_GRAIN, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            raycast(queries[i], test, closest[i]);
+        }
+    });
+}
+
+void dynamic_tree::occluded(eastl::span<const raycast::ray> queries, const ray_test& test, eastl::span<uint8_t> blocked) const {
+    ELOO_ASSERT_FATAL(queries.size() == blocked.size(), "Batch occlusion spans differ in length (%zu vs %zu)", queries.size(), blocked.size());
+
+    parallel::parallel_for(queries.size(), QUERY_GRAIN, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            blocked[i] = occluded(queries[i], test) ? 1 : 0;
+        }
+    });
+}
+
+void dynamic_tree::spherecast(eastl::span<const spherecast::sweep> queries, const sweep_test& test, eastl::span<batch_hit> closest) const {
+    ELOO_ASSERT_FATAL(queries.size() == closest.size(), "Batch spherecast spans differ in length (%zu vs %zu)", queries.size(), closest.size());
+
+    parallel::parallel_for(queries.size(), QUERY_GRAIN, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            spherecast(queries[i], test, closest[i]);
+        }
+    });
+}
+
+// Each run of queries collects its pairs separately, and the runs are joined in order
+size_t dynamic_tree::overlap(eastl::span<const aabb> boxes, eastl::vector<overlap_pair>& pairs) const {
+    const size_t runs = (boxes.size() + QUERY_GRAIN - 1) / QUERY_GRAIN;
+    eastl::vector<eastl::vector<overlap_pair>> partial(runs);
+    parallel::parallel_for(boxes.size(), QUERY_GRAIN, [&](size_t begin, size_t end) {
+        eastl::vector<overlap_pair>& out = partial[begin / QUERY_GRAIN];
+        eastl::vector<uint32_t> found;
+        for (size_t i = begin; i < end; ++i) {
+            found.clear();
+            overlap(boxes[i], found);
+            for (const uint32_t userData : found) {
+                out.push_back({ static_cast<uint32_t>(i), userData });
+            }
+        }
+    });
+
+    const size_t initialSize = pairs.size();
+    for (const eastl::vector<overlap_pair>& run : partial) {
+        pairs.insert(pairs.end(), run.begin(), run.end());
+    }
+    return pairs.size() - initialSize;
+}
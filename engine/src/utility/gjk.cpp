@@ -0,0 +1,738 @@
+#include "utility/gjk.h"
+
+#include "maths/math.h"
+#include "utility/parallel.h"
+
+using namespace eloo;
+using namespace eloo::gjk;
+
+namespace {
+    constexpr uint32_t GJK_MAX_ITERATIONS = 64;
+    // Distance is converged once a new support point gets less than this much closer, relative
+    // to the distance itself
+    constexpr float GJK_TOLERANCE = 1e-5f;
+    // Squared distance, relative to the size of the simplex, below which the origin is touching it
+    constexpr float GJK_TOUCHING = 1e-10f;
+    // Squared sine of the angle below which a triangle or tetrahedron is taken as flat. Both are
+    // measured with cross products rather than differences of dot products, which keep their
+    // precision for much thinner ones
+    constexpr float GJK_FLAT = 1e-12f;
+
+    constexpr uint32_t EPA_MAX_ITERATIONS = 128;
+    // Each iteration adds a vertex, and a closed polytope of V vertices has 2V - 4 faces
+    constexpr uint32_t EPA_MAX_VERTICES = EPA_MAX_ITERATIONS + 4;
+    constexpr uint32_t EPA_MAX_FACES = 2 * EPA_MAX_VERTICES;
+    constexpr uint32_t EPA_MAX_EDGES = EPA_MAX_FACES;
+    // Depth is converged once a new support point reaches less than this much past the closest
+    // face, relative to the size of the starting tetrahedron
+    constexpr float EPA_TOLERANCE = 1e-4f;
+
+    // Pairs are handed to the workers in runs of this many
+    constexpr size_t PAIR_GRAIN = 64;
+
+    // A point of the Minkowski difference A - B, with the points of A and B it came from and the
+    // direction that found it
+    struct vertex {
+        float3::values w = float3::ZERO;
+        float3::values a = float3::ZERO;
+        float3::values b = float3::ZERO;
+        float3::values direction = float3::ZERO;
+    };
+
+    // 'lambda' holds the barycentric weights of the closest point for fewer than four points
+    struct simplex {
+        vertex points[4];
+        float lambda[4];
+        uint32_t count = 0;
+    };
+
+    // A subset of the simplex and the weights of its closest point
+    struct region {
+        uint32_t keep[4];
+        float lambda[4];
+        uint32_t count;
+    };
+
+    struct gjk_state {
+        simplex s;
+        float3::values v = float3::ZERO;
+        uint32_t iterations = 0;
+        bool overlapping = false;
+    };
+
+    ELOO_FORCE_INLINE float margin(const shape& convex) {
+        return convex.type == shape_type::sphere || convex.type == shape_type::capsule ? convex.radius : 0.0f;
+    }
+
+    // Support of the shape without its radius: the centre of a sphere or the segment of a capsule
+    float3::values core_support(const shape& convex, const float3::values& direction) {
+        switch (convex.type) {
+        case shape_type::sphere:
+            return convex.origin;
+        case shape_type::capsule: {
+            const float halfHeight = convex.height * 0.5f;
+            return { convex.origin.x(), convex.origin.y() + (direction.y() >= 0.0f ? halfHeight : -halfHeight), convex.origin.z() };
+        }
+        case shape_type::box:
+            return {
+                direction.x() >= 0.0f ? convex.extent.x() : convex.origin.x(),
+                direction.y() >= 0.0f ? convex.extent.y() : convex.origin.y(),
+                direction.z() >= 0.0f ? convex.extent.z() : convex.origin.z()
+            };
+        case shape_type::ellipsoid: {
+            // The point whose normal is 'direction' is origin + R^2 d / |R d| for radii R
+            const float3::values scaled = direction * convex.extent;
+            const float length = math::vector::magnitude(scaled);
+            if (length <= 0.0f) {
+                return convex.origin;
+            }
+            return convex.origin + scaled * convex.extent * (1.0f / length);
+        }
+        case shape_type::hull: {
+            uint32_t best = 0;
+            float bestReach = math::vector::dot(convex.vertices[0], direction);
+            for (uint32_t i = 1; i < convex.vertices.size(); ++i) {
+                const float reach = math::vector::dot(convex.vertices[i], direction);
+                if (reach > bestReach) {
+                    bestReach = reach;
+                    best = i;
+                }
+            }
+            return convex.vertices[best];
+        }
+        }
+        return convex.origin;
+    }
+
+    float3::values centre(const shape& convex) {
+        switch (convex.type) {
+        case shape_type::box:
+            return (convex.origin + convex.extent) * 0.5f;
+        case shape_type::hull:
+            return convex.vertices[0];
+        default:
+            return convex.origin;
+        }
+    }
+
+    ELOO_FORCE_INLINE vertex support_pair(const shape& a, const shape& b, const float3::values& direction, bool full) {
+        const float3::values pointA = full ? support(a, direction) : core_support(a, direction);
+        const float3::values pointB = full ? support(b, -direction) : core_support(b, -direction);
+        return { pointA - pointB, pointA, pointB, direction };
+    }
+
+
+    /////////////////////////////////////////////////////////////////////
+    // Closest point on a simplex
+
+    region closest_on_segment(const simplex& s, uint32_t i0, uint32_t i1) {
+        const float3::values& p0 = s.points[i0].w;
+        const float3::values ab = s.points[i1].w - p0;
+        const float lengthSqr = math::vector::dot(ab, ab);
+        const float t = lengthSqr > 0.0f ? -math::vector::dot(p0, ab) / lengthSqr : 0.0f;
+        if (t <= 0.0f) {
+            return { { i0 }, { 1.0f }, 1 };
+        }
+        if (t >= 1.0f) {
+            return { { i1 }, { 1.0f }, 1 };
+        }
+        return { { i0, i1 }, { 1.0f - t, t }, 2 };
+    }
+
+    float3::values point_of(const simplex& s, const region& r) {
+        float3::values point = s.points[r.keep[0]].w * r.lambda[0];
+        for (uint32_t i = 1; i < r.count; ++i) {
+            point += s.points[r.keep[i]].w * r.lambda[i];
+        }
+        return point;
+    }
+
+    // Voronoi regions of the triangle, following Ericson's closest point on triangle test with
+    // the query point at the origin. Triangles too thin for the face weights fall back to their
+    // closest edge
+    region closest_on_triangle(const simplex& s, uint32_t i0, uint32_t i1, uint32_t i2) {
+        const float3::values& a = s.points[i0].w;
+        const float3::values& b = s.points[i1].w;
+        const float3::values& c = s.points[i2].w;
+        const float3::values ab = b - a;
+        const float3::values ac = c - a;
+
+        const float d1 = -math::vector::dot(ab, a);
+        const float d2 = -math::vector::dot(ac, a);
+        if (d1 <= 0.0f && d2 <= 0.0f) {
+            return { { i0 }, { 1.0f }, 1 };
+        }
+
+        const float d3 = -math::vector::dot(ab, b);
+        const float d4 = -math::vector::dot(ac, b);
+        if (d3 >= 0.0f && d4 <= d3) {
+            return { { i1 }, { 1.0f }, 1 };
+        }
+
+        // Barycentric weights scaled by the squared length of ab x ac. Taking them from the
+        // normal keeps them accurate for thin triangles, where Ericson's products of dot products
+        // cancel
+        const float3::values normal = math::vector::cross(ab, ac);
+        const float vc = math::vector::dot(normal, math::vector::cross(a, ab));
+        if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) {
+            const float t = d1 / (d1 - d3);
+            return { { i0, i1 }, { 1.0f - t, t }, 2 };
+        }
+
+        const float d5 = -math::vector::dot(ab, c);
+        const float d6 = -math::vector::dot(ac, c);
+        if (d6 >= 0.0f && d5 <= d6) {
+            return { { i2 }, { 1.0f }, 1 };
+        }
+
+        const float vb = -math::vector::dot(normal, math::vector::cross(a, ac));
+        if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) {
+            const float t = d2 / (d2 - d6);
+            return { { i0, i2 }, { 1.0f - t, t }, 2 };
+        }
+
+        const float va = math::vector::dot(normal, math::vector::cross(b, c - b));
+        if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f) {
+            const float t = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+            return { { i1, i2 }, { 1.0f - t, t }, 2 };
+        }
+
+        const float area = math::vector::dot(normal, normal);
+        if (!(area > GJK_FLAT * math::vector::dot(ab, ab) * math::vector::dot(ac, ac))) {
+            region best = closest_on_segment(s, i0, i1);
+            float bestSqr = math::vector::magnitude_sqr(point_of(s, best));
+            for (const region& edge : { closest_on_segment(s, i0, i2), closest_on_segment(s, i1, i2) }) {
+                const float distSqr = math::vector::magnitude_sqr(point_of(s, edge));
+                if (distSqr < bestSqr) {
+                    best = edge;
+                    bestSqr = distSqr;
+                }
+            }
+            return best;
+        }
+
+        const float invArea = 1.0f / area;
+        const float v = vb * invArea;
+        const float w = vc * invArea;
+        return { { i0, i1, i2 }, { 1.0f - v - w, v, w }, 3 };
+    }
+
+    // The closest point over the faces whose plane separates the origin from the opposite vertex,
+    // or the whole tetrahedron when there are none and the origin is inside. A flat tetrahedron
+    // has no inside, so every face is tried
+    region closest_on_tetrahedron(const simplex& s) {
+        static constexpr uint32_t FACES[4][4] = { { 0, 1, 2, 3 }, { 0, 3, 1, 2 }, { 0, 2, 3, 1 }, { 1, 3, 2, 0 } };
+
+        const float3::values& a = s.points[0].w;
+        const float3::values ab = s.points[1].w - a;
+        const float3::values ac = s.points[2].w - a;
+        const float3::values ad = s.points[3].w - a;
+        const float volume = math::vector::dot(ad, math::vector::cross(ab, ac));
+        const bool flat = volume * volume <= GJK_FLAT * math::vector::dot(ab, ab) * math::vector::dot(ac, ac) * math::vector::dot(ad, ad);
+
+        region best = { { 0, 1, 2, 3 }, { 0.0f, 0.0f, 0.0f, 0.0f }, 4 };
+        float bestSqr = FLT_MAX;
+        for (const auto& face : FACES) {
+            const float3::values& p = s.points[face[0]].w;
+            const float3::values normal = math::vector::cross(s.points[face[1]].w - p, s.points[face[2]].w - p);
+            const float originSide = -math::vector::dot(p, normal);
+            const float oppositeSide = math::vector::dot(s.points[face[3]].w - p, normal);
+            if (!flat && originSide * oppositeSide >= 0.0f) {
+                continue;
+            }
+
+            const region candidate = closest_on_triangle(s, face[0], face[1], face[2]);
+            const float distSqr = math::vector::magnitude_sqr(point_of(s, candidate));
+            if (distSqr < bestSqr) {
+                best = candidate;
+                bestSqr = distSqr;
+            }
+        }
+        return best;
+    }
+
+    // Reduces the simplex to the points its closest point to the origin needs. Returns true when
+    // the simplex holds the origin
+    bool solve(simplex& s, float3::values& v) {
+        region r;
+        switch (s.count) {
+        case 1:
+            r = { { 0 }, { 1.0f }, 1 };
+            break;
+        case 2:
+            r = closest_on_segment(s, 0, 1);
+            break;
+        case 3:
+            r = closest_on_triangle(s, 0, 1, 2);
+            break;
+        default:
+            r = closest_on_tetrahedron(s);
+            if (r.count == 4) {
+                v = float3::ZERO;
+                return true;
+            }
+            break;
+        }
+
+        vertex kept[4];
+        for (uint32_t i = 0; i < r.count; ++i) {
+            kept[i] = s.points[r.keep[i]];
+        }
+        for (uint32_t i = 0; i < r.count; ++i) {
+            s.points[i] = kept[i];
+            s.lambda[i] = r.lambda[i];
+        }
+        s.count = r.count;
+
+        v = s.points[0].w * s.lambda[0];
+        for (uint32_t i = 1; i < s.count; ++i) {
+            v += s.points[i].w * s.lambda[i];
+        }
+        return false;
+    }
+
+    bool contains(const simplex& s, const float3::values& w) {
+        for (uint32_t i = 0; i < s.count; ++i) {
+            if (s.points[i].w == w) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    float simplex_scale_sqr(const simplex& s) {
+        float scaleSqr = 0.0f;
+        for (uint32_t i = 0; i < s.count; ++i) {
+            scaleSqr = math::max(scaleSqr, math::vector::magnitude_sqr(s.points[i].w));
+        }
+        return scaleSqr;
+    }
+
+
+    /////////////////////////////////////////////////////////////////////
+    // GJK
+
+    // Searches A - B for the point closest to the origin, over the cores or the full shapes. The
+    // warm start rebuilds the last simplex from its directions against where the shapes are now,
+    // which any set of support points is a valid start for. 'separatingOnly' stops at the first
+    // direction that proves the shapes apart, for overlap tests that don't need the distance
+    void run_gjk(const shape& a, const shape& b, bool full, bool separatingOnly, const cache* warm, gjk_state& state) {
+        simplex& s = state.s;
+        s.count = 0;
+        state.iterations = 0;
+        state.overlapping = false;
+
+        if (warm != nullptr) {
+            for (uint32_t i = 0; i < warm->count; ++i) {
+                const vertex p = support_pair(a, b, warm->directions[i], full);
+                if (!contains(s, p.w)) {
+                    s.points[s.count++] = p;
+                }
+            }
+        }
+        if (s.count == 0) {
+            float3::values direction = centre(b) - centre(a);
+            if (math::vector::magnitude_sqr(direction) <= 0.0f) {
+                direction = float3::RIGHT;
+            }
+            s.points[s.count++] = support_pair(a, b, direction, full);
+        }
+        if (solve(s, state.v)) {
+            state.overlapping = true;
+            return;
+        }
+
+        float scaleSqr = simplex_scale_sqr(s);
+        while (state.iterations < GJK_MAX_ITERATIONS) {
+            ++state.iterations;
+            const float distSqr = math::vector::magnitude_sqr(state.v);
+            if (distSqr <= GJK_TOUCHING * scaleSqr) {
+                state.overlapping = true;
+                return;
+            }
+
+            const vertex p = support_pair(a, b, state.v * -1.0f, full);
+            const float reach = math::vector::dot(state.v, p.w);
+            if (separatingOnly && reach > 0.0f) {
+                return;
+            }
+            if (distSqr - reach <= GJK_TOLERANCE * distSqr || contains(s, p.w)) {
+                return;
+            }
+
+            // A step that gets no closer, which rounding can cause once the simplex is nearly
+            // flat, is undone so the result is the best simplex found rather than the last
+            const simplex previous = s;
+            const float3::values previousV = state.v;
+            scaleSqr = math::max(scaleSqr, math::vector::magnitude_sqr(p.w));
+            s.points[s.count++] = p;
+            if (solve(s, state.v)) {
+                state.overlapping = true;
+                return;
+            }
+            if (math::vector::magnitude_sqr(state.v) >= distSqr) {
+                s = previous;
+                state.v = previousV;
+                return;
+            }
+        }
+    }
+
+    void store(const simplex& s, cache* warm) {
+        if (warm == nullptr) {
+            return;
+        }
+        warm->count = s.count;
+        for (uint32_t i = 0; i < s.count; ++i) {
+            warm->directions[i] = s.points[i].direction;
+        }
+    }
+
+
+    /////////////////////////////////////////////////////////////////////
+    // EPA
+
+    struct epa_face {
+        uint32_t v[3] = { 0, 0, 0 };
+        float3::values normal = float3::ZERO;
+        float distance = FLT_MAX;
+    };
+
+    struct epa_edge {
+        uint32_t from;
+        uint32_t to;
+    };
+
+    // Faces too small for a normal are kept to close the polytope but never chosen
+    epa_face make_face(const vertex* verts, uint32_t i0, uint32_t i1, uint32_t i2) {
+        epa_face face;
+        face.v[0] = i0;
+        face.v[1] = i1;
+        face.v[2] = i2;
+        const float3::values normal = math::vector::cross(verts[i1].w - verts[i0].w, verts[i2].w - verts[i0].w);
+        const float length = math::vector::magnitude(normal);
+        if (length > 0.0f) {
+            face.normal = normal * (1.0f / length);
+            face.distance = math::vector::dot(face.normal, verts[i0].w);
+        }
+        return face;
+    }
+
+    // Grows the simplex GJK stopped with into a tetrahedron, searching along directions off the
+    // points it has so far. The origin lies on the simplex, so the tetrahedron still holds it
+    bool expand_simplex(const shape& a, const shape& b, simplex& s) {
+        static constexpr float3::values AXES[6] = { { 1.0f, 0.0f, 0.0f }, { -1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, { 0.0f, -1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f }, { 0.0f, 0.0f, -1.0f } };
+
+        const float epsilon = GJK_TOUCHING * math::max(simplex_scale_sqr(s), 1e-12f);
+        if (s.count == 1) {
+            for (const float3::values& axis : AXES) {
+                const vertex p = support_pair(a, b, axis, true);
+                if (math::vector::distance_sqr(p.w, s.points[0].w) > epsilon) {
+                    s.points[s.count++] = p;
+                    break;
+                }
+            }
+        }
+        if (s.count == 2) {
+            const float3::values line = s.points[1].w - s.points[0].w;
+            const float ax = math::abs(line.x());
+            const float ay = math::abs(line.y());
+            const float az = math::abs(line.z());
+            const float3::values& axis = ax <= ay && ax <= az ? float3::RIGHT : (ay <= az ? float3::UP : float3::FORWARD);
+            const float3::values side1 = math::vector::cross(line, axis);
+            const float3::values side2 = math::vector::cross(line, side1);
+            for (const float3::values& direction : { side1, -side1, side2, -side2 }) {
+                const vertex p = support_pair(a, b, direction, true);
+                if (math::vector::magnitude_sqr(math::vector::cross(p.w - s.points[0].w, line)) > epsilon * math::vector::magnitude_sqr(line)) {
+                    s.points[s.count++] = p;
+                    break;
+                }
+            }
+        }
+        if (s.count == 3) {
+            const float3::values normal = math::vector::cross(s.points[1].w - s.points[0].w, s.points[2].w - s.points[0].w);
+            const float3::values toOrigin = math::vector::dot(normal, s.points[0].w) <= 0.0f ? normal : -normal;
+            for (const float3::values& direction : { toOrigin, -toOrigin }) {
+                const vertex p = support_pair(a, b, direction, true);
+                const float height = math::vector::dot(p.w - s.points[0].w, normal);
+                if (height * height > epsilon * math::vector::magnitude_sqr(normal)) {
+                    s.points[s.count++] = p;
+                    break;
+                }
+            }
+        }
+        return s.count == 4;
+    }
+
+    // Expands the polytope towards the face closest to the origin until the support point along
+    // its normal gets no further, replacing the faces the new point can see with a fan from it
+    // to their horizon
+    void run_epa(const shape& a, const shape& b, simplex& s, result& info) {
+        if (!expand_simplex(a, b, s)) {
+            // Flat shapes, touching along their whole extent
+            float3::values normal = centre(b) - centre(a);
+            const float length = math::vector::magnitude(normal);
+            info.normal = length > 0.0f ? normal * (1.0f / length) : float3::UP;
+            info.distance = 0.0f;
+            info.pointA = s.points[0].a;
+            info.pointB = s.points[0].a;
+            return;
+        }
+
+        vertex verts[EPA_MAX_VERTICES];
+        epa_face faces[EPA_MAX_FACES];
+        epa_edge edges[EPA_MAX_EDGES];
+        for (uint32_t i = 0; i < 4; ++i) {
+            verts[i] = s.points[i];
+        }
+        uint32_t vertexCount = 4;
+
+        static constexpr uint32_t START_FACES[4][4] = { { 0, 1, 2, 3 }, { 0, 3, 1, 2 }, { 0, 2, 3, 1 }, { 1, 3, 2, 0 } };
+        uint32_t faceCount = 0;
+        for (const auto& face : START_FACES) {
+            const float3::values normal = math::vector::cross(verts[face[1]].w - verts[face[0]].w, verts[face[2]].w - verts[face[0]].w);
+            const bool inward = math::vector::dot(normal, verts[face[3]].w - verts[face[0]].w) > 0.0f;
+            faces[faceCount++] = inward ? make_face(verts, face[0], face[2], face[1]) : make_face(verts, face[0], face[1], face[2]);
+        }
+
+        const float tolerance = EPA_TOLERANCE * math::sqrt(simplex_scale_sqr(s));
+        uint32_t closest = 0;
+        for (uint32_t iteration = 0;; ++iteration) {
+            closest = 0;
+            for (uint32_t i = 1; i < faceCount; ++i) {
+                if (faces[i].distance < faces[closest].distance) {
+                    closest = i;
+                }
+            }
+            if (iteration == EPA_MAX_ITERATIONS || vertexCount == EPA_MAX_VERTICES) {
+                break;
+            }
+
+            const epa_face& face = faces[closest];
+            const vertex p = support_pair(a, b, face.normal, true);
+            if (math::vector::dot(p.w, face.normal) - face.distance <= tolerance) {
+                break;
+            }
+
+            const uint32_t added = vertexCount++;
+            verts[added] = p;
+
+            // Faces are removed by moving the last one into their place, which has already been
+            // looked at as the walk runs backwards
+            uint32_t edgeCount = 0;
+            bool overflow = false;
+            for (uint32_t i = faceCount; i-- > 0;) {
+                if (math::vector::dot(faces[i].normal, p.w - verts[faces[i].v[0]].w) <= 0.0f) {
+                    continue;
+                }
+                for (uint32_t e = 0; e < 3; ++e) {
+                    const epa_edge edge = { faces[i].v[e], faces[i].v[(e + 1) % 3] };
+                    uint32_t twin = 0;
+                    while (twin < edgeCount && (edges[twin].from != edge.to || edges[twin].to != edge.from)) {
+                        ++twin;
+                    }
+                    if (twin < edgeCount) {
+                        edges[twin] = edges[--edgeCount];
+                    }
+                    else if (edgeCount < EPA_MAX_EDGES) {
+                        edges[edgeCount++] = edge;
+                    }
+                    else {
+                        overflow = true;
+                    }
+                }
+                faces[i] = faces[--faceCount];
+            }
+
+            for (uint32_t e = 0; e < edgeCount; ++e) {
+                if (faceCount == EPA_MAX_FACES) {
+                    overflow = true;
+                    break;
+                }
+                faces[faceCount++] = make_face(verts, edges[e].from, edges[e].to, added);
+            }
+            if (overflow || faceCount == 0) {
+                closest = 0;
+                for (uint32_t i = 1; i < faceCount; ++i) {
+                    if (faces[i].distance < faces[closest].distance) {
+                        closest = i;
+                    }
+                }
+                break;
+            }
+        }
+
+        // Barycentric weights of the origin's projection onto the closest face carry over to the
+        // points of A and B that made it
+        const epa_face& face = faces[closest];
+        const float depth = math::max(face.distance, 0.0f);
+        const float3::values& p0 = verts[face.v[0]].w;
+        const float3::values e0 = verts[face.v[1]].w - p0;
+        const float3::values e1 = verts[face.v[2]].w - p0;
+        const float3::values e2 = face.normal * face.distance - p0;
+        const float d00 = math::vector::dot(e0, e0);
+        const float d01 = math::vector::dot(e0, e1);
+        const float d11 = math::vector::dot(e1, e1);
+        const float d20 = math::vector::dot(e2, e0);
+        const float d21 = math::vector::dot(e2, e1);
+        const float denom = d00 * d11 - d01 * d01;
+        float lambda[3] = { 1.0f, 0.0f, 0.0f };
+        if (denom > 0.0f) {
+            lambda[1] = (d11 * d20 - d01 * d21) / denom;
+            lambda[2] = (d00 * d21 - d01 * d20) / denom;
+            lambda[0] = 1.0f - lambda[1] - lambda[2];
+        }
+
+        info.pointA = verts[face.v[0]].a * lambda[0] + verts[face.v[1]].a * lambda[1] + verts[face.v[2]].a * lambda[2];
+        info.pointB = info.pointA - face.normal * depth;
+        info.normal = face.normal;
+        info.distance = -depth;
+    }
+
+
+    /////////////////////////////////////////////////////////////////////
+    // Queries
+
+    // Overlap from the cores when either shape has a radius, as the core distance converges
+    // quickly and only has to be compared with the radii. Shapes without one stop early instead
+    bool test_overlap(const shape& a, const shape& b, cache* warm, uint32_t& iterations) {
+        gjk_state state;
+        const float margins = margin(a) + margin(b);
+        run_gjk(a, b, margins <= 0.0f, margins <= 0.0f, warm, state);
+        store(state.s, warm);
+        iterations = state.iterations;
+        return state.overlapping || math::vector::magnitude_sqr(state.v) <= margins * margins;
+    }
+
+    // The radii are added back along the line between the closest core points, which is exact
+    // both for separated shapes and for ones that only overlap by their radii
+    bool test_pair(const shape& a, const shape& b, result& info, cache* warm, bool withDepth) {
+        info = result();
+        gjk_state state;
+        run_gjk(a, b, false, false, warm, state);
+        info.iterations = state.iterations;
+
+        if (!state.overlapping) {
+            float3::values coreA = state.s.points[0].a * state.s.lambda[0];
+            float3::values coreB = state.s.points[0].b * state.s.lambda[0];
+            for (uint32_t i = 1; i < state.s.count; ++i) {
+                coreA += state.s.points[i].a * state.s.lambda[i];
+                coreB += state.s.points[i].b * state.s.lambda[i];
+            }
+            const float coreDistance = math::vector::magnitude(state.v);
+            info.normal = state.v * (-1.0f / coreDistance);
+            info.distance = coreDistance - margin(a) - margin(b);
+            info.pointA = coreA + info.normal * margin(a);
+            info.pointB = coreB - info.normal * margin(b);
+            info.overlapping = info.distance < 0.0f;
+            store(state.s, warm);
+            return info.overlapping;
+        }
+
+        info.overlapping = true;
+        store(state.s, warm);
+        if (!withDepth) {
+            return true;
+        }
+
+        // EPA needs a simplex around the origin of the full shapes, which starts from the cores'
+        // directions when there are radii
+        if (margin(a) + margin(b) > 0.0f) {
+            const uint32_t coreIterations = state.iterations;
+            run_gjk(a, b, true, false, warm, state);
+            info.iterations += coreIterations;
+        }
+        run_epa(a, b, state.s, info);
+        return true;
+    }
+
+    template <typename PairFn>
+    void run_batch(size_t count, PairFn pairFn) {
+        parallel::parallel_for(count, PAIR_GRAIN, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                pairFn(i);
+            }
+        });
+    }
+}
+
+
+/////////////////////////////////////////////////////////////////////
+// Shapes
+
+shape shape::sphere(const float3::values& origin, float radius) {
+    return { shape_type::sphere, origin, float3::ZERO, 0.0f, radius, {} };
+}
+
+shape shape::capsule(const float3::values& origin, float height, float radius) {
+    return { shape_type::capsule, origin, float3::ZERO, height, radius, {} };
+}
+
+shape shape::box(const float3::values& min, const float3::values& max) {
+    return { shape_type::box, min, max, 0.0f, 0.0f, {} };
+}
+
+shape shape::ellipsoid(const float3::values& origin, const float3::values& radii) {
+    return { shape_type::ellipsoid, origin, radii, 0.0f, 0.0f, {} };
+}
+
+shape shape::hull(eastl::span<const float3::values> vertices) {
+    ELOO_ASSERT_FATAL(!vertices.empty(), "Convex hull has no vertices");
+    return { shape_type::hull, float3::ZERO, float3::ZERO, 0.0f, 0.0f, vertices };
+}
+
+float3::values gjk::support(const shape& convex, const float3::values& direction) {
+    const float3::values core = core_support(convex, direction);
+    const float radius = margin(convex);
+    if (radius <= 0.0f) {
+        return core;
+    }
+    const float length = math::vector::magnitude(direction);
+    return length > 0.0f ? core + direction * (radius / length) : core;
+}
+
+
+/////////////////////////////////////////////////////////////////////
+// Pairs
+
+bool gjk::overlap(const shape& a, const shape& b, cache* warm) {
+    uint32_t iterations = 0;
+    return test_overlap(a, b, warm, iterations);
+}
+
+bool gjk::closest_points(const shape& a, const shape& b, result& info, cache* warm) {
+    return !test_pair(a, b, info, warm, false);
+}
+
+bool gjk::penetration(const shape& a, const shape& b, result& info, cache* warm) {
+    return test_pair(a, b, info, warm, true);
+}
+
+
+/////////////////////////////////////////////////////////////////////
+// Batches
+
+void gjk::overlap(eastl::span<const shape> shapes, eastl::span<const shape_pair> pairs, eastl::span<uint8_t> overlapping, eastl::span<cache> caches) {
+    ELOO_ASSERT_FATAL(overlapping.size() >= pairs.size(), "GJK batch has %zu results for %zu pairs", overlapping.size(), pairs.size());
+    ELOO_ASSERT_FATAL(caches.empty() || caches.size() >= pairs.size(), "GJK batch has %zu caches for %zu pairs", caches.size(), pairs.size());
+    run_batch(pairs.size(), [&](size_t i) {
+        uint32_t iterations = 0;
+        overlapping[i] = test_overlap(shapes[pairs[i].a], shapes[pairs[i].b], caches.empty() ? nullptr : &caches[i], iterations) ? 1 : 0;
+    });
+}
+
+void gjk::closest_points(eastl::span<const shape> shapes, eastl::span<const shape_pair> pairs, eastl::span<result> results, eastl::span<cache> caches) {
+    ELOO_ASSERT_FATAL(results.size() >= pairs.size(), "GJK batch has %zu results for %zu pairs", results.size(), pairs.size());
+    ELOO_ASSERT_FATAL(caches.empty() || caches.size() >= pairs.size(), "GJK batch has %zu caches for %zu pairs", caches.size(), pairs.size());
+    run_batch(pairs.size(), [&](size_t i) {
+        test_pair(shapes[pairs[i].a], shapes[pairs[i].b], results[i], caches.empty() ? nullptr : &caches[i], false);
+    });
+}
+
+void gjk::penetration(eastl::span<const shape> shapes, eastl::span<const shape_pair> pairs, eastl::span<result> results, eastl::span<cache> caches) {
+    ELOO_ASSERT_FATAL(results.size() >= pairs.size(), "GJK batch has %zu results for %zu pairs", results.size(), pairs.size());
+    ELOO_ASSERT_FATAL(caches.empty() || caches.size() >= pairs.size(), "GJK batch has %zu caches for %zu pairs", caches.size(), pairs.size());
+    run_batch(pairs.size(), [&](size_t i) {
+        test_pair(shapes[pairs[i].a], shapes[pairs[i].b], results[i], caches.empty() ? nullptr : &caches[i], true);
+    });
+}
@@ -0,0 +1,198 @@
+#include "utility/gradient.h"
+
+#include "maths/math.h"
+#include "maths/simd.h"
+#include "utility/colour_convert.h"
+
+#include <EASTL/algorithm.h>
+
+#include <cmath>
+
+using namespace eloo;
+using namespace eloo::colour;
+
+namespace {
+    // HSV of a linear colour, achromatic colours getting a hue of 0
+    float4::values rgb_to_hsv(const float4::values& rgba) {
+        const float r = rgba.x();
+        const float g = rgba.y();
+        const float b = rgba.z();
+        const float maxC = math::max(r, math::max(g, b));
+        const float delta = maxC - math::min(r, math::min(g, b));
+
+        float h = 0.0f;
+        if (delta > 0.0f) {
+            if (maxC == r) {
+                h = (g - b) / delta;
+            } else if (maxC == g) {
+                h = (b - r) / delta + 2.0f;
+            } else {
+                h = (r - g) / delta + 4.0f;
+            }
+            h *= 1.0f / 6.0f;
+            if (h < 0.0f) {
+                h += 1.0f;
+            }
+        }
+        return { h, maxC > 0.0f ? delta / maxC : 0.0f, maxC, rgba.w() };
+    }
+
+    float4::values hsv_to_rgb(const float4::values& hsva) {
+        const float h6 = (hsva.x() - std::floor(hsva.x())) * 6.0f;
+        const int sector = static_cast<int>(h6) % 6;
+        const float f = h6 - static_cast<float>(static_cast<int>(h6));
+        const float s = hsva.y();
+        const float v = hsva.z();
+        const float p = v * (1.0f - s);
+        const float q = v * (1.0f - f * s);
+        const float t = v * (1.0f - (1.0f - f) * s);
+        switch (sector) {
+            case 0:  return { v, t, p, hsva.w() };
+            case 1:  return { q, v, p, hsva.w() };
+            case 2:  return { p, v, t, hsva.w() };
+            case 3:  return { p, q, v, hsva.w() };
+            case 4:  return { t, p, v, hsva.w() };
+            default: return { v, p, q, hsva.w() };
+        }
+    }
+
+    ELOO_FORCE_INLINE float lerp(float from, float to, float w) {
+        return from + (to - from) * w;
+    }
+}
+
+
+/////////////////////////////////////////////////////////////////////
+// Lookup table
+
+colour_t gradient_lut::sample(float t) const {
+    ELOO_ASSERT_FATAL(!mEntries.empty(), "Sampling an empty gradient lookup table");
+    const float scaled = math::saturate(t) * static_cast<float>(mEntries.size() - 1) + 0.5f;
+    return mEntries[static_cast<size_t>(scaled)];
+}
+
+void gradient_lut::sample(eastl::span<const float> t, eastl::span<colour_t> out) const {
+    ELOO_ASSERT_FATAL(!mEntries.empty(), "Sampling an empty gradient lookup table");
+    ELOO_ASSERT_FATAL(t.size() == out.size(), "Gradient sample spans differ in length (%zu vs %zu)", t.size(), out.size());
+
+    // Indices are computed 4-wide, the lookups themselves are plain loads
+    const colour_t* entries = mEntries.data();
+    const math::simd::f32x4 scale = math::simd::set1(static_cast<float>(mEntries.size() - 1));
+    const math::simd::f32x4 half = math::simd::set1(0.5f);
+    const math::simd::f32x4 one = math::simd::set1(1.0f);
+    const size_t count = t.size();
+    size_t i = 0;
+    for (; i + math::simd::WIDTH <= count; i += math::simd::WIDTH) {
+        const math::simd::f32x4 clamped = math::simd::min(math::simd::max(math::simd::load(t.data() + i), math::simd::zero()), one);
+        int32_t index[math::simd::WIDTH];
+        math::simd::store_i32(index, math::simd::to_i32(math::simd::madd(clamped, scale, half)));
+        out[i] = entries[index[0]];
+        out[i + 1] = entries[index[1]];
+        out[i + 2] = entries[index[2]];
+        out[i + 3] = entries[index[3]];
+    }
+    for (; i < count; ++i) {
+        out[i] = sample(t[i]);
+    }
+}
+
+
+/////////////////////////////////////////////////////////////////////
+// Gradient
+
+gradient::gradient(mode blendMode)
+    : mMode(blendMode) {
+}
+
+void gradient::add_stop(float position, const float4::values& linearColour, math::interpolation::blend_func blend, math::interpolation::blend_opt options) {
+    auto it = eastl::upper_bound(mStops.begin(), mStops.end(), position, [](float value, const stop& other) {
+        return value < other.position;
+    });
+    mStops.insert(it, stop { position, linearColour, rgb_to_hsv(linearColour), blend, options });
+}
+
+void gradient::add_stop(float position, colour_t colour, math::interpolation::blend_func blend, math::interpolation::blend_opt options) {
+    add_stop(position, to_linear(colour), blend, options);
+}
+
+void gradient::clear() {
+    mStops.clear();
+}
+
+float4::values gradient::evaluate(float t) const {
+    if (mStops.empty()) {
+        return { 0.0f, 0.0f, 0.0f, 0.0f };
+    }
+    if (!(t > mStops.front().position)) {
+        return mStops.front().colour;
+    }
+    if (t >= mStops.back().position) {
+        return mStops.back().colour;
+    }
+
+    // First stop past 't', so the segment is [next - 1, next)
+    auto next = eastl::upper_bound(mStops.begin(), mStops.end(), t, [](float value, const stop& other) {
+        return value < other.position;
+    });
+    const stop& from = *(next - 1);
+    const stop& to = *next;
+    const float local = (t - from.position) / (to.position - from.position);
+    const float w = math::interpolation::interpolate(0.0f, 1.0f, local, from.blend, from.options);
+
+    if (mMode == mode::rgb) {
+        return {
+            lerp(from.colour.x(), to.colour.x(), w),
+            lerp(from.colour.y(), to.colour.y(), w),
+            lerp(from.colour.z(), to.colour.z(), w),
+            lerp(from.colour.w(), to.colour.w(), w)
+        };
+    }
+
+    // Greys have no meaningful hue, so they borrow the other end's to avoid sweeping the wheel
+    float fromHue = from.hsv.x();
+    float toHue = to.hsv.x();
+    if (from.hsv.y() <= 0.0f) {
+        fromHue = toHue;
+    } else if (to.hsv.y() <= 0.0f) {
+        toHue = fromHue;
+    }
+    float hueDelta = toHue - fromHue;
+    if (hueDelta > 0.5f) {
+        hueDelta -= 1.0f;
+    } else if (hueDelta < -0.5f) {
+        hueDelta += 1.0f;
+    }
+
+    return hsv_to_rgb({
+        fromHue + hueDelta * w,
+        lerp(from.hsv.y(), to.hsv.y(), w),
+        lerp(from.hsv.z(), to.hsv.z(), w),
+        lerp(from.hsv.w(), to.hsv.w(), w)
+    });
+}
+
+void gradient::evaluate(eastl::span<const float> t, eastl::span<float4::values> out) const {
+    ELOO_ASSERT_FATAL(t.size() == out.size(), "Gradient evaluate spans differ in length (%zu vs %zu)", t.size(), out.size());
+    for (size_t i = 0; i < t.size(); ++i) {
+        out[i] = evaluate(t[i]);
+    }
+}
+
+gradient_lut gradient::bake(uint32_t resolution) const {
+    ELOO_ASSERT_FATAL(resolution >= 2, "Gradient lookup tables need at least 2 entries, %u requested", resolution);
+
+    eastl::vector<float> positions(resolution);
+    const float step = 1.0f / static_cast<float>(resolution - 1);
+    for (uint32_t i = 0; i < resolution; ++i) {
+        positions[i] = static_cast<float>(i) * step;
+    }
+    positions.back() = 1.0f;
+
+    eastl::vector<float4::values> linear(resolution, float4::values(0.0f, 0.0f, 0.0f, 0.0f));
+    evaluate(positions, linear);
+
+    gradient_lut lut;
+    lut.mEntries.resize(resolution);
+    from_linear(linear, lut.mEntries);
+    return lut;
+}
@@ -0,0 +1,601 @@
+#include "utility/loose_octree.h"
+
+#include "maths/math.h"
+
+using namespace eloo;
+using namespace eloo::spatial;
+
+namespace {
+    constexpr uint32_t NONE = loose_octree::INVALID_PROXY;
+
+    // Marks pooled nodes and empty hash table slots
+    constexpr uint64_t FREE_KEY = UINT64_MAX;
+
+    // The root is created first and never released
+    constexpr uint32_t ROOT = 0;
+
+    // The hash table starts with this many slots and doubles whenever it would be over half full
+    constexpr size_t INITIAL_SLOTS = 64;
+
+    ELOO_FORCE_INLINE uint32_t hash_key(uint64_t key) {
+        return static_cast<uint32_t>((key * 0x9E3779B97F4A7C15ull) >> 32);
+    }
+
+    // Entry distance reported for boxes the ray misses
+    constexpr float MISS = FLT_MAX;
+
+    // Node keys hold the depth above three cell coordinates. A cell at depth d needs d bits per
+    // axis, and the two spare top bits keep every key clear of FREE_KEY
+    constexpr uint32_t CELL_BITS = 19;
+    constexpr uint32_t DEPTH_BITS = 5;
+    constexpr uint64_t CELL_MASK = (1ull << CELL_BITS) - 1;
+    static_assert(loose_octree::MAX_DEPTH <= CELL_BITS, "Cell coordinates at the deepest level must fit their bits");
+    static_assert(loose_octree::MAX_DEPTH < (1u << DEPTH_BITS), "The deepest level must fit the depth bits");
+    static_assert(CELL_BITS * 3 + DEPTH_BITS < 64, "Node keys must fit in 64 bits below FREE_KEY");
+
+    // Walks push at most seven siblings per level on top of the node being expanded
+    constexpr uint32_t STACK_SIZE = 8 * (loose_octree::MAX_DEPTH + 1);
+
+    struct ray_terms {
+        float origin[3];
+        float invDirection[3];
+        uint32_t sign[3];
+
+        explicit ray_terms(const raycast::ray& query)
+            : origin { query.origin.x(), query.origin.y(), query.origin.z() }
+            , invDirection { query.invDirection.x(), query.invDirection.y(), query.invDirection.z() }
+            , sign { query.sign[0], query.sign[1], query.sign[2] } {
+        }
+    };
+
+    // Distance at which the ray enters the box within [tmin, tmax], or MISS. A slab the ray runs
+    // along produces NaNs, which the argument order below drops rather than spreads
+    template <typename Box>
+    ELOO_FORCE_INLINE float entry_distance(const Box& box, const ray_terms& terms, float tmin, float tmax) {
+        float tNear = tmin;
+        float tFar = tmax;
+        for (int axis = 0; axis < 3; ++axis) {
+            const float t0 = ((terms.sign[axis] ? box.max[axis] : box.min[axis]) - terms.origin[axis]) * terms.invDirection[axis];
+            const float t1 = ((terms.sign[axis] ? box.min[axis] : box.max[axis]) - terms.origin[axis]) * terms.invDirection[axis];
+            tNear = math::max(t0, tNear);
+            tFar = math::min(t1, tFar);
+        }
+        return tNear <= tFar ? tNear : MISS;
+    }
+
+    template <typename BoxA, typename BoxB>
+    ELOO_FORCE_INLINE bool overlaps(const BoxA& a, const BoxB& b) {
+        return a.min[0] <= b.max[0] && a.max[0] >= b.min[0]
+            && a.min[1] <= b.max[1] && a.max[1] >= b.min[1]
+            && a.min[2] <= b.max[2] && a.max[2] >= b.min[2];
+    }
+
+    template <typename BoxA, typename BoxB>
+    ELOO_FORCE_INLINE bool contains(const BoxA& outer, const BoxB& inner) {
+        return outer.min[0] <= inner.min[0] && outer.max[0] >= inner.max[0]
+            && outer.min[1] <= inner.min[1] && outer.max[1] >= inner.max[1]
+            && outer.min[2] <= inner.min[2] && outer.max[2] >= inner.max[2];
+    }
+
+    enum class plane_side {
+        outside,
+        inside,
+        crossing
+    };
+
+    // Tests the corner furthest along each plane's normal, which is outside only when the whole
+    // box is, and the nearest corner, which is inside only when the whole box is
+    template <typename Box>
+    plane_side classify(const Box& box, eastl::span<const float4::values> planes) {
+        plane_side side = plane_side::inside;
+        for (const float4::values& plane : planes) {
+            const float normal[3] = { plane.x(), plane.y(), plane.z() };
+            float far = plane.w();
+            float near = plane.w();
+            for (int axis = 0; axis < 3; ++axis) {
+                far += normal[axis] * (normal[axis] >= 0.0f ? box.max[axis] : box.min[axis]);
+                near += normal[axis] * (normal[axis] >= 0.0f ? box.min[axis] : box.max[axis]);
+            }
+            if (far < 0.0f) {
+                return plane_side::outside;
+            }
+            if (near < 0.0f) {
+                side = plane_side::crossing;
+            }
+        }
+        return side;
+    }
+}
+
+
+/////////////////////////////////////////////////////////////////////
+// Keys and nodes
+
+uint64_t loose_octree::key_of(uint32_t depth, const int3::values& cell) {
+    return (static_cast<uint64_t>(depth) << (CELL_BITS * 3))
+        | ((static_cast<uint64_t>(cell.x()) & CELL_MASK) << (CELL_BITS * 2))
+        | ((static_cast<uint64_t>(cell.y()) & CELL_MASK) << CELL_BITS)
+        | (static_cast<uint64_t>(cell.z()) & CELL_MASK);
+}
+
+uint32_t loose_octree::depth_of(uint64_t key) {
+    return static_cast<uint32_t>(key >> (CELL_BITS * 3));
+}
+
+int3::values loose_octree::cell_of(uint64_t key) {
+    return { static_cast<int>((key >> (CELL_BITS * 2)) & CELL_MASK), static_cast<int>((key >> CELL_BITS) & CELL_MASK), static_cast<int>(key & CELL_MASK) };
+}
+
+// Children are numbered by the low bit of their cell on each axis, x first
+uint64_t loose_octree::child_key(uint64_t key, uint32_t child) {
+    const int3::values cell = cell_of(key);
+    return key_of(depth_of(key) + 1, { (cell.x() << 1) | static_cast<int>(child & 1), (cell.y() << 1) | static_cast<int>((child >> 1) & 1), (cell.z() << 1) | static_cast<int>(child >> 2) });
+}
+
+loose_octree::loose_octree(const aabb& worldBounds, uint32_t maxDepth)
+    : mMaxDepth(maxDepth) {
+    ELOO_ASSERT_FATAL(maxDepth <= MAX_DEPTH, "Loose octree depth %u is past the limit of %u", maxDepth, MAX_DEPTH);
+
+    const float extent[3] = { worldBounds.max.x() - worldBounds.min.x(), worldBounds.max.y() - worldBounds.min.y(), worldBounds.max.z() - worldBounds.min.z() };
+    mOrigin[0] = worldBounds.min.x();
+    mOrigin[1] = worldBounds.min.y();
+    mOrigin[2] = worldBounds.min.z();
+    mSize = math::max(math::max(extent[0], extent[1]), extent[2]);
+    ELOO_ASSERT_FATAL(mSize > 0.0f, "Loose octree world bounds are empty");
+
+    clear();
+}
+
+void loose_octree::clear() {
+    mObjects.clear();
+    mNodes.clear();
+    mSlots.assign(INITIAL_SLOTS, { FREE_KEY, NONE });
+    mFreeObject = NONE;
+    mFreeNode = NONE;
+    mObjectCount = 0;
+    mNodeCount = 0;
+
+    const uint64_t rootKey = key_of(0, int3::ZERO);
+    for (int axis = 0; axis < 3; ++axis) {
+        mRootBounds.min[axis] = mOrigin[axis] - mSize * 0.5f;
+        mRootBounds.max[axis] = mOrigin[axis] + mSize * 1.5f;
+    }
+    acquire_node(rootKey);
+}
+
+aabb loose_octree::node_bounds(uint32_t depth, const int3::values& cell) const {
+    const box3 box = loose_bounds(key_of(depth, cell));
+    return { { box.min[0], box.min[1], box.min[2] }, { box.max[0], box.max[1], box.max[2] } };
+}
+
+loose_octree::box3 loose_octree::loose_bounds(uint64_t key) const {
+    const uint32_t depth = depth_of(key);
+    if (depth == 0) {
+        return mRootBounds;
+    }
+
+    const float cellSize = mSize / static_cast<float>(1u << depth);
+    const int3::values cell = cell_of(key);
+    const int coords[3] = { cell.x(), cell.y(), cell.z() };
+    box3 box;
+    for (int axis = 0; axis < 3; ++axis) {
+        box.min[axis] = mOrigin[axis] + (static_cast<float>(coords[axis]) - 0.5f) * cellSize;
+        box.max[axis] = box.min[axis] + 2.0f * cellSize;
+    }
+    return box;
+}
+
+// The deepest level whose cells are at least as large as the box, then up from there until the
+// loose bounds hold it, which only takes more than one try for boxes reaching outside the world
+uint64_t loose_octree::place(const box3& box) const {
+    const float extent = math::max(math::max(box.max[0] - box.min[0], box.max[1] - box.min[1]), box.max[2] - box.min[2]);
+    uint32_t depth = 0;
+    float cellSize = mSize;
+    while (depth < mMaxDepth && extent <= cellSize * 0.5f) {
+        cellSize *= 0.5f;
+        ++depth;
+    }
+
+    int coords[3];
+    const int cellCount = 1 << depth;
+    for (int axis = 0; axis < 3; ++axis) {
+        const float centre = (box.min[axis] + box.max[axis]) * 0.5f;
+        const float cell = math::floor((centre - mOrigin[axis]) / cellSize);
+        coords[axis] = cell < 0.0f ? 0 : (cell >= static_cast<float>(cellCount) ? cellCount - 1 : static_cast<int>(cell));
+    }
+
+    for (; depth > 0; --depth) {
+        const uint64_t key = key_of(depth, { coords[0], coords[1], coords[2] });
+        if (contains(loose_bounds(key), box)) {
+            return key;
+        }
+        for (int& coord : coords) {
+            coord >>= 1;
+        }
+    }
+    return key_of(0, int3::ZERO);
+}
+
+uint32_t loose_octree::find_node(uint64_t key) const {
+    const uint32_t mask = static_cast<uint32_t>(mSlots.size() - 1);
+    for (uint32_t i = hash_key(key) & mask;; i = (i + 1) & mask) {
+        if (mSlots[i].key == key) {
+            return mSlots[i].node;
+        }
+        if (mSlots[i].key == FREE_KEY) {
+            return NONE;
+        }
+    }
+}
+
+// Linear probing, doubling the table before it gets over half full
+void loose_octree::index_node(uint64_t key, uint32_t node) {
+    if ((mNodeCount + 1) * 2 > mSlots.size()) {
+        eastl::vector<slot> previous;
+        previous.swap(mSlots);
+        mSlots.assign(previous.size() * 2, { FREE_KEY, NONE });
+        for (const slot& entry : previous) {
+            if (entry.key != FREE_KEY) {
+                index_node(entry.key, entry.node);
+            }
+        }
+    }
+
+    const uint32_t mask = static_cast<uint32_t>(mSlots.size() - 1);
+    uint32_t i = hash_key(key) & mask;
+    while (mSlots[i].key != FREE_KEY) {
+        i = (i + 1) & mask;
+    }
+    mSlots[i] = { key, node };
+}
+
+// Later entries of the probe run are shifted back into the hole, unless that would move them
+// before their home slot, so lookups never need tombstones
+void loose_octree::unindex_node(uint64_t key) {
+    const uint32_t mask = static_cast<uint32_t>(mSlots.size() - 1);
+    uint32_t hole = hash_key(key) & mask;
+    while (mSlots[hole].key != key) {
+        hole = (hole + 1) & mask;
+    }
+
+    for (uint32_t i = (hole + 1) & mask; mSlots[i].key != FREE_KEY; i = (i + 1) & mask) {
+        const uint32_t home = hash_key(mSlots[i].key) & mask;
+        if (((i - home) & mask) >= ((i - hole) & mask)) {
+            mSlots[hole] = mSlots[i];
+            hole = i;
+        }
+    }
+    mSlots[hole].key = FREE_KEY;
+}
+
+// Creates the node and any missing ancestors, marking each in its parent's child mask
+uint32_t loose_octree::acquire_node(uint64_t key) {
+    const uint32_t existing = find_node(key);
+    if (existing != NONE) {
+        return existing;
+    }
+
+    const uint32_t depth = depth_of(key);
+    if (depth > 0) {
+        const int3::values cell = cell_of(key);
+        const uint32_t parent = acquire_node(key_of(depth - 1, { cell.x() >> 1, cell.y() >> 1, cell.z() >> 1 }));
+        mNodes[parent].childMask |= static_cast<uint8_t>(1u << ((cell.x() & 1) | ((cell.y() & 1) << 1) | ((cell.z() & 1) << 2)));
+    }
+
+    uint32_t index;
+    if (mFreeNode != NONE) {
+        index = mFreeNode;
+        mFreeNode = mNodes[index].firstObject;
+    }
+    else {
+        index = static_cast<uint32_t>(mNodes.size());
+        mNodes.emplace_back();
+    }
+    mNodes[index] = { key, NONE, 0, 0 };
+    index_node(key, index);
+    ++mNodeCount;
+    return index;
+}
+
+// Releases the node if it holds nothing, then its ancestors in turn. The root always stays
+void loose_octree::release_empty(uint32_t index) {
+    while (mNodes[index].objectCount == 0 && mNodes[index].childMask == 0) {
+        const uint64_t key = mNodes[index].key;
+        const uint32_t depth = depth_of(key);
+        if (depth == 0) {
+            return;
+        }
+
+        unindex_node(key);
+        mNodes[index].key = FREE_KEY;
+        mNodes[index].firstObject = mFreeNode;
+        mFreeNode = index;
+        --mNodeCount;
+
+        const int3::values cell = cell_of(key);
+        index = find_node(key_of(depth - 1, { cell.x() >> 1, cell.y() >> 1, cell.z() >> 1 }));
+        mNodes[index].childMask &= static_cast<uint8_t>(~(1u << ((cell.x() & 1) | ((cell.y() & 1) << 1) | ((cell.z() & 1) << 2))));
+    }
+}
+
+
+/////////////////////////////////////////////////////////////////////
+// Objects
+
+void loose_octree::link(uint32_t proxy, uint64_t key) {
+    const uint32_t index = acquire_node(key);
+    node& n = mNodes[index];
+    object& o = mObjects[proxy];
+    o.node = index;
+    o.prev = NONE;
+    o.next = n.firstObject;
+    if (n.firstObject != NONE) {
+        mObjects[n.firstObject].prev = proxy;
+    }
+    n.firstObject = proxy;
+    ++n.objectCount;
+
+    if (depth_of(key) == 0) {
+        for (int axis = 0; axis < 3; ++axis) {
+            mRootBounds.min[axis] = math::min(mRootBounds.min[axis], o.min[axis]);
+            mRootBounds.max[axis] = math::max(mRootBounds.max[axis], o.max[axis]);
+        }
+    }
+}
+
+void loose_octree::unlink(uint32_t proxy) {
+    object& o = mObjects[proxy];
+    node& n = mNodes[o.node];
+    if (o.prev != NONE) {
+        mObjects[o.prev].next = o.next;
+    }
+    else {
+        n.firstObject = o.next;
+    }
+    if (o.next != NONE) {
+        mObjects[o.next].prev = o.prev;
+    }
+    --n.objectCount;
+    release_empty(o.node);
+}
+
+uint32_t loose_octree::insert(const aabb& box, uint32_t userData) {
+    uint32_t proxy;
+    if (mFreeObject != NONE) {
+        proxy = mFreeObject;
+        mFreeObject = mObjects[proxy].next;
+    }
+    else {
+        proxy = static_cast<uint32_t>(mObjects.size());
+        mObjects.emplace_back();
+    }
+
+    object& o = mObjects[proxy];
+    o.min[0] = box.min.x();
+    o.min[1] = box.min.y();
+    o.min[2] = box.min.z();
+    o.max[0] = box.max.x();
+    o.max[1] = box.max.y();
+    o.max[2] = box.max.z();
+    o.userData = userData;
+
+    const box3 bounds = { { o.min[0], o.min[1], o.min[2] }, { o.max[0], o.max[1], o.max[2] } };
+    link(proxy, place(bounds));
+    ++mObjectCount;
+    return proxy;
+}
+
+void loose_octree::remove(uint32_t proxy) {
+    ELOO_ASSERT_FATAL(proxy < mObjects.size() && mObjects[proxy].node != NONE, "Invalid loose octree proxy %u", proxy);
+
+    unlink(proxy);
+    object& o = mObjects[proxy];
+    o.node = NONE;
+    o.next = mFreeObject;
+    mFreeObject = proxy;
+    --mObjectCount;
+}
+
+bool loose_octree::update(uint32_t proxy, const aabb& box) {
+    ELOO_ASSERT_FATAL(proxy < mObjects.size() && mObjects[proxy].node != NONE, "Invalid loose octree proxy %u", proxy);
+
+    const box3 bounds = { { box.min.x(), box.min.y(), box.min.z() }, { box.max.x(), box.max.y(), box.max.z() } };
+    const uint64_t key = place(bounds);
+    object& o = mObjects[proxy];
+    const bool moved = mNodes[o.node].key != key;
+    if (moved) {
+        unlink(proxy);
+    }
+
+    for (int axis = 0; axis < 3; ++axis) {
+        o.min[axis] = bounds.min[axis];
+        o.max[axis] = bounds.max[axis];
+    }
+
+    if (moved) {
+        link(proxy, key);
+    }
+    else if (depth_of(key) == 0) {
+        for (int axis = 0; axis < 3; ++axis) {
+            mRootBounds.min[axis] = math::min(mRootBounds.min[axis], o.min[axis]);
+            mRootBounds.max[axis] = math::max(mRootBounds.max[axis], o.max[axis]);
+        }
+    }
+    return moved;
+}
+
+uint32_t loose_octree::user_data(uint32_t proxy) const {
+    ELOO_ASSERT_FATAL(proxy < mObjects.size() && mObjects[proxy].node != NONE, "Invalid loose octree proxy %u", proxy);
+    return mObjects[proxy].userData;
+}
+
+aabb loose_octree::bounds(uint32_t proxy) const {
+    ELOO_ASSERT_FATAL(proxy < mObjects.size() && mObjects[proxy].node != NONE, "Invalid loose octree proxy %u", proxy);
+    const object& o = mObjects[proxy];
+    return { { o.min[0], o.min[1], o.min[2] }, { o.max[0], o.max[1], o.max[2] } };
+}
+
+
+/////////////////////////////////////////////////////////////////////
+// Queries
+
+// Calls 'nodeFn(index, bounds)' for every node reached from the root, descending into the
+// children of those it returns true for
+template <typename NodeFn>
+void loose_octree::walk(NodeFn nodeFn) const {
+    uint32_t stack[STACK_SIZE];
+    uint32_t top = 0;
+    stack[top++] = ROOT;
+    while (top > 0) {
+        const uint32_t index = stack[--top];
+        const node& n = mNodes[index];
+        if (!nodeFn(index, loose_bounds(n.key)) || n.childMask == 0) {
+            continue;
+        }
+
+        for (uint32_t child = 0; child < 8; ++child) {
+            if (n.childMask & (1u << child)) {
+                stack[top++] = find_node(child_key(n.key, child));
+            }
+        }
+    }
+}
+
+void loose_octree::report_subtree(uint32_t index, eastl::vector<uint32_t>& userData) const {
+    uint32_t stack[STACK_SIZE];
+    uint32_t top = 0;
+    stack[top++] = index;
+    while (top > 0) {
+        const node& n = mNodes[stack[--top]];
+        for (uint32_t proxy = n.firstObject; proxy != NONE; proxy = mObjects[proxy].next) {
+            userData.push_back(mObjects[proxy].userData);
+        }
+
+        for (uint32_t child = 0; child < 8; ++child) {
+            if (n.childMask & (1u << child)) {
+                stack[top++] = find_node(child_key(n.key, child));
+            }
+        }
+    }
+}
+
+size_t loose_octree::overlap(const aabb& box, eastl::vector<uint32_t>& userData) const {
+    const size_t initialSize = userData.size();
+    const box3 query = { { box.min.x(), box.min.y(), box.min.z() }, { box.max.x(), box.max.y(), box.max.z() } };
+    walk([&](uint32_t index, const box3& bounds) {
+        if (!overlaps(bounds, query)) {
+            return false;
+        }
+        for (uint32_t proxy = mNodes[index].firstObject; proxy != NONE; proxy = mObjects[proxy].next) {
+            if (overlaps(mObjects[proxy], query)) {
+                userData.push_back(mObjects[proxy].userData);
+            }
+        }
+        return true;
+    });
+    return userData.size() - initialSize;
+}
+
+size_t loose_octree::frustum(eastl::span<const float4::values> planes, eastl::vector<uint32_t>& userData) const {
+    const size_t initialSize = userData.size();
+    walk([&](uint32_t index, const box3& bounds) {
+        const plane_side side = classify(bounds, planes);
+        if (side == plane_side::outside) {
+            return false;
+        }
+        if (side == plane_side::inside) {
+            report_subtree(index, userData);
+            return false;
+        }
+        for (uint32_t proxy = mNodes[index].firstObject; proxy != NONE; proxy = mObjects[proxy].next) {
+            if (classify(mObjects[proxy], planes) != plane_side::outside) {
+                userData.push_back(mObjects[proxy].userData);
+            }
+        }
+        return true;
+    });
+    return userData.size() - initialSize;
+}
+
+// Nodes are visited nearest entry first among siblings and skipped once they start beyond the
+// query's tmax. 'visit(proxy)' is called for each object whose box the ray enters, and the walk
+// ends early when it returns true
+template <typename Visit>
+bool loose_octree::walk_front_to_back(raycast::ray& query, Visit visit) const {
+    const ray_terms terms(query);
+    const float rootDistance = entry_distance(mRootBounds, terms, query.tmin, query.tmax);
+    if (rootDistance == MISS) {
+        return false;
+    }
+
+    struct entry {
+        uint32_t index;
+        float distance;
+    };
+    entry stack[STACK_SIZE];
+    uint32_t top = 0;
+    stack[top++] = { ROOT, rootDistance };
+    while (top > 0) {
+        const entry next = stack[--top];
+        if (next.distance > query.tmax) {
+            continue;
+        }
+
+        const node& n = mNodes[next.index];
+        for (uint32_t proxy = n.firstObject; proxy != NONE; proxy = mObjects[proxy].next) {
+            if (entry_distance(mObjects[proxy], terms, query.tmin, query.tmax) != MISS && visit(proxy)) {
+                return true;
+            }
+        }
+        if (n.childMask == 0) {
+            continue;
+        }
+
+        // Children are sorted nearest first, then pushed in reverse so the nearest is on top
+        entry children[8];
+        uint32_t childCount = 0;
+        for (uint32_t child = 0; child < 8; ++child) {
+            if ((n.childMask & (1u << child)) == 0) {
+                continue;
+            }
+            const uint64_t childKey = child_key(n.key, child);
+            const float distance = entry_distance(loose_bounds(childKey), terms, query.tmin, query.tmax);
+            if (distance == MISS) {
+                continue;
+            }
+            uint32_t slot = childCount++;
+            for (; slot > 0 && children[slot - 1].distance > distance; --slot) {
+                children[slot] = children[slot - 1];
+            }
+            children[slot] = { find_node(childKey), distance };
+        }
+        while (childCount > 0) {
+            stack[top++] = children[--childCount];
+        }
+    }
+    return false;
+}
+
+bool loose_octree::raycast(const raycast::ray& query, const ray_test& test, batch_hit& closest) const {
+    closest = batch_hit();
+    raycast::ray local = query;
+    walk_front_to_back(local, [&](uint32_t proxy) {
+        const uint32_t userData = mObjects[proxy].userData;
+        raycast::result hit;
+        if (test(userData, local, hit) && (hit.distance < closest.hit.distance || userData < closest.index)) {
+            closest.index = userData;
+            closest.hit = hit;
+            local.shrink(hit.distance);
+        }
+        return false;
+    });
+    return closest.index != batch_hit::INVALID_INDEX;
+}
+
+bool loose_octree::occluded(const raycast::ray& query, const ray_test& test) const {
+    raycast::ray local = query;
+    return walk_front_to_back(local, [&](uint32_t proxy) {
+        raycast::result hit;
+        return test(mObjects[proxy].userData, local, hit);
+    });
+}
@@ -0,0 +1,513 @@
+#include "utility/palette.h"
+
+#include "maths/simd.h"
+#include "utility/parallel.h"
+
+#include <EASTL/algorithm.h>
+
+#include <cmath>
+
+using namespace eloo;
+using namespace eloo::math::simd;
+using namespace eloo::palette;
+
+namespace {
+    // Rows are handed to the workers in bands of roughly this many pixels
+    constexpr uint32_t BAND_PIXELS = 16384;
+
+    // Mapper buckets split each channel into 8 levels of 32 values
+    constexpr uint32_t BUCKET_SHIFT = 5;
+    constexpr uint32_t BUCKET_LEVELS = 256 >> BUCKET_SHIFT;
+    constexpr uint32_t BUCKET_COUNT = BUCKET_LEVELS * BUCKET_LEVELS * BUCKET_LEVELS * BUCKET_LEVELS;
+
+    // Median cut histogram keeps the top 5 bits of each channel
+    constexpr uint32_t HISTOGRAM_BITS = 5;
+    constexpr uint32_t HISTOGRAM_LEVELS = 1u << HISTOGRAM_BITS;
+    constexpr uint32_t HISTOGRAM_SIZE = 1u << (HISTOGRAM_BITS * 4);
+
+    // Padding lanes sit far enough away that they never win, while their distance stays finite
+    constexpr float FAR_CHANNEL = 1.0e6f;
+
+    constexpr uint8_t BAYER_8X8[8][8] = {
+        {  0, 32,  8, 40,  2, 34, 10, 42 },
+        { 48, 16, 56, 24, 50, 18, 58, 26 },
+        { 12, 44,  4, 36, 14, 46,  6, 38 },
+        { 60, 28, 52, 20, 62, 30, 54, 22 },
+        {  3, 35, 11, 43,  1, 33,  9, 41 },
+        { 51, 19, 59, 27, 49, 17, 57, 25 },
+        { 15, 47,  7, 39, 13, 45,  5, 37 },
+        { 63, 31, 55, 23, 61, 29, 53, 21 }
+    };
+
+    struct rgba8 {
+        int32_t c[4];
+
+        explicit rgba8(colour_t colour)
+            : c { colour::get_r(colour), colour::get_g(colour), colour::get_b(colour), colour::get_a(colour) } {}
+    };
+
+    ELOO_FORCE_INLINE uint32_t bucket_of(colour_t colour) {
+        const uint32_t r = colour::get_r(colour) >> BUCKET_SHIFT;
+        const uint32_t g = colour::get_g(colour) >> BUCKET_SHIFT;
+        const uint32_t b = colour::get_b(colour) >> BUCKET_SHIFT;
+        const uint32_t a = colour::get_a(colour) >> BUCKET_SHIFT;
+        return ((a * BUCKET_LEVELS + b) * BUCKET_LEVELS + g) * BUCKET_LEVELS + r;
+    }
+
+    ELOO_FORCE_INLINE uint8_t clamp_channel(int32_t value) {
+        return static_cast<uint8_t>(value < 0 ? 0 : (value > 255 ? 255 : value));
+    }
+
+    template <typename RowsFn>
+    void for_each_band(uint32_t rows, uint32_t width, RowsFn rowsFn) {
+        const size_t rowsPerBand = width < BAND_PIXELS ? BAND_PIXELS / width : 1;
+        parallel::parallel_for(rows, rowsPerBand, [&](size_t begin, size_t end) {
+            rowsFn(static_cast<uint32_t>(begin), static_cast<uint32_t>(end));
+        });
+    }
+
+
+    /////////////////////////////////////////////////////////////////////
+    // Median cut
+
+    struct histogram_entry {
+        uint8_t c[4];
+        uint32_t count;
+    };
+
+    struct box {
+        uint32_t first;
+        uint32_t last;
+        uint64_t pixels;
+        uint8_t lo[4];
+        uint8_t hi[4];
+
+        int widest_channel() const {
+            int widest = 0;
+            for (int ch = 1; ch < 4; ++ch) {
+                if (hi[ch] - lo[ch] > hi[widest] - lo[widest]) {
+                    widest = ch;
+                }
+            }
+            return widest;
+        }
+
+        // Population weighted extent, so large sparse boxes and small dense ones both get split
+        uint64_t score() const {
+            const int ch = widest_channel();
+            return pixels * static_cast<uint64_t>(hi[ch] - lo[ch]);
+        }
+    };
+
+    box make_box(const eastl::vector<histogram_entry>& entries, uint32_t first, uint32_t last) {
+        box result { first, last, 0, { 255, 255, 255, 255 }, { 0, 0, 0, 0 } };
+        for (uint32_t i = first; i < last; ++i) {
+            result.pixels += entries[i].count;
+            for (int ch = 0; ch < 4; ++ch) {
+                result.lo[ch] = eastl::min(result.lo[ch], entries[i].c[ch]);
+                result.hi[ch] = eastl::max(result.hi[ch], entries[i].c[ch]);
+            }
+        }
+        return result;
+    }
+
+    colour_t box_colour(const eastl::vector<histogram_entry>& entries, const box& cell) {
+        uint64_t sums[4] = {};
+        for (uint32_t i = cell.first; i < cell.last; ++i) {
+            for (int ch = 0; ch < 4; ++ch) {
+                sums[ch] += static_cast<uint64_t>(entries[i].c[ch]) * entries[i].count;
+            }
+        }
+        // Mean histogram level rescaled from [0, 31] to [0, 255]
+        uint8_t c[4];
+        for (int ch = 0; ch < 4; ++ch) {
+            const double mean = static_cast<double>(sums[ch]) / static_cast<double>(cell.pixels);
+            c[ch] = static_cast<uint8_t>(mean * (255.0 / (HISTOGRAM_LEVELS - 1)) + 0.5);
+        }
+        return colour::make_rgba(c[0], c[1], c[2], c[3]);
+    }
+
+    eastl::vector<colour_t> median_cut(const surface::const_view& src, uint32_t count) {
+        eastl::vector<uint32_t> histogram(HISTOGRAM_SIZE, 0u);
+        for (uint32_t y = 0; y < src.height; ++y) {
+            const colour_t* row = src.row(y);
+            for (uint32_t x = 0; x < src.width; ++x) {
+                const rgba8 px(row[x]);
+                constexpr int drop = 8 - HISTOGRAM_BITS;
+                ++histogram[
+                    (px.c[0] >> drop) |
+                    ((px.c[1] >> drop) << HISTOGRAM_BITS) |
+                    ((px.c[2] >> drop) << (HISTOGRAM_BITS * 2)) |
+                    ((px.c[3] >> drop) << (HISTOGRAM_BITS * 3))];
+            }
+        }
+
+        eastl::vector<histogram_entry> entries;
+        for (uint32_t key = 0; key < HISTOGRAM_SIZE; ++key) {
+            if (histogram[key] != 0) {
+                constexpr uint32_t mask = HISTOGRAM_LEVELS - 1;
+                entries.push_back({
+                    {
+                        static_cast<uint8_t>(key & mask),
+                        static_cast<uint8_t>((key >> HISTOGRAM_BITS) & mask),
+                        static_cast<uint8_t>((key >> (HISTOGRAM_BITS * 2)) & mask),
+                        static_cast<uint8_t>(key >> (HISTOGRAM_BITS * 3))
+                    },
+                    histogram[key]
+                });
+            }
+        }
+
+        eastl::vector<box> boxes;
+        boxes.push_back(make_box(entries, 0, static_cast<uint32_t>(entries.size())));
+        while (boxes.size() < count) {
+            size_t target = boxes.size();
+            uint64_t bestScore = 0;
+            for (size_t i = 0; i < boxes.size(); ++i) {
+                const uint64_t score = boxes[i].score();
+                if (score > bestScore) {
+                    bestScore = score;
+                    target = i;
+                }
+            }
+            if (target == boxes.size()) {
+                break; // Every box is down to a single histogram level
+            }
+
+            // Split at the population median along the widest channel, keeping both halves non-empty
+            const box cell = boxes[target];
+            const int ch = cell.widest_channel();
+            eastl::sort(entries.begin() + cell.first, entries.begin() + cell.last, [ch](const histogram_entry& lhs, const histogram_entry& rhs) {
+                return lhs.c[ch] < rhs.c[ch];
+            });
+            uint32_t split = cell.first;
+            uint64_t below = 0;
+            while (split < cell.last - 1 && below + entries[split].count <= cell.pixels / 2) {
+                below += entries[split++].count;
+            }
+            split = eastl::max(split, cell.first + 1);
+
+            boxes[target] = make_box(entries, cell.first, split);
+            boxes.push_back(make_box(entries, split, cell.last));
+        }
+
+        eastl::vector<colour_t> colours;
+        colours.reserve(boxes.size());
+        for (const box& cell : boxes) {
+            colours.push_back(box_colour(entries, cell));
+        }
+        return colours;
+    }
+
+
+    /////////////////////////////////////////////////////////////////////
+    // K-means
+
+    struct cluster_sums {
+        uint64_t c[4];
+        uint64_t pixels;
+    };
+
+    void refine_kmeans(const surface::const_view& src, eastl::vector<colour_t>& colours, uint32_t iterations) {
+        // Each band accumulates into its own slots, summed in band order so the result doesn't
+        // depend on how the bands were scheduled
+        const uint32_t rowsPerBand = src.width < BAND_PIXELS ? BAND_PIXELS / src.width : 1;
+        const uint32_t bandCount = (src.height + rowsPerBand - 1) / rowsPerBand;
+        eastl::vector<cluster_sums> bandSums;
+
+        for (uint32_t iteration = 0; iteration < iterations; ++iteration) {
+            const mapper palette(colours);
+            const size_t clusterCount = colours.size();
+            bandSums.assign(static_cast<size_t>(bandCount) * clusterCount, cluster_sums {});
+
+            parallel::parallel_for(bandCount, 1, [&](size_t begin, size_t end) {
+                for (size_t band = begin; band < end; ++band) {
+                    cluster_sums* sums = bandSums.data() + band * clusterCount;
+                    const uint32_t lastRow = eastl::min<uint32_t>(src.height, static_cast<uint32_t>(band + 1) * rowsPerBand);
+                    for (uint32_t y = static_cast<uint32_t>(band) * rowsPerBand; y < lastRow; ++y) {
+                        const colour_t* row = src.row(y);
+                        for (uint32_t x = 0; x < src.width; ++x) {
+                            const rgba8 px(row[x]);
+                            cluster_sums& cluster = sums[palette.nearest(row[x])];
+                            for (int ch = 0; ch < 4; ++ch) {
+                                cluster.c[ch] += static_cast<uint64_t>(px.c[ch]);
+                            }
+                            ++cluster.pixels;
+                        }
+                    }
+                }
+            });
+
+            bool changed = false;
+            for (size_t i = 0; i < clusterCount; ++i) {
+                cluster_sums total {};
+                for (uint32_t band = 0; band < bandCount; ++band) {
+                    const cluster_sums& sums = bandSums[band * clusterCount + i];
+                    for (int ch = 0; ch < 4; ++ch) {
+                        total.c[ch] += sums.c[ch];
+                    }
+                    total.pixels += sums.pixels;
+                }
+                if (total.pixels == 0) {
+                    continue; // Nothing mapped here, keep the old colour
+                }
+                uint8_t c[4];
+                for (int ch = 0; ch < 4; ++ch) {
+                    c[ch] = static_cast<uint8_t>((total.c[ch] + total.pixels / 2) / total.pixels);
+                }
+                const colour_t centre = colour::make_rgba(c[0], c[1], c[2], c[3]);
+                changed |= centre != colours[i];
+                colours[i] = centre;
+            }
+            if (!changed) {
+                break;
+            }
+        }
+    }
+
+
+    /////////////////////////////////////////////////////////////////////
+    // Pixel mapping
+
+    // Runs every pixel of 'src' through 'palette', calling emit(x, y, index)
+    template <typename EmitFn>
+    void map_pixels(const surface::const_view& src, const mapper& palette, dither mode, float strength, EmitFn emit) {
+        if (src.width == 0 || src.height == 0) {
+            return;
+        }
+
+        if (mode == dither::diffusion) {
+            // Serpentine Floyd-Steinberg over RGB, errors carried in two rows padded by one
+            // pixel on each side
+            const size_t stride = static_cast<size_t>(src.width) + 2;
+            eastl::vector<float> errors(stride * 3 * 2, 0.0f);
+            float* current = errors.data();
+            float* next = errors.data() + stride * 3;
+            const eastl::span<const colour_t> colours = palette.colours();
+
+            for (uint32_t y = 0; y < src.height; ++y) {
+                const colour_t* row = src.row(y);
+                const bool reverse = (y & 1u) != 0;
+                const int32_t step = reverse ? -1 : 1;
+                for (uint32_t i = 0; i < src.width; ++i) {
+                    const uint32_t x = reverse ? src.width - 1 - i : i;
+                    const rgba8 px(row[x]);
+                    float* err = current + (x + 1) * 3;
+                    float wanted[3];
+                    uint8_t c[3];
+                    for (int ch = 0; ch < 3; ++ch) {
+                        wanted[ch] = eastl::clamp(static_cast<float>(px.c[ch]) + err[ch], 0.0f, 255.0f);
+                        c[ch] = static_cast<uint8_t>(wanted[ch] + 0.5f);
+                    }
+                    const uint8_t index = palette.nearest(colour::make_rgba(c[0], c[1], c[2], static_cast<uint8_t>(px.c[3])));
+                    emit(x, y, index);
+
+                    const rgba8 chosen(colours[index]);
+                    float* ahead = err + step * 3;
+                    float* below = next + (x + 1) * 3;
+                    for (int ch = 0; ch < 3; ++ch) {
+                        const float e = (wanted[ch] - static_cast<float>(chosen.c[ch])) * strength;
+                        ahead[ch] += e * (7.0f / 16.0f);
+                        below[ch - step * 3] += e * (3.0f / 16.0f);
+                        below[ch] += e * (5.0f / 16.0f);
+                        below[ch + step * 3] += e * (1.0f / 16.0f);
+                    }
+                }
+                eastl::swap(current, next);
+                eastl::fill(next, next + stride * 3, 0.0f);
+            }
+            return;
+        }
+
+        // Ordered offsets span about one palette step, taking the palette as a uniform grid
+        int32_t offsets[8][8] = {};
+        if (mode == dither::ordered) {
+            const float amplitude = strength * 255.0f / std::cbrt(static_cast<float>(palette.size()));
+            for (int y = 0; y < 8; ++y) {
+                for (int x = 0; x < 8; ++x) {
+                    offsets[y][x] = static_cast<int32_t>(std::lround((BAYER_8X8[y][x] + 0.5f) / 64.0f * amplitude - amplitude * 0.5f));
+                }
+            }
+        }
+
+        for_each_band(src.height, src.width, [&](uint32_t rowBegin, uint32_t rowEnd) {
+            for (uint32_t y = rowBegin; y < rowEnd; ++y) {
+                const colour_t* row = src.row(y);
+                if (mode == dither::none) {
+                    for (uint32_t x = 0; x < src.width; ++x) {
+                        emit(x, y, palette.nearest(row[x]));
+                    }
+                    continue;
+                }
+                for (uint32_t x = 0; x < src.width; ++x) {
+                    const rgba8 px(row[x]);
+                    const int32_t offset = offsets[y & 7u][x & 7u];
+                    const colour_t shifted = colour::make_rgba(
+                        clamp_channel(px.c[0] + offset),
+                        clamp_channel(px.c[1] + offset),
+                        clamp_channel(px.c[2] + offset),
+                        static_cast<uint8_t>(px.c[3]));
+                    emit(x, y, palette.nearest(shifted));
+                }
+            }
+        });
+    }
+}
+
+
+/////////////////////////////////////////////////////////////////////
+// Palette construction
+
+eastl::vector<colour_t> palette::build(const surface::const_view& src, uint32_t count, method kind, uint32_t iterations) {
+    ELOO_ASSERT_FATAL(count >= 1 && count <= MAX_COLOURS, "Palettes hold between 1 and %u colours, %u requested", MAX_COLOURS, count);
+    if (src.width == 0 || src.height == 0) {
+        return {};
+    }
+
+    eastl::vector<colour_t> colours = median_cut(src, count);
+    if (kind == method::kmeans) {
+        refine_kmeans(src, colours, iterations);
+    }
+    return colours;
+}
+
+
+/////////////////////////////////////////////////////////////////////
+// Mapper
+
+mapper::mapper(eastl::span<const colour_t> colours)
+    : mColours(colours.begin(), colours.end()) {
+    ELOO_ASSERT_FATAL(!colours.empty() && colours.size() <= MAX_COLOURS, "Palettes hold between 1 and %u colours, got %zu", MAX_COLOURS, colours.size());
+
+    eastl::vector<rgba8> entries;
+    entries.reserve(mColours.size());
+    for (colour_t colour : mColours) {
+        entries.emplace_back(colour);
+    }
+
+    // An entry can only be nearest to some colour in a bucket if its closest approach to the
+    // bucket is within the best worst case distance of any entry
+    eastl::vector<eastl::vector<uint8_t>> lists(BUCKET_COUNT);
+    parallel::parallel_for(BUCKET_COUNT, 64, [&](size_t begin, size_t end) {
+        for (size_t bucketIndex = begin; bucketIndex < end; ++bucketIndex) {
+            int32_t lo[4];
+            int32_t hi[4];
+            for (int ch = 0; ch < 4; ++ch) {
+                const uint32_t level = (static_cast<uint32_t>(bucketIndex) >> (ch * 3)) & (BUCKET_LEVELS - 1);
+                lo[ch] = static_cast<int32_t>(level << BUCKET_SHIFT);
+                hi[ch] = lo[ch] + (1 << BUCKET_SHIFT) - 1;
+            }
+
+            int32_t bound = INT32_MAX;
+            for (const rgba8& entry : entries) {
+                int32_t farthest = 0;
+                for (int ch = 0; ch < 4; ++ch) {
+                    const int32_t d = eastl::max(entry.c[ch] - lo[ch], hi[ch] - entry.c[ch]);
+                    farthest += d * d;
+                }
+                bound = eastl::min(bound, farthest);
+            }
+
+            eastl::vector<uint8_t>& list = lists[bucketIndex];
+            for (size_t i = 0; i < entries.size(); ++i) {
+                int32_t closest = 0;
+                for (int ch = 0; ch < 4; ++ch) {
+                    const int32_t c = entries[i].c[ch];
+                    const int32_t d = c < lo[ch] ? lo[ch] - c : (c > hi[ch] ? c - hi[ch] : 0);
+                    closest += d * d;
+                }
+                if (closest <= bound) {
+                    list.push_back(static_cast<uint8_t>(i));
+                }
+            }
+        }
+    });
+
+    mBuckets.resize(BUCKET_COUNT);
+    for (uint32_t bucketIndex = 0; bucketIndex < BUCKET_COUNT; ++bucketIndex) {
+        const eastl::vector<uint8_t>& list = lists[bucketIndex];
+        const uint32_t blocks = static_cast<uint32_t>((list.size() + WIDTH - 1) / WIDTH);
+        mBuckets[bucketIndex] = { static_cast<uint32_t>(mCandidates.size()), blocks };
+        for (uint32_t block = 0; block < blocks; ++block) {
+            candidates& group = mCandidates.emplace_back();
+            for (uint32_t lane = 0; lane < WIDTH; ++lane) {
+                const size_t i = block * WIDTH + lane;
+                if (i < list.size()) {
+                    const rgba8& entry = entries[list[i]];
+                    group.r[lane] = static_cast<float>(entry.c[0]);
+                    group.g[lane] = static_cast<float>(entry.c[1]);
+                    group.b[lane] = static_cast<float>(entry.c[2]);
+                    group.a[lane] = static_cast<float>(entry.c[3]);
+                    group.index[lane] = static_cast<float>(list[i]);
+                } else {
+                    group.r[lane] = group.g[lane] = group.b[lane] = group.a[lane] = FAR_CHANNEL;
+                    group.index[lane] = static_cast<float>(list.back());
+                }
+            }
+        }
+    }
+}
+
+uint8_t mapper::nearest(colour_t colour) const {
+    // Channel differences are whole numbers, so the float distances are exact
+    const rgba8 px(colour);
+    const f32x4 r = set1(static_cast<float>(px.c[0]));
+    const f32x4 g = set1(static_cast<float>(px.c[1]));
+    const f32x4 b = set1(static_cast<float>(px.c[2]));
+    const f32x4 a = set1(static_cast<float>(px.c[3]));
+    f32x4 best = set1(3.0e38f);
+    f32x4 bestIndex = zero();
+
+    const bucket& cell = mBuckets[bucket_of(colour)];
+    const candidates* group = mCandidates.data() + cell.first;
+    for (uint32_t i = 0; i < cell.count; ++i, ++group) {
+        const f32x4 dr = r - load(group->r);
+        const f32x4 dg = g - load(group->g);
+        const f32x4 db = b - load(group->b);
+        const f32x4 da = a - load(group->a);
+        const f32x4 distance = madd(dr, dr, madd(dg, dg, madd(db, db, da * da)));
+        const f32x4 closer = cmp_lt(distance, best);
+        best = select(closer, distance, best);
+        bestIndex = select(closer, load(group->index), bestIndex);
+    }
+
+    // Candidates are in palette order and each lane keeps its first minimum, so breaking lane
+    // ties on the index keeps the lowest overall
+    float distances[WIDTH];
+    float indices[WIDTH];
+    store(distances, best);
+    store(indices, bestIndex);
+    int lane = 0;
+    for (int i = 1; i < WIDTH; ++i) {
+        if (distances[i] < distances[lane] || (distances[i] == distances[lane] && indices[i] < indices[lane])) {
+            lane = i;
+        }
+    }
+    return static_cast<uint8_t>(indices[lane]);
+}
+
+void mapper::nearest(eastl::span<const colour_t> in, eastl::span<uint8_t> out) const {
+    ELOO_ASSERT_FATAL(in.size() == out.size(), "Palette lookup spans differ in length (%zu vs %zu)", in.size(), out.size());
+    for (size_t i = 0; i < in.size(); ++i) {
+        out[i] = nearest(in[i]);
+    }
+}
+
+
+/////////////////////////////////////////////////////////////////////
+// Remapping
+
+void palette::remap(const surface::const_view& src, const mapper& palette, eastl::span<uint8_t> indices, dither mode, float strength) {
+    ELOO_ASSERT_FATAL(indices.size() == static_cast<size_t>(src.width) * src.height,
+        "Index buffer holds %zu entries for a %ux%u image", indices.size(), src.width, src.height);
+    map_pixels(src, palette, mode, strength, [&](uint32_t x, uint32_t y, uint8_t index) {
+        indices[static_cast<size_t>(y) * src.width + x] = index;
+    });
+}
+
+void palette::apply(const surface::view& target, const mapper& palette, dither mode, float strength) {
+    const eastl::span<const colour_t> colours = palette.colours();
+    map_pixels(target, palette, mode, strength, [&](uint32_t x, uint32_t y, uint8_t index) {
+        target.at(x, y) = colours[index];
+    });
+}
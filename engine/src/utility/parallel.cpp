@@ -0,0 +1,146 @@
+#include "utility/parallel.h"
+
+#include <EASTL/atomic.h>
+#include <EASTL/vector.h>
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+using namespace eloo;
+
+namespace {
+    thread_local bool tInsideRange = false;
+
+    class thread_pool {
+    public:
+        thread_pool() {
+            const unsigned hardware = std::thread::hardware_concurrency();
+            const size_t workers = hardware > 1 ? hardware - 1 : 0;
+            mThreads.reserve(workers);
+            for (size_t i = 0; i < workers; ++i) {
+                mThreads.push_back(std::thread([this] { worker_loop(); }));
+            }
+        }
+
+        ~thread_pool() {
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                mStopping = true;
+            }
+            mWake.notify_all();
+            for (std::thread& thread : mThreads) {
+                thread.join();
+            }
+        }
+
+        size_t thread_count() const { return mThreads.size() + 1; }
+
+        std::mutex& submit_mutex() { return mSubmitMutex; }
+
+        // Caller must hold the submit mutex
+        void run(size_t count, size_t grain, const parallel::range_fn& fn) {
+            const size_t chunks = (count + grain - 1) / grain;
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                mFn = &fn;
+                mCount = count;
+                mGrain = grain;
+                mChunkCount = chunks;
+                mNextChunk.store(0);
+                mRemaining.store(chunks);
+                ++mGeneration;
+            }
+            mWake.notify_all();
+
+            run_chunks();
+
+            std::unique_lock<std::mutex> lock(mMutex);
+            mDone.wait(lock, [this] { return mRemaining.load() == 0 && mActiveWorkers == 0; });
+            mFn = nullptr;
+        }
+
+    private:
+        void run_chunks() {
+            tInsideRange = true;
+            size_t chunk;
+            while ((chunk = mNextChunk.fetch_add(1)) < mChunkCount) {
+                const size_t begin = chunk * mGrain;
+                const size_t end = begin + mGrain < mCount ? begin + mGrain : mCount;
+                (*mFn)(begin, end);
+                if (mRemaining.fetch_sub(1) == 1) {
+                    std::lock_guard<std::mutex> lock(mMutex);
+                    mDone.notify_all();
+                }
+            }
+            tInsideRange = false;
+        }
+
+        void worker_loop() {
+            uint64_t seenGeneration = 0;
+            std::unique_lock<std::mutex> lock(mMutex);
+            for (;;) {
+                mWake.wait(lock, [&] { return mStopping || (mFn != nullptr && mGeneration != seenGeneration); });
+                if (mStopping) {
+                    return;
+                }
+                seenGeneration = mGeneration;
+                ++mActiveWorkers;
+                lock.unlock();
+
+                run_chunks();
+
+                lock.lock();
+                if (--mActiveWorkers == 0) {
+                    mDone.notify_all();
+                }
+            }
+        }
+
+    private:
+        eastl::vector<std::thread> mThreads;
+        std::mutex mSubmitMutex;
+        std::mutex mMutex;
+        std::condition_variable mWake;
+        std::condition_variable mDone;
+
+        const parallel::range_fn* mFn = nullptr;
+        size_t mCount = 0;
+        size_t mGrain = 1;
+        size_t mChunkCount = 0;
+        uint64_t mGeneration = 0;
+        size_t mActiveWorkers = 0;
+        bool mStopping = false;
+        eastl::atomic<size_t> mNextChunk { 0 };
+        eastl::atomic<size_t> mRemaining { 0 };
+    };
+
+    thread_pool& pool() {
+        static thread_pool gPool;
+        return gPool;
+    }
+}
+
+size_t parallel::worker_count() {
+    return pool().thread_count();
+}
+
+void parallel::parallel_for(size_t count, size_t grain, const range_fn& fn) {
+    if (count == 0) {
+        return;
+    }
+    grain = grain > 0 ? grain : 1;
+
+    // Nested or contended calls, and ranges that fit in a single chunk, aren't worth waking the pool for
+    if (tInsideRange || count <= grain || pool().thread_count() == 1) {
+        fn(0, count);
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(pool().submit_mutex(), std::try_to_lock);
+    if (!lock.owns_lock()) {
+        fn(0, count);
+        return;
+    }
+    pool().run(count, grain, fn);
+}
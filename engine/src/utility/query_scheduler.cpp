@@ -0,0 +1,260 @@
+#include "utility/query_scheduler.h"
+
+#include "maths/math.h"
+#include "utility/parallel.h"
+
+#include <chrono>
+
+using namespace eloo;
+using namespace eloo::raycast;
+
+namespace {
+    constexpr uint32_t NO_CALLBACK = UINT32_MAX;
+
+    // Queries are handed to the workers in runs of this many
+    constexpr size_t QUERY_GRAIN = 64;
+
+    // Origins are placed on a grid of this many cells per axis for the Morton order, which with
+    // the octant and kind fills a 32 bit sort key
+    constexpr uint32_t MORTON_LEVELS = 1u << 9;
+    constexpr uint32_t KIND_SHIFT = 27;
+    constexpr uint32_t OCTANT_SHIFT = 29;
+
+    int64_t now_ns() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    float to_ms(int64_t ns) {
+        return static_cast<float>(static_cast<double>(ns) * 1e-6);
+    }
+
+    // Spreads the low 10 bits of 'v' out so two zero bits follow each one
+    uint32_t expand_bits(uint32_t v) {
+        v = (v * 0x00010001u) & 0xFF0000FFu;
+        v = (v * 0x00000101u) & 0x0F00F00Fu;
+        v = (v * 0x00000011u) & 0xC30C30C3u;
+        v = (v * 0x00000005u) & 0x49249249u;
+        return v;
+    }
+}
+
+
+/////////////////////////////////////////////////////////////////////
+// Queueing
+
+void query_scheduler::frame::clear() {
+    queries.clear();
+    callbacks.clear();
+    order.clear();
+    results.clear();
+}
+
+query_scheduler::query_scheduler(const scene& target)
+    : mScene(target) {
+}
+
+void query_scheduler::set_scene(const scene& target) {
+    mScene = target;
+}
+
+void query_scheduler::reserve(size_t queries) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mPending.queries.reserve(queries);
+}
+
+query_scheduler::query_id query_scheduler::raycast(const ray& query, query_result* slot) {
+    return push(spherecast::sweep(query, 0.0f), query_kind::raycast, slot, nullptr);
+}
+
+query_scheduler::query_id query_scheduler::raycast(const ray& query, const callback& onResult) {
+    return push(spherecast::sweep(query, 0.0f), query_kind::raycast, nullptr, &onResult);
+}
+
+query_scheduler::query_id query_scheduler::occluded(const ray& query, query_result* slot) {
+    return push(spherecast::sweep(query, 0.0f), query_kind::occluded, slot, nullptr);
+}
+
+query_scheduler::query_id query_scheduler::occluded(const ray& query, const callback& onResult) {
+    return push(spherecast::sweep(query, 0.0f), query_kind::occluded, nullptr, &onResult);
+}
+
+query_scheduler::query_id query_scheduler::spherecast(const spherecast::sweep& query, query_result* slot) {
+    return push(query, query_kind::spherecast, slot, nullptr);
+}
+
+query_scheduler::query_id query_scheduler::spherecast(const spherecast::sweep& query, const callback& onResult) {
+    return push(query, query_kind::spherecast, nullptr, &onResult);
+}
+
+query_scheduler::query_id query_scheduler::push(const spherecast::sweep& query, query_kind kind, query_result* slot, const callback* onResult) {
+    const int64_t queuedAt = now_ns();
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    ELOO_ASSERT_FATAL(mPending.queries.size() < INVALID_QUERY, "Too many queries queued for one flush");
+
+    uint32_t callbackIndex = NO_CALLBACK;
+    if (onResult != nullptr) {
+        callbackIndex = static_cast<uint32_t>(mPending.callbacks.size());
+        mPending.callbacks.push_back(*onResult);
+    }
+
+    const query_id id = static_cast<query_id>(mPending.queries.size());
+    mPending.queries.push_back({ query, kind, slot, callbackIndex, queuedAt });
+    return id;
+}
+
+size_t query_scheduler::pending() const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mPending.queries.size();
+}
+
+const query_result& query_scheduler::result(query_id id) const {
+    ELOO_ASSERT_FATAL(id < mFlushed.results.size(), "Query %u was not run by the last flush", id);
+    return mFlushed.results[id];
+}
+
+
+/////////////////////////////////////////////////////////////////////
+// Flushing
+
+// Keys are the direction octant, then the kind, then the origin's Morton code within the bounds
+// of this frame's origins. The radix sort is stable, so equal keys run in queue order
+void query_scheduler::sort(frame& batch) const {
+    const uint32_t count = static_cast<uint32_t>(batch.queries.size());
+
+    float lo[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+    float hi[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+    for (const queued_query& queued : batch.queries) {
+        const float origin[3] = { queued.query.origin.x(), queued.query.origin.y(), queued.query.origin.z() };
+        for (int axis = 0; axis < 3; ++axis) {
+            lo[axis] = math::min(lo[axis], origin[axis]);
+            hi[axis] = math::max(hi[axis], origin[axis]);
+        }
+    }
+    float scale[3];
+    for (int axis = 0; axis < 3; ++axis) {
+        const float extent = hi[axis] - lo[axis];
+        scale[axis] = extent > 0.0f ? static_cast<float>(MORTON_LEVELS) / extent : 0.0f;
+    }
+
+    eastl::vector<uint32_t> keys(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        const spherecast::sweep& query = batch.queries[i].query;
+        uint32_t key = (query.sign[0] | (query.sign[1] << 1) | (query.sign[2] << 2)) << OCTANT_SHIFT;
+        key |= static_cast<uint32_t>(batch.queries[i].kind) << KIND_SHIFT;
+        const float origin[3] = { query.origin.x(), query.origin.y(), query.origin.z() };
+        for (int axis = 0; axis < 3; ++axis) {
+            const uint32_t cell = static_cast<uint32_t>((origin[axis] - lo[axis]) * scale[axis]);
+            key |= expand_bits(cell < MORTON_LEVELS ? cell : MORTON_LEVELS - 1) << (2 - axis);
+        }
+        keys[i] = key;
+    }
+
+    batch.order.resize(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        batch.order[i] = i;
+    }
+
+    eastl::vector<uint32_t> keysOut(count);
+    eastl::vector<uint32_t> orderOut(count);
+    for (uint32_t shift = 0; shift < 32; shift += 8) {
+        uint32_t offsets[256] = {};
+        for (uint32_t i = 0; i < count; ++i) {
+            ++offsets[(keys[i] >> shift) & 0xFFu];
+        }
+        uint32_t sum = 0;
+        for (uint32_t& offset : offsets) {
+            const uint32_t digitCount = offset;
+            offset = sum;
+            sum += digitCount;
+        }
+        for (uint32_t i = 0; i < count; ++i) {
+            const uint32_t slot = offsets[(keys[i] >> shift) & 0xFFu]++;
+            keysOut[slot] = keys[i];
+            orderOut[slot] = batch.order[i];
+        }
+        keys.swap(keysOut);
+        batch.order.swap(orderOut);
+    }
+}
+
+// The queue is swapped out first, so callbacks that queue more queries add them to the next flush
+void query_scheduler::flush() {
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        eastl::swap(mPending, mFlushed);
+        mPending.clear();
+    }
+
+    mStats = stats();
+    frame& batch = mFlushed;
+    const size_t count = batch.queries.size();
+    if (count == 0) {
+        batch.clear();
+        return;
+    }
+
+    const int64_t sortStart = now_ns();
+    sort(batch);
+
+    const int64_t executeStart = now_ns();
+    batch.results.clear();
+    batch.results.resize(count);
+    parallel::parallel_for(count, QUERY_GRAIN, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const uint32_t index = batch.order[i];
+            const queued_query& queued = batch.queries[index];
+            query_result& result = batch.results[index];
+            switch (queued.kind) {
+            case query_kind::raycast:
+                result.hit = mScene.raycast && mScene.raycast(queued.query, result.closest);
+                break;
+            case query_kind::occluded:
+                result.hit = mScene.occluded && mScene.occluded(queued.query);
+                break;
+            case query_kind::spherecast:
+                result.hit = mScene.spherecast && mScene.spherecast(queued.query, result.closest);
+                break;
+            }
+        }
+    });
+
+    const int64_t deliverStart = now_ns();
+    int64_t totalLatency = 0;
+    int64_t maxLatency = 0;
+    for (size_t i = 0; i < count; ++i) {
+        const queued_query& queued = batch.queries[i];
+        const query_result& result = batch.results[i];
+        if (queued.slot != nullptr) {
+            *queued.slot = result;
+        }
+        if (queued.callbackIndex != NO_CALLBACK) {
+            batch.callbacks[queued.callbackIndex](static_cast<query_id>(i), result);
+        }
+
+        switch (queued.kind) {
+        case query_kind::raycast:
+            ++mStats.raycasts;
+            break;
+        case query_kind::occluded:
+            ++mStats.occlusions;
+            break;
+        case query_kind::spherecast:
+            ++mStats.spherecasts;
+            break;
+        }
+        mStats.hits += result.hit ? 1 : 0;
+
+        // Results are available from the end of the execute pass, whenever a query is delivered
+        const int64_t latency = deliverStart - queued.queuedAt;
+        totalLatency += latency;
+        maxLatency = latency > maxLatency ? latency : maxLatency;
+    }
+    const int64_t deliverEnd = now_ns();
+
+    mStats.sortMs = to_ms(executeStart - sortStart);
+    mStats.executeMs = to_ms(deliverStart - executeStart);
+    mStats.deliverMs = to_ms(deliverEnd - deliverStart);
+    mStats.meanLatencyMs = to_ms(totalLatency / static_cast<int64_t>(count));
+    mStats.maxLatencyMs = to_ms(maxLatency);
+}
@@ -119,7 +119,11 @@ namespace eloo::raycast {
 
         const float3::values Q = math::vector::cross(T, edge1);
         const float v = math::vector::dot(rayDir, Q) * invDet;
-        float t = math::vector::dot(rayDir, Q) * invDet;
+        if (v < 0.0f || u + v > 1.0f) {
+            return false;
+        }
+
+        const float t = math::vector::dot(edge2, Q) * invDet;
         if (t < 0.0f || t > rayLength) {
             return false;
         }
@@ -311,7 +315,7 @@ namespace eloo::raycast {
         // 2) Sphere caps
         const auto testSphere = [&](const float3::values& sphereOrigin) {
             result sphereHit;
-            const bool didHit = test_sphere(rayOrigin, rayDir, sphereOrigin, radius, sphereHit);
+            const bool didHit = test_sphere(rayOrigin, rayDir, rayLength, sphereOrigin, radius, sphereHit);
             if (didHit && (hit.distance < 0.0f || sphereHit.distance < hit.distance)) {
                 hit = sphereHit;
             }
@@ -320,7 +324,7 @@ namespace eloo::raycast {
         testSphere(P0);
         testSphere(P1);
 
-        return hit.distance >= 0.0f;
+        return hit.distance < FLT_MAX;
     }
     bool test_capsule(ELOO_RAYCAST_PARAMS_2, FLOAT3_DECLARE_PARAMS(origin), float height, float radius, result& hit) {
         return test_capsule(ELOO_RAYCAST_FORWARD_PARAMS_2, { FLOAT3_FORWARD_PARAMS(origin) }, height, radius, hit);
@@ -331,4 +335,209 @@ namespace eloo::raycast {
     bool test_capsule(ELOO_RAYCAST_PARAMS_4, FLOAT3_DECLARE_PARAMS(origin), float height, float radius, result& hit) {
         return test_capsule(ELOO_RAYCAST_FORWARD_PARAMS_4, { FLOAT3_FORWARD_PARAMS(origin) }, height, radius, hit);
     }
+
+
+    /////////////////////////////////////////////////////////////////////
+    // Prepared rays
+
+    ray::ray(const float3::values& rayOrigin, const float3::values& rayDir, float rayLength)
+        : origin(rayOrigin)
+        , direction(rayDir)
+        , invDirection(1.0f / rayDir.x(), 1.0f / rayDir.y(), 1.0f / rayDir.z())
+        , sign { std::signbit(rayDir.x()) ? 1u : 0u, std::signbit(rayDir.y()) ? 1u : 0u, std::signbit(rayDir.z()) ? 1u : 0u }
+        , dirLengthSqr(math::vector::dot(rayDir, rayDir))
+        , tmax(rayLength) {
+    }
+
+    // Primitives without a dedicated path reuse the tests above bounded by tmax, discarding hits
+    // that land before tmin
+    bool test_plane(const ray& query, const float4::values& plane, result& hit) {
+        if (!test_plane(query.origin, query.direction, query.tmax, plane, hit) || !query.accepts(hit.distance)) {
+            hit = result();
+            return false;
+        }
+        return true;
+    }
+
+    bool test_quad(const ray& query, const float4::values& quad, float width, float height, result& hit) {
+        if (!test_quad(query.origin, query.direction, query.tmax, quad, width, height, hit) || !query.accepts(hit.distance)) {
+            hit = result();
+            return false;
+        }
+        return true;
+    }
+
+    bool test_tri(const ray& query, const float3::values& vertex1, const float3::values& vertex2, const float3::values& vertex3, result& hit) {
+        if (!test_tri(query.origin, query.direction, query.tmax, vertex1, vertex2, vertex3, hit) || !query.accepts(hit.distance)) {
+            hit = result();
+            return false;
+        }
+        return true;
+    }
+
+    bool test_aabb(const ray& query, const float3::values& min, const float3::values& max, result& hit) {
+        hit = result();
+
+        // The sign bits pick the near and far slab directly, so there is nothing to swap
+        const float3::values bounds[2] = { min, max };
+        const float txNear = (bounds[query.sign[0]].x() - query.origin.x()) * query.invDirection.x();
+        const float txFar = (bounds[1 - query.sign[0]].x() - query.origin.x()) * query.invDirection.x();
+        const float tyNear = (bounds[query.sign[1]].y() - query.origin.y()) * query.invDirection.y();
+        const float tyFar = (bounds[1 - query.sign[1]].y() - query.origin.y()) * query.invDirection.y();
+        if (txNear > tyFar || tyNear > txFar) {
+            return false;
+        }
+        const float tzNear = (bounds[query.sign[2]].z() - query.origin.z()) * query.invDirection.z();
+        const float tzFar = (bounds[1 - query.sign[2]].z() - query.origin.z()) * query.invDirection.z();
+
+        const float tNear = math::max(math::max(txNear, tyNear), tzNear);
+        const float tFar = math::min(math::min(txFar, tyFar), tzFar);
+        if (tNear > tFar) {
+            return false;
+        }
+
+        const float t = tNear >= query.tmin ? tNear : tFar;
+        if (!query.accepts(t)) {
+            return false;
+        }
+
+        hit.distance = t;
+        hit.position = query.origin + query.direction * t;
+        return true;
+    }
+
+    bool test_sphere(const ray& query, const float3::values& origin, float radius, result& hit) {
+        hit = result();
+
+        const float3::values L = query.origin - origin;
+        const float b = 2.0f * math::vector::dot(L, query.direction);
+        const float c = math::vector::dot(L, L) - radius * radius;
+        const float disc = b * b - 4.0f * query.dirLengthSqr * c;
+        if (disc < 0.0f) {
+            return false;
+        }
+
+        const float sqrtDisc = math::sqrt(disc);
+        const float t0 = (-b - sqrtDisc) / (2.0f * query.dirLengthSqr);
+        const float t1 = (-b + sqrtDisc) / (2.0f * query.dirLengthSqr);
+        const float t = t0 > query.tmin ? t0 : t1;
+        if (!query.accepts(t)) {
+            return false;
+        }
+
+        hit.distance = t;
+        hit.position = query.origin + query.direction * t;
+        return true;
+    }
+
+    bool test_ellipsoid(const ray& query, const float3::values& origin, const float3::values& radii, result& hit) {
+        if (!test_ellipsoid(query.origin, query.direction, query.tmax, origin, radii, hit) || !query.accepts(hit.distance)) {
+            hit = result();
+            return false;
+        }
+        return true;
+    }
+
+    bool test_capsule(const ray& query, const float3::values& origin, float height, float radius, result& hit) {
+        if (!test_capsule(query.origin, query.direction, query.tmax, origin, height, radius, hit) || !query.accepts(hit.distance)) {
+            hit = result();
+            return false;
+        }
+        return true;
+    }
+
+
+    /////////////////////////////////////////////////////////////////////
+    // Any-hit tests
+
+    // Each follows its prepared test above step for step, so the two always agree, but stops
+    // once the distance is known to be in range
+    bool occluded_plane(const ray& query, const float4::values& plane) {
+        const float3::values normRayDir = math::vector::normalize(query.direction);
+        const float3::values planeNormal = math::vector::normalize(plane.xyz());
+
+        const float denom = math::vector::dot(normRayDir, planeNormal);
+        if (math::is_close_to_zero(math::abs(denom))) {
+            return false;
+        }
+
+        const float t = -(math::vector::dot(query.origin, planeNormal) + plane.w()) / denom;
+        return t >= 0.0f && t <= query.tmax && query.accepts(t);
+    }
+
+    bool occluded_quad(const ray& query, const float4::values& quad, float width, float height) {
+        result hit;
+        return test_quad(query, quad, width, height, hit);
+    }
+
+    bool occluded_tri(const ray& query, const float3::values& vertex1, const float3::values& vertex2, const float3::values& vertex3) {
+        const float3::values edge1 = vertex2 - vertex1;
+        const float3::values edge2 = vertex3 - vertex1;
+        const float3::values P = math::vector::cross(query.direction, edge2);
+        const float det = math::vector::dot(edge1, P);
+        if (math::is_close_to_zero(det)) {
+            return false;
+        }
+
+        const float invDet = 1.0f / det;
+        const float3::values T = query.origin - vertex1;
+        const float u = math::vector::dot(T, P) * invDet;
+        if (u < 0.0f || u > 1.0f) {
+            return false;
+        }
+
+        const float3::values Q = math::vector::cross(T, edge1);
+        const float v = math::vector::dot(query.direction, Q) * invDet;
+        if (v < 0.0f || u + v > 1.0f) {
+            return false;
+        }
+
+        const float t = math::vector::dot(edge2, Q) * invDet;
+        return t >= 0.0f && t <= query.tmax && query.accepts(t);
+    }
+
+    bool occluded_aabb(const ray& query, const float3::values& min, const float3::values& max) {
+        const float3::values bounds[2] = { min, max };
+        const float txNear = (bounds[query.sign[0]].x() - query.origin.x()) * query.invDirection.x();
+        const float txFar = (bounds[1 - query.sign[0]].x() - query.origin.x()) * query.invDirection.x();
+        const float tyNear = (bounds[query.sign[1]].y() - query.origin.y()) * query.invDirection.y();
+        const float tyFar = (bounds[1 - query.sign[1]].y() - query.origin.y()) * query.invDirection.y();
+        if (txNear > tyFar || tyNear > txFar) {
+            return false;
+        }
+        const float tzNear = (bounds[query.sign[2]].z() - query.origin.z()) * query.invDirection.z();
+        const float tzFar = (bounds[1 - query.sign[2]].z() - query.origin.z()) * query.invDirection.z();
+
+        const float tNear = math::max(math::max(txNear, tyNear), tzNear);
+        const float tFar = math::min(math::min(txFar, tyFar), tzFar);
+        if (tNear > tFar) {
+            return false;
+        }
+        return query.accepts(tNear >= query.tmin ? tNear : tFar);
+    }
+
+    bool occluded_sphere(const ray& query, const float3::values& origin, float radius) {
+        const float3::values L = query.origin - origin;
+        const float b = 2.0f * math::vector::dot(L, query.direction);
+        const float c = math::vector::dot(L, L) - radius * radius;
+        const float disc = b * b - 4.0f * query.dirLengthSqr * c;
+        if (disc < 0.0f) {
+            return false;
+        }
+
+        const float sqrtDisc = math::sqrt(disc);
+        const float t0 = (-b - sqrtDisc) / (2.0f * query.dirLengthSqr);
+        const float t1 = (-b + sqrtDisc) / (2.0f * query.dirLengthSqr);
+        return query.accepts(t0 > query.tmin ? t0 : t1);
+    }
+
+    bool occluded_ellipsoid(const ray& query, const float3::values& origin, const float3::values& radii) {
+        result hit;
+        return test_ellipsoid(query, origin, radii, hit);
+    }
+
+    bool occluded_capsule(const ray& query, const float3::values& origin, float height, float radius) {
+        result hit;
+        return test_capsule(query, origin, height, radius, hit);
+    }
 };
\ No newline at end of file
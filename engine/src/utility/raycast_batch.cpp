@@ -0,0 +1,407 @@
+#include "utility/raycast_batch.h"
+
+#include "maths/simd.h"
+#include "utility/spherecast.h"
+
+#include <cfloat>
+
+using namespace eloo;
+using namespace eloo::math::simd;
+using namespace eloo::raycast;
+
+namespace {
+    // Lanes [0, count) set, for the partial group at the end of a set
+    alignas(16) constexpr int32_t TAIL_MASKS[WIDTH + 1][WIDTH] = {
+        {  0,  0,  0,  0 },
+        { -1,  0,  0,  0 },
+        { -1, -1,  0,  0 },
+        { -1, -1, -1,  0 },
+        { -1, -1, -1, -1 }
+    };
+
+    alignas(16) constexpr int32_t LANE_OFFSETS[WIDTH] = { 0, 1, 2, 3 };
+
+    // Terms shared by every primitive tested against one ray
+    struct ray_terms {
+        f32x4 originX, originY, originZ;
+        f32x4 dirX, dirY, dirZ;
+        f32x4 invDirX, invDirY, invDirZ;
+        f32x4 tmin;
+        f32x4 tmax;
+        f32x4 dirDot;
+        f32x4 twoDirDot;
+        f32x4 fourDirDot;
+
+        explicit ray_terms(const ray& query) {
+            const float a = query.dirLengthSqr;
+            originX = set1(query.origin.x());
+            originY = set1(query.origin.y());
+            originZ = set1(query.origin.z());
+            dirX = set1(query.direction.x());
+            dirY = set1(query.direction.y());
+            dirZ = set1(query.direction.z());
+            invDirX = set1(query.invDirection.x());
+            invDirY = set1(query.invDirection.y());
+            invDirZ = set1(query.invDirection.z());
+            tmin = set1(query.tmin);
+            tmax = set1(query.tmax);
+            dirDot = set1(a);
+            twoDirDot = set1(2.0f * a);
+            fourDirDot = set1(4.0f * a);
+        }
+    };
+
+    // Loads lanes [first, first + lanes) of 'values', zero filling past the end
+    ELOO_FORCE_INLINE f32x4 fetch(const float* values, size_t first, size_t lanes) {
+        if (lanes == WIDTH) {
+            return load(values + first);
+        }
+        alignas(16) float tmp[WIDTH] = {};
+        for (size_t lane = 0; lane < lanes; ++lane) {
+            tmp[lane] = values[first + lane];
+        }
+        return load(tmp);
+    }
+
+    ELOO_FORCE_INLINE f32x4 in_range(f32x4 t, const ray_terms& ray) {
+        return bit_and(cmp_ge(t, ray.tmin), cmp_le(t, ray.tmax));
+    }
+
+    struct sphere_kernel {
+        const ray_terms& ray;
+        const float* x;
+        const float* y;
+        const float* z;
+        const float* radius;
+        f32x4 inflate;
+
+        // Lanes that hit, with their distances in 't'
+        ELOO_FORCE_INLINE f32x4 operator()(size_t first, size_t lanes, f32x4& t) const {
+            const f32x4 r = fetch(radius, first, lanes) + inflate;
+            const f32x4 lx = ray.originX - fetch(x, first, lanes);
+            const f32x4 ly = ray.originY - fetch(y, first, lanes);
+            const f32x4 lz = ray.originZ - fetch(z, first, lanes);
+            const f32x4 b = set1(2.0f) * (lx * ray.dirX + ly * ray.dirY + lz * ray.dirZ);
+            const f32x4 c = (lx * lx + ly * ly + lz * lz) - r * r;
+            const f32x4 disc = b * b - ray.fourDirDot * c;
+            const f32x4 valid = bit_and(cmp_ge(disc, zero()), as_f32(load_i32(TAIL_MASKS[lanes])));
+            if (movemask(valid) == 0) {
+                return valid;
+            }
+
+            const f32x4 sqrtDisc = math::simd::sqrt(math::simd::max(disc, zero()));
+            const f32x4 t0 = (zero() - b - sqrtDisc) / ray.twoDirDot;
+            const f32x4 t1 = (zero() - b + sqrtDisc) / ray.twoDirDot;
+            t = select(cmp_gt(t0, ray.tmin), t0, t1);
+            return bit_and(valid, in_range(t, ray));
+        }
+    };
+
+    struct aabb_kernel {
+        const ray_terms& ray;
+        const float* minX;
+        const float* minY;
+        const float* minZ;
+        const float* maxX;
+        const float* maxY;
+        const float* maxZ;
+        f32x4 inflate;
+
+        ELOO_FORCE_INLINE f32x4 operator()(size_t first, size_t lanes, f32x4& t) const {
+            const f32x4 x0 = (fetch(minX, first, lanes) - inflate - ray.originX) * ray.invDirX;
+            const f32x4 x1 = (fetch(maxX, first, lanes) + inflate - ray.originX) * ray.invDirX;
+            const f32x4 y0 = (fetch(minY, first, lanes) - inflate - ray.originY) * ray.invDirY;
+            const f32x4 y1 = (fetch(maxY, first, lanes) + inflate - ray.originY) * ray.invDirY;
+            const f32x4 z0 = (fetch(minZ, first, lanes) - inflate - ray.originZ) * ray.invDirZ;
+            const f32x4 z1 = (fetch(maxZ, first, lanes) + inflate - ray.originZ) * ray.invDirZ;
+            const f32x4 tmin = math::simd::max(math::simd::max(math::simd::min(x0, x1), math::simd::min(y0, y1)), math::simd::min(z0, z1));
+            const f32x4 tmax = math::simd::min(math::simd::min(math::simd::max(x0, x1), math::simd::max(y0, y1)), math::simd::max(z0, z1));
+
+            t = select(cmp_ge(tmin, ray.tmin), tmin, tmax);
+            const f32x4 valid = bit_and(cmp_le(tmin, tmax), as_f32(load_i32(TAIL_MASKS[lanes])));
+            return bit_and(valid, in_range(t, ray));
+        }
+    };
+
+    ELOO_FORCE_INLINE float3::values hit_position(const float3::values& origin, const float3::values& dir, float t) {
+        return origin + dir * t;
+    }
+
+    // Tracks the nearest hit per lane, each lane keeping the first of equal distances
+    struct closest_lanes {
+        f32x4 distance = set1(FLT_MAX);
+        i32x4 index = set1_i32(-1);
+
+        ELOO_FORCE_INLINE void update(f32x4 hitMask, f32x4 t, size_t first) {
+            const f32x4 closer = bit_and(hitMask, bit_or(cmp_lt(t, distance), bit_and(cmp_eq(t, distance), as_f32(cmp_eq(index, set1_i32(-1))))));
+            distance = select(closer, t, distance);
+            index = select(as_i32(closer), set1_i32(static_cast<int32_t>(first)) + load_i32(LANE_OFFSETS), index);
+        }
+    };
+
+    template <typename Kernel>
+    bool find_closest(size_t count, const Kernel& kernel, const float3::values& origin, const float3::values& dir, batch_hit& closest) {
+        // Two independent groups per step so their latencies overlap
+        closest_lanes even;
+        closest_lanes odd;
+        size_t first = 0;
+        for (; first + WIDTH * 2 <= count; first += WIDTH * 2) {
+            f32x4 t0 = zero();
+            f32x4 t1 = zero();
+            const f32x4 hit0 = kernel(first, WIDTH, t0);
+            const f32x4 hit1 = kernel(first + WIDTH, WIDTH, t1);
+            even.update(hit0, t0, first);
+            odd.update(hit1, t1, first + WIDTH);
+        }
+        for (; first < count; first += WIDTH) {
+            const size_t lanes = count - first < WIDTH ? count - first : WIDTH;
+            f32x4 t = zero();
+            const f32x4 hit = kernel(first, lanes, t);
+            even.update(hit, t, first);
+        }
+
+        alignas(16) float distances[WIDTH * 2];
+        alignas(16) int32_t indices[WIDTH * 2];
+        store(distances, even.distance);
+        store(distances + WIDTH, odd.distance);
+        store_i32(indices, even.index);
+        store_i32(indices + WIDTH, odd.index);
+
+        closest = batch_hit();
+        for (int lane = 0; lane < WIDTH * 2; ++lane) {
+            if (indices[lane] < 0) {
+                continue;
+            }
+            const uint32_t index = static_cast<uint32_t>(indices[lane]);
+            if (closest.index == batch_hit::INVALID_INDEX || distances[lane] < closest.hit.distance ||
+                (distances[lane] == closest.hit.distance && index < closest.index)) {
+                closest.index = index;
+                closest.hit.distance = distances[lane];
+            }
+        }
+        if (closest.index == batch_hit::INVALID_INDEX) {
+            return false;
+        }
+        closest.hit.position = hit_position(origin, dir, closest.hit.distance);
+        return true;
+    }
+
+    template <typename Kernel>
+    size_t find_all(size_t count, const Kernel& kernel, const float3::values& origin, const float3::values& dir, eastl::vector<batch_hit>& hits) {
+        const size_t before = hits.size();
+        const auto emit = [&](f32x4 hitMask, f32x4 t, size_t first) {
+            const int bits = movemask(hitMask);
+            if (bits == 0) {
+                return;
+            }
+            alignas(16) float distances[WIDTH];
+            store(distances, t);
+            for (int lane = 0; lane < WIDTH; ++lane) {
+                if (bits & (1 << lane)) {
+                    batch_hit& hit = hits.emplace_back();
+                    hit.index = static_cast<uint32_t>(first + lane);
+                    hit.hit.distance = distances[lane];
+                    hit.hit.position = hit_position(origin, dir, distances[lane]);
+                }
+            }
+        };
+
+        size_t first = 0;
+        for (; first + WIDTH * 2 <= count; first += WIDTH * 2) {
+            f32x4 t0 = zero();
+            f32x4 t1 = zero();
+            const f32x4 hit0 = kernel(first, WIDTH, t0);
+            const f32x4 hit1 = kernel(first + WIDTH, WIDTH, t1);
+            emit(hit0, t0, first);
+            emit(hit1, t1, first + WIDTH);
+        }
+        for (; first < count; first += WIDTH) {
+            const size_t lanes = count - first < WIDTH ? count - first : WIDTH;
+            f32x4 t = zero();
+            emit(kernel(first, lanes, t), t, first);
+        }
+        return hits.size() - before;
+    }
+
+    template <typename Kernel>
+    bool find_any(size_t count, const Kernel& kernel) {
+        size_t first = 0;
+        for (; first + WIDTH * 2 <= count; first += WIDTH * 2) {
+            f32x4 t0 = zero();
+            f32x4 t1 = zero();
+            const f32x4 hit0 = kernel(first, WIDTH, t0);
+            const f32x4 hit1 = kernel(first + WIDTH, WIDTH, t1);
+            if (movemask(bit_or(hit0, hit1)) != 0) {
+                return true;
+            }
+        }
+        for (; first < count; first += WIDTH) {
+            const size_t lanes = count - first < WIDTH ? count - first : WIDTH;
+            f32x4 t = zero();
+            if (movemask(kernel(first, lanes, t)) != 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void check_set(const sphere_set& spheres) {
+        ELOO_ASSERT_FATAL(spheres.y.size() == spheres.size() && spheres.z.size() == spheres.size() && spheres.radius.size() == spheres.size(),
+            "Sphere set components differ in length");
+    }
+
+    void check_set(const aabb_set& boxes) {
+        const size_t count = boxes.size();
+        ELOO_ASSERT_FATAL(boxes.minY.size() == count && boxes.minZ.size() == count &&
+            boxes.maxX.size() == count && boxes.maxY.size() == count && boxes.maxZ.size() == count,
+            "AABB set components differ in length");
+    }
+
+    sphere_kernel make_kernel(const ray_terms& ray, const sphere_set& spheres, float inflate) {
+        check_set(spheres);
+        return { ray, spheres.x.data(), spheres.y.data(), spheres.z.data(), spheres.radius.data(), set1(inflate) };
+    }
+
+    aabb_kernel make_kernel(const ray_terms& ray, const aabb_set& boxes, float inflate) {
+        check_set(boxes);
+        return { ray, boxes.minX.data(), boxes.minY.data(), boxes.minZ.data(), boxes.maxX.data(), boxes.maxY.data(), boxes.maxZ.data(), set1(inflate) };
+    }
+
+    template <typename Set>
+    bool closest_in(const ray& query, float inflate, const Set& set, batch_hit& closest) {
+        const ray_terms ray(query);
+        return find_closest(set.size(), make_kernel(ray, set, inflate), query.origin, query.direction, closest);
+    }
+
+    template <typename Set>
+    bool any_in(const ray& query, float inflate, const Set& set) {
+        const ray_terms ray(query);
+        return find_any(set.size(), make_kernel(ray, set, inflate));
+    }
+
+    template <typename Set>
+    size_t all_in(const ray& query, float inflate, const Set& set, eastl::vector<batch_hit>& hits) {
+        const ray_terms ray(query);
+        return find_all(set.size(), make_kernel(ray, set, inflate), query.origin, query.direction, hits);
+    }
+}
+
+
+/////////////////////////////////////////////////////////////////////
+// Raycasts
+
+bool raycast::test_spheres(const ray& query, const sphere_set& spheres, batch_hit& closest) {
+    return closest_in(query, 0.0f, spheres, closest);
+}
+bool raycast::test_spheres(const float3::values& rayOrigin, const float3::values& rayDir, float rayLength, const sphere_set& spheres, batch_hit& closest) {
+    return closest_in(ray(rayOrigin, rayDir, rayLength), 0.0f, spheres, closest);
+}
+bool raycast::test_spheres(const float3::values& rayOrigin, const float3::values& rayDir, const sphere_set& spheres, batch_hit& closest) {
+    return closest_in(ray(rayOrigin, rayDir), 0.0f, spheres, closest);
+}
+size_t raycast::test_spheres(const ray& query, const sphere_set& spheres, eastl::vector<batch_hit>& hits) {
+    return all_in(query, 0.0f, spheres, hits);
+}
+size_t raycast::test_spheres(const float3::values& rayOrigin, const float3::values& rayDir, float rayLength, const sphere_set& spheres, eastl::vector<batch_hit>& hits) {
+    return all_in(ray(rayOrigin, rayDir, rayLength), 0.0f, spheres, hits);
+}
+size_t raycast::test_spheres(const float3::values& rayOrigin, const float3::values& rayDir, const sphere_set& spheres, eastl::vector<batch_hit>& hits) {
+    return all_in(ray(rayOrigin, rayDir), 0.0f, spheres, hits);
+}
+bool raycast::occluded_spheres(const ray& query, const sphere_set& spheres) {
+    return any_in(query, 0.0f, spheres);
+}
+bool raycast::occluded_spheres(const float3::values& rayOrigin, const float3::values& rayDir, float rayLength, const sphere_set& spheres) {
+    return any_in(ray(rayOrigin, rayDir, rayLength), 0.0f, spheres);
+}
+bool raycast::occluded_spheres(const float3::values& rayOrigin, const float3::values& rayDir, const sphere_set& spheres) {
+    return any_in(ray(rayOrigin, rayDir), 0.0f, spheres);
+}
+
+bool raycast::test_aabbs(const ray& query, const aabb_set& boxes, batch_hit& closest) {
+    return closest_in(query, 0.0f, boxes, closest);
+}
+bool raycast::test_aabbs(const float3::values& rayOrigin, const float3::values& rayDir, float rayLength, const aabb_set& boxes, batch_hit& closest) {
+    return closest_in(ray(rayOrigin, rayDir, rayLength), 0.0f, boxes, closest);
+}
+bool raycast::test_aabbs(const float3::values& rayOrigin, const float3::values& rayDir, const aabb_set& boxes, batch_hit& closest) {
+    return closest_in(ray(rayOrigin, rayDir), 0.0f, boxes, closest);
+}
+size_t raycast::test_aabbs(const ray& query, const aabb_set& boxes, eastl::vector<batch_hit>& hits) {
+    return all_in(query, 0.0f, boxes, hits);
+}
+size_t raycast::test_aabbs(const float3::values& rayOrigin, const float3::values& rayDir, float rayLength, const aabb_set& boxes, eastl::vector<batch_hit>& hits) {
+    return all_in(ray(rayOrigin, rayDir, rayLength), 0.0f, boxes, hits);
+}
+size_t raycast::test_aabbs(const float3::values& rayOrigin, const float3::values& rayDir, const aabb_set& boxes, eastl::vector<batch_hit>& hits) {
+    return all_in(ray(rayOrigin, rayDir), 0.0f, boxes, hits);
+}
+bool raycast::occluded_aabbs(const ray& query, const aabb_set& boxes) {
+    return any_in(query, 0.0f, boxes);
+}
+bool raycast::occluded_aabbs(const float3::values& rayOrigin, const float3::values& rayDir, float rayLength, const aabb_set& boxes) {
+    return any_in(ray(rayOrigin, rayDir, rayLength), 0.0f, boxes);
+}
+bool raycast::occluded_aabbs(const float3::values& rayOrigin, const float3::values& rayDir, const aabb_set& boxes) {
+    return any_in(ray(rayOrigin, rayDir), 0.0f, boxes);
+}
+
+
+/////////////////////////////////////////////////////////////////////
+// Spherecasts
+
+bool spherecast::test_spheres(const sweep& query, const sphere_set& spheres, batch_hit& closest) {
+    return closest_in(query, query.radius, spheres, closest);
+}
+bool spherecast::test_spheres(const float3::values& rayOrigin, const float3::values& rayDir, float rayLength, float castRadius, const sphere_set& spheres, batch_hit& closest) {
+    return closest_in(ray(rayOrigin, rayDir, rayLength), castRadius, spheres, closest);
+}
+bool spherecast::test_spheres(const float3::values& rayOrigin, const float3::values& rayDir, float castRadius, const sphere_set& spheres, batch_hit& closest) {
+    return closest_in(ray(rayOrigin, rayDir), castRadius, spheres, closest);
+}
+size_t spherecast::test_spheres(const sweep& query, const sphere_set& spheres, eastl::vector<batch_hit>& hits) {
+    return all_in(query, query.radius, spheres, hits);
+}
+size_t spherecast::test_spheres(const float3::values& rayOrigin, const float3::values& rayDir, float rayLength, float castRadius, const sphere_set& spheres, eastl::vector<batch_hit>& hits) {
+    return all_in(ray(rayOrigin, rayDir, rayLength), castRadius, spheres, hits);
+}
+size_t spherecast::test_spheres(const float3::values& rayOrigin, const float3::values& rayDir, float castRadius, const sphere_set& spheres, eastl::vector<batch_hit>& hits) {
+    return all_in(ray(rayOrigin, rayDir), castRadius, spheres, hits);
+}
+bool spherecast::occluded_spheres(const sweep& query, const sphere_set& spheres) {
+    return any_in(query, query.radius, spheres);
+}
+bool spherecast::occluded_spheres(const float3::values& rayOrigin, const float3::values& rayDir, float rayLength, float castRadius, const sphere_set& spheres) {
+    return any_in(ray(rayOrigin, rayDir, rayLength), castRadius, spheres);
+}
+bool spherecast::occluded_spheres(const float3::values& rayOrigin, const float3::values& rayDir, float castRadius, const sphere_set& spheres) {
+    return any_in(ray(rayOrigin, rayDir), castRadius, spheres);
+}
+
+bool spherecast::test_aabbs(const sweep& query, const aabb_set& boxes, batch_hit& closest) {
+    return closest_in(query, query.radius, boxes, closest);
+}
+bool spherecast::test_aabbs(const float3::values& rayOrigin, const float3::values& rayDir, float rayLength, float castRadius, const aabb_set& boxes, batch_hit& closest) {
+    return closest_in(ray(rayOrigin, rayDir, rayLength), castRadius, boxes, closest);
+}
+bool spherecast::test_aabbs(const float3::values& rayOrigin, const float3::values& rayDir, float castRadius, const aabb_set& boxes, batch_hit& closest) {
+    return closest_in(ray(rayOrigin, rayDir), castRadius, boxes, closest);
+}
+size_t spherecast::test_aabbs(const sweep& query, const aabb_set& boxes, eastl::vector<batch_hit>& hits) {
+    return all_in(query, query.radius, boxes, hits);
+}
+size_t spherecast::test_aabbs(const float3::values& rayOrigin, const float3::values& rayDir, float rayLength, float castRadius, const aabb_set& boxes, eastl::vector<batch_hit>& hits) {
+    return all_in(ray(rayOrigin, rayDir, rayLength), castRadius, boxes, hits);
+}
+size_t spherecast::test_aabbs(const float3::values& rayOrigin, const float3::values& rayDir, float castRadius, const aabb_set& boxes, eastl::vector<batch_hit>& hits) {
+    return all_in(ray(rayOrigin, rayDir), castRadius, boxes, hits);
+}
+bool spherecast::occluded_aabbs(const sweep& query, const aabb_set& boxes) {
+    return any_in(query, query.radius, boxes);
+}
+bool spherecast::occluded_aabbs(const float3::values& rayOrigin, const float3::values& rayDir, float rayLength, float castRadius, const aabb_set& boxes) {
+    return any_in(ray(rayOrigin, rayDir, rayLength), castRadius, boxes);
+}
+bool spherecast::occluded_aabbs(const float3::values& rayOrigin, const float3::values& rayDir, float castRadius, const aabb_set& boxes) {
+    return any_in(ray(rayOrigin, rayDir), castRadius, boxes);
+}
@@ -0,0 +1,270 @@
+#include "utility/raycast_packet.h"
+
+#include "maths/constants.h"
+#include "maths/simd.h"
+
+using namespace eloo;
+using namespace eloo::math::simd;
+using namespace eloo::raycast;
+
+namespace {
+    // All-ones lanes for each 4 bit active mask
+    alignas(16) constexpr int32_t LANE_MASKS[16][4] = {
+        {  0,  0,  0,  0 }, { -1,  0,  0,  0 }, {  0, -1,  0,  0 }, { -1, -1,  0,  0 },
+        {  0,  0, -1,  0 }, { -1,  0, -1,  0 }, {  0, -1, -1,  0 }, { -1, -1, -1,  0 },
+        {  0,  0,  0, -1 }, { -1,  0,  0, -1 }, {  0, -1,  0, -1 }, { -1, -1,  0, -1 },
+        {  0,  0, -1, -1 }, { -1,  0, -1, -1 }, {  0, -1, -1, -1 }, { -1, -1, -1, -1 }
+    };
+
+    struct ray_lanes {
+        f32x4 originX, originY, originZ;
+        f32x4 dirX, dirY, dirZ;
+        f32x4 length;
+    };
+
+    ELOO_FORCE_INLINE f32x4 dot(f32x4 ax, f32x4 ay, f32x4 az, f32x4 bx, f32x4 by, f32x4 bz) {
+        return ax * bx + ay * by + az * bz;
+    }
+
+    template <int Lanes>
+    ELOO_FORCE_INLINE ray_lanes load_lanes(const packet<Lanes>& rays, int first) {
+        return {
+            load(rays.originX + first), load(rays.originY + first), load(rays.originZ + first),
+            load(rays.dirX + first), load(rays.dirY + first), load(rays.dirZ + first),
+            load(rays.length + first)
+        };
+    }
+
+    // Runs 'groupFn' over each group of 4 lanes with any active ray. It returns the mask of lanes
+    // that hit and fills in their distances, from which the results are written
+    template <int Lanes, typename GroupFn>
+    uint32_t for_each_group(const packet<Lanes>& rays, packet_result<Lanes>& hits, GroupFn groupFn) {
+        uint32_t mask = 0;
+        for (int first = 0; first < Lanes; first += WIDTH) {
+            const uint32_t activeBits = (rays.active >> first) & 0xFu;
+            if (activeBits == 0) {
+                continue;
+            }
+
+            const ray_lanes ray = load_lanes(rays, first);
+            f32x4 t = zero();
+            const uint32_t hitBits = static_cast<uint32_t>(movemask(groupFn(ray, as_f32(load_i32(LANE_MASKS[activeBits])), t)));
+            if (hitBits == 0) {
+                continue;
+            }
+
+            alignas(16) float distance[WIDTH];
+            alignas(16) float x[WIDTH];
+            alignas(16) float y[WIDTH];
+            alignas(16) float z[WIDTH];
+            store(distance, t);
+            store(x, madd(ray.dirX, t, ray.originX));
+            store(y, madd(ray.dirY, t, ray.originY));
+            store(z, madd(ray.dirZ, t, ray.originZ));
+            for (int lane = 0; lane < WIDTH; ++lane) {
+                if (hitBits & (1u << lane)) {
+                    result& hit = hits.hits[first + lane];
+                    hit.distance = distance[lane];
+                    hit.position = float3::values(x[lane], y[lane], z[lane]);
+                }
+            }
+            mask |= hitBits << first;
+        }
+        hits.mask = mask;
+        return mask;
+    }
+
+    // As for_each_group, but only gathers the mask of lanes that hit
+    template <int Lanes, typename GroupFn>
+    uint32_t hit_mask(const packet<Lanes>& rays, GroupFn groupFn) {
+        uint32_t mask = 0;
+        for (int first = 0; first < Lanes; first += WIDTH) {
+            const uint32_t activeBits = (rays.active >> first) & 0xFu;
+            if (activeBits == 0) {
+                continue;
+            }
+
+            f32x4 t = zero();
+            mask |= static_cast<uint32_t>(movemask(groupFn(load_lanes(rays, first), as_f32(load_i32(LANE_MASKS[activeBits])), t))) << first;
+        }
+        return mask;
+    }
+
+    // Keeps lanes whose chosen distance lies within [0, length]
+    ELOO_FORCE_INLINE f32x4 in_range(f32x4 t, f32x4 length) {
+        return bit_and(cmp_ge(t, zero()), cmp_le(t, length));
+    }
+}
+
+
+/////////////////////////////////////////////////////////////////////
+// AABB
+
+namespace {
+    struct aabb_kernel {
+        f32x4 minX, minY, minZ;
+        f32x4 maxX, maxY, maxZ;
+
+        aabb_kernel(const float3::values& min, const float3::values& max)
+            : minX(set1(min.x())), minY(set1(min.y())), minZ(set1(min.z()))
+            , maxX(set1(max.x())), maxY(set1(max.y())), maxZ(set1(max.z())) {
+        }
+
+        ELOO_FORCE_INLINE f32x4 operator()(const ray_lanes& ray, f32x4 active, f32x4& t) const {
+            const f32x4 x0 = (minX - ray.originX) / ray.dirX;
+            const f32x4 x1 = (maxX - ray.originX) / ray.dirX;
+            const f32x4 y0 = (minY - ray.originY) / ray.dirY;
+            const f32x4 y1 = (maxY - ray.originY) / ray.dirY;
+            const f32x4 z0 = (minZ - ray.originZ) / ray.dirZ;
+            const f32x4 z1 = (maxZ - ray.originZ) / ray.dirZ;
+            const f32x4 tmin = math::simd::max(math::simd::max(math::simd::min(x0, x1), math::simd::min(y0, y1)), math::simd::min(z0, z1));
+            const f32x4 tmax = math::simd::min(math::simd::min(math::simd::max(x0, x1), math::simd::max(y0, y1)), math::simd::max(z0, z1));
+
+            // Rays starting inside report the exit point, as the single ray test does
+            t = select(cmp_ge(tmin, zero()), tmin, tmax);
+            return bit_and(bit_and(active, cmp_le(tmin, tmax)), in_range(t, ray.length));
+        }
+    };
+}
+
+template <int Lanes>
+uint32_t raycast::test_aabb(const packet<Lanes>& rays, const float3::values& min, const float3::values& max, packet_result<Lanes>& hits) {
+    return for_each_group(rays, hits, aabb_kernel(min, max));
+}
+
+template <int Lanes>
+uint32_t raycast::occluded_aabb(const packet<Lanes>& rays, const float3::values& min, const float3::values& max) {
+    return hit_mask(rays, aabb_kernel(min, max));
+}
+
+
+/////////////////////////////////////////////////////////////////////
+// Sphere
+
+namespace {
+    struct sphere_kernel {
+        f32x4 centreX, centreY, centreZ;
+        f32x4 radiusSqr;
+
+        sphere_kernel(const float3::values& origin, float radius)
+            : centreX(set1(origin.x())), centreY(set1(origin.y())), centreZ(set1(origin.z()))
+            , radiusSqr(set1(radius * radius)) {
+        }
+
+        ELOO_FORCE_INLINE f32x4 operator()(const ray_lanes& ray, f32x4 active, f32x4& t) const {
+            const f32x4 lx = ray.originX - centreX;
+            const f32x4 ly = ray.originY - centreY;
+            const f32x4 lz = ray.originZ - centreZ;
+            const f32x4 a = dot(ray.dirX, ray.dirY, ray.dirZ, ray.dirX, ray.dirY, ray.dirZ);
+            const f32x4 b = set1(2.0f) * dot(lx, ly, lz, ray.dirX, ray.dirY, ray.dirZ);
+            const f32x4 c = dot(lx, ly, lz, lx, ly, lz) - radiusSqr;
+            const f32x4 disc = b * b - set1(4.0f) * a * c;
+            const f32x4 valid = bit_and(active, cmp_ge(disc, zero()));
+            if (movemask(valid) == 0) {
+                return valid;
+            }
+
+            const f32x4 sqrtDisc = math::simd::sqrt(math::simd::max(disc, zero()));
+            const f32x4 twoA = a + a;
+            const f32x4 t0 = (zero() - b - sqrtDisc) / twoA;
+            const f32x4 t1 = (zero() - b + sqrtDisc) / twoA;
+            t = select(cmp_gt(t0, zero()), t0, select(cmp_ge(t1, zero()), t1, set1(-1.0f)));
+            return bit_and(valid, in_range(t, ray.length));
+        }
+    };
+}
+
+template <int Lanes>
+uint32_t raycast::test_sphere(const packet<Lanes>& rays, const float3::values& origin, float radius, packet_result<Lanes>& hits) {
+    return for_each_group(rays, hits, sphere_kernel(origin, radius));
+}
+
+template <int Lanes>
+uint32_t raycast::occluded_sphere(const packet<Lanes>& rays, const float3::values& origin, float radius) {
+    return hit_mask(rays, sphere_kernel(origin, radius));
+}
+
+
+/////////////////////////////////////////////////////////////////////
+// Triangle
+
+namespace {
+    struct tri_kernel {
+        f32x4 e1x, e1y, e1z;
+        f32x4 e2x, e2y, e2z;
+        f32x4 v1x, v1y, v1z;
+
+        tri_kernel(const float3::values& vertex1, const float3::values& vertex2, const float3::values& vertex3) {
+            const float3::values edge1 = vertex2 - vertex1;
+            const float3::values edge2 = vertex3 - vertex1;
+            e1x = set1(edge1.x());
+            e1y = set1(edge1.y());
+            e1z = set1(edge1.z());
+            e2x = set1(edge2.x());
+            e2y = set1(edge2.y());
+            e2z = set1(edge2.z());
+            v1x = set1(vertex1.x());
+            v1y = set1(vertex1.y());
+            v1z = set1(vertex1.z());
+        }
+
+        ELOO_FORCE_INLINE f32x4 operator()(const ray_lanes& ray, f32x4 active, f32x4& t) const {
+            const f32x4 one = set1(1.0f);
+
+            // P = dir x edge2
+            const f32x4 px = ray.dirY * e2z - ray.dirZ * e2y;
+            const f32x4 py = ray.dirZ * e2x - ray.dirX * e2z;
+            const f32x4 pz = ray.dirX * e2y - ray.dirY * e2x;
+            const f32x4 det = dot(e1x, e1y, e1z, px, py, pz);
+            f32x4 valid = bit_and(active, cmp_gt(math::simd::abs(det), set1(math::f32::CLOSE_ABS_TOLERANCE)));
+
+            const f32x4 invDet = one / det;
+            const f32x4 tx = ray.originX - v1x;
+            const f32x4 ty = ray.originY - v1y;
+            const f32x4 tz = ray.originZ - v1z;
+            const f32x4 u = dot(tx, ty, tz, px, py, pz) * invDet;
+            valid = bit_and(valid, bit_and(cmp_ge(u, zero()), cmp_le(u, one)));
+            if (movemask(valid) == 0) {
+                return valid;
+            }
+
+            // Q = T x edge1
+            const f32x4 qx = ty * e1z - tz * e1y;
+            const f32x4 qy = tz * e1x - tx * e1z;
+            const f32x4 qz = tx * e1y - ty * e1x;
+            const f32x4 v = dot(ray.dirX, ray.dirY, ray.dirZ, qx, qy, qz) * invDet;
+            valid = bit_and(valid, bit_and(cmp_ge(v, zero()), cmp_le(u + v, one)));
+
+            t = dot(e2x, e2y, e2z, qx, qy, qz) * invDet;
+            return bit_and(valid, in_range(t, ray.length));
+        }
+    };
+}
+
+template <int Lanes>
+uint32_t raycast::test_tri(const packet<Lanes>& rays, const float3::values& vertex1, const float3::values& vertex2, const float3::values& vertex3, packet_result<Lanes>& hits) {
+    return for_each_group(rays, hits, tri_kernel(vertex1, vertex2, vertex3));
+}
+
+template <int Lanes>
+uint32_t raycast::occluded_tri(const packet<Lanes>& rays, const float3::values& vertex1, const float3::values& vertex2, const float3::values& vertex3) {
+    return hit_mask(rays, tri_kernel(vertex1, vertex2, vertex3));
+}
+
+
+/////////////////////////////////////////////////////////////////////
+// Instantiations
+
+#define ELOO_RAYCAST_PACKET_INSTANTIATE(LANES) \
+    template uint32_t raycast::test_aabb<LANES>(const packet<LANES>&, const float3::values&, const float3::values&, packet_result<LANES>&); \
+    template uint32_t raycast::test_sphere<LANES>(const packet<LANES>&, const float3::values&, float, packet_result<LANES>&); \
+    template uint32_t raycast::test_tri<LANES>(const packet<LANES>&, const float3::values&, const float3::values&, const float3::values&, packet_result<LANES>&); \
+    template uint32_t raycast::occluded_aabb<LANES>(const packet<LANES>&, const float3::values&, const float3::values&); \
+    template uint32_t raycast::occluded_sphere<LANES>(const packet<LANES>&, const float3::values&, float); \
+    template uint32_t raycast::occluded_tri<LANES>(const packet<LANES>&, const float3::values&, const float3::values&, const float3::values&);
+
+ELOO_RAYCAST_PACKET_INSTANTIATE(4)
+ELOO_RAYCAST_PACKET_INSTANTIATE(8)
+ELOO_RAYCAST_PACKET_INSTANTIATE(16)
+
+#undef ELOO_RAYCAST_PACKET_INSTANTIATE
@@ -0,0 +1,409 @@
+#include "utility/raycast_watertight.h"
+
+#include "maths/math.h"
+#include "maths/simd.h"
+
+using namespace eloo;
+using namespace eloo::math::simd;
+using namespace eloo::raycast;
+
+namespace {
+    // The ray's dominant axis goes last, the other two follow it in cyclic order
+    ELOO_FORCE_INLINE uint32_t dominant_axis(float x, float y, float z) {
+        const float ax = math::abs(x);
+        const float ay = math::abs(y);
+        const float az = math::abs(z);
+        return ax >= ay && ax >= az ? 0u : (ay >= az ? 1u : 2u);
+    }
+
+    // A vertex relative to the ray origin, permuted and sheared so the ray runs along +z
+    struct sheared_vertex {
+        float x;
+        float y;
+        float z;
+    };
+
+    ELOO_FORCE_INLINE sheared_vertex shear_vertex(const float* vertex, const watertight_ray& ray) {
+        const float relative[3] = { vertex[0] - ray.origin[0], vertex[1] - ray.origin[1], vertex[2] - ray.origin[2] };
+        const float along = relative[ray.axis[2]];
+        return { relative[ray.axis[0]] - ray.shear[0] * along, relative[ray.axis[1]] - ray.shear[1] * along, ray.shear[2] * along };
+    }
+
+    // Solves for the hit once the vertices are in ray space. Every path through here, SIMD or not,
+    // takes the same products in the same order so shared edges agree exactly
+    bool solve(const sheared_vertex& a, const sheared_vertex& b, const sheared_vertex& c, float tmin, float tmax, float& t, float& u, float& v) {
+        float edgeA = c.x * b.y - c.y * b.x;
+        float edgeB = a.x * c.y - a.y * c.x;
+        float edgeC = b.x * a.y - b.y * a.x;
+        if (edgeA == 0.0f || edgeB == 0.0f || edgeC == 0.0f) {
+            // Products of floats are exact in double, so the sign of a near zero edge is right
+            edgeA = static_cast<float>(static_cast<double>(c.x) * b.y - static_cast<double>(c.y) * b.x);
+            edgeB = static_cast<float>(static_cast<double>(a.x) * c.y - static_cast<double>(a.y) * c.x);
+            edgeC = static_cast<float>(static_cast<double>(b.x) * a.y - static_cast<double>(b.y) * a.x);
+        }
+
+        if ((edgeA < 0.0f || edgeB < 0.0f || edgeC < 0.0f) && (edgeA > 0.0f || edgeB > 0.0f || edgeC > 0.0f)) {
+            return false;
+        }
+        const float det = edgeA + edgeB + edgeC;
+        if (det == 0.0f) {
+            return false;
+        }
+
+        t = (edgeA * a.z + edgeB * b.z + edgeC * c.z) / det;
+        if (!(t >= tmin && t <= tmax)) {
+            return false;
+        }
+        u = edgeB / det;
+        v = edgeC / det;
+        return true;
+    }
+
+    void fill_hit(const triangle_record& tri, const float* origin, const float* direction, float t, float u, float v, triangle_hit& hit) {
+        hit.id = tri.id;
+        hit.hit.distance = t;
+        hit.hit.position = float3::values(direction[0] * t + origin[0], direction[1] * t + origin[1], direction[2] * t + origin[2]);
+        hit.u = u;
+        hit.v = v;
+        hit.normal = float3::values(tri.normal[0], tri.normal[1], tri.normal[2]);
+    }
+
+    // Vertices of four triangles in ray space, one per lane
+    struct sheared_lanes {
+        f32x4 ax, ay, az;
+        f32x4 bx, by, bz;
+        f32x4 cx, cy, cz;
+    };
+
+    // The lane form of solve(). Lanes with an edge function of exactly zero are left out of the
+    // returned mask and flagged in 'redo' for the scalar path, which handles them in double
+    ELOO_FORCE_INLINE f32x4 solve_lanes(const sheared_lanes& s, f32x4 tmin, f32x4 tmax, f32x4& t, f32x4& u, f32x4& v, f32x4& redo) {
+        const f32x4 edgeA = s.cx * s.by - s.cy * s.bx;
+        const f32x4 edgeB = s.ax * s.cy - s.ay * s.cx;
+        const f32x4 edgeC = s.bx * s.ay - s.by * s.ax;
+        const f32x4 zeroes = zero();
+        redo = bit_or(bit_or(cmp_eq(edgeA, zeroes), cmp_eq(edgeB, zeroes)), cmp_eq(edgeC, zeroes));
+
+        const f32x4 anyNegative = bit_or(bit_or(cmp_lt(edgeA, zeroes), cmp_lt(edgeB, zeroes)), cmp_lt(edgeC, zeroes));
+        const f32x4 anyPositive = bit_or(bit_or(cmp_gt(edgeA, zeroes), cmp_gt(edgeB, zeroes)), cmp_gt(edgeC, zeroes));
+        const f32x4 det = edgeA + edgeB + edgeC;
+        f32x4 valid = bit_and(bit_xor(anyNegative, anyPositive), cmp_eq(cmp_eq(det, zeroes), zeroes));
+        if (movemask(bit_or(valid, redo)) == 0) {
+            return valid;
+        }
+
+        t = (edgeA * s.az + edgeB * s.bz + edgeC * s.cz) / det;
+        u = edgeB / det;
+        v = edgeC / det;
+        valid = bit_and(valid, bit_and(cmp_ge(t, tmin), cmp_le(t, tmax)));
+        return bit_and(valid, bit_xor(redo, cmp_eq(zeroes, zeroes)));
+    }
+
+    // Picks per lane between the x, y and z forms by the lane's dominant axis
+    ELOO_FORCE_INLINE f32x4 pick(f32x4 isX, f32x4 isY, f32x4 x, f32x4 y, f32x4 z) {
+        return select(isX, x, select(isY, y, z));
+    }
+}
+
+
+/////////////////////////////////////////////////////////////////////
+// Records
+
+triangle_record::triangle_record(const float3::values& v1, const float3::values& v2, const float3::values& v3, uint32_t triangleId)
+    : vertex1 { v1.x(), v1.y(), v1.z() }
+    , vertex2 { v2.x(), v2.y(), v2.z() }
+    , vertex3 { v3.x(), v3.y(), v3.z() }
+    , normal { 0.0f, 0.0f, 0.0f }
+    , id(triangleId)
+    , padding { 0, 0, 0 } {
+    const float3::values cross = math::vector::cross(v2 - v1, v3 - v1);
+    const float length = math::sqrt(math::vector::dot(cross, cross));
+    if (length > 0.0f) {
+        normal[0] = cross.x() / length;
+        normal[1] = cross.y() / length;
+        normal[2] = cross.z() / length;
+    }
+}
+
+void raycast::build_records(eastl::span<const float3::values> vertices, eastl::span<const uint32_t> indices, eastl::vector<triangle_record>& records, uint32_t firstId) {
+    ELOO_ASSERT_FATAL(indices.size() % 3 == 0, "Triangle index count %zu isn't a multiple of 3", indices.size());
+
+    records.reserve(records.size() + indices.size() / 3);
+    for (size_t i = 0; i < indices.size(); i += 3) {
+        records.emplace_back(vertices[indices[i]], vertices[indices[i + 1]], vertices[indices[i + 2]], firstId + static_cast<uint32_t>(i / 3));
+    }
+}
+
+watertight_ray::watertight_ray(const ray& query)
+    : watertight_ray(query.origin, query.direction, query.tmax) {
+    tmin = query.tmin;
+}
+
+watertight_ray::watertight_ray(const float3::values& rayOrigin, const float3::values& rayDir, float rayLength)
+    : origin { rayOrigin.x(), rayOrigin.y(), rayOrigin.z() }
+    , direction { rayDir.x(), rayDir.y(), rayDir.z() }
+    , tmin(0.0f)
+    , tmax(rayLength) {
+    const uint32_t kz = dominant_axis(direction[0], direction[1], direction[2]);
+    axis[0] = (kz + 1) % 3;
+    axis[1] = (kz + 2) % 3;
+    axis[2] = kz;
+    shear[0] = direction[axis[0]] / direction[kz];
+    shear[1] = direction[axis[1]] / direction[kz];
+    shear[2] = 1.0f / direction[kz];
+}
+
+
+/////////////////////////////////////////////////////////////////////
+// Single triangle
+
+bool raycast::test_tri(const watertight_ray& query, const triangle_record& tri, triangle_hit& hit) {
+    hit = triangle_hit();
+
+    float t, u, v;
+    if (!solve(shear_vertex(tri.vertex1, query), shear_vertex(tri.vertex2, query), shear_vertex(tri.vertex3, query), query.tmin, query.tmax, t, u, v)) {
+        return false;
+    }
+    fill_hit(tri, query.origin, query.direction, t, u, v, hit);
+    return true;
+}
+
+bool raycast::occluded_tri(const watertight_ray& query, const triangle_record& tri) {
+    float t, u, v;
+    return solve(shear_vertex(tri.vertex1, query), shear_vertex(tri.vertex2, query), shear_vertex(tri.vertex3, query), query.tmin, query.tmax, t, u, v);
+}
+
+
+/////////////////////////////////////////////////////////////////////
+// Batches
+
+namespace {
+    // Runs the lane test over 'tris' four records at a time, calling 'hitFn(index, t, u, v)' for
+    // each hit in order until it returns true. 'tmaxFn' gives the current upper bound so closest
+    // hit searches can shrink it. The records left over at the end go through the scalar test
+    template <typename TmaxFn, typename HitFn>
+    bool for_each_hit(const watertight_ray& query, eastl::span<const triangle_record> tris, TmaxFn tmaxFn, HitFn hitFn) {
+        const f32x4 origin[3] = { set1(query.origin[0]), set1(query.origin[1]), set1(query.origin[2]) };
+        const f32x4 shearX = set1(query.shear[0]);
+        const f32x4 shearY = set1(query.shear[1]);
+        const f32x4 shearZ = set1(query.shear[2]);
+        const uint32_t kx = query.axis[0];
+        const uint32_t ky = query.axis[1];
+        const uint32_t kz = query.axis[2];
+        const f32x4 tmin = set1(query.tmin);
+
+        const auto shear = [&](const f32x4* relative, f32x4& x, f32x4& y, f32x4& z) {
+            x = relative[kx] - shearX * relative[kz];
+            y = relative[ky] - shearY * relative[kz];
+            z = shearZ * relative[kz];
+        };
+
+        const size_t count = tris.size();
+        size_t first = 0;
+        for (; first + WIDTH <= count; first += WIDTH) {
+            const triangle_record* group = tris.data() + first;
+
+            // Rows of each record are v1xyz v2x | v2yz v3xy | v3z normal, so three transposes
+            // give every vertex component in lanes
+            const float* row0 = reinterpret_cast<const float*>(group);
+            const float* row1 = reinterpret_cast<const float*>(group + 1);
+            const float* row2 = reinterpret_cast<const float*>(group + 2);
+            const float* row3 = reinterpret_cast<const float*>(group + 3);
+            f32x4 v1x = load(row0), v1y = load(row1), v1z = load(row2), v2x = load(row3);
+            f32x4 v2y = load(row0 + 4), v2z = load(row1 + 4), v3x = load(row2 + 4), v3y = load(row3 + 4);
+            f32x4 v3z = load(row0 + 8), n1 = load(row1 + 8), n2 = load(row2 + 8), n3 = load(row3 + 8);
+            transpose(v1x, v1y, v1z, v2x);
+            transpose(v2y, v2z, v3x, v3y);
+            transpose(v3z, n1, n2, n3);
+
+            const f32x4 a[3] = { v1x - origin[0], v1y - origin[1], v1z - origin[2] };
+            const f32x4 b[3] = { v2x - origin[0], v2y - origin[1], v2z - origin[2] };
+            const f32x4 c[3] = { v3x - origin[0], v3y - origin[1], v3z - origin[2] };
+            sheared_lanes lanes;
+            shear(a, lanes.ax, lanes.ay, lanes.az);
+            shear(b, lanes.bx, lanes.by, lanes.bz);
+            shear(c, lanes.cx, lanes.cy, lanes.cz);
+
+            f32x4 t = zero(), u = zero(), v = zero(), redo = zero();
+            const uint32_t hitBits = static_cast<uint32_t>(movemask(solve_lanes(lanes, tmin, set1(tmaxFn()), t, u, v, redo)));
+            const uint32_t redoBits = static_cast<uint32_t>(movemask(redo));
+            if ((hitBits | redoBits) == 0) {
+                continue;
+            }
+
+            alignas(16) float distance[WIDTH];
+            alignas(16) float weightU[WIDTH];
+            alignas(16) float weightV[WIDTH];
+            store(distance, t);
+            store(weightU, u);
+            store(weightV, v);
+            for (int lane = 0; lane < WIDTH; ++lane) {
+                if (hitBits & (1u << lane)) {
+                    if (hitFn(first + lane, distance[lane], weightU[lane], weightV[lane])) {
+                        return true;
+                    }
+                }
+                else if (redoBits & (1u << lane)) {
+                    const triangle_record& tri = group[lane];
+                    float redoT, redoU, redoV;
+                    if (solve(shear_vertex(tri.vertex1, query), shear_vertex(tri.vertex2, query), shear_vertex(tri.vertex3, query), query.tmin, tmaxFn(), redoT, redoU, redoV) &&
+                        hitFn(first + lane, redoT, redoU, redoV)) {
+                        return true;
+                    }
+                }
+            }
+        }
+
+        for (; first < count; ++first) {
+            const triangle_record& tri = tris[first];
+            float t, u, v;
+            if (solve(shear_vertex(tri.vertex1, query), shear_vertex(tri.vertex2, query), shear_vertex(tri.vertex3, query), query.tmin, tmaxFn(), t, u, v) &&
+                hitFn(first, t, u, v)) {
+                return true;
+            }
+        }
+        return false;
+    }
+}
+
+bool raycast::test_tris(const watertight_ray& query, eastl::span<const triangle_record> tris, triangle_hit& closest) {
+    closest = triangle_hit();
+
+    // Hits at the current best distance pass the range test, and are dropped here so the lower
+    // position keeps the tie
+    float tmax = query.tmax;
+    size_t best = tris.size();
+    float bestU = 0.0f, bestV = 0.0f;
+    for_each_hit(query, tris, [&]() { return tmax; }, [&](size_t index, float t, float u, float v) {
+        if (best == tris.size() || t < tmax) {
+            best = index;
+            tmax = t;
+            bestU = u;
+            bestV = v;
+        }
+        return false;
+    });
+
+    if (best == tris.size()) {
+        return false;
+    }
+    fill_hit(tris[best], query.origin, query.direction, tmax, bestU, bestV, closest);
+    return true;
+}
+
+size_t raycast::test_tris(const watertight_ray& query, eastl::span<const triangle_record> tris, eastl::vector<triangle_hit>& hits) {
+    const size_t initialSize = hits.size();
+    for_each_hit(query, tris, [&]() { return query.tmax; }, [&](size_t index, float t, float u, float v) {
+        fill_hit(tris[index], query.origin, query.direction, t, u, v, hits.emplace_back());
+        return false;
+    });
+    return hits.size() - initialSize;
+}
+
+bool raycast::occluded_tris(const watertight_ray& query, eastl::span<const triangle_record> tris) {
+    return for_each_hit(query, tris, [&]() { return query.tmax; }, [](size_t, float, float, float) { return true; });
+}
+
+
+/////////////////////////////////////////////////////////////////////
+// Packets
+
+namespace {
+    // Runs the lane test for every active group of the packet, calling 'hitFn(index, t, u, v)' for
+    // each lane that hits. Returns the mask of those lanes
+    template <int Lanes, typename HitFn>
+    uint32_t for_each_lane_hit(const packet<Lanes>& rays, const triangle_record& tri, HitFn hitFn) {
+        const f32x4 v1[3] = { set1(tri.vertex1[0]), set1(tri.vertex1[1]), set1(tri.vertex1[2]) };
+        const f32x4 v2[3] = { set1(tri.vertex2[0]), set1(tri.vertex2[1]), set1(tri.vertex2[2]) };
+        const f32x4 v3[3] = { set1(tri.vertex3[0]), set1(tri.vertex3[1]), set1(tri.vertex3[2]) };
+
+        uint32_t mask = 0;
+        for (int first = 0; first < Lanes; first += WIDTH) {
+            const uint32_t activeBits = (rays.active >> first) & 0xFu;
+            if (activeBits == 0) {
+                continue;
+            }
+
+            const f32x4 origin[3] = { load(rays.originX + first), load(rays.originY + first), load(rays.originZ + first) };
+            const f32x4 dir[3] = { load(rays.dirX + first), load(rays.dirY + first), load(rays.dirZ + first) };
+            const f32x4 length = load(rays.length + first);
+
+            // Each lane has its own dominant axis, chosen as watertight_ray does, so the permuted
+            // components are picked per lane
+            const f32x4 absX = math::simd::abs(dir[0]), absY = math::simd::abs(dir[1]), absZ = math::simd::abs(dir[2]);
+            const f32x4 isX = bit_and(cmp_ge(absX, absY), cmp_ge(absX, absZ));
+            const f32x4 isY = bit_and(bit_xor(isX, cmp_eq(absX, absX)), cmp_ge(absY, absZ));
+            const f32x4 dirZ = pick(isX, isY, dir[0], dir[1], dir[2]);
+            const f32x4 shearX = pick(isX, isY, dir[1], dir[2], dir[0]) / dirZ;
+            const f32x4 shearY = pick(isX, isY, dir[2], dir[0], dir[1]) / dirZ;
+            const f32x4 shearZ = set1(1.0f) / dirZ;
+
+            const auto shear = [&](const f32x4* vertex, f32x4& x, f32x4& y, f32x4& z) {
+                const f32x4 rx = vertex[0] - origin[0], ry = vertex[1] - origin[1], rz = vertex[2] - origin[2];
+                const f32x4 along = pick(isX, isY, rx, ry, rz);
+                x = pick(isX, isY, ry, rz, rx) - shearX * along;
+                y = pick(isX, isY, rz, rx, ry) - shearY * along;
+                z = shearZ * along;
+            };
+            sheared_lanes lanes;
+            shear(v1, lanes.ax, lanes.ay, lanes.az);
+            shear(v2, lanes.bx, lanes.by, lanes.bz);
+            shear(v3, lanes.cx, lanes.cy, lanes.cz);
+
+            f32x4 t = zero(), u = zero(), v = zero(), redo = zero();
+            const uint32_t hitBits = static_cast<uint32_t>(movemask(solve_lanes(lanes, zero(), length, t, u, v, redo))) & activeBits;
+            const uint32_t redoBits = static_cast<uint32_t>(movemask(redo)) & activeBits;
+            if ((hitBits | redoBits) == 0) {
+                continue;
+            }
+
+            alignas(16) float distance[WIDTH];
+            alignas(16) float weightU[WIDTH];
+            alignas(16) float weightV[WIDTH];
+            store(distance, t);
+            store(weightU, u);
+            store(weightV, v);
+            for (int lane = 0; lane < WIDTH; ++lane) {
+                const int index = first + lane;
+                if (hitBits & (1u << lane)) {
+                    hitFn(index, distance[lane], weightU[lane], weightV[lane]);
+                    mask |= 1u << index;
+                }
+                else if (redoBits & (1u << lane)) {
+                    const watertight_ray query({ rays.originX[index], rays.originY[index], rays.originZ[index] }, { rays.dirX[index], rays.dirY[index], rays.dirZ[index] }, rays.length[index]);
+                    float redoT, redoU, redoV;
+                    if (solve(shear_vertex(tri.vertex1, query), shear_vertex(tri.vertex2, query), shear_vertex(tri.vertex3, query), query.tmin, query.tmax, redoT, redoU, redoV)) {
+                        hitFn(index, redoT, redoU, redoV);
+                        mask |= 1u << index;
+                    }
+                }
+            }
+        }
+        return mask;
+    }
+}
+
+template <int Lanes>
+uint32_t raycast::test_tri(const packet<Lanes>& rays, const triangle_record& tri, packet_triangle_result<Lanes>& hits) {
+    hits.mask = for_each_lane_hit(rays, tri, [&](int index, float t, float u, float v) {
+        const float origin[3] = { rays.originX[index], rays.originY[index], rays.originZ[index] };
+        const float direction[3] = { rays.dirX[index], rays.dirY[index], rays.dirZ[index] };
+        fill_hit(tri, origin, direction, t, u, v, hits.hits[index]);
+    });
+    return hits.mask;
+}
+
+template <int Lanes>
+uint32_t raycast::occluded_tri(const packet<Lanes>& rays, const triangle_record& tri) {
+    return for_each_lane_hit(rays, tri, [](int, float, float, float) {});
+}
+
+#define ELOO_WATERTIGHT_PACKET_INSTANTIATE(LANES) \
+    template uint32_t raycast::test_tri<LANES>(const packet<LANES>&, const triangle_record&, packet_triangle_result<LANES>&); \
+    template uint32_t raycast::occluded_tri<LANES>(const packet<LANES>&, const triangle_record&);
+
+ELOO_WATERTIGHT_PACKET_INSTANTIATE(4)
+ELOO_WATERTIGHT_PACKET_INSTANTIATE(8)
+ELOO_WATERTIGHT_PACKET_INSTANTIATE(16)
+
+#undef ELOO_WATERTIGHT_PACKET_INSTANTIATE
@@ -0,0 +1,516 @@
+#include "utility/spatial_hash.h"
+
+#include "maths/math.h"
+#include "utility/parallel.h"
+
+#include <EASTL/algorithm.h>
+#include <EASTL/heap.h>
+
+using namespace eloo;
+using namespace eloo::spatial;
+
+namespace {
+    // Points handled per task in the build passes
+    constexpr size_t BUILD_GRAIN = 16384;
+
+    // The first build pass spreads points into this many ranges of buckets, which the second pass
+    // then sorts independently
+    constexpr uint32_t RANGE_BITS = 10;
+    constexpr size_t RANGE_GRAIN = 16;
+
+    // Smallest table chosen from the point count
+    constexpr uint32_t MIN_TABLE_SIZE = 64;
+
+    uint32_t round_up_pow2(uint32_t v) {
+        uint32_t size = 1;
+        while (size < v) {
+            size <<= 1;
+        }
+        return size;
+    }
+
+    uint32_t log2_pow2(uint32_t v) {
+        uint32_t bits = 0;
+        while ((1u << bits) < v) {
+            ++bits;
+        }
+        return bits;
+    }
+
+    // Floor of 'v' as an int. Cells are worked out for every point on every build and query, and
+    // this avoids a library call per axis
+    ELOO_FORCE_INLINE int cell_coord(float v) {
+        const int truncated = static_cast<int>(v);
+        return truncated - (static_cast<float>(truncated) > v ? 1 : 0);
+    }
+
+    // Large prime multipliers per axis, then a finalizer so neighbouring cells land in unrelated
+    // buckets even when the table is small
+    ELOO_FORCE_INLINE uint32_t hash_cell(int x, int y, int z) {
+        uint32_t h = (static_cast<uint32_t>(x) * 73856093u) ^ (static_cast<uint32_t>(y) * 19349663u) ^ (static_cast<uint32_t>(z) * 83492791u);
+        h ^= h >> 16;
+        h *= 0x7FEB352Du;
+        h ^= h >> 15;
+        return h;
+    }
+
+    struct candidate {
+        float distanceSqr;
+        uint32_t index;
+
+        inline bool operator<(const candidate& other) const {
+            return distanceSqr < other.distanceSqr || (distanceSqr == other.distanceSqr && index < other.index);
+        }
+    };
+
+    struct cell_range {
+        int min[3];
+        int max[3];
+
+        inline bool empty() const { return min[0] > max[0] || min[1] > max[1] || min[2] > max[2]; }
+    };
+}
+
+
+/////////////////////////////////////////////////////////////////////
+// Building
+
+hash_grid::hash_grid(float cellSize) {
+    set_cell_size(cellSize);
+}
+
+void hash_grid::set_cell_size(float cellSize) {
+    ELOO_ASSERT_FATAL(cellSize > 0.0f, "Hash grid cells need a positive size (%f)", cellSize);
+    mCellSize = cellSize;
+    mInvCellSize = 1.0f / cellSize;
+    clear();
+}
+
+void hash_grid::clear() {
+    mBucketMask = 0;
+    mBucketStarts.clear();
+    mX.clear();
+    mY.clear();
+    mZ.clear();
+    mIndices.clear();
+    mBounds = aabb();
+    for (int axis = 0; axis < 3; ++axis) {
+        mCellMin[axis] = 0;
+        mCellMax[axis] = -1;
+    }
+}
+
+int3::values hash_grid::cell_of(const float3::values& position) const {
+    return { cell_coord(position.x() * mInvCellSize), cell_coord(position.y() * mInvCellSize), cell_coord(position.z() * mInvCellSize) };
+}
+
+uint32_t hash_grid::bucket_of(const int3::values& cell) const {
+    return hash_cell(cell.x(), cell.y(), cell.z()) & mBucketMask;
+}
+
+// Points are first spread into ranges of buckets by the top bits of their bucket, each task
+// counting its own points and then writing them in order to its share of every range. Tasks are
+// fixed runs of BUILD_GRAIN points, so the two passes agree on them however parallel_for splits
+// the work. Each range is then counting sorted by bucket on its own, so both passes are stable
+void hash_grid::build(eastl::span<const float> x, eastl::span<const float> y, eastl::span<const float> z, uint32_t tableSize) {
+    ELOO_ASSERT_FATAL(x.size() == y.size() && x.size() == z.size(), "Hash grid columns differ in length (%zu, %zu, %zu)", x.size(), y.size(), z.size());
+    ELOO_ASSERT_FATAL(x.size() < UINT32_MAX, "Too many points for a hash grid (%zu)", x.size());
+
+    clear();
+    const uint32_t count = static_cast<uint32_t>(x.size());
+    if (count == 0) {
+        return;
+    }
+
+    const uint32_t buckets = round_up_pow2(tableSize != 0 ? tableSize : eastl::max(count * 2, MIN_TABLE_SIZE));
+    const uint32_t bucketBits = log2_pow2(buckets);
+    const uint32_t rangeShift = bucketBits > RANGE_BITS ? bucketBits - RANGE_BITS : 0;
+    const uint32_t ranges = buckets >> rangeShift;
+    mBucketMask = buckets - 1;
+
+    const size_t tasks = (count + BUILD_GRAIN - 1) / BUILD_GRAIN;
+    mScratchBuckets.resize(count);
+    mScratchOffsets.assign(tasks * ranges, 0);
+    eastl::vector<aabb> taskBounds(tasks);
+    parallel::parallel_for(tasks, 1, [&](size_t firstTask, size_t lastTask) {
+        for (size_t task = firstTask; task < lastTask; ++task) {
+            uint32_t* counts = &mScratchOffsets[task * ranges];
+            float lo[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+            float hi[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+            const size_t end = eastl::min<size_t>(count, (task + 1) * BUILD_GRAIN);
+            for (size_t i = task * BUILD_GRAIN; i < end; ++i) {
+                const float position[3] = { x[i], y[i], z[i] };
+                int cell[3];
+                for (int axis = 0; axis < 3; ++axis) {
+                    cell[axis] = cell_coord(position[axis] * mInvCellSize);
+                    lo[axis] = math::min(lo[axis], position[axis]);
+                    hi[axis] = math::max(hi[axis], position[axis]);
+                }
+                const uint32_t bucket = hash_cell(cell[0], cell[1], cell[2]) & mBucketMask;
+                mScratchBuckets[i] = bucket;
+                ++counts[bucket >> rangeShift];
+            }
+            taskBounds[task].min = { lo[0], lo[1], lo[2] };
+            taskBounds[task].max = { hi[0], hi[1], hi[2] };
+        }
+    });
+
+    eastl::vector<uint32_t> rangeStarts(ranges + 1);
+    uint32_t sum = 0;
+    for (uint32_t range = 0; range < ranges; ++range) {
+        rangeStarts[range] = sum;
+        for (size_t task = 0; task < tasks; ++task) {
+            uint32_t& offset = mScratchOffsets[task * ranges + range];
+            const uint32_t taskCount = offset;
+            offset = sum;
+            sum += taskCount;
+        }
+    }
+    rangeStarts[ranges] = sum;
+
+    // Points are carried along whole, so the second pass reads each range in one sweep rather
+    // than gathering from the input columns
+    mScratchPoints.resize(count);
+    parallel::parallel_for(tasks, 1, [&](size_t firstTask, size_t lastTask) {
+        for (size_t task = firstTask; task < lastTask; ++task) {
+            uint32_t* cursors = &mScratchOffsets[task * ranges];
+            const size_t end = eastl::min<size_t>(count, (task + 1) * BUILD_GRAIN);
+            for (size_t i = task * BUILD_GRAIN; i < end; ++i) {
+                const uint32_t bucket = mScratchBuckets[i];
+                mScratchPoints[cursors[bucket >> rangeShift]++] = { x[i], y[i], z[i], bucket, static_cast<uint32_t>(i) };
+            }
+        }
+    });
+
+    mBucketStarts.resize(buckets + 1);
+    mX.resize(count);
+    mY.resize(count);
+    mZ.resize(count);
+    mIndices.resize(count);
+    mScratchBuckets.resize(eastl::max(count, buckets));
+    parallel::parallel_for(ranges, RANGE_GRAIN, [&](size_t begin, size_t end) {
+        for (size_t range = begin; range < end; ++range) {
+            const uint32_t firstBucket = static_cast<uint32_t>(range) << rangeShift;
+            const uint32_t lastBucket = firstBucket + (1u << rangeShift);
+            uint32_t* cursors = mScratchBuckets.data();
+            for (uint32_t bucket = firstBucket; bucket < lastBucket; ++bucket) {
+                cursors[bucket] = 0;
+            }
+            for (uint32_t i = rangeStarts[range]; i < rangeStarts[range + 1]; ++i) {
+                ++cursors[mScratchPoints[i].bucket];
+            }
+            uint32_t start = rangeStarts[range];
+            for (uint32_t bucket = firstBucket; bucket < lastBucket; ++bucket) {
+                const uint32_t bucketCount = cursors[bucket];
+                mBucketStarts[bucket] = start;
+                cursors[bucket] = start;
+                start += bucketCount;
+            }
+            for (uint32_t i = rangeStarts[range]; i < rangeStarts[range + 1]; ++i) {
+                const scratch_point& point = mScratchPoints[i];
+                const uint32_t slot = cursors[point.bucket]++;
+                mX[slot] = point.x;
+                mY[slot] = point.y;
+                mZ[slot] = point.z;
+                mIndices[slot] = point.index;
+            }
+        }
+    });
+    mBucketStarts[buckets] = count;
+
+    for (const aabb& box : taskBounds) {
+        mBounds.min = { math::min(mBounds.min.x(), box.min.x()), math::min(mBounds.min.y(), box.min.y()), math::min(mBounds.min.z(), box.min.z()) };
+        mBounds.max = { math::max(mBounds.max.x(), box.max.x()), math::max(mBounds.max.y(), box.max.y()), math::max(mBounds.max.z(), box.max.z()) };
+    }
+    const int3::values cellMin = cell_of(mBounds.min);
+    const int3::values cellMax = cell_of(mBounds.max);
+    mCellMin[0] = cellMin.x();
+    mCellMin[1] = cellMin.y();
+    mCellMin[2] = cellMin.z();
+    mCellMax[0] = cellMax.x();
+    mCellMax[1] = cellMax.y();
+    mCellMax[2] = cellMax.z();
+}
+
+
+/////////////////////////////////////////////////////////////////////
+// Queries
+
+namespace {
+    // Cells covering [lo, hi] on each axis, clipped to 'limit' first so that far away or huge
+    // bounds never overflow the cell coordinates
+    cell_range clip_cells(const float lo[3], const float hi[3], float invCellSize, const int limitMin[3], const int limitMax[3]) {
+        cell_range cells;
+        for (int axis = 0; axis < 3; ++axis) {
+            const float first = math::floor(lo[axis] * invCellSize);
+            const float last = math::floor(hi[axis] * invCellSize);
+            cells.min[axis] = first > static_cast<float>(limitMin[axis]) ? static_cast<int>(first) : limitMin[axis];
+            cells.max[axis] = last < static_cast<float>(limitMax[axis]) ? static_cast<int>(last) : limitMax[axis];
+        }
+        return cells;
+    }
+}
+
+template <typename CellFn>
+void hash_grid::for_each_in_cell(int cx, int cy, int cz, CellFn cellFn) const {
+    const uint32_t bucket = hash_cell(cx, cy, cz) & mBucketMask;
+    for (uint32_t i = mBucketStarts[bucket]; i < mBucketStarts[bucket + 1]; ++i) {
+        if (cell_coord(mX[i] * mInvCellSize) == cx && cell_coord(mY[i] * mInvCellSize) == cy && cell_coord(mZ[i] * mInvCellSize) == cz) {
+            cellFn(i);
+        }
+    }
+}
+
+size_t hash_grid::overlap(const float3::values& centre, float radius, eastl::vector<uint32_t>& indices) const {
+    const size_t initialSize = indices.size();
+    if (empty() || radius < 0.0f) {
+        return 0;
+    }
+
+    const float lo[3] = { centre.x() - radius, centre.y() - radius, centre.z() - radius };
+    const float hi[3] = { centre.x() + radius, centre.y() + radius, centre.z() + radius };
+    const cell_range cells = clip_cells(lo, hi, mInvCellSize, mCellMin, mCellMax);
+    if (cells.empty()) {
+        return 0;
+    }
+
+    const float radiusSqr = radius * radius;
+    for (int cz = cells.min[2]; cz <= cells.max[2]; ++cz) {
+        for (int cy = cells.min[1]; cy <= cells.max[1]; ++cy) {
+            for (int cx = cells.min[0]; cx <= cells.max[0]; ++cx) {
+                for_each_in_cell(cx, cy, cz, [&](uint32_t i) {
+                    const float dx = mX[i] - centre.x();
+                    const float dy = mY[i] - centre.y();
+                    const float dz = mZ[i] - centre.z();
+                    if (dx * dx + dy * dy + dz * dz <= radiusSqr) {
+                        indices.push_back(mIndices[i]);
+                    }
+                });
+            }
+        }
+    }
+    return indices.size() - initialSize;
+}
+
+size_t hash_grid::overlap(const aabb& box, eastl::vector<uint32_t>& indices) const {
+    const size_t initialSize = indices.size();
+    if (empty()) {
+        return 0;
+    }
+
+    const float lo[3] = { box.min.x(), box.min.y(), box.min.z() };
+    const float hi[3] = { box.max.x(), box.max.y(), box.max.z() };
+    const cell_range cells = clip_cells(lo, hi, mInvCellSize, mCellMin, mCellMax);
+    if (cells.empty()) {
+        return 0;
+    }
+
+    for (int cz = cells.min[2]; cz <= cells.max[2]; ++cz) {
+        for (int cy = cells.min[1]; cy <= cells.max[1]; ++cy) {
+            for (int cx = cells.min[0]; cx <= cells.max[0]; ++cx) {
+                for_each_in_cell(cx, cy, cz, [&](uint32_t i) {
+                    if (mX[i] >= lo[0] && mX[i] <= hi[0] && mY[i] >= lo[1] && mY[i] <= hi[1] && mZ[i] >= lo[2] && mZ[i] <= hi[2]) {
+                        indices.push_back(mIndices[i]);
+                    }
+                });
+            }
+        }
+    }
+    return indices.size() - initialSize;
+}
+
+// Rings of cells at growing Chebyshev distance from the query's cell are searched until the k
+// best found so far are all closer than anything outside the rings could be. The best are kept
+// in a max heap so the worst of them is always on top
+size_t hash_grid::nearest(const float3::values& position, uint32_t k, eastl::vector<uint32_t>& indices, float maxDistance) const {
+    if (empty() || k == 0 || maxDistance < 0.0f) {
+        return 0;
+    }
+
+    const float point[3] = { position.x(), position.y(), position.z() };
+    const float maxDistanceSqr = maxDistance < FLT_MAX ? maxDistance * maxDistance : FLT_MAX;
+
+    // The query cell is clamped to just outside the occupied cells, which keeps far away queries
+    // in range without changing which cells each ring reaches
+    int centre[3];
+    int firstRing = 0;
+    int lastRing = 0;
+    for (int axis = 0; axis < 3; ++axis) {
+        const float cell = math::floor(point[axis] * mInvCellSize);
+        const float lo = static_cast<float>(mCellMin[axis] - 1);
+        const float hi = static_cast<float>(mCellMax[axis] + 1);
+        centre[axis] = static_cast<int>(cell < lo ? lo : (cell > hi ? hi : cell));
+        firstRing = eastl::max(firstRing, eastl::max(mCellMin[axis] - centre[axis], centre[axis] - mCellMax[axis]));
+        lastRing = eastl::max(lastRing, eastl::max(centre[axis] - mCellMin[axis], mCellMax[axis] - centre[axis]));
+    }
+
+    eastl::vector<candidate> best;
+    best.reserve(k);
+    const auto consider = [&](uint32_t i) {
+        const float dx = mX[i] - point[0];
+        const float dy = mY[i] - point[1];
+        const float dz = mZ[i] - point[2];
+        const candidate found = { dx * dx + dy * dy + dz * dz, mIndices[i] };
+        if (found.distanceSqr > maxDistanceSqr) {
+            return;
+        }
+        if (best.size() < k) {
+            best.push_back(found);
+            eastl::push_heap(best.begin(), best.end());
+        }
+        else if (found < best.front()) {
+            eastl::pop_heap(best.begin(), best.end());
+            best.back() = found;
+            eastl::push_heap(best.begin(), best.end());
+        }
+    };
+
+    for (int ring = firstRing; ring <= lastRing; ++ring) {
+        int lo[3];
+        int hi[3];
+        for (int axis = 0; axis < 3; ++axis) {
+            lo[axis] = eastl::max(centre[axis] - ring, mCellMin[axis]);
+            hi[axis] = eastl::min(centre[axis] + ring, mCellMax[axis]);
+        }
+        for (int cy = lo[1]; cy <= hi[1]; ++cy) {
+            for (int cx = lo[0]; cx <= hi[0]; ++cx) {
+                const bool onRing = cx == centre[0] - ring || cx == centre[0] + ring || cy == centre[1] - ring || cy == centre[1] + ring;
+                if (onRing) {
+                    for (int cz = lo[2]; cz <= hi[2]; ++cz) {
+                        for_each_in_cell(cx, cy, cz, consider);
+                    }
+                    continue;
+                }
+                if (centre[2] - ring >= lo[2] && centre[2] - ring <= hi[2]) {
+                    for_each_in_cell(cx, cy, centre[2] - ring, consider);
+                }
+                if (ring > 0 && centre[2] + ring >= lo[2] && centre[2] + ring <= hi[2]) {
+                    for_each_in_cell(cx, cy, centre[2] + ring, consider);
+                }
+            }
+        }
+
+        // Every point not yet seen lies outside the cells searched so far
+        float reach = FLT_MAX;
+        for (int axis = 0; axis < 3; ++axis) {
+            const float below = point[axis] - static_cast<float>(centre[axis] - ring) * mCellSize;
+            const float above = static_cast<float>(centre[axis] + ring + 1) * mCellSize - point[axis];
+            reach = math::min(reach, math::min(below, above));
+        }
+        if (reach > 0.0f) {
+            const float reachSqr = reach * reach;
+            if (reachSqr > maxDistanceSqr || (best.size() == k && best.front().distanceSqr < reachSqr)) {
+                break;
+            }
+        }
+    }
+
+    eastl::sort_heap(best.begin(), best.end());
+    for (const candidate& found : best) {
+        indices.push_back(found.index);
+    }
+    return best.size();
+}
+
+// The ray is clipped to the points' bounds grown by the radius, then walked a cell at a time.
+// A sphere is hit at a point within its radius of its centre, so every sphere hit inside the
+// current cell has its centre within 'reach' cells of it. The block of cells within reach is
+// tested once on entry, and each step then only tests the face of cells the block moves onto
+bool hash_grid::raycast(const raycast::ray& query, float pointRadius, batch_hit& closest) const {
+    closest = batch_hit();
+    if (empty() || pointRadius < 0.0f) {
+        return false;
+    }
+
+    const float origin[3] = { query.origin.x(), query.origin.y(), query.origin.z() };
+    const float direction[3] = { query.direction.x(), query.direction.y(), query.direction.z() };
+    const float invDirection[3] = { query.invDirection.x(), query.invDirection.y(), query.invDirection.z() };
+    const float boundsMin[3] = { mBounds.min.x() - pointRadius, mBounds.min.y() - pointRadius, mBounds.min.z() - pointRadius };
+    const float boundsMax[3] = { mBounds.max.x() + pointRadius, mBounds.max.y() + pointRadius, mBounds.max.z() + pointRadius };
+
+    // A slab the ray runs along produces NaNs, which the argument order below drops
+    float tNear = query.tmin;
+    float tFar = query.tmax;
+    for (int axis = 0; axis < 3; ++axis) {
+        const float t0 = ((query.sign[axis] ? boundsMax[axis] : boundsMin[axis]) - origin[axis]) * invDirection[axis];
+        const float t1 = ((query.sign[axis] ? boundsMin[axis] : boundsMax[axis]) - origin[axis]) * invDirection[axis];
+        tNear = math::max(t0, tNear);
+        tFar = math::min(t1, tFar);
+    }
+    if (tNear > tFar) {
+        return false;
+    }
+
+    const int reach = pointRadius > 0.0f ? static_cast<int>(math::floor(pointRadius * mInvCellSize)) + 1 : 0;
+    int walkMin[3];
+    int walkMax[3];
+    int cell[3];
+    int step[3];
+    float tNext[3];
+    float tDelta[3];
+    for (int axis = 0; axis < 3; ++axis) {
+        walkMin[axis] = mCellMin[axis] - reach;
+        walkMax[axis] = mCellMax[axis] + reach;
+        const float entry = math::floor((origin[axis] + direction[axis] * tNear) * mInvCellSize);
+        cell[axis] = entry < static_cast<float>(walkMin[axis]) ? walkMin[axis] : (entry > static_cast<float>(walkMax[axis]) ? walkMax[axis] : static_cast<int>(entry));
+        step[axis] = direction[axis] > 0.0f ? 1 : (direction[axis] < 0.0f ? -1 : 0);
+        if (step[axis] != 0) {
+            const float boundary = static_cast<float>(cell[axis] + (step[axis] > 0 ? 1 : 0)) * mCellSize;
+            tNext[axis] = (boundary - origin[axis]) * invDirection[axis];
+            tDelta[axis] = mCellSize * math::abs(invDirection[axis]);
+        }
+        else {
+            tNext[axis] = FLT_MAX;
+            tDelta[axis] = FLT_MAX;
+        }
+    }
+
+    raycast::ray local = query;
+    const auto test_cells = [&](const int lo[3], const int hi[3]) {
+        int first[3];
+        int last[3];
+        for (int axis = 0; axis < 3; ++axis) {
+            first[axis] = eastl::max(lo[axis], mCellMin[axis]);
+            last[axis] = eastl::min(hi[axis], mCellMax[axis]);
+        }
+        for (int cz = first[2]; cz <= last[2]; ++cz) {
+            for (int cy = first[1]; cy <= last[1]; ++cy) {
+                for (int cx = first[0]; cx <= last[0]; ++cx) {
+                    for_each_in_cell(cx, cy, cz, [&](uint32_t i) {
+                        raycast::result hit;
+                        if (raycast::test_sphere(local, float3::values(mX[i], mY[i], mZ[i]), pointRadius, hit)
+                            && (hit.distance < closest.hit.distance || mIndices[i] < closest.index)) {
+                            closest.index = mIndices[i];
+                            closest.hit = hit;
+                            local.shrink(hit.distance);
+                        }
+                    });
+                }
+            }
+        }
+    };
+
+    {
+        const int lo[3] = { cell[0] - reach, cell[1] - reach, cell[2] - reach };
+        const int hi[3] = { cell[0] + reach, cell[1] + reach, cell[2] + reach };
+        test_cells(lo, hi);
+    }
+
+    for (;;) {
+        const int axis = tNext[0] < tNext[1] ? (tNext[0] < tNext[2] ? 0 : 2) : (tNext[1] < tNext[2] ? 1 : 2);
+        if (step[axis] == 0 || tNext[axis] > local.tmax || tNext[axis] > tFar) {
+            break;
+        }
+        cell[axis] += step[axis];
+        if (cell[axis] < walkMin[axis] || cell[axis] > walkMax[axis]) {
+            break;
+        }
+        tNext[axis] += tDelta[axis];
+
+        int lo[3] = { cell[0] - reach, cell[1] - reach, cell[2] - reach };
+        int hi[3] = { cell[0] + reach, cell[1] + reach, cell[2] + reach };
+        lo[axis] = hi[axis] = cell[axis] + step[axis] * reach;
+        test_cells(lo, hi);
+    }
+    return closest.index != batch_hit::INVALID_INDEX;
+}
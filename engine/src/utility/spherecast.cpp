@@ -165,7 +165,7 @@ namespace eloo::spherecast {
             }
         }
 
-        return hit.distance >= 0.0f;
+        return hit.distance < FLT_MAX;
     }
     bool test_tri(ELOO_RAYCAST_PARAMS_2, float castRadius, FLOAT3_DECLARE_PARAMS(vertex1), FLOAT3_DECLARE_PARAMS(vertex2), FLOAT3_DECLARE_PARAMS(vertex3), result& hit) {
         return test_tri(ELOO_RAYCAST_FORWARD_PARAMS_2, castRadius, { FLOAT3_FORWARD_PARAMS(vertex1) }, { FLOAT3_FORWARD_PARAMS(vertex2) }, { FLOAT3_FORWARD_PARAMS(vertex3) }, hit);
@@ -246,6 +246,47 @@ namespace eloo::spherecast {
     bool test_capsule(ELOO_RAYCAST_PARAMS_4, float castRadius, FLOAT3_DECLARE_PARAMS(origin), float height, float radius, result& hit) {
         return test_capsule(ELOO_RAYCAST_FORWARD_PARAMS_4, castRadius, { FLOAT3_FORWARD_PARAMS(origin) }, height, radius, hit);
     }
+
+
+    /////////////////////////////////////////////////////////////////////
+    // Prepared sweeps
+
+    bool test_plane(const sweep& query, const float4::values& plane, result& hit) {
+        const float4::values planeOffset = { plane.x(), plane.y(), plane.z(), plane.w() + query.radius };
+        return raycast::test_plane(query, planeOffset, hit);
+    }
+
+    bool test_quad(const sweep& query, const float4::values& quad, float width, float height, result& hit) {
+        if (!test_quad(query.origin, query.direction, query.tmax, query.radius, quad, width, height, hit) || !query.accepts(hit.distance)) {
+            hit = result();
+            return false;
+        }
+        return true;
+    }
+
+    bool test_tri(const sweep& query, const float3::values& vertex1, const float3::values& vertex2, const float3::values& vertex3, result& hit) {
+        if (!test_tri(query.origin, query.direction, query.tmax, query.radius, vertex1, vertex2, vertex3, hit) || !query.accepts(hit.distance)) {
+            hit = result();
+            return false;
+        }
+        return true;
+    }
+
+    bool test_aabb(const sweep& query, const float3::values& min, const float3::values& max, result& hit) {
+        return raycast::test_aabb(query, min - float3::ONE * query.radius, max + float3::ONE * query.radius, hit);
+    }
+
+    bool test_sphere(const sweep& query, const float3::values& origin, float radius, result& hit) {
+        return raycast::test_sphere(query, origin, radius + query.radius, hit);
+    }
+
+    bool test_ellipsoid(const sweep& query, const float3::values& origin, const float3::values& radii, result& hit) {
+        return raycast::test_ellipsoid(query, origin, radii + float3::ONE * query.radius, hit);
+    }
+
+    bool test_capsule(const sweep& query, const float3::values& origin, float height, float radius, result& hit) {
+        return raycast::test_capsule(query, origin, height, radius + query.radius, hit);
+    }
 };
 
 
@@ -0,0 +1,348 @@
+#include "utility/surface.h"
+
+#include "maths/simd.h"
+#include "utility/parallel.h"
+
+#include <EASTL/algorithm.h>
+#include <EASTL/type_traits.h>
+#include <EASTL/vector.h>
+
+#include <cstring>
+
+using namespace eloo;
+using namespace eloo::math::simd;
+using namespace eloo::surface;
+
+namespace {
+    // Rows are handed to the workers in bands of roughly this many pixels
+    constexpr uint32_t BAND_PIXELS = 16384;
+
+    // Memory offset of the alpha byte within a pixel, which is the lane the 16 bit kernels read
+#if defined IS_BIG_ENDIAN
+    constexpr int ALPHA_BYTE = 3 - static_cast<int>(colour::A_COMPONENT_SHIFT / 8);
+#else
+    constexpr int ALPHA_BYTE = static_cast<int>(colour::A_COMPONENT_SHIFT / 8);
+#endif
+
+    struct clip_rect {
+        uint32_t dstX, dstY;
+        uint32_t srcX, srcY;
+        uint32_t width, height;
+    };
+
+    // Intersects the rectangle (x, y, width, height) with [0, limitW) x [0, limitH), returning
+    // false when nothing is left. src* is the clipped rectangle's offset within the original
+    bool clip(int32_t x, int32_t y, uint32_t width, uint32_t height, uint32_t limitW, uint32_t limitH, clip_rect& out) {
+        const int64_t x0 = eastl::max<int64_t>(x, 0);
+        const int64_t y0 = eastl::max<int64_t>(y, 0);
+        const int64_t x1 = eastl::min<int64_t>(static_cast<int64_t>(x) + width, limitW);
+        const int64_t y1 = eastl::min<int64_t>(static_cast<int64_t>(y) + height, limitH);
+        if (x1 <= x0 || y1 <= y0) {
+            return false;
+        }
+        out = {
+            static_cast<uint32_t>(x0), static_cast<uint32_t>(y0),
+            static_cast<uint32_t>(x0 - x), static_cast<uint32_t>(y0 - y),
+            static_cast<uint32_t>(x1 - x0), static_cast<uint32_t>(y1 - y0)
+        };
+        return true;
+    }
+
+    template <typename RowsFn>
+    void for_each_band(uint32_t rows, uint32_t width, RowsFn rowsFn) {
+        const size_t rowsPerBand = width < BAND_PIXELS ? BAND_PIXELS / width : 1;
+        parallel::parallel_for(rows, rowsPerBand, [&](size_t begin, size_t end) {
+            rowsFn(static_cast<uint32_t>(begin), static_cast<uint32_t>(end));
+        });
+    }
+
+    ELOO_FORCE_INLINE i32x4 load_pixels(const colour_t* p, uint32_t lanes) {
+        if (lanes == WIDTH) {
+            return load_i32(reinterpret_cast<const int32_t*>(p));
+        }
+        int32_t tmp[WIDTH] = {};
+        std::memcpy(tmp, p, lanes * sizeof(colour_t));
+        return load_i32(tmp);
+    }
+
+    ELOO_FORCE_INLINE void store_pixels(colour_t* p, uint32_t lanes, i32x4 pixels) {
+        if (lanes == WIDTH) {
+            store_i32(reinterpret_cast<int32_t*>(p), pixels);
+            return;
+        }
+        int32_t tmp[WIDTH];
+        store_i32(tmp, pixels);
+        std::memcpy(p, tmp, lanes * sizeof(colour_t));
+    }
+
+
+    /////////////////////////////////////////////////////////////////////
+    // Blend kernels
+
+    // Two pixels in 16 bit lanes. 'alphaLanes' holds 255 in each alpha lane and 0 elsewhere
+    template <blend_mode Mode, bool Tinted>
+    ELOO_FORCE_INLINE u16x8 blend_pair(u16x8 d, u16x8 s, u16x8 tint, u16x8 alphaLanes) {
+        if constexpr (Tinted) {
+            s = div255(s * tint);
+        }
+        if constexpr (Mode == blend_mode::replace) {
+            return s;
+        } else {
+            const u16x8 sa = broadcast4<ALPHA_BYTE>(s);
+            const u16x8 inverse = set1_u16(255) - sa;
+            // Source with its alpha lane forced to 255, so 'opaque * sa' carries sa through to alpha
+            const u16x8 opaque = s | alphaLanes;
+
+            if constexpr (Mode == blend_mode::alpha) {
+                return div255(opaque * sa + d * inverse);
+            } else if constexpr (Mode == blend_mode::premultiplied) {
+                return s + div255(d * inverse);
+            } else if constexpr (Mode == blend_mode::additive) {
+                return d + div255(opaque * sa);
+            } else {
+                return div255(d * (div255(opaque * sa) + inverse));
+            }
+        }
+    }
+
+    // Blends 'count' pixels into 'dst', pulling 4 source pixels at a time from sourceFn(index, lanes)
+    template <blend_mode Mode, bool Tinted, typename SourceFn>
+    void blend_span(colour_t* dst, uint32_t count, colour_t tint, SourceFn sourceFn) {
+        const u16x8 tintLanes = widen_lo(set1_i32(static_cast<int32_t>(tint)));
+        const u16x8 alphaLanes = widen_lo(set1_i32(static_cast<int32_t>(colour::A_COMPONENT_MASK)));
+        for (uint32_t i = 0; i < count; i += WIDTH) {
+            const uint32_t lanes = count - i < WIDTH ? count - i : WIDTH;
+            const i32x4 s = sourceFn(i, lanes);
+            i32x4 result;
+            if constexpr (Mode == blend_mode::replace && !Tinted) {
+                result = s;
+            } else {
+                const i32x4 d = load_pixels(dst + i, lanes);
+                result = narrow(
+                    blend_pair<Mode, Tinted>(widen_lo(d), widen_lo(s), tintLanes, alphaLanes),
+                    blend_pair<Mode, Tinted>(widen_hi(d), widen_hi(s), tintLanes, alphaLanes));
+            }
+            store_pixels(dst + i, lanes, result);
+        }
+    }
+
+    template <blend_mode Mode, bool Tinted>
+    void blend_row(colour_t* dst, const colour_t* src, uint32_t count, colour_t tint) {
+        if constexpr (Mode == blend_mode::replace && !Tinted) {
+            std::memcpy(dst, src, count * sizeof(colour_t));
+        } else {
+            blend_span<Mode, Tinted>(dst, count, tint, [src](uint32_t i, uint32_t lanes) { return load_pixels(src + i, lanes); });
+        }
+    }
+
+    // Calls fn.template operator()<Mode, Tinted>() with the runtime choices as template arguments
+    template <typename KernelFn>
+    void dispatch(blend_mode mode, bool tinted, KernelFn&& kernelFn) {
+        auto withMode = [&]<bool Tinted>() {
+            switch (mode) {
+            case blend_mode::replace:
+                kernelFn.template operator()<blend_mode::replace, Tinted>();
+                return;
+            case blend_mode::alpha:
+                kernelFn.template operator()<blend_mode::alpha, Tinted>();
+                return;
+            case blend_mode::premultiplied:
+                kernelFn.template operator()<blend_mode::premultiplied, Tinted>();
+                return;
+            case blend_mode::additive:
+                kernelFn.template operator()<blend_mode::additive, Tinted>();
+                return;
+            case blend_mode::multiply:
+                kernelFn.template operator()<blend_mode::multiply, Tinted>();
+                return;
+            }
+            ELOO_ASSERT_FALSE("Unknown blend mode %d", static_cast<int>(mode));
+        };
+        if (tinted) {
+            withMode.template operator()<true>();
+        } else {
+            withMode.template operator()<false>();
+        }
+    }
+
+    void blit_impl(const view& dst, const const_view& src, int32_t x, int32_t y, colour_t tint, bool tinted, blend_mode mode) {
+        clip_rect rect;
+        if (!clip(x, y, src.width, src.height, dst.width, dst.height, rect)) {
+            return;
+        }
+        dispatch(mode, tinted, [&]<blend_mode Mode, bool Tinted>() {
+            for_each_band(rect.height, rect.width, [&](uint32_t begin, uint32_t end) {
+                for (uint32_t row = begin; row < end; ++row) {
+                    blend_row<Mode, Tinted>(dst.row(rect.dstY + row) + rect.dstX, src.row(rect.srcY + row) + rect.srcX, rect.width, tint);
+                }
+            });
+        });
+    }
+
+
+    /////////////////////////////////////////////////////////////////////
+    // Bilinear sampling
+
+    // Blends two pixels 'f' / 256 of the way from a to b, two channels at a time
+    ELOO_FORCE_INLINE colour_t lerp_pixel(colour_t a, colour_t b, uint32_t f) {
+        const uint32_t inverse = 256 - f;
+        const uint32_t rb = ((a & 0x00FF00FFu) * inverse + (b & 0x00FF00FFu) * f + 0x00800080u) >> 8;
+        const uint32_t ag = ((a >> 8) & 0x00FF00FFu) * inverse + ((b >> 8) & 0x00FF00FFu) * f + 0x00800080u;
+        return (rb & 0x00FF00FFu) | (ag & 0xFF00FF00u);
+    }
+
+    struct sample_axis {
+        eastl::vector<uint32_t> first;
+        eastl::vector<uint32_t> second;
+        eastl::vector<uint32_t> weight;
+    };
+
+    // Maps 'count' destination pixels, starting 'offset' into a span of 'size', onto a source
+    // axis of 'sourceSize' texels. Pixel centres line up, positions outside clamp to the edge
+    sample_axis build_axis(uint32_t offset, uint32_t count, uint32_t size, uint32_t sourceSize) {
+        sample_axis axis;
+        axis.first.resize(count);
+        axis.second.resize(count);
+        axis.weight.resize(count);
+
+        const int64_t step = (static_cast<int64_t>(sourceSize) << 16) / size;
+        const int64_t last = static_cast<int64_t>(sourceSize) - 1;
+        for (uint32_t i = 0; i < count; ++i) {
+            const int64_t position = eastl::max<int64_t>((offset + i) * step + step / 2 - 0x8000, 0);
+            const int64_t texel = position >> 16;
+            axis.first[i] = static_cast<uint32_t>(eastl::min(texel, last));
+            axis.second[i] = static_cast<uint32_t>(eastl::min(texel + 1, last));
+            axis.weight[i] = texel < last ? static_cast<uint32_t>((position >> 8) & 0xFF) : 0;
+        }
+        return axis;
+    }
+}
+
+
+/////////////////////////////////////////////////////////////////////
+// Views
+
+view view::sub(int32_t x, int32_t y, uint32_t w, uint32_t h) const {
+    clip_rect rect;
+    if (!clip(x, y, w, h, width, height, rect)) {
+        return view(pixels, 0, 0, stride);
+    }
+    return view(row(rect.dstY) + rect.dstX, rect.width, rect.height, stride);
+}
+
+const_view const_view::sub(int32_t x, int32_t y, uint32_t w, uint32_t h) const {
+    clip_rect rect;
+    if (!clip(x, y, w, h, width, height, rect)) {
+        return const_view(pixels, 0, 0, stride);
+    }
+    return const_view(row(rect.dstY) + rect.dstX, rect.width, rect.height, stride);
+}
+
+
+/////////////////////////////////////////////////////////////////////
+// Compositing
+
+void surface::fill(const view& dst, colour_t colour, blend_mode mode) {
+    if (dst.width == 0 || dst.height == 0) {
+        return;
+    }
+    const i32x4 source = set1_i32(static_cast<int32_t>(colour));
+    dispatch(mode, false, [&]<blend_mode Mode, bool Tinted>() {
+        for_each_band(dst.height, dst.width, [&](uint32_t begin, uint32_t end) {
+            for (uint32_t y = begin; y < end; ++y) {
+                blend_span<Mode, Tinted>(dst.row(y), dst.width, colour::C_WHITE, [source](uint32_t, uint32_t) { return source; });
+            }
+        });
+    });
+}
+
+void surface::blit(const view& dst, const const_view& src, int32_t x, int32_t y, blend_mode mode) {
+    blit_impl(dst, src, x, y, colour::C_WHITE, false, mode);
+}
+
+void surface::blit_tinted(const view& dst, const const_view& src, int32_t x, int32_t y, colour_t tint, blend_mode mode) {
+    blit_impl(dst, src, x, y, tint, tint != colour::C_WHITE, mode);
+}
+
+void surface::blit_scaled(const view& dst, const const_view& src, int32_t x, int32_t y, uint32_t width, uint32_t height, blend_mode mode, colour_t tint) {
+    clip_rect rect;
+    if (src.width == 0 || src.height == 0 || !clip(x, y, width, height, dst.width, dst.height, rect)) {
+        return;
+    }
+
+    const sample_axis columns = build_axis(rect.srcX, rect.width, width, src.width);
+    const sample_axis rows = build_axis(rect.srcY, rect.height, height, src.height);
+
+    dispatch(mode, tint != colour::C_WHITE, [&]<blend_mode Mode, bool Tinted>() {
+        for_each_band(rect.height, rect.width, [&](uint32_t begin, uint32_t end) {
+            // Each band resamples a row into scratch, then blends it like a regular blit
+            eastl::vector<colour_t> scratch(rect.width);
+            for (uint32_t row = begin; row < end; ++row) {
+                const colour_t* top = src.row(rows.first[row]);
+                const colour_t* bottom = src.row(rows.second[row]);
+                const uint32_t fy = rows.weight[row];
+                for (uint32_t i = 0; i < rect.width; ++i) {
+                    const uint32_t x0 = columns.first[i];
+                    const uint32_t x1 = columns.second[i];
+                    const uint32_t fx = columns.weight[i];
+                    scratch[i] = lerp_pixel(lerp_pixel(top[x0], top[x1], fx), lerp_pixel(bottom[x0], bottom[x1], fx), fy);
+                }
+                blend_row<Mode, Tinted>(dst.row(rect.dstY + row) + rect.dstX, scratch.data(), rect.width, tint);
+            }
+        });
+    });
+}
+
+void surface::premultiply(const view& target) {
+    if (target.width == 0 || target.height == 0) {
+        return;
+    }
+    const u16x8 alphaLanes = widen_lo(set1_i32(static_cast<int32_t>(colour::A_COMPONENT_MASK)));
+    for_each_band(target.height, target.width, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t y = begin; y < end; ++y) {
+            colour_t* pixels = target.row(y);
+            for (uint32_t i = 0; i < target.width; i += WIDTH) {
+                const uint32_t lanes = target.width - i < WIDTH ? target.width - i : WIDTH;
+                const i32x4 p = load_pixels(pixels + i, lanes);
+                const u16x8 lo = widen_lo(p);
+                const u16x8 hi = widen_hi(p);
+                store_pixels(pixels + i, lanes, narrow(
+                    div255((lo | alphaLanes) * broadcast4<ALPHA_BYTE>(lo)),
+                    div255((hi | alphaLanes) * broadcast4<ALPHA_BYTE>(hi))));
+            }
+        }
+    });
+}
+
+void surface::unpremultiply(const view& target) {
+    if (target.width == 0 || target.height == 0) {
+        return;
+    }
+
+    // ceil(255 * 2^24 / a) gives exactly round(c * 255 / a) for every 8 bit c and a
+    static const eastl::vector<uint64_t> gReciprocals = [] {
+        eastl::vector<uint64_t> reciprocals(256, 0);
+        for (uint64_t a = 1; a < 256; ++a) {
+            reciprocals[a] = ((255ull << 24) + a - 1) / a;
+        }
+        return reciprocals;
+    }();
+
+    for_each_band(target.height, target.width, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t y = begin; y < end; ++y) {
+            colour_t* pixels = target.row(y);
+            for (uint32_t i = 0; i < target.width; ++i) {
+                const colour_t p = pixels[i];
+                const uint8_t a = colour::get_a(p);
+                if (a == 0xFF) {
+                    continue;
+                }
+                const uint64_t reciprocal = gReciprocals[a];
+                auto channel = [reciprocal](uint8_t c) {
+                    return static_cast<uint8_t>(eastl::min<uint64_t>((c * reciprocal + (1ull << 23)) >> 24, 255));
+                };
+                pixels[i] = colour::make_rgba(channel(colour::get_r(p)), channel(colour::get_g(p)), channel(colour::get_b(p)), a);
+            }
+        }
+    });
+}
@@ -0,0 +1,501 @@
+#include "utility/sweep_and_prune.h"
+
+#include "maths/math.h"
+
+using namespace eloo;
+using namespace eloo::spatial;
+
+namespace {
+    constexpr uint32_t NONE = sweep_and_prune::INVALID_PROXY;
+
+    // Marks empty hash table slots, and no pair key can be this as proxyA < proxyB
+    constexpr uint64_t EMPTY_KEY = UINT64_MAX;
+
+    // The hash table starts with this many slots and doubles whenever it would be over half full
+    constexpr size_t INITIAL_SLOTS = 64;
+
+    // Pair states
+    constexpr uint8_t PAIR_PRESENT = 1;
+    constexpr uint8_t PAIR_REPORTED = 2;
+    constexpr uint8_t PAIR_CHANGED = 4;
+
+    // Ends of the sentinels bounding every axis, which no finite endpoint ever passes
+    constexpr uint32_t SENTINEL_MIN = UINT32_MAX - 1;
+    constexpr uint32_t SENTINEL_MAX = UINT32_MAX;
+
+    // Where removed proxies are moved to leave every pair before they are dropped
+    constexpr float REMOVED = FLT_MAX;
+
+    ELOO_FORCE_INLINE uint32_t hash_key(uint64_t key) {
+        return static_cast<uint32_t>((key * 0x9E3779B97F4A7C15ull) >> 32);
+    }
+
+    ELOO_FORCE_INLINE uint64_t pair_key(uint32_t a, uint32_t b) {
+        return a < b ? (static_cast<uint64_t>(a) << 32) | b : (static_cast<uint64_t>(b) << 32) | a;
+    }
+
+    ELOO_FORCE_INLINE bool is_max(uint32_t end) {
+        return (end & 1) != 0;
+    }
+
+    // Equal values put mins first, so boxes that only touch still overlap
+    ELOO_FORCE_INLINE bool precedes(float valueA, uint32_t endA, float valueB, uint32_t endB) {
+        return valueA < valueB || (valueA == valueB && !is_max(endA) && is_max(endB));
+    }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Proxies
+
+sweep_and_prune::sweep_and_prune() {
+    clear();
+}
+
+void sweep_and_prune::reserve(size_t proxies) {
+    mProxies.reserve(proxies);
+    for (int axis = 0; axis < 3; ++axis) {
+        mValues[axis].reserve(proxies * 2 + 2);
+        mEnds[axis].reserve(proxies * 2 + 2);
+    }
+}
+
+void sweep_and_prune::clear() {
+    mProxies.clear();
+    for (int axis = 0; axis < 3; ++axis) {
+        mValues[axis].assign({ -INFINITY, INFINITY });
+        mEnds[axis].assign({ SENTINEL_MIN, SENTINEL_MAX });
+    }
+    mSlots.assign(INITIAL_SLOTS, { EMPTY_KEY, 0, 0, 0 });
+    mChanged.clear();
+    mEnded.clear();
+    mFreeProxy = NONE;
+    mProxyCount = 0;
+    mPairCount = 0;
+    mUsedSlots = 0;
+}
+
+// Both endpoints start past everything else, where the box overlaps nothing, and sort down into
+// place. Pairs only need tracking on the last axis, once the other two are already in place
+uint32_t sweep_and_prune::insert(const float3::values& min, const float3::values& max, uint32_t userData) {
+    const float mins[3] = { min.x(), min.y(), min.z() };
+    const float maxs[3] = { max.x(), max.y(), max.z() };
+    for (int axis = 0; axis < 3; ++axis) {
+        ELOO_ASSERT_FATAL(mins[axis] <= maxs[axis] && mins[axis] > -FLT_MAX && maxs[axis] < FLT_MAX, "Sweep and prune box is empty or not finite");
+    }
+
+    uint32_t id = mFreeProxy;
+    if (id != NONE) {
+        mFreeProxy = mProxies[id].userData;
+    }
+    else {
+        id = static_cast<uint32_t>(mProxies.size());
+        mProxies.emplace_back();
+    }
+    mProxies[id].userData = userData;
+    ++mProxyCount;
+
+    for (int axis = 0; axis < 3; ++axis) {
+        eastl::vector<float>& values = mValues[axis];
+        eastl::vector<uint32_t>& ends = mEnds[axis];
+        const uint32_t first = static_cast<uint32_t>(values.size() - 1);
+        values.resize(values.size() + 2, INFINITY);
+        ends.resize(ends.size() + 2, SENTINEL_MAX);
+        values[first] = mins[axis];
+        values[first + 1] = maxs[axis];
+        ends[first] = id << 1;
+        ends[first + 1] = (id << 1) | 1;
+        mProxies[id].minIndex[axis] = first;
+        mProxies[id].maxIndex[axis] = first + 1;
+
+        sort_down(axis, first, axis == 2);
+        sort_down(axis, mProxies[id].maxIndex[axis], axis == 2);
+    }
+    return id;
+}
+
+// Moves the box past everything else, which ends each of its pairs as its first axis min passes
+// the other box's max, and then drops the endpoints from the top of each axis.
+//
+// The proxy id may be reused before the next flush, so every pair of the proxy that is no longer
+// present is settled now: reported as removed if it was last reported as added, and left
+// unreported so that a new pair under the same key starts afresh. Pairs that ended earlier in the
+// frame count too, and every pair that isn't present is queued as changed, so only those need
+// looking at
+void sweep_and_prune::remove(uint32_t proxy) {
+    ELOO_ASSERT_FATAL(proxy < mProxies.size() && mProxies[proxy].minIndex[0] != NONE, "Invalid sweep and prune proxy %u", proxy);
+
+    for (int axis = 0; axis < 3; ++axis) {
+        mValues[axis][mProxies[proxy].maxIndex[axis]] = REMOVED;
+        sort_up(axis, mProxies[proxy].maxIndex[axis], false);
+        mValues[axis][mProxies[proxy].minIndex[axis]] = REMOVED;
+        sort_up(axis, mProxies[proxy].minIndex[axis], axis == 0);
+
+        eastl::vector<float>& values = mValues[axis];
+        eastl::vector<uint32_t>& ends = mEnds[axis];
+        const size_t last = values.size() - 3;
+        values[last] = INFINITY;
+        ends[last] = SENTINEL_MAX;
+        values.resize(last + 1);
+        ends.resize(last + 1);
+    }
+
+    for (const uint64_t key : mChanged) {
+        const uint32_t proxyA = static_cast<uint32_t>(key >> 32);
+        const uint32_t proxyB = static_cast<uint32_t>(key);
+        if (proxyA != proxy && proxyB != proxy) {
+            continue;
+        }
+        pair_slot& entry = mSlots[find_slot(key)];
+        if ((entry.state & (PAIR_PRESENT | PAIR_REPORTED)) == PAIR_REPORTED) {
+            mEnded.push_back({ proxyA, proxyB, entry.userDataA, entry.userDataB });
+            entry.state &= ~PAIR_REPORTED;
+        }
+    }
+
+    mProxies[proxy].minIndex[0] = NONE;
+    mProxies[proxy].userData = mFreeProxy;
+    mFreeProxy = proxy;
+    --mProxyCount;
+}
+
+// Growing sides move first, so neither endpoint ever has to pass the other one
+void sweep_and_prune::update(uint32_t proxy, const float3::values& min, const float3::values& max) {
+    ELOO_ASSERT_FATAL(proxy < mProxies.size() && mProxies[proxy].minIndex[0] != NONE, "Invalid sweep and prune proxy %u", proxy);
+    const float mins[3] = { min.x(), min.y(), min.z() };
+    const float maxs[3] = { max.x(), max.y(), max.z() };
+
+    for (int axis = 0; axis < 3; ++axis) {
+        ELOO_ASSERT_FATAL(mins[axis] <= maxs[axis] && mins[axis] > -FLT_MAX && maxs[axis] < FLT_MAX, "Sweep and prune box is empty or not finite");
+
+        const box_proxy& entry = mProxies[proxy];
+        float* values = mValues[axis].data();
+        const float minDelta = mins[axis] - values[entry.minIndex[axis]];
+        const float maxDelta = maxs[axis] - values[entry.maxIndex[axis]];
+        values[entry.minIndex[axis]] = mins[axis];
+        values[entry.maxIndex[axis]] = maxs[axis];
+
+        if (minDelta < 0.0f) {
+            sort_down(axis, entry.minIndex[axis], true);
+        }
+        if (maxDelta > 0.0f) {
+            sort_up(axis, entry.maxIndex[axis], true);
+        }
+        if (minDelta > 0.0f) {
+            sort_up(axis, entry.minIndex[axis], true);
+        }
+        if (maxDelta < 0.0f) {
+            sort_down(axis, entry.maxIndex[axis], true);
+        }
+    }
+}
+
+uint32_t sweep_and_prune::user_data(uint32_t proxy) const {
+    ELOO_ASSERT_FATAL(proxy < mProxies.size() && mProxies[proxy].minIndex[0] != NONE, "Invalid sweep and prune proxy %u", proxy);
+    return mProxies[proxy].userData;
+}
+
+float3::values sweep_and_prune::min(uint32_t proxy) const {
+    ELOO_ASSERT_FATAL(proxy < mProxies.size() && mProxies[proxy].minIndex[0] != NONE, "Invalid sweep and prune proxy %u", proxy);
+    const box_proxy& entry = mProxies[proxy];
+    return { mValues[0][entry.minIndex[0]], mValues[1][entry.minIndex[1]], mValues[2][entry.minIndex[2]] };
+}
+
+float3::values sweep_and_prune::max(uint32_t proxy) const {
+    ELOO_ASSERT_FATAL(proxy < mProxies.size() && mProxies[proxy].minIndex[0] != NONE, "Invalid sweep and prune proxy %u", proxy);
+    const box_proxy& entry = mProxies[proxy];
+    return { mValues[0][entry.maxIndex[0]], mValues[1][entry.maxIndex[1]], mValues[2][entry.maxIndex[2]] };
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Sorting
+
+// A min passing a max going down starts the two intervals overlapping on this axis, and a max
+// passing a min going down ends it. The box only has to be checked on the other two axes, as the
+// crossing itself settles this one. Other axes may still hold the proxy's old endpoints, but any
+// of them that is wrong is put right as that axis is sorted
+void sweep_and_prune::sort_down(int axis, uint32_t index, bool updatePairs) {
+    float* values = mValues[axis].data();
+    uint32_t* ends = mEnds[axis].data();
+    const float value = values[index];
+    const uint32_t end = ends[index];
+    const uint32_t self = end >> 1;
+
+    while (precedes(value, end, values[index - 1], ends[index - 1])) {
+        const uint32_t other = ends[index - 1];
+        if (updatePairs) {
+            if (!is_max(end) && is_max(other)) {
+                if (overlaps_off_axis(self, other >> 1, axis)) {
+                    add_pair(self, other >> 1);
+                }
+            }
+            else if (is_max(end) && !is_max(other)) {
+                remove_pair(self, other >> 1);
+            }
+        }
+
+        values[index] = values[index - 1];
+        ends[index] = other;
+        box_proxy& moved = mProxies[other >> 1];
+        (is_max(other) ? moved.maxIndex : moved.minIndex)[axis] = index;
+        --index;
+    }
+
+    values[index] = value;
+    ends[index] = end;
+    box_proxy& entry = mProxies[self];
+    (is_max(end) ? entry.maxIndex : entry.minIndex)[axis] = index;
+}
+
+// The mirror of sort_down(), where a max passing a min going up starts an overlap and a min
+// passing a max ends one
+void sweep_and_prune::sort_up(int axis, uint32_t index, bool updatePairs) {
+    float* values = mValues[axis].data();
+    uint32_t* ends = mEnds[axis].data();
+    const float value = values[index];
+    const uint32_t end = ends[index];
+    const uint32_t self = end >> 1;
+
+    while (precedes(values[index + 1], ends[index + 1], value, end)) {
+        const uint32_t other = ends[index + 1];
+        if (updatePairs) {
+            if (is_max(end) && !is_max(other)) {
+                if (overlaps_off_axis(self, other >> 1, axis)) {
+                    add_pair(self, other >> 1);
+                }
+            }
+            else if (!is_max(end) && is_max(other)) {
+                remove_pair(self, other >> 1);
+            }
+        }
+
+        values[index] = values[index + 1];
+        ends[index] = other;
+        box_proxy& moved = mProxies[other >> 1];
+        (is_max(other) ? moved.maxIndex : moved.minIndex)[axis] = index;
+        ++index;
+    }
+
+    values[index] = value;
+    ends[index] = end;
+    box_proxy& entry = mProxies[self];
+    (is_max(end) ? entry.maxIndex : entry.minIndex)[axis] = index;
+}
+
+// Endpoint positions order the same way as their values, ties included, so comparing indices
+// is enough
+bool sweep_and_prune::overlaps_off_axis(uint32_t a, uint32_t b, int axis) const {
+    const box_proxy& first = mProxies[a];
+    const box_proxy& second = mProxies[b];
+    const int axis1 = (axis + 1) % 3;
+    const int axis2 = (axis + 2) % 3;
+    return first.minIndex[axis1] < second.maxIndex[axis1] && second.minIndex[axis1] < first.maxIndex[axis1]
+        && first.minIndex[axis2] < second.maxIndex[axis2] && second.minIndex[axis2] < first.maxIndex[axis2];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Pairs
+
+uint32_t sweep_and_prune::find_slot(uint64_t key) const {
+    const uint32_t mask = static_cast<uint32_t>(mSlots.size() - 1);
+    for (uint32_t i = hash_key(key) & mask;; i = (i + 1) & mask) {
+        if (mSlots[i].key == key) {
+            return i;
+        }
+        if (mSlots[i].key == EMPTY_KEY) {
+            return NONE;
+        }
+    }
+}
+
+bool sweep_and_prune::overlapping(uint32_t proxyA, uint32_t proxyB) const {
+    if (proxyA == proxyB) {
+        return false;
+    }
+    const uint32_t slot = find_slot(pair_key(proxyA, proxyB));
+    return slot != NONE && (mSlots[slot].state & PAIR_PRESENT) != 0;
+}
+
+// The pair's slot as found by find_slot(), or a new empty one added with linear probing, doubling
+// the table before it gets over half full. Changed pairs are queued for flush_events() once
+sweep_and_prune::pair_slot& sweep_and_prune::touch_pair(uint64_t key, uint32_t slot) {
+    if (slot == NONE) {
+        if ((mUsedSlots + 1) * 2 > mSlots.size()) {
+            eastl::vector<pair_slot> previous;
+            previous.swap(mSlots);
+            mSlots.assign(previous.size() * 2, { EMPTY_KEY, 0, 0, 0 });
+            const uint32_t mask = static_cast<uint32_t>(mSlots.size() - 1);
+            for (const pair_slot& entry : previous) {
+                if (entry.key != EMPTY_KEY) {
+                    uint32_t i = hash_key(entry.key) & mask;
+                    while (mSlots[i].key != EMPTY_KEY) {
+                        i = (i + 1) & mask;
+                    }
+                    mSlots[i] = entry;
+                }
+            }
+        }
+
+        const uint32_t mask = static_cast<uint32_t>(mSlots.size() - 1);
+        slot = hash_key(key) & mask;
+        while (mSlots[slot].key != EMPTY_KEY) {
+            slot = (slot + 1) & mask;
+        }
+        mSlots[slot] = { key, 0, 0, 0 };
+        ++mUsedSlots;
+    }
+
+    pair_slot& entry = mSlots[slot];
+    if ((entry.state & PAIR_CHANGED) == 0) {
+        entry.state |= PAIR_CHANGED;
+        mChanged.push_back(key);
+    }
+    return entry;
+}
+
+void sweep_and_prune::add_pair(uint32_t a, uint32_t b) {
+    const uint64_t key = pair_key(a, b);
+    const uint32_t slot = find_slot(key);
+    if (slot != NONE && (mSlots[slot].state & PAIR_PRESENT) != 0) {
+        return;
+    }
+
+    pair_slot& entry = touch_pair(key, slot);
+    entry.state |= PAIR_PRESENT;
+    entry.userDataA = mProxies[static_cast<uint32_t>(key >> 32)].userData;
+    entry.userDataB = mProxies[static_cast<uint32_t>(key)].userData;
+    ++mPairCount;
+}
+
+void sweep_and_prune::remove_pair(uint32_t a, uint32_t b) {
+    const uint64_t key = pair_key(a, b);
+    const uint32_t slot = find_slot(key);
+    if (slot == NONE || (mSlots[slot].state & PAIR_PRESENT) == 0) {
+        return;
+    }
+
+    pair_slot& entry = touch_pair(key, slot);
+    entry.state &= ~PAIR_PRESENT;
+    entry.userDataA = mProxies[static_cast<uint32_t>(key >> 32)].userData;
+    entry.userDataB = mProxies[static_cast<uint32_t>(key)].userData;
+    --mPairCount;
+}
+
+// Later entries of the probe run are shifted back into the hole, unless that would move them
+// before their home slot, so lookups never need tombstones
+void sweep_and_prune::erase_slot(uint32_t slot) {
+    const uint32_t mask = static_cast<uint32_t>(mSlots.size() - 1);
+    uint32_t hole = slot;
+    for (uint32_t i = (hole + 1) & mask; mSlots[i].key != EMPTY_KEY; i = (i + 1) & mask) {
+        const uint32_t home = hash_key(mSlots[i].key) & mask;
+        if (((i - home) & mask) >= ((i - hole) & mask)) {
+            mSlots[hole] = mSlots[i];
+            hole = i;
+        }
+    }
+    mSlots[hole].key = EMPTY_KEY;
+    --mUsedSlots;
+}
+
+size_t sweep_and_prune::pairs(eastl::vector<overlap_pair>& out) const {
+    const size_t first = out.size();
+    for (const pair_slot& entry : mSlots) {
+        if (entry.key != EMPTY_KEY && (entry.state & PAIR_PRESENT) != 0) {
+            const uint32_t proxyA = static_cast<uint32_t>(entry.key >> 32);
+            const uint32_t proxyB = static_cast<uint32_t>(entry.key);
+            out.push_back({ proxyA, proxyB, mProxies[proxyA].userData, mProxies[proxyB].userData });
+        }
+    }
+    return out.size() - first;
+}
+
+// Compares each changed pair with how it stood at the last flush, so a pair that came and went
+// in between reports nothing. Pairs that ended are dropped from the table once reported
+void sweep_and_prune::flush_events(eastl::vector<overlap_pair>& added, eastl::vector<overlap_pair>& removed) {
+    removed.insert(removed.end(), mEnded.begin(), mEnded.end());
+    mEnded.clear();
+
+    for (const uint64_t key : mChanged) {
+        const uint32_t slot = find_slot(key);
+        pair_slot& entry = mSlots[slot];
+        const bool present = (entry.state & PAIR_PRESENT) != 0;
+        const bool reported = (entry.state & PAIR_REPORTED) != 0;
+        const overlap_pair pair = { static_cast<uint32_t>(key >> 32), static_cast<uint32_t>(key), entry.userDataA, entry.userDataB };
+        if (present && !reported) {
+            added.push_back(pair);
+        }
+        else if (!present && reported) {
+            removed.push_back(pair);
+        }
+
+        if (present) {
+            entry.state = PAIR_PRESENT | PAIR_REPORTED;
+        }
+        else {
+            erase_slot(slot);
+        }
+    }
+    mChanged.clear();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Queries
+
+// Walks the x axis from the ray's start, over mins going right or maxes going left, and stops
+// at the first box that starts beyond the closest hit so far
+bool sweep_and_prune::raycast(const raycast::ray& query, batch_hit& closest) const {
+    closest = batch_hit();
+    raycast::ray local = query;
+    const float* values = mValues[0].data();
+    const uint32_t* ends = mEnds[0].data();
+    const float originX = query.origin.x();
+    const float invDirectionX = query.invDirection.x();
+
+    const auto test_proxy = [&](uint32_t id) {
+        const box_proxy& entry = mProxies[id];
+        const float3::values boxMin = { values[entry.minIndex[0]], mValues[1][entry.minIndex[1]], mValues[2][entry.minIndex[2]] };
+        const float3::values boxMax = { values[entry.maxIndex[0]], mValues[1][entry.maxIndex[1]], mValues[2][entry.maxIndex[2]] };
+        raycast::result hit;
+        if (raycast::test_aabb(local, boxMin, boxMax, hit) && (hit.distance < closest.hit.distance || entry.userData < closest.index)) {
+            closest.index = entry.userData;
+            closest.hit = hit;
+            local.shrink(hit.distance);
+        }
+    };
+
+    // A ray running along x gives NaN distances for boxes level with its origin, and the
+    // comparisons below keep those rather than stopping or skipping on them
+    const size_t last = mValues[0].size() - 1;
+    if (query.sign[0] == 0) {
+        for (size_t i = 1; i < last; ++i) {
+            if (is_max(ends[i])) {
+                continue;
+            }
+            if ((values[i] - originX) * invDirectionX > local.tmax) {
+                break;
+            }
+            const uint32_t id = ends[i] >> 1;
+            if (!((values[mProxies[id].maxIndex[0]] - originX) * invDirectionX < local.tmin)) {
+                test_proxy(id);
+            }
+        }
+    }
+    else {
+        for (size_t i = last - 1; i > 0; --i) {
+            if (!is_max(ends[i])) {
+                continue;
+            }
+            if ((values[i] - originX) * invDirectionX > local.tmax) {
+                break;
+            }
+            const uint32_t id = ends[i] >> 1;
+            if (!((values[mProxies[id].minIndex[0]] - originX) * invDirectionX < local.tmin)) {
+                test_proxy(id);
+            }
+        }
+    }
+    return closest.index != batch_hit::INVALID_INDEX;
+}
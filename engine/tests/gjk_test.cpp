@@ -0,0 +1,159 @@
+#include "test.h"
+
+#include "maths/math.h"
+#include "maths/random.h"
+#include "utility/gjk.h"
+
+#include <EASTL/vector.h>
+
+using namespace eloo;
+
+// closest_points() and penetration() against the support functions. Along any unit direction n
+// the gap between the shapes is min over B of n.b minus max over A of n.a. The distance between
+// separated shapes is the largest gap over all directions, and the penetration depth of
+// overlapping ones is the smallest overlap, so searching directions bounds both from the other
+// side to GJK and EPA
+
+namespace {
+    constexpr int PAIRS = 3000;
+    constexpr uint32_t DIRECTIONS = 4000;
+    constexpr float SPREAD = 1.2f;
+    constexpr uint32_t ASCENT_STEPS = 400;
+    constexpr float ASCENT_RATE = 0.05f;
+    constexpr uint32_t HULL_VERTICES = 24;
+    // Allowed error, relative to the size of the shapes
+    constexpr float TOLERANCE = 1e-3f;
+    // The same for the gap along the reported normal. Near contact, rounding of the closest point
+    // leaves its direction loose by about the square root of that rounding, which tilts the gap
+    // between a corner and a curved face by a few times TOLERANCE
+    constexpr float NORMAL_TOLERANCE = 4e-3f;
+
+    float3::values random_point(math::random::generator& rng, float extent) {
+        return { rng.range(-extent, extent), rng.range(-extent, extent), rng.range(-extent, extent) };
+    }
+
+    // Each shape has a size of about one, so errors compare across types
+    gjk::shape random_shape(math::random::generator& rng, uint32_t kind, eastl::vector<float3::values>& hull) {
+        const float3::values centre = random_point(rng, SPREAD);
+        switch (kind) {
+            case 0:  return gjk::shape::sphere(centre, rng.range(0.2f, 1.0f));
+            case 1:  return gjk::shape::capsule(centre, rng.range(0.0f, 1.5f), rng.range(0.2f, 0.8f));
+            case 2:  return gjk::shape::box(centre, centre + float3::values(rng.range(0.2f, 2.0f), rng.range(0.2f, 2.0f), rng.range(0.2f, 2.0f)));
+            case 3:  return gjk::shape::ellipsoid(centre, { rng.range(0.05f, 1.5f), rng.range(0.05f, 1.5f), rng.range(0.05f, 1.5f) });
+            default: {
+                hull.clear();
+                for (uint32_t i = 0; i < HULL_VERTICES; ++i) {
+                    hull.push_back(centre + math::vector::normalize(random_point(rng, 1.0f)) * rng.range(0.5f, 1.0f));
+                }
+                return gjk::shape::hull(hull);
+            }
+        }
+    }
+
+    // Gap between the shapes along unit direction 'n' from A to B, negative where they overlap
+    float gap(const gjk::shape& a, const gjk::shape& b, const float3::values& n) {
+        return math::vector::dot(n, gjk::support(b, n * -1.0f)) - math::vector::dot(n, gjk::support(a, n));
+    }
+
+    // The largest gap over a spread of directions, refined from the best one by subgradient
+    // ascent. The gap is concave over all of space, as support functions are convex, so where
+    // it's positive this converges to the distance. It's never more than the distance between
+    // separated shapes, nor less than minus the penetration depth of overlapping ones
+    float best_gap(const gjk::shape& a, const gjk::shape& b, const float3::values& hint) {
+        float3::values best = hint;
+        float bestGap = gap(a, b, hint);
+        // Fibonacci sphere
+        for (uint32_t i = 0; i < DIRECTIONS; ++i) {
+            const float y = 1.0f - 2.0f * (static_cast<float>(i) + 0.5f) / static_cast<float>(DIRECTIONS);
+            const float r = std::sqrt(math::max(0.0f, 1.0f - y * y));
+            const float angle = 2.39996323f * static_cast<float>(i);
+            const float3::values n(r * std::cos(angle), y, r * std::sin(angle));
+            const float g = gap(a, b, n);
+            if (g > bestGap) {
+                bestGap = g;
+                best = n;
+            }
+        }
+
+        float3::values n = best;
+        for (uint32_t step = 0; step < ASCENT_STEPS; ++step) {
+            const float3::values slope = gjk::support(b, n * -1.0f) - gjk::support(a, n);
+            const float length = math::vector::magnitude(slope);
+            if (length <= 0.0f) {
+                break;
+            }
+            n = math::vector::normalize(n + slope * (ASCENT_RATE / (length * std::sqrt(static_cast<float>(step + 1)))));
+            const float g = gap(a, b, n);
+            if (g > bestGap) {
+                bestGap = g;
+            }
+        }
+        return bestGap;
+    }
+
+    float size_of(const gjk::shape& a, const gjk::shape& b) {
+        const float3::values directions[3] = { float3::RIGHT, float3::UP, float3::FORWARD };
+        float size = 0.0f;
+        for (const float3::values& n : directions) {
+            size = math::max(size, math::vector::dot(n, gjk::support(a, n)) + math::vector::dot(n, gjk::support(a, n * -1.0f) * -1.0f));
+            size = math::max(size, math::vector::dot(n, gjk::support(b, n)) + math::vector::dot(n, gjk::support(b, n * -1.0f) * -1.0f));
+        }
+        return math::max(size, 1.0f);
+    }
+}
+
+int main() {
+    math::random::generator rng(17);
+    eastl::vector<float3::values> hullA, hullB;
+    int separated = 0, overlapping = 0, distanceMisses = 0, depthMisses = 0;
+    float worstDistance = 0.0f, worstDepth = 0.0f;
+
+    for (int i = 0; i < PAIRS; ++i) {
+        for (uint32_t kindA = 0; kindA < 5; ++kindA) {
+            const gjk::shape a = random_shape(rng, kindA, hullA);
+            const gjk::shape b = random_shape(rng, rng.range(0, 4), hullB);
+            const float size = size_of(a, b);
+            const float tolerance = TOLERANCE * size;
+            const float normalTolerance = NORMAL_TOLERANCE * size;
+
+            gjk::result info;
+            const bool apart = gjk::closest_points(a, b, info);
+            ELOO_CHECK_NEAR(math::vector::magnitude(info.pointB - info.pointA - info.normal * info.distance), 0.0f, tolerance);
+            if (apart) {
+                ++separated;
+                // GJK's own witness points make its distance an upper bound, and the shapes must
+                // be that far apart along the reported normal
+                const float along = gap(a, b, info.normal);
+                const float bound = best_gap(a, b, info.normal);
+                const float error = math::max(std::fabs(info.distance - along) / normalTolerance, (info.distance - bound) / tolerance);
+                worstDistance = math::max(worstDistance, error);
+                distanceMisses += error > 1.0f ? 1 : 0;
+            }
+
+            gjk::result depth;
+            const bool hit = gjk::penetration(a, b, depth);
+            ELOO_CHECK(hit == !apart);
+            ELOO_CHECK_NEAR(math::vector::magnitude(depth.pointB - depth.pointA - depth.normal * depth.distance), 0.0f, tolerance);
+            if (hit) {
+                ++overlapping;
+                // The shapes must overlap by the reported depth along the reported normal, and by
+                // no less along any direction
+                const float along = gap(a, b, depth.normal);
+                const float bound = best_gap(a, b, depth.normal);
+                const float error = math::max(std::fabs(depth.distance - along) / normalTolerance, (bound - depth.distance) / tolerance);
+                worstDepth = math::max(worstDepth, error);
+                depthMisses += error > 1.0f ? 1 : 0;
+            }
+        }
+    }
+
+    std::printf("%d separated, worst distance error %.2f tolerances\n", separated, worstDistance);
+    std::printf("%d overlapping, worst depth error %.2f tolerances\n", overlapping, worstDepth);
+    if (!ELOO_CHECK(distanceMisses == 0)) {
+        std::printf("  %d distances off the support bound\n", distanceMisses);
+    }
+    if (!ELOO_CHECK(depthMisses == 0)) {
+        std::printf("  %d depths off the support bound\n", depthMisses);
+    }
+    return test::finish();
+}
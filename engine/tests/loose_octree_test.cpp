@@ -0,0 +1,62 @@
+#include "test.h"
+
+#include "utility/loose_octree.h"
+
+#include <EASTL/vector.h>
+
+using namespace eloo;
+
+// A tiny object sinks to the deepest level the tree allows. Every depth up to MAX_DEPTH must
+// give it its own chain of nodes below the root and find it again through each query
+
+namespace {
+    constexpr float WORLD_SIZE = 1024.0f;
+    constexpr float OBJECT_SIZE = 1e-4f;
+    constexpr uint32_t USER_DATA = 42;
+
+    void test_depth(uint32_t maxDepth) {
+        const bvh::aabb world = { { 0.0f, 0.0f, 0.0f }, { WORLD_SIZE, WORLD_SIZE, WORLD_SIZE } };
+        spatial::loose_octree octree(world, maxDepth);
+
+        const float3::values centre(700.0f, 300.0f, 500.0f);
+        const float3::values half(OBJECT_SIZE * 0.5f, OBJECT_SIZE * 0.5f, OBJECT_SIZE * 0.5f);
+        const bvh::aabb object = { centre - half, centre + half };
+        const uint32_t proxy = octree.insert(object, USER_DATA);
+
+        // The root and one node per level down to the object
+        if (!ELOO_CHECK(octree.node_count() == maxDepth + 1)) {
+            std::printf("  max depth %u: %zu nodes\n", maxDepth, octree.node_count());
+        }
+
+        eastl::vector<uint32_t> found;
+        const bvh::aabb around = { centre - float3::values(1.0f, 1.0f, 1.0f), centre + float3::values(1.0f, 1.0f, 1.0f) };
+        ELOO_CHECK(octree.overlap(around, found) == 1 && found[0] == USER_DATA);
+
+        const auto box_test = [&object](uint32_t, const raycast::ray& query, raycast::result& hit) {
+            return raycast::test_aabb(query, object.min, object.max, hit);
+        };
+        const raycast::ray down(centre + float3::values(0.0f, 10.0f, 0.0f), float3::values(0.0f, -1.0f, 0.0f));
+        raycast::batch_hit closest;
+        ELOO_CHECK(octree.raycast(down, box_test, closest) && closest.index == USER_DATA);
+        ELOO_CHECK(octree.occluded(down, box_test));
+
+        // Moving it across the world and back keeps the node chains consistent
+        const float3::values moved(100.0f, 900.0f, 20.0f);
+        ELOO_CHECK(octree.update(proxy, { moved - half, moved + half }) == (maxDepth > 0));
+        found.clear();
+        ELOO_CHECK(octree.overlap(around, found) == 0);
+        ELOO_CHECK(octree.overlap({ moved - float3::values(1.0f, 1.0f, 1.0f), moved + float3::values(1.0f, 1.0f, 1.0f) }, found) == 1);
+        ELOO_CHECK(octree.node_count() == maxDepth + 1);
+
+        octree.remove(proxy);
+        ELOO_CHECK(octree.size() == 0);
+        ELOO_CHECK(octree.node_count() <= 1);
+    }
+}
+
+int main() {
+    for (uint32_t maxDepth = 0; maxDepth <= spatial::loose_octree::MAX_DEPTH; ++maxDepth) {
+        test_depth(maxDepth);
+    }
+    return test::finish();
+}
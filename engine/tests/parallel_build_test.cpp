@@ -0,0 +1,147 @@
+#include "test.h"
+
+#include "maths/random.h"
+#include "utility/bvh.h"
+#include "utility/parallel.h"
+#include "utility/spatial_hash.h"
+
+#include <EASTL/atomic.h>
+#include <EASTL/vector.h>
+
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+using namespace eloo;
+
+// Builds that split work into several parallel_for passes while another thread keeps taking and
+// releasing the pool. A pass that finds the pool taken runs as one serial call, so consecutive
+// passes of the same build can be split differently, and the results must not depend on it
+
+namespace {
+    constexpr int GRID_BUILDS = 40;
+    constexpr size_t POINT_COUNT = 200000;
+    // Tree builds are slower, and the same size still trips a mismatched partition within a few
+    constexpr int BVH_BUILDS = 16;
+    constexpr size_t BOX_COUNT = 200000;
+    constexpr float SPREAD = 50.0f;
+
+    // Keeps submitting short ranges from its own thread, pausing between them so that builds on
+    // the main thread sometimes get the pool and sometimes don't
+    class busy_pool {
+    public:
+        busy_pool() : mThread([this] { run(); }) {}
+
+        ~busy_pool() {
+            mStopping.store(true);
+            mThread.join();
+        }
+
+    private:
+        void run() {
+            math::random::generator rng(7);
+            while (!mStopping.load()) {
+                parallel::parallel_for(parallel::worker_count() * 4, 1, [](size_t, size_t) {
+                    std::this_thread::sleep_for(std::chrono::microseconds(200));
+                });
+                std::this_thread::sleep_for(std::chrono::microseconds(rng.range(0, 2000)));
+            }
+        }
+
+    private:
+        eastl::atomic<bool> mStopping { false };
+        std::thread mThread;
+    };
+
+    eastl::vector<bvh::aabb> make_boxes() {
+        math::random::generator rng(5);
+        eastl::vector<bvh::aabb> boxes(BOX_COUNT);
+        for (bvh::aabb& box : boxes) {
+            const float3::values corner(rng.range(-SPREAD, SPREAD), rng.range(-SPREAD, SPREAD), rng.range(-SPREAD, SPREAD));
+            box = { corner, corner + float3::values(rng.range(0.01f, 1.0f), rng.range(0.01f, 1.0f), rng.range(0.01f, 1.0f)) };
+        }
+        return boxes;
+    }
+
+    bool same_nodes(eastl::span<const bvh::node> a, eastl::span<const bvh::node> b) {
+        return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size_bytes()) == 0;
+    }
+
+    // Every build must give the same tree as one made while the pool was free, and its primitive
+    // order must be a permutation
+    void test_bvh(const eastl::vector<bvh::aabb>& boxes, const bvh::tree& reference) {
+        bvh::tree tree;
+        eastl::vector<uint8_t> seen(BOX_COUNT);
+        for (int build = 0; build < BVH_BUILDS; ++build) {
+            tree.build(boxes);
+
+            eastl::fill(seen.begin(), seen.end(), uint8_t(0));
+            size_t duplicates = 0;
+            for (const uint32_t index : tree.indices()) {
+                duplicates += index >= BOX_COUNT || seen[index] != 0 ? 1 : 0;
+                if (index < BOX_COUNT) {
+                    seen[index] = 1;
+                }
+            }
+            if (!ELOO_CHECK(tree.indices().size() == BOX_COUNT && duplicates == 0)) {
+                std::printf("  bvh build %d: %zu duplicated or invalid indices\n", build, duplicates);
+            }
+            ELOO_CHECK(same_nodes(tree.nodes(), reference.nodes()));
+        }
+    }
+
+    void test_hash_grid() {
+        math::random::generator rng(3);
+        eastl::vector<float> x(POINT_COUNT), y(POINT_COUNT), z(POINT_COUNT);
+        rng.fill_range(x, -SPREAD, SPREAD);
+        rng.fill_range(y, -SPREAD, SPREAD);
+        rng.fill_range(z, -SPREAD, SPREAD);
+
+        const bvh::aabb everything = { { -SPREAD, -SPREAD, -SPREAD }, { SPREAD, SPREAD, SPREAD } };
+        const float3::values centre(1.0f, -2.0f, 3.0f);
+        const float radius = 4.0f;
+        size_t expectedNear = 0;
+        for (size_t i = 0; i < POINT_COUNT; ++i) {
+            const float dx = x[i] - centre.x();
+            const float dy = y[i] - centre.y();
+            const float dz = z[i] - centre.z();
+            expectedNear += dx * dx + dy * dy + dz * dz <= radius * radius ? 1 : 0;
+        }
+
+        spatial::hash_grid grid(2.0f);
+        eastl::vector<uint32_t> found;
+        eastl::vector<uint8_t> seen(POINT_COUNT);
+        for (int build = 0; build < GRID_BUILDS; ++build) {
+            grid.build(x, y, z);
+
+            // Every point comes back exactly once
+            found.clear();
+            ELOO_CHECK(grid.overlap(everything, found) == POINT_COUNT);
+            eastl::fill(seen.begin(), seen.end(), uint8_t(0));
+            size_t duplicates = 0;
+            for (const uint32_t index : found) {
+                duplicates += index >= POINT_COUNT || seen[index] != 0 ? 1 : 0;
+                if (index < POINT_COUNT) {
+                    seen[index] = 1;
+                }
+            }
+            if (!ELOO_CHECK(duplicates == 0)) {
+                std::printf("  hash grid build %d: %zu duplicated or invalid indices\n", build, duplicates);
+            }
+
+            found.clear();
+            ELOO_CHECK(grid.overlap(centre, radius, found) == expectedNear);
+        }
+    }
+}
+
+int main() {
+    std::printf("%zu workers\n", parallel::worker_count());
+    const eastl::vector<bvh::aabb> boxes = make_boxes();
+    const bvh::tree reference(boxes);
+
+    busy_pool busy;
+    test_hash_grid();
+    test_bvh(boxes, reference);
+    return test::finish();
+}
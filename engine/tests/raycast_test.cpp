@@ -0,0 +1,182 @@
+#include "test.h"
+
+#include "maths/math.h"
+
+#include "utility/bvh.h"
+#include "utility/bvh_compressed.h"
+#include "utility/dynamic_tree.h"
+#include "utility/loose_octree.h"
+#include "utility/query_scheduler.h"
+#include "utility/raycast.h"
+#include "utility/spatial_hash.h"
+#include "utility/sweep_and_prune.h"
+
+#include <EASTL/vector.h>
+
+using namespace eloo;
+using raycast::batch_hit;
+
+// Rays whose direction has -0 components, which have a -infinity inverse. The prepared ray
+// terms and every traversal built on them must pick the slabs from the sign bit, or the near
+// and far planes swap and the ray misses
+
+namespace {
+    struct ray_case {
+        float3::values origin;
+        float3::values direction;
+    };
+
+    // Each case hits the unit box [-1, 1]^3 at t = 4
+    const ray_case CASES[] = {
+        { { 0.5f, 0.5f, 5.0f }, { -0.0f, 0.0f, -1.0f } },
+        { { 0.5f, 0.5f, 5.0f }, { 0.0f, -0.0f, -1.0f } },
+        { { 0.5f, 0.5f, 5.0f }, { -0.0f, -0.0f, -1.0f } },
+        { { 5.0f, 0.5f, 0.5f }, { -1.0f, -0.0f, -0.0f } },
+        { { 0.5f, -5.0f, 0.5f }, { -0.0f, 1.0f, -0.0f } },
+    };
+
+    constexpr float HIT_DISTANCE = 4.0f;
+    constexpr float TOLERANCE = 1e-4f;
+    constexpr uint32_t TARGET = 0;
+
+    // The unit box first, then a ring of boxes around it that no case reaches
+    eastl::vector<bvh::aabb> make_boxes() {
+        eastl::vector<bvh::aabb> boxes;
+        boxes.push_back({ { -1.0f, -1.0f, -1.0f }, { 1.0f, 1.0f, 1.0f } });
+        for (int i = -3; i <= 3; ++i) {
+            for (int j = -3; j <= 3; ++j) {
+                if (i == 0 && j == 0) {
+                    continue;
+                }
+                const float x = static_cast<float>(i) * 20.0f;
+                const float y = static_cast<float>(j) * 20.0f;
+                boxes.push_back({ { x - 1.0f, y - 1.0f, -21.0f }, { x + 1.0f, y + 1.0f, -19.0f } });
+            }
+        }
+        return boxes;
+    }
+
+    // Twelve triangles per box, as a soup
+    eastl::vector<float3::values> make_triangles(eastl::span<const bvh::aabb> boxes) {
+        eastl::vector<float3::values> vertices;
+        for (const bvh::aabb& box : boxes) {
+            const float3::values& lo = box.min;
+            const float3::values& hi = box.max;
+            const float3::values corners[8] = {
+                { lo.x(), lo.y(), lo.z() }, { hi.x(), lo.y(), lo.z() }, { lo.x(), hi.y(), lo.z() }, { hi.x(), hi.y(), lo.z() },
+                { lo.x(), lo.y(), hi.z() }, { hi.x(), lo.y(), hi.z() }, { lo.x(), hi.y(), hi.z() }, { hi.x(), hi.y(), hi.z() },
+            };
+            const uint32_t faces[6][4] = { { 0, 2, 3, 1 }, { 4, 5, 7, 6 }, { 0, 1, 5, 4 }, { 2, 6, 7, 3 }, { 0, 4, 6, 2 }, { 1, 3, 7, 5 } };
+            for (const auto& face : faces) {
+                vertices.push_back(corners[face[0]]);
+                vertices.push_back(corners[face[1]]);
+                vertices.push_back(corners[face[2]]);
+                vertices.push_back(corners[face[0]]);
+                vertices.push_back(corners[face[2]]);
+                vertices.push_back(corners[face[3]]);
+            }
+        }
+        return vertices;
+    }
+
+    void check_hit(bool hit, const batch_hit& closest, uint32_t expectedIndex) {
+        ELOO_CHECK(hit);
+        ELOO_CHECK(closest.index == expectedIndex);
+        ELOO_CHECK_NEAR(closest.hit.distance, HIT_DISTANCE, TOLERANCE);
+    }
+
+    void test_prepared(const raycast::ray& query, const bvh::aabb& box) {
+        ELOO_CHECK(query.sign[0] == (std::signbit(query.direction.x()) ? 1u : 0u));
+        ELOO_CHECK(query.sign[1] == (std::signbit(query.direction.y()) ? 1u : 0u));
+        ELOO_CHECK(query.sign[2] == (std::signbit(query.direction.z()) ? 1u : 0u));
+
+        raycast::result scalar, prepared;
+        ELOO_CHECK(raycast::test_aabb(query.origin, query.direction, box.min, box.max, scalar));
+        ELOO_CHECK(raycast::test_aabb(query, box.min, box.max, prepared));
+        ELOO_CHECK_NEAR(scalar.distance, HIT_DISTANCE, TOLERANCE);
+        ELOO_CHECK_NEAR(prepared.distance, HIT_DISTANCE, TOLERANCE);
+        ELOO_CHECK(raycast::occluded_aabb(query, box.min, box.max));
+    }
+}
+
+int main() {
+    const eastl::vector<bvh::aabb> boxes = make_boxes();
+    const eastl::vector<float3::values> triangles = make_triangles(boxes);
+    const auto box_test = [&boxes](uint32_t userData, const raycast::ray& query, raycast::result& hit) {
+        return raycast::test_aabb(query, boxes[userData].min, boxes[userData].max, hit);
+    };
+
+    const bvh::tree tree(boxes);
+    const bvh::mesh mesh(triangles);
+    const bvh::compressed_mesh<4> compressed4(triangles);
+    const bvh::compressed_mesh<8> compressed8(triangles);
+
+    bvh::dynamic_tree dynamicTree;
+    spatial::loose_octree octree({ { -100.0f, -100.0f, -100.0f }, { 100.0f, 100.0f, 100.0f } }, 6);
+    spatial::sweep_and_prune sweep;
+    for (uint32_t i = 0; i < boxes.size(); ++i) {
+        dynamicTree.insert(boxes[i], i);
+        octree.insert(boxes[i], i);
+        sweep.insert(boxes[i].min, boxes[i].max, i);
+    }
+
+    // One point at the centre of each box, as a sphere of radius 1
+    eastl::vector<float> pointX, pointY, pointZ;
+    for (const bvh::aabb& box : boxes) {
+        pointX.push_back((box.min.x() + box.max.x()) * 0.5f);
+        pointY.push_back((box.min.y() + box.max.y()) * 0.5f);
+        pointZ.push_back((box.min.z() + box.max.z()) * 0.5f);
+    }
+    spatial::hash_grid grid(4.0f);
+    grid.build(pointX, pointY, pointZ);
+
+    raycast::query_scheduler::scene scene;
+    scene.raycast = [&tree](const raycast::ray& query, batch_hit& closest) { return tree.raycast(query, closest); };
+    scene.occluded = [&tree](const raycast::ray& query) { return tree.occluded(query); };
+    raycast::query_scheduler scheduler(scene);
+
+    for (const ray_case& rayCase : CASES) {
+        const raycast::ray query(rayCase.origin, rayCase.direction);
+        test_prepared(query, boxes[TARGET]);
+
+        batch_hit closest;
+        check_hit(tree.raycast(query, closest), closest, TARGET);
+        ELOO_CHECK(tree.occluded(query));
+
+        // Mesh hits report the triangle, which belongs to the target box when below twelve
+        ELOO_CHECK(mesh.raycast(query, closest) && closest.index < 12);
+        ELOO_CHECK_NEAR(closest.hit.distance, HIT_DISTANCE, TOLERANCE);
+        ELOO_CHECK(mesh.occluded(query));
+        ELOO_CHECK(compressed4.raycast(query, closest) && closest.index < 12);
+        ELOO_CHECK_NEAR(closest.hit.distance, HIT_DISTANCE, TOLERANCE);
+        ELOO_CHECK(compressed4.occluded(query));
+        ELOO_CHECK(compressed8.raycast(query, closest) && closest.index < 12);
+        ELOO_CHECK_NEAR(closest.hit.distance, HIT_DISTANCE, TOLERANCE);
+        ELOO_CHECK(compressed8.occluded(query));
+
+        check_hit(dynamicTree.raycast(query, box_test, closest), closest, TARGET);
+        ELOO_CHECK(dynamicTree.occluded(query, box_test));
+
+        check_hit(octree.raycast(query, box_test, closest), closest, TARGET);
+        ELOO_CHECK(octree.occluded(query, box_test));
+
+        check_hit(sweep.raycast(query, closest), closest, TARGET);
+
+        // Every case passes the target's centre 0.5 off axis on both other axes
+        const float centreDistance = math::vector::magnitude(rayCase.origin - float3::values(pointX[TARGET], pointY[TARGET], pointZ[TARGET]));
+        const float sphereRadius = 1.0f;
+        const float offAxis = 0.5f * 1.41421356f;
+        const float sphereHit = std::sqrt(centreDistance * centreDistance - offAxis * offAxis) - std::sqrt(sphereRadius * sphereRadius - offAxis * offAxis);
+        ELOO_CHECK(grid.raycast(query, sphereRadius, closest) && closest.index == TARGET);
+        ELOO_CHECK_NEAR(closest.hit.distance, sphereHit, TOLERANCE);
+
+        raycast::query_result rayResult, occludedResult;
+        scheduler.raycast(query, &rayResult);
+        scheduler.occluded(query, &occludedResult);
+        scheduler.flush();
+        check_hit(rayResult.hit, rayResult.closest, TARGET);
+        ELOO_CHECK(occludedResult.hit);
+    }
+
+    return test::finish();
+}
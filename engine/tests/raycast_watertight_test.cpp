@@ -0,0 +1,266 @@
+#include "test.h"
+
+#include "maths/math.h"
+#include "maths/random.h"
+#include "utility/raycast_watertight.h"
+
+#include <EASTL/vector.h>
+
+using namespace eloo;
+
+// Rays aimed exactly at shared vertices and edges must hit at least one of the triangles that
+// meet there, on an open heightfield seen from above and on a closed, jittered cube seen from
+// inside. The batch and packet forms must agree with the single ray test
+
+namespace {
+    struct indexed_mesh {
+        eastl::vector<float3::values> vertices;
+        eastl::vector<uint32_t> indices;
+        eastl::vector<raycast::triangle_record> records;
+
+        void finish() {
+            raycast::build_records(vertices, indices, records);
+        }
+    };
+
+    float3::values record_vertex(const float (&vertex)[3]) {
+        return { vertex[0], vertex[1], vertex[2] };
+    }
+
+    // Jittered grid of 'size' x 'size' cells on the XZ plane with random heights
+    indexed_mesh make_heightfield(math::random::generator& rng, uint32_t size) {
+        indexed_mesh terrain;
+        for (uint32_t z = 0; z <= size; ++z) {
+            for (uint32_t x = 0; x <= size; ++x) {
+                terrain.vertices.push_back({
+                    static_cast<float>(x) * 0.37f + rng.range(-0.1f, 0.1f),
+                    rng.range(-1.0f, 1.0f),
+                    static_cast<float>(z) * 0.41f + rng.range(-0.1f, 0.1f) });
+            }
+        }
+        for (uint32_t z = 0; z < size; ++z) {
+            for (uint32_t x = 0; x < size; ++x) {
+                const uint32_t corner = z * (size + 1) + x;
+                const uint32_t triangles[6] = { corner, corner + size + 1, corner + 1, corner + 1, corner + size + 1, corner + size + 2 };
+                terrain.indices.insert(terrain.indices.end(), triangles, triangles + 6);
+            }
+        }
+        terrain.finish();
+        return terrain;
+    }
+
+    // A cube made of a 'size' x 'size' grid per face, with every vertex pushed in or out along
+    // its direction from the centre. Vertices shared by two faces are moved by the same amount,
+    // so the surface stays closed
+    indexed_mesh make_closed_cube(uint32_t size) {
+        indexed_mesh cube;
+        for (int face = 0; face < 6; ++face) {
+            const uint32_t base = static_cast<uint32_t>(cube.vertices.size());
+            for (uint32_t j = 0; j <= size; ++j) {
+                for (uint32_t i = 0; i <= size; ++i) {
+                    const float a = static_cast<float>(i) * 2.0f / static_cast<float>(size) - 1.0f;
+                    const float b = static_cast<float>(j) * 2.0f / static_cast<float>(size) - 1.0f;
+                    const float3::values onFace[6] = { { 1.0f, a, b }, { -1.0f, b, a }, { b, 1.0f, a }, { a, -1.0f, b }, { a, b, 1.0f }, { b, a, -1.0f } };
+                    cube.vertices.push_back(onFace[face]);
+                }
+            }
+            for (uint32_t j = 0; j < size; ++j) {
+                for (uint32_t i = 0; i < size; ++i) {
+                    const uint32_t corner = base + j * (size + 1) + i;
+                    const uint32_t triangles[6] = { corner, corner + 1, corner + size + 1, corner + 1, corner + size + 2, corner + size + 1 };
+                    cube.indices.insert(cube.indices.end(), triangles, triangles + 6);
+                }
+            }
+        }
+
+        // The scale is hashed from the exact grid position, which both faces share at a seam
+        for (float3::values& vertex : cube.vertices) {
+            const uint32_t hash = static_cast<uint32_t>((vertex.x() + 2.0f) * 1000.0f) * 73856093u
+                ^ static_cast<uint32_t>((vertex.y() + 2.0f) * 1000.0f) * 19349663u
+                ^ static_cast<uint32_t>((vertex.z() + 2.0f) * 1000.0f) * 83492791u;
+            const float scale = 1.0f + (static_cast<float>(hash % 1000) / 1000.0f - 0.5f) * 0.2f;
+            vertex = vertex * scale;
+        }
+        cube.finish();
+        return cube;
+    }
+
+    // Fires a ray at 'target', checks it hits the mesh, and adds it to the packet. Full packets
+    // are checked to have every lane blocked by some triangle, then emptied
+    void fire(const indexed_mesh& mesh, const float3::values& origin, const float3::values& target, raycast::packet8& lanes, int& leaks) {
+        const float3::values direction = (target - origin) * 1.5f;
+        const raycast::watertight_ray query(origin, direction);
+        raycast::triangle_hit closest;
+        if (!raycast::test_tris(query, mesh.records, closest) || !raycast::occluded_tris(query, mesh.records)) {
+            ++leaks;
+        }
+
+        int lane = 0;
+        while (lane < 8 && (lanes.active & (1u << lane))) {
+            ++lane;
+        }
+        lanes.set(lane, origin, direction);
+        if (lanes.active == raycast::packet8::ALL_LANES) {
+            uint32_t blocked = 0;
+            for (const raycast::triangle_record& record : mesh.records) {
+                blocked |= raycast::occluded_tri(lanes, record);
+            }
+            ELOO_CHECK(blocked == raycast::packet8::ALL_LANES);
+            lanes = raycast::packet8();
+        }
+    }
+
+    void test_heightfield(math::random::generator& rng) {
+        constexpr uint32_t SIZE = 48;
+        const indexed_mesh terrain = make_heightfield(rng, SIZE);
+
+        int leaks = 0;
+        int rays = 0;
+        raycast::packet8 lanes;
+        for (uint32_t z = 1; z < SIZE; ++z) {
+            for (uint32_t x = 1; x < SIZE; ++x) {
+                // The vertex, then the midpoints of its edge along x, its edge along z and the
+                // cell's diagonal
+                const uint32_t corner = z * (SIZE + 1) + x;
+                const float3::values& vertex = terrain.vertices[corner];
+                const float3::values targets[4] = {
+                    vertex,
+                    (vertex + terrain.vertices[corner + 1]) * 0.5f,
+                    (vertex + terrain.vertices[corner + SIZE + 1]) * 0.5f,
+                    (terrain.vertices[corner + 1] + terrain.vertices[corner + SIZE + 1]) * 0.5f
+                };
+                for (const float3::values& target : targets) {
+                    fire(terrain, target + float3::values(0.0f, 10.0f, 0.0f), target, lanes, leaks);
+                    for (int i = 0; i < 3; ++i) {
+                        const float3::values offset(rng.range(-2.0f, 2.0f), rng.range(8.0f, 30.0f), rng.range(-2.0f, 2.0f));
+                        fire(terrain, target + offset, target, lanes, leaks);
+                    }
+                    rays += 4;
+                }
+            }
+        }
+        std::printf("heightfield: %d rays at shared vertices and edges, %d leaked\n", rays, leaks);
+        ELOO_CHECK(leaks == 0);
+    }
+
+    void test_closed_cube(math::random::generator& rng) {
+        const indexed_mesh cube = make_closed_cube(12);
+
+        int leaks = 0;
+        int rays = 0;
+        raycast::packet8 lanes;
+        for (size_t i = 0; i < cube.indices.size(); i += 3) {
+            const float3::values& vertex1 = cube.vertices[cube.indices[i]];
+            const float3::values& vertex2 = cube.vertices[cube.indices[i + 1]];
+            const float3::values& vertex3 = cube.vertices[cube.indices[i + 2]];
+            const float3::values targets[3] = { vertex1, (vertex1 + vertex2) * 0.5f, (vertex2 + vertex3) * 0.5f };
+            for (const float3::values& target : targets) {
+                for (int j = 0; j < 3; ++j) {
+                    const float3::values origin(rng.range(-0.7f, 0.7f), rng.range(-0.7f, 0.7f), rng.range(-0.7f, 0.7f));
+                    fire(cube, origin, target, lanes, leaks);
+                    ++rays;
+                }
+            }
+        }
+        std::printf("closed cube: %d rays from inside at shared vertices and edges, %d leaked\n", rays, leaks);
+        ELOO_CHECK(leaks == 0);
+    }
+
+    // Batch and packet results against the single ray test, over random triangles that include
+    // exact duplicates
+    void test_batch_and_packet(math::random::generator& rng) {
+        for (int iteration = 0; iteration < 2000; ++iteration) {
+            const uint32_t count = static_cast<uint32_t>(rng.range(0, 40));
+            eastl::vector<raycast::triangle_record> records;
+            for (uint32_t i = 0; i < count; ++i) {
+                if (i % 5 == 4) {
+                    records.push_back(records.back());
+                    continue;
+                }
+                const float3::values centre(rng.range(-5.0f, 5.0f), rng.range(-5.0f, 5.0f), rng.range(-5.0f, 5.0f));
+                const auto corner = [&] { return centre + float3::values(rng.range(-2.0f, 2.0f), rng.range(-2.0f, 2.0f), rng.range(-2.0f, 2.0f)); };
+                const float3::values v1 = corner();
+                const float3::values v2 = corner();
+                const float3::values v3 = corner();
+                records.emplace_back(v1, v2, v3, i * 7);
+            }
+
+            const float3::values origin(rng.range(-8.0f, 8.0f), rng.range(-8.0f, 8.0f), rng.range(-8.0f, 8.0f));
+            const float3::values direction = iteration % 7 == 0 ? float3::values(0.0f, -1.0f, 0.0f) : float3::values(rng.range(-1.0f, 1.0f), rng.range(-1.0f, 1.0f), rng.range(-1.0f, 1.0f));
+            raycast::ray prepared(origin, direction, rng.boolean(0.5f) ? FLT_MAX : rng.range(0.0f, 20.0f));
+            if (iteration % 3 == 0) {
+                prepared.tmin = rng.range(0.0f, 3.0f);
+            }
+            const raycast::watertight_ray query(prepared);
+
+            raycast::triangle_hit best;
+            bool anyHit = false;
+            eastl::vector<raycast::triangle_hit> every;
+            for (const raycast::triangle_record& record : records) {
+                raycast::triangle_hit hit;
+                const bool hitRecord = raycast::test_tri(query, record, hit);
+                ELOO_CHECK(hitRecord == raycast::occluded_tri(query, record));
+                if (!hitRecord) {
+                    continue;
+                }
+                every.push_back(hit);
+                if (!anyHit || hit.hit.distance < best.hit.distance) {
+                    best = hit;
+                }
+                anyHit = true;
+
+                const float3::values fromWeights = record_vertex(record.vertex1) * (1.0f - hit.u - hit.v) + record_vertex(record.vertex2) * hit.u + record_vertex(record.vertex3) * hit.v;
+                ELOO_CHECK(math::vector::magnitude(fromWeights - hit.hit.position) < 1e-3f);
+                ELOO_CHECK_NEAR(math::vector::magnitude(hit.normal), 1.0f, 1e-4f);
+            }
+
+            raycast::triangle_hit closest;
+            ELOO_CHECK(raycast::test_tris(query, records, closest) == anyHit);
+            ELOO_CHECK(raycast::occluded_tris(query, records) == anyHit);
+            if (anyHit) {
+                ELOO_CHECK(closest.id == best.id && closest.hit.distance == best.hit.distance && closest.u == best.u && closest.v == best.v);
+            }
+
+            eastl::vector<raycast::triangle_hit> hits;
+            ELOO_CHECK(raycast::test_tris(query, records, hits) == every.size());
+            for (size_t i = 0; i < hits.size() && i < every.size(); ++i) {
+                ELOO_CHECK(hits[i].id == every[i].id && hits[i].hit.distance == every[i].hit.distance);
+            }
+
+            raycast::packet8 lanes;
+            for (int lane = 0; lane < 8; ++lane) {
+                if (!rng.boolean(0.8f)) {
+                    continue;
+                }
+                const float3::values laneOrigin(rng.range(-8.0f, 8.0f), rng.range(-8.0f, 8.0f), rng.range(-8.0f, 8.0f));
+                const float3::values laneDirection = lane == 3 ? float3::values(1.0f, 0.0f, 0.0f) : float3::values(rng.range(-1.0f, 1.0f), rng.range(-1.0f, 1.0f), rng.range(-1.0f, 1.0f));
+                lanes.set(lane, laneOrigin, laneDirection, rng.range(0.0f, 30.0f));
+            }
+            for (const raycast::triangle_record& record : records) {
+                raycast::packet_triangle_result<8> packetHits;
+                const uint32_t mask = raycast::test_tri(lanes, record, packetHits);
+                ELOO_CHECK(mask == raycast::occluded_tri(lanes, record));
+                for (int lane = 0; lane < 8; ++lane) {
+                    raycast::triangle_hit hit;
+                    bool hitLane = false;
+                    if (lanes.active & (1u << lane)) {
+                        const raycast::watertight_ray laneQuery({ lanes.originX[lane], lanes.originY[lane], lanes.originZ[lane] }, { lanes.dirX[lane], lanes.dirY[lane], lanes.dirZ[lane] }, lanes.length[lane]);
+                        hitLane = raycast::test_tri(laneQuery, record, hit);
+                    }
+                    ELOO_CHECK(hitLane == packetHits.hit(lane));
+                    if (hitLane && packetHits.hit(lane)) {
+                        ELOO_CHECK(hit.id == packetHits.hits[lane].id && hit.hit.distance == packetHits.hits[lane].hit.distance && hit.u == packetHits.hits[lane].u && hit.v == packetHits.hits[lane].v);
+                    }
+                }
+            }
+        }
+    }
+}
+
+int main() {
+    math::random::generator rng(3);
+    test_heightfield(rng);
+    test_closed_cube(rng);
+    test_batch_and_packet(rng);
+    return test::finish();
+}
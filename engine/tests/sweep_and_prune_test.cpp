@@ -0,0 +1,168 @@
+#include "test.h"
+
+#include "maths/math.h"
+#include "maths/random.h"
+#include "utility/sweep_and_prune.h"
+
+#include <EASTL/algorithm.h>
+#include <EASTL/vector.h>
+
+using namespace eloo;
+
+// Pair events against brute force. Boxes are inserted, moved and removed at random, with proxy
+// ids reused as they free up, and every flush must report exactly the pairs of user data that
+// started or stopped overlapping since the last one
+
+namespace {
+    using overlap_pair = spatial::sweep_and_prune::overlap_pair;
+
+    constexpr int STEPS = 300;
+    constexpr int OPERATIONS_PER_STEP = 16;
+    constexpr size_t MAX_BOXES = 32;
+    // Small enough that most boxes overlap a few others, so pairs end and ids get reused often
+    // between flushes
+    constexpr float WORLD_SIZE = 10.0f;
+    // Coordinates snap to this, so boxes often share or touch endpoints
+    constexpr float SNAP = 0.5f;
+
+    struct model_box {
+        float3::values min = float3::ZERO;
+        float3::values max = float3::ZERO;
+        uint32_t proxy = 0;
+        uint32_t userData = 0;
+    };
+
+    // Pairs of user data, lower first, sorted
+    using pair_list = eastl::vector<eastl::pair<uint32_t, uint32_t>>;
+
+    eastl::pair<uint32_t, uint32_t> ordered(uint32_t a, uint32_t b) {
+        return a < b ? eastl::make_pair(a, b) : eastl::make_pair(b, a);
+    }
+
+    bool boxes_overlap(const model_box& a, const model_box& b) {
+        return a.min.x() <= b.max.x() && b.min.x() <= a.max.x()
+            && a.min.y() <= b.max.y() && b.min.y() <= a.max.y()
+            && a.min.z() <= b.max.z() && b.min.z() <= a.max.z();
+    }
+
+    pair_list brute_force(const eastl::vector<model_box>& boxes) {
+        pair_list pairs;
+        for (size_t i = 0; i < boxes.size(); ++i) {
+            for (size_t j = i + 1; j < boxes.size(); ++j) {
+                if (boxes_overlap(boxes[i], boxes[j])) {
+                    pairs.push_back(ordered(boxes[i].userData, boxes[j].userData));
+                }
+            }
+        }
+        eastl::sort(pairs.begin(), pairs.end());
+        return pairs;
+    }
+
+    pair_list user_data_of(const eastl::vector<overlap_pair>& events) {
+        pair_list pairs;
+        for (const overlap_pair& event : events) {
+            ELOO_CHECK(event.proxyA < event.proxyB);
+            pairs.push_back(ordered(event.userDataA, event.userDataB));
+        }
+        eastl::sort(pairs.begin(), pairs.end());
+        return pairs;
+    }
+
+    pair_list difference(const pair_list& a, const pair_list& b) {
+        pair_list out;
+        eastl::set_difference(a.begin(), a.end(), b.begin(), b.end(), eastl::back_inserter(out));
+        return out;
+    }
+
+    float snapped(math::random::generator& rng, float lo, float hi) {
+        return math::floor(rng.range(lo, hi) / SNAP) * SNAP;
+    }
+
+    void random_box(math::random::generator& rng, model_box& box) {
+        const float3::values corner(snapped(rng, 0.0f, WORLD_SIZE), snapped(rng, 0.0f, WORLD_SIZE), snapped(rng, 0.0f, WORLD_SIZE));
+        box.min = corner;
+        box.max = corner + float3::values(snapped(rng, 0.0f, 4.0f), snapped(rng, 0.0f, 4.0f), snapped(rng, 0.0f, 4.0f));
+    }
+
+    // Removing a proxy whose pair already ended earlier in the frame, then reusing its id
+    void test_reused_id() {
+        spatial::sweep_and_prune sap;
+        eastl::vector<overlap_pair> added, removed;
+        const uint32_t first = sap.insert({ 0.0f, 0.0f, 0.0f }, { 2.0f, 2.0f, 2.0f }, 100);
+        sap.insert({ 1.0f, 1.0f, 1.0f }, { 3.0f, 3.0f, 3.0f }, 200);
+        sap.flush_events(added, removed);
+        ELOO_CHECK(added.size() == 1 && removed.empty());
+
+        added.clear();
+        sap.update(first, { 10.0f, 10.0f, 10.0f }, { 12.0f, 12.0f, 12.0f });
+        sap.remove(first);
+        const uint32_t third = sap.insert({ 1.0f, 1.0f, 1.0f }, { 3.0f, 3.0f, 3.0f }, 300);
+        ELOO_CHECK(third == first);
+        sap.flush_events(added, removed);
+        ELOO_CHECK(user_data_of(added) == pair_list({ { 200, 300 } }));
+        ELOO_CHECK(user_data_of(removed) == pair_list({ { 100, 200 } }));
+
+        added.clear();
+        removed.clear();
+        sap.remove(third);
+        sap.flush_events(added, removed);
+        ELOO_CHECK(added.empty());
+        ELOO_CHECK(user_data_of(removed) == pair_list({ { 200, 300 } }));
+        ELOO_CHECK(sap.size() == 1 && sap.pair_count() == 0);
+    }
+
+    void test_random() {
+        math::random::generator rng(11);
+        spatial::sweep_and_prune sap;
+        eastl::vector<model_box> boxes;
+        uint32_t nextUserData = 1;
+        pair_list reported;
+        eastl::vector<overlap_pair> added, removed, current;
+
+        int mismatches = 0;
+        for (int step = 0; step < STEPS; ++step) {
+            for (int operation = 0; operation < OPERATIONS_PER_STEP; ++operation) {
+                const int kind = rng.range(0, 3);
+                if (boxes.size() < 2 || (kind == 0 && boxes.size() < MAX_BOXES)) {
+                    model_box box;
+                    random_box(rng, box);
+                    box.userData = nextUserData++;
+                    box.proxy = sap.insert(box.min, box.max, box.userData);
+                    boxes.push_back(box);
+                }
+                else if (kind == 1) {
+                    const size_t index = static_cast<size_t>(rng.range(0, static_cast<int32_t>(boxes.size()) - 1));
+                    sap.remove(boxes[index].proxy);
+                    boxes.erase(boxes.begin() + index);
+                }
+                else {
+                    model_box& box = boxes[rng.range(0, static_cast<int32_t>(boxes.size()) - 1)];
+                    random_box(rng, box);
+                    sap.update(box.proxy, box.min, box.max);
+                }
+            }
+
+            const pair_list expected = brute_force(boxes);
+            added.clear();
+            removed.clear();
+            sap.flush_events(added, removed);
+            const bool eventsMatch = user_data_of(added) == difference(expected, reported) && user_data_of(removed) == difference(reported, expected);
+
+            current.clear();
+            sap.pairs(current);
+            const bool pairsMatch = user_data_of(current) == expected && sap.pair_count() == expected.size();
+            mismatches += eventsMatch && pairsMatch ? 0 : 1;
+            reported = expected;
+        }
+
+        if (!ELOO_CHECK(mismatches == 0)) {
+            std::printf("  %d of %d steps disagreed with brute force\n", mismatches, STEPS);
+        }
+    }
+}
+
+int main() {
+    test_reused_id();
+    test_random();
+    return test::finish();
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cmath>
+#include <cstdio>
+
+// Shared helpers for the engine tests
+//
+// Each test is a standalone executable registered with CTest. Checks print where they failed and
+// carry on, and finish() turns the failure count into the exit code.
+
+namespace eloo::test {
+    inline int gFailures = 0;
+
+    inline bool check(bool passed, const char* expression, const char* file, int line) {
+        if (!passed) {
+            ++gFailures;
+            std::printf("%s(%d): check failed: %s\n", file, line, expression);
+        }
+        return passed;
+    }
+
+    inline int finish() {
+        if (gFailures > 0) {
+            std::printf("%d check(s) failed\n", gFailures);
+            return 1;
+        }
+        std::printf("All checks passed\n");
+        return 0;
+    }
+}
+
+#define ELOO_CHECK(condition) ::eloo::test::check((condition), #condition, __FILE__, __LINE__)
+#define ELOO_CHECK_NEAR(a, b, tolerance) ::eloo::test::check(std::fabs((a) - (b)) <= (tolerance), #a " == " #b, __FILE__, __LINE__)